@@ -37,7 +37,9 @@ void VncWidget::Private::paint(const QRect &rect)
         return;
     }
     
-    p.drawImage(rect, client->image(), rect);
+    // The view does not share the framebuffer, so painting never makes the
+    // client copy it on its next update
+    p.drawImage(rect, client->imageView(), rect);
 }
 
 VncWidget::VncWidget(QWidget *parent)
@@ -70,8 +72,9 @@ void VncWidget::setClient(QVncClient *client)
             update();
         });
         
-        connect(client, &QVncClient::imageChanged, this, [this](const QRect &rect) {
-            update(rect);
+        // One repaint per framebuffer update, however many rectangles it had
+        connect(client, &QVncClient::imageRegionChanged, this, [this](const QRegion &region) {
+            update(region);
         });
         
         connect(client, &QVncClient::connectionStateChanged, this, [this](bool connected) {
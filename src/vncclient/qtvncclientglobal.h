@@ -15,6 +15,7 @@ QT_BEGIN_NAMESPACE
 using namespace Qt::Literals::StringLiterals;
 
 Q_DECLARE_LOGGING_CATEGORY(lcVncClient)
+Q_DECLARE_LOGGING_CATEGORY(lcVncClientRead)
 
 QT_END_NAMESPACE
 
@@ -7,5 +7,6 @@ QT_BEGIN_NAMESPACE
 
 // Define the logging category
 Q_LOGGING_CATEGORY(lcVncClient, "qt.vncclient")
+Q_LOGGING_CATEGORY(lcVncClientRead, "qt.vncclient.read")
 
 QT_END_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,345 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncchangetracker.h"
+#include "qvncclient.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QHashFunctions>
+#include <QtCore/QList>
+#include <QtCore/QTimer>
+
+QT_BEGIN_NAMESPACE
+
+class QVncChangeTracker::Private
+{
+public:
+    struct Tile {
+        size_t hash = 0;
+        quint64 token = 0;      // changeToken of the last change
+        qint64 changedAt = 0;   // clock ns of the last change
+        quint64 visited = 0;    // pass that last looked at the tile
+    };
+
+    // The tiles covering \a area, in tile coordinates; all for a null area
+    QRect tileRange(const QRect &area) const
+    {
+        const QRect framebuffer(QPoint(), size);
+        const QRect clipped = area.isNull() ? framebuffer : area & framebuffer;
+        if (clipped.isEmpty())
+            return QRect();
+        return QRect(QPoint(clipped.left() / tileSize, clipped.top() / tileSize),
+                     QPoint(clipped.right() / tileSize, clipped.bottom() / tileSize));
+    }
+
+    QRect tileRect(int column, int row) const
+    {
+        return QRect(column * tileSize, row * tileSize, tileSize, tileSize) & QRect(QPoint(), size);
+    }
+
+    Tile &tile(int column, int row) { return tiles[row * columns + column]; }
+    const Tile &tile(int column, int row) const { return tiles.at(row * columns + column); }
+
+    // Hashes the pixels of one tile straight from the framebuffer
+    size_t hashTile(int column, int row) const
+    {
+        const uchar *bits = client ? client->framebufferBits() : nullptr;
+        if (!bits)
+            return 0;
+        const qsizetype bytesPerLine = client->framebufferBytesPerLine();
+        const QRect rect = tileRect(column, row);
+        size_t hash = 0;
+        for (int y = rect.top(); y <= rect.bottom(); y++)
+            hash = qHashBits(bits + y * bytesPerLine + rect.left() * 4, size_t(rect.width()) * 4, hash);
+        return hash;
+    }
+
+    void rebuild(QVncChangeTracker *q);
+    void update(QVncChangeTracker *q, const QRegion &region);
+
+    QVncClient *client = nullptr;
+    QList<QMetaObject::Connection> connections;
+    int tileSize = 64;
+    QSize size;
+    int columns = 0;
+    int rows = 0;
+    QList<Tile> tiles;
+    quint64 token = 0;
+    quint64 pass = 0;
+    qint64 rebuiltAt = 0;
+    QElapsedTimer clock;
+};
+
+/*!
+    \internal
+    Starts over with the framebuffer size of the client: every tile is
+    hashed once and counts as changed.
+*/
+void QVncChangeTracker::Private::rebuild(QVncChangeTracker *q)
+{
+    size = client ? QSize(client->framebufferWidth(), client->framebufferHeight()) : QSize();
+    columns = (size.width() + tileSize - 1) / tileSize;
+    rows = (size.height() + tileSize - 1) / tileSize;
+    tiles = QList<Tile>(qsizetype(columns) * rows);
+    rebuiltAt = clock.nsecsElapsed();
+    ++token;
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            Tile &t = tile(column, row);
+            t.hash = hashTile(column, row);
+            t.token = token;
+            t.changedAt = rebuiltAt;
+        }
+    }
+    emit q->changed(QRegion(QRect(QPoint(), size)), token);
+}
+
+/*!
+    \internal
+    Rehashes the tiles touched by \a region. Only tiles whose pixels differ
+    from before count as changed, so areas the server sends again unchanged
+    do not.
+*/
+void QVncChangeTracker::Private::update(QVncChangeTracker *q, const QRegion &region)
+{
+    if (!client || size != QSize(client->framebufferWidth(), client->framebufferHeight())) {
+        rebuild(q);
+        return;
+    }
+    ++pass;
+    const qint64 now = clock.nsecsElapsed();
+    QRegion changedTiles;
+    for (const QRect &rect : region) {
+        const QRect range = tileRange(rect);
+        for (int row = range.top(); row <= range.bottom(); row++) {
+            for (int column = range.left(); column <= range.right(); column++) {
+                Tile &t = tile(column, row);
+                if (t.visited == pass)
+                    continue;
+                t.visited = pass;
+                const size_t hash = hashTile(column, row);
+                if (hash == t.hash)
+                    continue;
+                if (changedTiles.isEmpty())
+                    ++token;
+                t.hash = hash;
+                t.token = token;
+                t.changedAt = now;
+                changedTiles += tileRect(column, row);
+            }
+        }
+    }
+    if (!changedTiles.isEmpty())
+        emit q->changed(changedTiles, token);
+}
+
+/*!
+    \class QVncChangeTracker
+    \inmodule QtVncClient
+    \brief Tracks which parts of a QVncClient framebuffer change.
+
+    Automated tests driving a remote machine wait for the screen to settle
+    after an action, or check whether an area changed. Comparing copies of
+    QVncClient::image() for that costs a copy and a scan of the whole
+    framebuffer each time. A change tracker instead divides the framebuffer
+    into tiles of tileSize pixels and keeps a hash of each. When an update
+    is complete, only the tiles it touched are hashed again, straight from
+    the framebuffer; a tile whose hash differs has changed. Rectangles the
+    server sends again with the same pixels do not count.
+
+    Each update that changes something advances changeToken(). Take the
+    token before an action and ask hasChanged() or changedSince() about it
+    afterwards. waitForStable() waits until an area has not changed for a
+    given time, and checksum() identifies the contents of an area, for
+    example to compare against a known good state.
+
+    All areas are handled at tile granularity: an area is considered
+    changed when any tile it touches has changed.
+
+    \code
+    QVncChangeTracker tracker;
+    tracker.setClient(&client);
+    const quint64 before = tracker.changeToken();
+    client.handleKeyEvent(&enter);
+    if (tracker.waitForStable(dialogArea, 500) && tracker.hasChanged(dialogArea, before))
+        ...
+    \endcode
+
+    \sa QVncClient::imageRegionChanged()
+*/
+
+/*!
+    Constructs a change tracker with the given \a parent.
+*/
+QVncChangeTracker::QVncChangeTracker(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+    d->clock.start();
+}
+
+/*!
+    Destroys the change tracker.
+*/
+QVncChangeTracker::~QVncChangeTracker()
+{
+}
+
+/*!
+    \property QVncChangeTracker::client
+    \brief The client whose framebuffer is tracked.
+
+    Setting a client hashes its framebuffer once; all tiles then count as
+    changed.
+*/
+QVncClient *QVncChangeTracker::client() const
+{
+    return d->client;
+}
+
+void QVncChangeTracker::setClient(QVncClient *client)
+{
+    if (d->client == client)
+        return;
+    for (const QMetaObject::Connection &connection : std::as_const(d->connections))
+        disconnect(connection);
+    d->connections.clear();
+    d->client = client;
+    if (client) {
+        d->connections.append(connect(client, &QVncClient::imageRegionChanged, this,
+                                      [this](const QRegion &region) { d->update(this, region); }));
+        d->connections.append(connect(client, &QVncClient::framebufferSizeChanged, this,
+                                      [this]() { d->rebuild(this); }));
+        d->connections.append(connect(client, &QObject::destroyed, this,
+                                      [this]() { setClient(nullptr); }));
+    }
+    d->rebuild(this);
+    emit clientChanged(client);
+}
+
+/*!
+    \property QVncChangeTracker::tileSize
+    \brief The width and height of the tiles changes are tracked in, in
+    pixels.
+
+    Smaller tiles locate changes more precisely; larger ones keep less
+    state. The default is 64. Changing the size starts over.
+*/
+int QVncChangeTracker::tileSize() const
+{
+    return d->tileSize;
+}
+
+void QVncChangeTracker::setTileSize(int size)
+{
+    size = qMax(1, size);
+    if (d->tileSize == size)
+        return;
+    d->tileSize = size;
+    d->rebuild(this);
+    emit tileSizeChanged(size);
+}
+
+/*!
+    \property QVncChangeTracker::changeToken
+    \brief A counter advanced by each update that changes the framebuffer.
+
+    The token also advances when the tracker starts over, after a new
+    client, tile size or framebuffer size.
+*/
+quint64 QVncChangeTracker::changeToken() const
+{
+    return d->token;
+}
+
+/*!
+    Returns \c true if a tile touching \a area changed after the token was
+    \a since. A null \a area means the whole framebuffer.
+*/
+bool QVncChangeTracker::hasChanged(const QRect &area, quint64 since) const
+{
+    const QRect range = d->tileRange(area);
+    for (int row = range.top(); row <= range.bottom(); row++) {
+        for (int column = range.left(); column <= range.right(); column++) {
+            if (d->tile(column, row).token > since)
+                return true;
+        }
+    }
+    return false;
+}
+
+/*!
+    Returns the tiles that changed after the token was \a since.
+*/
+QRegion QVncChangeTracker::changedSince(quint64 since) const
+{
+    QRegion region;
+    for (int row = 0; row < d->rows; row++) {
+        for (int column = 0; column < d->columns; column++) {
+            if (d->tile(column, row).token > since)
+                region += d->tileRect(column, row);
+        }
+    }
+    return region;
+}
+
+/*!
+    Returns the number of milliseconds since a tile touching \a area last
+    changed. A null \a area means the whole framebuffer.
+*/
+qint64 QVncChangeTracker::msecsSinceChange(const QRect &area) const
+{
+    qint64 latest = d->rebuiltAt;
+    const QRect range = d->tileRange(area);
+    for (int row = range.top(); row <= range.bottom(); row++) {
+        for (int column = range.left(); column <= range.right(); column++)
+            latest = qMax(latest, d->tile(column, row).changedAt);
+    }
+    return (d->clock.nsecsElapsed() - latest) / 1000000;
+}
+
+/*!
+    Returns a checksum of the tiles touching \a area, computed from the
+    tile hashes without reading the framebuffer. A null \a area means the
+    whole framebuffer.
+
+    The checksum is the same for the same contents as long as the tile
+    size does not change. It is only meaningful within one process.
+*/
+quint64 QVncChangeTracker::checksum(const QRect &area) const
+{
+    size_t checksum = 0;
+    const QRect range = d->tileRange(area);
+    for (int row = range.top(); row <= range.bottom(); row++) {
+        for (int column = range.left(); column <= range.right(); column++)
+            checksum = qHash(d->tile(column, row).hash, checksum);
+    }
+    return checksum;
+}
+
+/*!
+    Waits until no tile touching \a area has changed for \a msecs
+    milliseconds, processing events in the meantime. Returns \c true once
+    the area is stable, or \c false if it is still changing after \a timeout
+    milliseconds. A null \a area means the whole framebuffer.
+*/
+bool QVncChangeTracker::waitForStable(const QRect &area, int msecs, int timeout)
+{
+    QElapsedTimer waiting;
+    waiting.start();
+    for (;;) {
+        const qint64 quiet = msecsSinceChange(area);
+        if (quiet >= msecs)
+            return true;
+        const qint64 remaining = timeout - waiting.elapsed();
+        if (remaining <= 0)
+            return false;
+        // Changes in the meantime are seen by the next check
+        QEventLoop loop;
+        QTimer::singleShot(int(qMin(msecs - quiet, remaining)), &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+}
+
+QT_END_NAMESPACE
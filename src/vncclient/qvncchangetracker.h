@@ -0,0 +1,53 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef QVNCCHANGETRACKER_H
+#define QVNCCHANGETRACKER_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QObject>
+#include <QtCore/QRect>
+#include <QtCore/QScopedPointer>
+#include <QtGui/QRegion>
+
+QT_BEGIN_NAMESPACE
+
+class QVncClient;
+
+class Q_VNCCLIENT_EXPORT QVncChangeTracker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVncClient *client READ client WRITE setClient NOTIFY clientChanged)
+    Q_PROPERTY(int tileSize READ tileSize WRITE setTileSize NOTIFY tileSizeChanged)
+    Q_PROPERTY(quint64 changeToken READ changeToken NOTIFY changed)
+public:
+    explicit QVncChangeTracker(QObject *parent = nullptr);
+    ~QVncChangeTracker() override;
+
+    QVncClient *client() const;
+    int tileSize() const;
+
+    quint64 changeToken() const;
+    bool hasChanged(const QRect &area, quint64 since) const;
+    QRegion changedSince(quint64 since) const;
+    qint64 msecsSinceChange(const QRect &area = QRect()) const;
+    quint64 checksum(const QRect &area = QRect()) const;
+
+    bool waitForStable(const QRect &area, int msecs, int timeout = 30000);
+
+public slots:
+    void setClient(QVncClient *client);
+    void setTileSize(int size);
+
+signals:
+    void clientChanged(QVncClient *client);
+    void tileSizeChanged(int size);
+    void changed(const QRegion &tiles, quint64 token);
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCCHANGETRACKER_H
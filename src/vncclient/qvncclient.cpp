@@ -33,22 +33,42 @@
 // For Qt Help integration, build with: qdoc src/vncclient/vncclient.qdocconf
 //
 #include "qvncclient.h"
+#include "qvnccursorcache_p.h"
+#include "qvncdamagetracker_p.h"
+#include "qvncdecodequeue_p.h"
 #include "qvncdes_p.h"
+#include "qvncencodingtuner_p.h"
+#include "qvncframebuffermemory_p.h"
+#include "qvncfrontbuffers_p.h"
+#include "qvnch264decoder_p.h"
+#include "qvncjpegdecoder_p.h"
+#include "qvncpixel_p.h"
+#include "qvncpixelformat_p.h"
+#include "qvncreceivebuffer_p.h"
+#include "qvncscratchbuffer_p.h"
+#include "qvncsendbuffer_p.h"
+#include "qvncsessionrecording_p.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QTimer>
 #include <QtCore/QtEndian>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
 #include <QtCore/QByteArray>
+#include <QtCore/QVarLengthArray>
 #include <QtCore/QVector>
-#include <QtGui/QPainter>
+#include <algorithm>
+#include <array>
 
 // Include for Tight encoding
 #ifdef USE_ZLIB
-#include <zlib.h>
+#include "qvnczlib_p.h"
 #endif
 
 #if QT_CONFIG(ssl)
+#include <QtNetwork/QSslConfiguration>
 #include <QtNetwork/QSslSocket>
 #endif
 
@@ -110,6 +130,9 @@ public:
         KeyEvent = 0x04,                 ///< Key press/release event
         PointerEvent = 0x05,             ///< Mouse movement/button event
         ClientCutText = 0x06,            ///< Client sends clipboard text
+        SetScale = 0x08,                 ///< UltraVNC: send the framebuffer scaled down
+        EnableContinuousUpdates = 150,   ///< Start or stop unrequested updates
+        ClientFence = 248,               ///< Fence request or response
     };
 
     /*!
@@ -123,6 +146,23 @@ public:
     enum ServerMessageType {
         FramebufferUpdate = 0x00, ///< Server sends framebuffer update data
         ServerCutText = 0x03,     ///< Server sends clipboard text
+        EndOfContinuousUpdates = 150, ///< Continuous updates supported, or stopped
+        ServerFence = 248,        ///< Fence request or response
+    };
+
+    /*!
+        \internal
+        \enum QVncClient::Private::FenceFlag
+        \brief Flags of Fence messages.
+
+        The client handles messages strictly in order, so it can honour all
+        of the ordering flags by simply answering.
+    */
+    enum FenceFlag : quint32 {
+        FenceBlockBefore = 1u << 0,   ///< Earlier messages are processed first
+        FenceBlockAfter = 1u << 1,    ///< Later messages wait for the response
+        FenceSyncNext = 1u << 2,      ///< The next message is processed on its own
+        FenceRequest = 1u << 31,      ///< Response expected
     };
 
     /*!
@@ -142,9 +182,16 @@ public:
 #ifdef USE_ZLIB
         Tight = 7,       ///< Tight encoding (with zlib compression and JPEG)
 #endif
+        OpenH264 = 50,   ///< Open H.264: an H.264 stream per rectangle
         // Pseudo-encodings (negative values per RFB spec)
         CursorPseudoEncoding = -239,    ///< RichCursor: server sends cursor shape
         CursorPosPseudoEncoding = -232, ///< CursorPos: server sends cursor position
+        DesktopSizePseudoEncoding = -223, ///< Framebuffer size changes
+        ExtendedDesktopSizePseudoEncoding = -308, ///< Size changes with the screen layout
+        FencePseudoEncoding = -312,      ///< Fence messages
+        ContinuousUpdatesPseudoEncoding = -313, ///< Updates without requests
+        QualityLevel0PseudoEncoding = -32,   ///< Tight JPEG quality, -32 + level 0-9
+        CompressLevel0PseudoEncoding = -256, ///< Tight zlib level, -256 + level 0-9
 #ifdef USE_ZLIB
         ExtendedClipboardPseudoEncoding = -1063131698, ///< 0xC0A1E5CE: Extended clipboard
 #endif
@@ -186,56 +233,21 @@ public:
         data for handling Tight encoding. ZLIB support is optional.
     */
     struct TightData {
-        z_stream zlibStream[4];      ///< Zlib streams for compression channels
-        bool zlibStreamActive[4];    ///< Whether each zlib stream is active
-        int jpegQuality;             ///< JPEG quality level (0-100)
-        int compressionLevel;        ///< Compression level (1-9)
-
-        TightData() : jpegQuality(75), compressionLevel(6) {
-            for (int i = 0; i < 4; i++) {
-                zlibStreamActive[i] = false;
-            }
-        }
-        
-        ~TightData() {
-            resetZlibStreams();
-        }
-        
+        QVncInflater zlibStream[4];  ///< Zlib streams for compression channels
+        QVncScratchBuffer inflateBuffer[4]; ///< Inflate output of each stream, reused
+
         void resetZlibStreams() {
-            for (int i = 0; i < 4; i++) {
-                if (zlibStreamActive[i]) {
-                    inflateEnd(&zlibStream[i]);
-                    zlibStreamActive[i] = false;
-                }
-            }
+            for (int i = 0; i < 4; i++)
+                zlibStream[i].end();
         }
     };
 #endif
 
     /*!
         \internal
-        \struct QVncClient::Private::PixelFormat
-        \brief Describes the pixel data format used in VNC communication.
-        
-        This structure follows the RFB protocol specification for pixel format
-        descriptors. It specifies how pixel data is encoded, including bit depth,
-        color channel information, and endianness.
+        \brief Pixel format descriptor as used in ServerInit and SetPixelFormat.
     */
-    struct PixelFormat {
-        quint8 bitsPerPixel = 0;     ///< Bits per pixel (typically 8, 16, or 32)
-        quint8 depth = 0;            ///< Color depth
-        quint8 bigEndianFlag = 0;    ///< 1 if big-endian, 0 if little-endian
-        quint8 trueColourFlag = 0;   ///< 1 if true color, 0 if color map
-        quint16_be redMax;           ///< Maximum value for red channel
-        quint16_be greenMax;         ///< Maximum value for green channel
-        quint16_be blueMax;          ///< Maximum value for blue channel
-        quint8 redShift = 0;         ///< Bit shift for red channel
-        quint8 greenShift = 0;       ///< Bit shift for green channel
-        quint8 blueShift = 0;        ///< Bit shift for blue channel
-        quint8 padding1 = 0;         ///< Padding (unused)
-        quint8 padding2 = 0;         ///< Padding (unused)
-        quint8 padding3 = 0;         ///< Padding (unused)
-    };
+    using PixelFormat = QVncPixelFormat;
 
     /*!
         \internal
@@ -272,8 +284,78 @@ public:
 
     void restartFramebufferUpdates();
 
+    /*!
+        \internal
+        \brief Asks for the next framebuffer update, or schedules the request
+        for when updateInterval has passed since the previous one.
+    */
+    void requestNextUpdate();
+
+    // A request is outstanding or about to be sent by requestTimer
+    bool requestScheduled() const { return updateRequestPending || requestTimer->isActive(); }
+
+    /*!
+        \internal
+        \brief Switches between continuous updates and throttled requests.
+    */
+    void applyUpdateInterval();
+
+    /*!
+        \internal
+        \brief Switches to the pixel format for the current preference.
+
+        The format is changed right away when no update is outstanding,
+        otherwise once the current one has been received, so that no
+        rectangle is ever decoded with the wrong format.
+    */
+    void requestPixelFormatChange();
+
+    /*!
+        \internal
+        \brief Sends encodingList() if it differs from what the server has.
+    */
+    void sendEncodings();
+
+    /*!
+        \internal
+        \brief Returns the part of the framebuffer that updates are requested for.
+
+        That is the viewport clipped to the framebuffer, or all of the
+        framebuffer when there is no viewport or it lies outside.
+    */
+    QRect requestArea() const;
+
+    /*!
+        \internal
+        \brief Requests the new viewport in full.
+
+        Pixels outside the previous viewport are stale. With continuous
+        updates the server is also told about the new area; otherwise the
+        request is sent once the outstanding one has been answered.
+    */
+    void requestViewport();
+
+    /*!
+        \internal
+        \brief Sends SetScale if the scale differs from what the server has.
+    */
+    void sendServerScale();
+
+    /*!
+        \internal
+        \brief Keeps \a count front buffers for frame().
+
+        The framebuffer is published right away unless an update is being
+        received, so frame() does not stay empty until the next one.
+    */
+    void setFrontBufferCount(int count) {
+        frontBuffers.setCount(count);
+        if (!fbu.active && !fbu.finishPending)
+            frontBuffers.publish(image, QRegion());
+    }
+
 private:
-    void reset();
+    void reset(bool keepFramebuffer = false);
 
     /*!
         \internal
@@ -292,58 +374,157 @@ private:
         appropriate parsing function based on the current protocol state.
     */
     void read();
+
+    /*!
+        \internal
+        \brief Moves what the socket has into the receive buffer.
+        \return The number of bytes added.
+    */
+    qint64 fillReceiveBuffer();
+
+    // Position in the stream received from the server of what is parsed next
+    qint64 streamPosition() const { return bytesReceived - receiveBuffer.bytesAvailable(); }
+
+    /*!
+        \internal
+        \brief Returns true once the current read() pass has used up the
+        time or byte budget and should let the event loop run.
+    */
+    bool readBudgetExceeded() const {
+        if (readByteBudget > 0 && streamPosition() - readPass.startPosition >= readByteBudget)
+            return true;
+        return readTimeBudget > 0 && clock.nsecsElapsed() - readPass.startTime >= readTimeBudget * qint64(1000000);
+    }
     
     /*!
         \internal
-        \brief Reads a binary structure from the socket.
+        \brief Reads a binary structure from the receive buffer.
         \param out Pointer to the structure to be filled with data.
         \tparam T The type of structure to read.
         
-        Reads binary data from the socket directly into the provided structure.
+        Copies binary data from the receive buffer into the provided structure.
     */
     template<class T>
     void read(T *out) {
-        if (isValid())
-            socket->read(reinterpret_cast<char *>(out), sizeof(T));
+        receiveBuffer.read(reinterpret_cast<char *>(out), sizeof(T));
     }
     
     /*!
         \internal
-        \brief Writes a string to the socket.
+        \brief Writes a string to the server.
         \param out The null-terminated string to write.
         
-        Sends string data to the VNC server.
+        Appends string data to the send buffer.
     */
     void write(const char *out) {
-        if (isValid())
-            socket->write(out, strlen(out));
+        if (isValid()) {
+            sendBuffer.append(out, qsizetype(strlen(out)));
+            flushUnlessBatching();
+        }
     }
     
     /*!
         \internal
-        \brief Writes binary data to the socket.
+        \brief Writes binary data to the server.
         \param out The binary data to write.
         \param len The length of the data in bytes.
         
-        Sends raw binary data to the VNC server.
+        Appends raw binary data to the send buffer.
     */
     void write(const unsigned char *out, int len) {
-        if (isValid())
-            socket->write(reinterpret_cast<const char *>(out), len);
+        if (isValid()) {
+            sendBuffer.append(out, len);
+            flushUnlessBatching();
+        }
+    }
+
+    void write(const QByteArray &out) {
+        if (isValid()) {
+            sendBuffer.append(out);
+            flushUnlessBatching();
+        }
     }
     
     /*!
         \internal
-        \brief Writes a binary structure to the socket.
+        \brief Writes a binary structure to the server.
         \param out The structure to write.
         \tparam T The type of structure to write.
         
-        Sends binary structure data to the VNC server.
+        Appends binary structure data to the send buffer.
     */
     template<class T>
     void write(const T &out) {
-        if (isValid())
-            socket->write(reinterpret_cast<const char *>(&out), sizeof(T));
+        if (isValid()) {
+            sendBuffer.append(&out, sizeof(T));
+            flushUnlessBatching();
+        }
+    }
+
+    /*!
+        \internal
+        \brief Writes the send buffer to the socket in one go.
+    */
+    void flushSendBuffer() {
+        sendBuffer.flush(isValid() ? socket : nullptr);
+    }
+
+    void flushUnlessBatching() {
+        if (!sendBuffer.isBatching())
+            flushSendBuffer();
+    }
+
+    // Collects what is written while it exists into one socket write.
+    // Every message is built inside one, so it leaves contiguously.
+    class SendBatch
+    {
+    public:
+        explicit SendBatch(Private *d) : d(d) { d->sendBuffer.beginBatch(); }
+        ~SendBatch() { if (d->sendBuffer.endBatch()) d->flushSendBuffer(); }
+    private:
+        Q_DISABLE_COPY(SendBatch)
+        Private *d;
+    };
+
+    /*!
+        \internal
+        \brief Returns the pixel format to request for the current preference.
+    */
+    PixelFormat preferredPixelFormat() const {
+        switch (pixelFormatPreference) {
+        case QVncClient::PixelFormatNative:
+            return PixelFormat::native();
+        case QVncClient::PixelFormatRgb565:
+            return PixelFormat::rgb565();
+        case QVncClient::PixelFormatBgr233:
+            return PixelFormat::bgr233();
+        case QVncClient::PixelFormatServer:
+            break;
+        }
+        return serverPixelFormat;
+    }
+
+    /*!
+        \internal
+        \brief Sends the preferred pixel format and rebuilds the converters.
+        \return true if the pixel format changed.
+    */
+    bool applyPixelFormat();
+
+    /*!
+        \internal
+        \brief Rebuilds the pixel converters after the pixel format changed.
+
+        PIXEL, CPIXEL (ZRLE) and TPIXEL (Tight) may differ in size, so each
+        gets its own converter.
+    */
+    void updatePixelConverters() {
+        pixelConverter = QVncPixelConverter(pixelFormat, pixelFormat.bitsPerPixel / 8);
+        cpixelConverter = QVncPixelConverter(pixelFormat, pixelFormat.cpixelSize());
+        tpixelConverter = QVncPixelConverter(pixelFormat, pixelFormat.tpixelSize());
+        // Cached cursor shapes are keyed on bytes in the old format
+        cursorCache.clear();
+        cursorKey.clear();
     }
 
     /// Handshaking Messages
@@ -459,7 +640,7 @@ private:
         Configures the pixel format that the server should use when sending
         framebuffer updates.
     */
-    void setPixelFormat();
+    void setPixelFormat(const PixelFormat &format);
     
     /*!
         \internal
@@ -469,6 +650,15 @@ private:
         Tells the server which encoding types the client prefers for framebuffer updates.
     */
     void setEncodings(const QList<qint32> &encodings);
+
+    /*!
+        \internal
+        \brief Returns the encodings to announce, in order of preference.
+
+        The order and the Tight levels come from the encoding tuner unless
+        the application set them explicitly.
+    */
+    QList<qint32> encodingList() const;
     
     /*!
         \internal
@@ -498,6 +688,104 @@ private:
     */
     void framebufferUpdate();
     void processFramebufferRects();
+    void finishFramebufferUpdate();
+
+    /*!
+        \internal
+        \brief Makes sure the framebuffer is not shared before writing to it.
+
+        Detaching copies the pixels, so any decode job still writing into
+        the old buffer has to finish first.
+    */
+    void detachFramebuffer() {
+        if (!image.isDetached())
+            decodeQueue.waitForDone();
+        image.detach();
+    }
+
+    QVncPixelWriter framebufferWriter() {
+        detachFramebuffer();
+        return QVncPixelWriter(image);
+    }
+
+    /*!
+        \internal
+        \brief Returns \a size bytes of \a data that stay valid for a decode job.
+
+        Decoding synchronously reads straight from the receive buffer. With
+        decode workers the bytes are copied into \a owner, which the job has
+        to capture.
+    */
+    const uchar *keepPayload(const uchar *data, qint64 size, QByteArray *owner) const {
+        if (!decodeQueue.isEnabled())
+            return data;
+        *owner = QByteArray(reinterpret_cast<const char *>(data), size);
+        return reinterpret_cast<const uchar *>(owner->constData());
+    }
+
+    /*!
+        \internal
+        \brief Writes the pixels of \a rect through \a decode.
+
+        Runs \a decode right away, or on a decode worker when threaded
+        decoding is enabled, in which case the change is reported once it
+        is done. \a reads is any other part of the framebuffer that \a decode
+        reads from, as for CopyRect.
+    */
+    template <typename Decode>
+    void decodeRect(const Rectangle &rect, Decode &&decode, const QRect &reads = QRect()) {
+        QVncPixelWriter writer = framebufferWriter();
+        if (!decodeQueue.isEnabled()) {
+            decode(writer);
+            return;
+        }
+        const QRect area(rect.x, rect.y, rect.w, rect.h);
+        fbu.rectQueued = true;
+        // Written by the job before it reports back, read in the callback
+        auto timing = std::make_shared<DecodeTiming>();
+        decodeQueue.start(area.united(reads),
+                          [this, writer, decode = std::forward<Decode>(decode), timing,
+                           received = lastFillTime]() mutable {
+                              const qint64 started = clock.nsecsElapsed();
+                              decode(writer);
+                              timing->queueDelay = started - received;
+                              timing->nsecs = clock.nsecsElapsed() - started;
+                          },
+                          [this, area, timing, encoding = fbu.encoding]() {
+                              statistics.encodings[encoding].decodeNsecs += timing->nsecs;
+                              addQueueDelay(timing->queueDelay);
+                              rectChanged(area);
+                          });
+    }
+
+    struct DecodeTiming {
+        qint64 queueDelay = 0;
+        qint64 nsecs = 0;
+    };
+
+    void addQueueDelay(qint64 nsecs) {
+        ++statistics.queueDelaySamples;
+        statistics.queueDelayNsecs += nsecs;
+        statistics.maxQueueDelayNsecs = qMax(statistics.maxQueueDelayNsecs, nsecs);
+    }
+
+    void addRoundTrip(qint64 nsecs) {
+        statistics.roundTripNsecs = nsecs;
+        if (statistics.minRoundTripNsecs < 0 || nsecs < statistics.minRoundTripNsecs)
+            statistics.minRoundTripNsecs = nsecs;
+    }
+
+    /*!
+        \internal
+        \brief Reports that the pixels in \a area were written.
+
+        Emits imageChanged() right away and adds \a area to the damage that
+        imageRegionChanged() reports when the update is complete.
+    */
+    void rectChanged(const QRect &area) {
+        emit q->imageChanged(area);
+        damage.add(area);
+    }
     
     /*!
         \internal
@@ -507,7 +795,9 @@ private:
         Processes uncompressed pixel data for the specified rectangle.
     */
     bool handleRawEncoding(const Rectangle &rect);
+    bool handleCopyRectEncoding(const Rectangle &rect);
     bool handleHextileEncoding(const Rectangle &rect);
+    void decodeHextile(const uchar *p, const Rectangle &rect, QVncPixelWriter &writer) const;
 #ifdef USE_ZLIB
     bool handleTightEncoding(const Rectangle &rect);
 #endif
@@ -516,27 +806,27 @@ private:
         \internal
         \brief Processes a JPEG-compressed rectangle in Tight encoding.
         \param rect The rectangle dimensions.
+        \param data The JPEG data.
         \param dataLength The length of the JPEG data in bytes.
         \return true if successful, false if there was an error.
         
-        Reads and decompresses JPEG image data for a rectangle in Tight encoding.
+        Decompresses JPEG image data for a rectangle in Tight encoding.
     */
-    bool handleTightJpeg(const Rectangle &rect, int dataLength);
+    bool handleTightJpeg(const Rectangle &rect, const uchar *data, int dataLength);
     
 #ifdef USE_ZLIB
     /*!
         \internal
         \brief Decompresses zlib data for Tight encoding.
-        \param rect The rectangle dimensions.
-        \param stream The zlib stream to use.
+        \param streamId The zlib stream to use.
         \param data The compressed data.
-        \param dataLength The length of the compressed data.
+        \param size The length of the compressed data.
         \param expectedBytes The expected size of the decompressed data.
         \return The decompressed data, or an empty array on error.
         
         Decompresses zlib-compressed data for a Tight-encoded rectangle.
     */
-    QByteArray decompressTightData(int streamId, const QByteArray &data, int expectedBytes);
+    QByteArray decompressTightData(int streamId, const uchar *data, int size, int expectedBytes);
 #endif
 
     /*!
@@ -547,12 +837,54 @@ private:
         Processes ZRLE (Zlib Run-Length Encoding) data for the specified rectangle.
     */
     bool handleZRLEEncoding(const Rectangle &rect);
+    void decodeZrle(const QByteArray &data, const Rectangle &rect, QVncPixelWriter &writer) const;
+    int decodeZrleTile(const uchar *buf, int bufSize, int dataOffset,
+                       int px, int py, int tw, int th, QVncPixelWriter &writer) const;
+
+    /*!
+        \internal
+        \brief Handles Open H.264 rectangle data.
+        \param rect The rectangle dimensions.
+
+        Decodes the next frame of the H.264 stream of the rectangle.
+    */
+    bool handleOpenH264Encoding(const Rectangle &rect);
 
     bool handleRichCursorEncoding(const Rectangle &rect);
     bool handleCursorPosEncoding(const Rectangle &rect);
+    bool handleDesktopSizeEncoding(const Rectangle &rect);
+    bool handleExtendedDesktopSizeEncoding(const Rectangle &rect);
+    void resizeFramebuffer(int width, int height);
+    void setScreens(const QList<QVncScreen> &layout);
 
     bool serverCutText();
 
+    /*!
+        \internal
+        \brief Handles a Fence message: answers requests and matches responses.
+        \return false if the message is not complete yet.
+    */
+    bool serverFence();
+
+    /*!
+        \internal
+        \brief Handles EndOfContinuousUpdates.
+
+        Sent once when the server learns that the client supports continuous
+        updates, and again whenever the server stops sending them.
+    */
+    void endOfContinuousUpdates();
+
+    void sendFence(quint32 flags, const QByteArray &payload);
+    void enableContinuousUpdates(bool enable);
+
+    /*!
+        \internal
+        \brief Switches to continuous updates once the server supports both
+        them and fences, which make pixel format switches safe.
+    */
+    void startContinuousUpdates();
+
 #ifdef USE_ZLIB
     enum ClipboardFormat : quint32 {
         ClipboardText  = 0x00000001,
@@ -583,6 +915,10 @@ private:
     QTcpSocket *prev = nullptr;                 ///< Previous socket for cleanup
     HandshakingState state = ProtocolVersionState; ///< Current protocol state
     bool reading = false;                           ///< Reentrancy guard for read()
+    struct {
+        qint64 startTime = 0;          ///< clock ns when the pass started
+        qint64 startPosition = 0;      ///< streamPosition() when the pass started
+    } readPass;                                     ///< The read() pass in progress
     qint16 pendingServerMessage = -1;               ///< Saved message type when handler needs more data
 
     // Framebuffer update state for non-blocking processing
@@ -593,20 +929,46 @@ private:
         int encoding = -1;
         bool active = false;       ///< Currently processing a framebuffer update
         bool rectHeaderRead = false; ///< Current rect header has been read
-        // Hextile resume state
+        bool rectQueued = false;   ///< Current rect was handed to the decode workers
+        bool finishPending = false; ///< Update parsed, waiting for decode workers
+        qint64 startOffset = 0;    ///< Stream position of the update, for the tuner
+        qint64 requestTime = -1;   ///< When the request it answers was sent, or -1
+        qint64 rectOffset = 0;     ///< Stream position of the current rect header
+        qint64 rectNsecs = 0;      ///< Spent in the current rect's handler so far
+        // Hextile scan resume state
         int hextileTY = 0;
         int hextileTX = 0;
-        quint32 hextileBG = 0;
-        quint32 hextileFG = 0;
+        qint64 hextileOffset = 0;
     } fbu;
+    QVncDamageTracker damage;                   ///< Area changed by the current update
+    PixelFormat serverPixelFormat;              ///< Pixel format announced in ServerInit
     PixelFormat pixelFormat;                    ///< Current pixel format
-    QMap<int, quint32> keyMap;                  ///< Map from Qt keys to VNC key codes
+    QVncPixelConverter pixelConverter;          ///< Converter for PIXEL values
+    QVncPixelConverter cpixelConverter;         ///< Converter for ZRLE CPIXEL values
+    QVncPixelConverter tpixelConverter;         ///< Converter for Tight TPIXEL values
 public:
     QTcpSocket *socket = nullptr;               ///< Socket for VNC communication
+    QVncReceiveBuffer receiveBuffer;            ///< Data received but not parsed yet
+    QVncSessionRecorder recorder;               ///< Copy of the received stream, if recording
+    qint64 bytesReceived = 0;                   ///< Total read from the socket
+    int readTimeBudget = 0;                     ///< Per read() pass in ms, 0 for none
+    qint64 readByteBudget = 0;                  ///< Per read() pass, 0 for none
+    QTimer *readTimer = nullptr;                ///< Continues a pass that ran out of budget
+    QVncSendBuffer sendBuffer;                  ///< Messages not written to the socket yet
+    QVncStatistics statistics;                  ///< See QVncClient::statistics()
+    qint64 lastFillTime = -1;                   ///< When data was last read from the socket, clock ns
+    bool lowDelay = false;                      ///< Sets QAbstractSocket::LowDelayOption
+    bool fastReconnect = false;                 ///< Keep the framebuffer across connections
+    bool lazyFramebuffer = false;               ///< Framebuffer pages allocated on first write
+    bool initPipelined = false;                 ///< Set-up and first request went out with ClientInit
+#if QT_CONFIG(ssl)
+    QString tlsSessionPeer;                     ///< host:port the ticket was issued by
+    QByteArray tlsSessionTicket;                ///< For resuming the TLS session on reconnect
+#endif
 #ifdef USE_ZLIB
     QScopedPointer<TightData> tightData;        ///< Data for Tight encoding
-    z_stream zrleStream;
-    bool zrleStreamActive = false;
+    QVncInflater zrleStream;
+    QVncScratchBuffer zrleBuffer;               ///< ZRLE inflate output, reused
 #endif
     ProtocolVersion protocolVersion = ProtocolVersionUnknown; ///< Current protocol version
     SecurityType securityType = SecurityTypeUnknwon;         ///< Current security type
@@ -615,27 +977,75 @@ public:
     QByteArray vncChallenge;                     ///< Stored challenge for deferred VNC auth
     quint32 veNCryptSubType = 0;                 ///< Selected VeNCrypt sub-type
     QImage image;                               ///< Image containing the framebuffer
+    QVncFrontBuffers frontBuffers;              ///< Completed frames, if buffered
+    QVncClient::BufferingMode bufferingMode = QVncClient::SingleBuffered;
     int frameBufferWidth = 0;                   ///< Framebuffer width
     int frameBufferHeight = 0;                  ///< Framebuffer height
+    struct {
+        const uchar *bits = nullptr;
+        int rows = 0;              ///< At image's stride
+    } framebufferMemory;                        ///< What image was allocated with
+    QList<QVncScreen> screenLayout;             ///< From ExtendedDesktopSize, or empty
     bool framebufferUpdatesEnabled = true;      ///< Controls automatic FramebufferUpdateRequests
+    bool updateRequestPending = false;          ///< A FramebufferUpdateRequest is unanswered
+    bool refreshPending = false;                ///< Next request is non-incremental
+    int updateInterval = 0;                     ///< Minimum time between requests, in ms
+    qint64 lastRequestTime = 0;                 ///< When the last request was sent, clock ns
+    bool lastRequestIncremental = false;        ///< Full requests are answered right away
+    qint64 fenceRequestTime = -1;               ///< When our fence request was sent, or -1
+    QTimer *requestTimer = nullptr;             ///< Sends a throttled request
+    QRect viewport;                             ///< Area to request, empty for all
+    int serverScale = 1;                        ///< Requested SetScale divisor
+    int sentServerScale = 1;                    ///< Last SetScale sent
+    bool fenceSupported = false;                ///< Server sent a Fence
+    bool continuousUpdatesSupported = false;    ///< Server sent EndOfContinuousUpdates
+    bool continuousUpdatesActive = false;       ///< Server sends updates without requests
+    bool pixelFormatFencePending = false;       ///< Waiting for the switch to fencedPixelFormat
+    PixelFormat fencedPixelFormat;              ///< Format sent after a SyncNext fence
+    QVncEncodingTuner encodingTuner;            ///< Measures the link, picks levels
+    QElapsedTimer clock;                        ///< Time base for the tuner
+    QList<qint32> sentEncodings;                ///< Last SetEncodings sent
+    int qualityLevel = -1;                      ///< Explicit Tight quality, or -1
+    int compressionLevel = -1;                  ///< Explicit Tight compression, or -1
+    QVncClient::PixelFormatPreference pixelFormatPreference = QVncClient::PixelFormatServer;
+    bool pixelFormatPending = false;            ///< Preference changed while an update was due
 
     // Cursor state (from pseudo-encodings)
     QImage cursorImage;                         ///< Cursor shape with alpha from bitmask
+    QByteArray cursorKey;                       ///< Cursor cache key of cursorImage
+    QVncCursorCache cursorCache;                ///< Shapes seen before, by content
     QPoint cursorHotspot;                       ///< Hotspot within cursor image
     QPoint cursorPos;                           ///< Last known cursor position from server
 
+    // Pointer state, for coalescing moves
+    int pointerEventInterval = 0;               ///< Minimum time between moves, in ms
+    quint8 pointerButtons = 0;                  ///< Button mask of the last PointerEvent
+    qint64 lastPointerTime = -1;                ///< When the last PointerEvent was sent, clock ns
+    bool pointerMovePending = false;            ///< A move waits for pointerTimer
+    QPoint pendingPointerPos;                   ///< Position of that move
+    QTimer *pointerTimer = nullptr;             ///< Sends the pending move
+
+    void sendPointerEvent(quint8 buttonMask, const QPoint &pos);
+    void flushPointerMove();
+    void applyLowDelay();
+
     void clientCutText(const QString &text);
     void clientCutImage(const QImage &image);
 
 #ifdef USE_ZLIB
     bool extendedClipboard = false;
-    z_stream clipboardInflateStream;
-    bool clipboardInflateActive = false;
-    z_stream clipboardDeflateStream;
-    bool clipboardDeflateActive = false;
+    QVncInflater clipboardInflateStream;
+    QVncScratchBuffer clipboardBuffer;          ///< Clipboard inflate output, reused
+    QVncDeflater clipboardDeflateStream;
     QString pendingClipboardText;
     QImage pendingClipboardImage;
 #endif
+
+    QVncJpegDecoder jpegDecoder;                ///< Tight JPEG decoder, shared by decode jobs
+    QVncH264Decoder h264Decoder;                ///< Open H.264 streams, one per rectangle
+
+    // Last, so that it is destroyed first: jobs still running reference the members above
+    QVncDecodeQueue decodeQueue;                ///< Decode workers for threaded decoding
 };
 
 /*!
@@ -649,52 +1059,33 @@ QVncClient::Private::Private(QVncClient *parent)
 #ifdef USE_ZLIB
     , tightData(new TightData())
 #endif
+    , decodeQueue(parent)
 {
-    const QList<quint32> keyList {
-        // Key mappings
-        Qt::Key_Backspace, 0xff08,
-        Qt::Key_Tab, 0xff09,
-        Qt::Key_Return, 0xff0d,
-        Qt::Key_Enter, 0xff0d,
-        Qt::Key_Insert, 0xff63,
-        Qt::Key_Delete, 0xffff,
-        Qt::Key_Home, 0xff50,
-        Qt::Key_End, 0xff57,
-        Qt::Key_PageUp, 0xff55,
-        Qt::Key_PageDown, 0xff56,
-        Qt::Key_Left, 0xff51,
-        Qt::Key_Up, 0xff52,
-        Qt::Key_Right, 0xff53,
-        Qt::Key_Down, 0xff54,
-        Qt::Key_F1, 0xffbe,
-        Qt::Key_F2, 0xffbf,
-        Qt::Key_F3, 0xffc0,
-        Qt::Key_F4, 0xffc1,
-        Qt::Key_F5, 0xffc2,
-        Qt::Key_F6, 0xffc3,
-        Qt::Key_F7, 0xffc4,
-        Qt::Key_F8, 0xffc5,
-        Qt::Key_F9, 0xffc6,
-        Qt::Key_F10, 0xffc7,
-        Qt::Key_F11, 0xffc8,
-        Qt::Key_F12, 0xffc9,
-        Qt::Key_Shift, 0xffe1,
-        Qt::Key_Control, 0xffe3,
-        Qt::Key_Meta, 0xffe7,
-        Qt::Key_Alt, 0xffe9
-    };
-    for (int i = 0; i < keyList.length(); i+=2) {
-        keyMap.insert(static_cast<int>(keyList.at(i)), keyList.at(i+1));
-    }
+    clock.start();
+    decodeQueue.setIdleHandler([this]() {
+        if (fbu.finishPending)
+            finishFramebufferUpdate();
+    });
+    requestTimer = new QTimer(q);
+    requestTimer->setSingleShot(true);
+    QObject::connect(requestTimer, &QTimer::timeout, q, [this]() { requestNextUpdate(); });
+    readTimer = new QTimer(q);
+    readTimer->setSingleShot(true);
+    QObject::connect(readTimer, &QTimer::timeout, q, [this]() { read(); });
+    pointerTimer = new QTimer(q);
+    pointerTimer->setSingleShot(true);
+    QObject::connect(pointerTimer, &QTimer::timeout, q, [this]() { flushPointerMove(); });
 
     connect(q, &QVncClient::socketChanged, q, [this](QTcpSocket *socket) {
         if (prev) {
             disconnect(prev, nullptr, q, nullptr);
         }
-        reset ();
+        reset(fastReconnect);
+        statistics = QVncStatistics();
 
         if (socket) {
             connect(socket, &QTcpSocket::connected, q, [this]() {
+                applyLowDelay();
                 emit q->connectionStateChanged(true);
                 qCInfo(lcVncClient) << "Connected to VNC server";
                 state = ProtocolVersionState;
@@ -706,11 +1097,12 @@ QVncClient::Private::Private(QVncClient *parent)
                 qCInfo(lcVncClient) << "Disconnected from VNC server";
                 emit q->connectionStateChanged(false);
                 
-                reset();
+                reset(fastReconnect);
             });
             connect(socket, &QTcpSocket::readyRead, q, [this]() {
                 read();
             });
+            applyLowDelay();
         }
         prev = socket;
     });
@@ -722,6 +1114,7 @@ QVncClient::Private::Private(QVncClient *parent)
         securityTypeChanged(securityType);
     });
     connect(q, &QVncClient::passwordChanged, q, [this](const QString &) {
+        SendBatch batch(this);
         if (state == VncAuthenticationState && !vncChallenge.isEmpty() && !password.isEmpty())
             sendVncAuthResponse();
         if (state == PlainAuthenticationState && !username.isEmpty() && !password.isEmpty())
@@ -730,6 +1123,7 @@ QVncClient::Private::Private(QVncClient *parent)
             parseAppleDH();
     });
     connect(q, &QVncClient::usernameChanged, q, [this](const QString &) {
+        SendBatch batch(this);
         if (state == PlainAuthenticationState && !username.isEmpty() && !password.isEmpty())
             sendPlainAuthResponse();
         if (state == AppleDHState && !username.isEmpty() && !password.isEmpty())
@@ -737,86 +1131,185 @@ QVncClient::Private::Private(QVncClient *parent)
     });
 }
 
-void QVncClient::Private::reset()
+/*!
+    \internal
+    Returns to the state before the protocol handshake.
+
+    With \a keepFramebuffer, used by fast reconnects, the framebuffer, the
+    screens and the cursor stay as they are, so the last picture remains
+    visible until the new connection sends a new one. Everything the server
+    keeps per connection, such as the zlib streams, is dropped either way.
+*/
+void QVncClient::Private::reset(bool keepFramebuffer)
 {
+    decodeQueue.clear();
+    fbu.finishPending = false;
+    damage.clear();
     state = ProtocolVersionState;
     q->setProtocolVersion(ProtocolVersionUnknown);
     q->setSecurityType(SecurityTypeUnknwon);
+    receiveBuffer.clear();
     vncChallenge.clear();
     veNCryptSubType = 0;
     fbu.active = false;
     pendingServerMessage = -1;
+    updateRequestPending = false;
+    refreshPending = false;
+    requestTimer->stop();
+    readTimer->stop();
+    sendBuffer.clear();
+    pointerTimer->stop();
+    pointerMovePending = false;
+    pointerButtons = 0;
+    lastPointerTime = -1;
+    sentServerScale = 1;
+    pixelFormatPending = false;
+    fenceSupported = false;
+    fenceRequestTime = -1;
+    fbu.requestTime = -1;
+    continuousUpdatesSupported = false;
+    continuousUpdatesActive = false;
+    pixelFormatFencePending = false;
+    encodingTuner.reset();
+    sentEncodings.clear();
+    initPipelined = false;
+    h264Decoder.reset();
+#ifdef USE_ZLIB
+    zrleStream.end();
+    clipboardInflateStream.end();
+    clipboardDeflateStream.end();
+    if (tightData)
+        tightData->resetZlibStreams();
+    extendedClipboard = false;
+    pendingClipboardText.clear();
+    pendingClipboardImage = QImage();
+#endif
+    if (keepFramebuffer && !image.isNull())
+        return;
+    frontBuffers.clear();
     frameBufferWidth = 0;
     frameBufferHeight = 0;
     image = QImage();
+    framebufferMemory = {};
+    screenLayout.clear();
     cursorImage = QImage();
+    cursorKey.clear();
+    cursorCache.clear();
     cursorHotspot = QPoint();
     cursorPos = QPoint();
-#ifdef USE_ZLIB
-    if (zrleStreamActive) { inflateEnd(&zrleStream); zrleStreamActive = false; }
-    if (clipboardInflateActive) { inflateEnd(&clipboardInflateStream); clipboardInflateActive = false; }
-    if (clipboardDeflateActive) { deflateEnd(&clipboardDeflateStream); clipboardDeflateActive = false; }
-    extendedClipboard = false;
-    pendingClipboardText.clear();
-    pendingClipboardImage = QImage();
-#endif
     emit q->framebufferSizeChanged(0, 0);
+    emit q->screensChanged();
 }
 
 /*!
     \internal
     Main state machine dispatcher for handling incoming socket data based on the current protocol state.
+
+    Everything the socket has is moved into the receive buffer first. The
+    parsers are then run for as long as they make progress, so several
+    messages received in one chunk are handled in one go. When they need
+    more data, whatever reached the socket in the meantime is taken in as
+    well; a message that is still incomplete then waits in the buffer for
+    the next readyRead. The replies to everything handled in a pass are
+    written to the socket together when it ends.
+
+    A pass ends early when it has used up readTimeBudget or readByteBudget,
+    also between the rectangles of a framebuffer update, and continues from
+    a zero timer once the event loop had a turn.
 */
 void QVncClient::Private::read()
 {
-    if (reading)
+    if (reading) {
+        // A handler runs a nested event loop. The pass in progress takes
+        // the new data in once the handler returns.
+        qCDebug(lcVncClientRead) << "Nested read() left to the pass in progress";
         return;
+    }
     reading = true;
-    switch (state) {
-    case ProtocolVersionState:
-        parseProtocolVersion();
-        break;
-    case SecurityState:
-        parseSecurity();
-        break;
-    case VncAuthenticationState:
-        parseVncAuthentication();
-        break;
-    case VeNCryptVersionState:
-        parseVeNCryptVersion();
-        break;
-    case VeNCryptSubTypeState:
-        parseVeNCryptSubTypes();
-        break;
-    case VeNCryptAckState:
-        parseVeNCryptAck();
-        break;
-    case VeNCryptTLSState:
-        break;
-    case PlainAuthenticationState:
-        parsePlainAuthentication();
-        break;
-    case AppleDHState:
-        parseAppleDH();
-        break;
-    case SecurityResultState:
-        parseSecurityResult();
-        break;
-    case ServerInitState:
-        parserServerInit();
-        break;
-    case WaitingState:
-        parseServerMessages();
-        break;
-    default:
-        qDebug() << socket->readAll();
-        break;
+    readTimer->stop();
+    SendBatch batch(this);
+    readPass.startTime = clock.nsecsElapsed();
+    readPass.startPosition = streamPosition();
+    int messages = 0;
+    bool budgetExceeded = false;
+    while (true) {
+        if (receiveBuffer.isEmpty() && fillReceiveBuffer() == 0)
+            break;
+        const qint64 before = receiveBuffer.bytesAvailable();
+        const HandshakingState stateBefore = state;
+        switch (state) {
+        case ProtocolVersionState:
+            parseProtocolVersion();
+            break;
+        case SecurityState:
+            parseSecurity();
+            break;
+        case VncAuthenticationState:
+            parseVncAuthentication();
+            break;
+        case VeNCryptVersionState:
+            parseVeNCryptVersion();
+            break;
+        case VeNCryptSubTypeState:
+            parseVeNCryptSubTypes();
+            break;
+        case VeNCryptAckState:
+            parseVeNCryptAck();
+            break;
+        case VeNCryptTLSState:
+            break;
+        case PlainAuthenticationState:
+            parsePlainAuthentication();
+            break;
+        case AppleDHState:
+            parseAppleDH();
+            break;
+        case SecurityResultState:
+            parseSecurityResult();
+            break;
+        case ServerInitState:
+            parserServerInit();
+            break;
+        case WaitingState:
+            parseServerMessages();
+            break;
+        default:
+            qDebug() << receiveBuffer.readAll();
+            break;
+        }
+        if (receiveBuffer.bytesAvailable() == before && state == stateBefore) {
+            // Waiting for more data; the TLS handshake reads the socket itself
+            if (state == VeNCryptTLSState || fillReceiveBuffer() == 0)
+                break;
+            continue;
+        }
+        ++messages;
+        if (readBudgetExceeded()) {
+            budgetExceeded = true;
+            break;
+        }
     }
     reading = false;
-    // Re-enter if there is buffered data we can still make progress on.
-    // Skip when waiting for more data mid-message to avoid a spin loop.
-    if (socket && socket->bytesAvailable() > 0 && !fbu.active && pendingServerMessage < 0)
-        QMetaObject::invokeMethod(q, [this]() { read(); }, Qt::QueuedConnection);
+    qCDebug(lcVncClientRead).nospace() << "Handled " << messages << " messages, "
+            << streamPosition() - readPass.startPosition << " bytes in "
+            << (clock.nsecsElapsed() - readPass.startTime) / 1000 << " us"
+            << (budgetExceeded ? ", out of budget" : "");
+    if (budgetExceeded)
+        readTimer->start(0);
+}
+
+qint64 QVncClient::Private::fillReceiveBuffer()
+{
+    const qint64 received = receiveBuffer.fill(socket);
+    bytesReceived += received;
+    if (received > 0) {
+        statistics.bytesReceived += received;
+        lastFillTime = clock.nsecsElapsed();
+        encodingTuner.dataReceived(bytesReceived, lastFillTime);
+    }
+    if (received > 0 && recorder.isOpen())
+        recorder.write(receiveBuffer.data() + receiveBuffer.bytesAvailable() - received, received);
+    return received;
 }
 
 #ifdef USE_ZLIB
@@ -831,132 +1324,68 @@ void QVncClient::Private::read()
 */
 bool QVncClient::Private::handleTightEncoding(const Rectangle &rect)
 {
-    if (socket->bytesAvailable() < 1) return false;
-
-    // Calculate TPIXEL size: 3 bytes when bpp=32, trueColor, all maxes == 255
-    const int tpixelSize = (pixelFormat.bitsPerPixel == 32 && pixelFormat.trueColourFlag
-        && pixelFormat.redMax == 255 && pixelFormat.greenMax == 255
-        && pixelFormat.blueMax == 255) ? 3 : (pixelFormat.bitsPerPixel / 8);
-
-    // Helper to read a TPIXEL from a byte buffer
-    auto readTPixel = [&](const char *data, int &off) -> quint32 {
-        quint32 color = 0;
-        if (tpixelSize == 3) {
-            if (pixelFormat.bigEndianFlag) {
-                color = (static_cast<quint8>(data[off]) << 16)
-                      | (static_cast<quint8>(data[off + 1]) << 8)
-                      | static_cast<quint8>(data[off + 2]);
-            } else {
-                color = static_cast<quint8>(data[off])
-                      | (static_cast<quint8>(data[off + 1]) << 8)
-                      | (static_cast<quint8>(data[off + 2]) << 16);
-            }
-        } else if (tpixelSize == 4) {
-            memcpy(&color, data + off, 4);
-        } else if (tpixelSize == 2) {
-            quint16 c16; memcpy(&c16, data + off, 2); color = c16;
-        } else {
-            color = static_cast<quint8>(data[off]);
-        }
-        off += tpixelSize;
-        return color;
-    };
+    const qint64 available = receiveBuffer.bytesAvailable();
+    if (available < 1) return false;
+    const uchar *p = receiveBuffer.data();
 
-    auto toRgb = [&](quint32 color) -> QRgb {
-        const auto r = (color >> pixelFormat.redShift) & pixelFormat.redMax;
-        const auto g = (color >> pixelFormat.greenShift) & pixelFormat.greenMax;
-        const auto b = (color >> pixelFormat.blueShift) & pixelFormat.blueMax;
-        return qRgb(r, g, b);
-    };
+    // TPIXEL size: 3 bytes when bpp=32, trueColor, all maxes == 255
+    const QVncPixelConverter &converter = tpixelConverter;
+    const int tpixelSize = converter.bytesPerPixel();
 
-    // Parse VNC compact length from a byte buffer at given offset.
+    // Parse VNC compact length at the given offset of the receive buffer.
     // Returns bytes consumed, or 0 if not enough data.
-    auto parseCompactLength = [](const QByteArray &buf, int off, int *length) -> int {
-        if (buf.size() <= off) return 0;
-        quint8 b1 = static_cast<quint8>(buf.at(off));
+    auto parseCompactLength = [p, available](qint64 off, int *length) -> int {
+        if (available <= off) return 0;
+        quint8 b1 = p[off];
         if (!(b1 & 0x80)) { *length = b1; return 1; }
-        if (buf.size() <= off + 1) return 0;
-        quint8 b2 = static_cast<quint8>(buf.at(off + 1));
+        if (available <= off + 1) return 0;
+        quint8 b2 = p[off + 1];
         if (!(b2 & 0x80)) { *length = (b1 & 0x7F) | (b2 << 7); return 2; }
-        if (buf.size() <= off + 2) return 0;
-        quint8 b3 = static_cast<quint8>(buf.at(off + 2));
+        if (available <= off + 2) return 0;
+        quint8 b3 = p[off + 2];
         *length = (b1 & 0x7F) | ((b2 & 0x7F) << 7) | (b3 << 14);
         return 3;
     };
 
-    // Peek enough to parse any Tight header (ctrl + filter + palette + compact len)
-    const qint64 peekSize = qMin(socket->bytesAvailable(), qint64(1 + 1 + 1 + 256 * tpixelSize + 3));
-    const QByteArray peek = socket->peek(peekSize);
-    if (peek.isEmpty()) return false;
-
-    const quint8 compControl = static_cast<quint8>(peek.at(0));
-
-    // Process stream reset flags (bits 0-3)
-    for (int i = 0; i < 4; i++) {
-        if ((compControl & (1 << i)) && tightData->zlibStreamActive[i]) {
-            inflateEnd(&tightData->zlibStream[i]);
-            tightData->zlibStreamActive[i] = false;
-        }
-    }
+    const quint8 compControl = p[0];
 
     // Extract compression type from bits 4-7
     const int compType = compControl >> 4;
 
+    // Work out the size of the whole rectangle before consuming anything
+    qint64 totalNeeded = 0;
+    int lenBytes = 0;
+    int dataLength = 0;
+    const bool hasFilter = compType < 0x08 && (compType & 0x04) != 0;
+    int filterId = 0; // default: Copy
+    int numColors = 0;
+    int dataSize = 0;
+    qint64 off = 1; // past control byte
+
     if (compType == 0x08) {
         // --- Fill compression: 1 TPIXEL, no compact length, no zlib ---
-        const qint64 totalNeeded = 1 + tpixelSize;
-        if (socket->bytesAvailable() < totalNeeded) return false;
-
-        socket->read(1); // control byte
-        QByteArray pixelData = socket->read(tpixelSize);
-        int off = 0;
-        QRgb rgb = toRgb(readTPixel(pixelData.constData(), off));
-        for (int y = 0; y < rect.h; y++)
-            for (int x = 0; x < rect.w; x++)
-                image.setPixel(rect.x + x, rect.y + y, rgb);
-        return true;
-
+        totalNeeded = 1 + tpixelSize;
     } else if (compType == 0x09) {
         // --- JPEG compression: compact length + JPEG data ---
-        int dataLength = 0;
-        int lenBytes = parseCompactLength(peek, 1, &dataLength);
+        lenBytes = parseCompactLength(1, &dataLength);
         if (lenBytes == 0) return false;
-
-        const qint64 totalNeeded = 1 + lenBytes + dataLength;
-        if (socket->bytesAvailable() < totalNeeded) return false;
-
-        socket->read(1);        // control byte
-        socket->read(lenBytes); // compact length bytes
-        handleTightJpeg(rect, dataLength);
-        return true;
-
+        totalNeeded = 1 + lenBytes + dataLength;
     } else {
         // --- Basic compression (compType 0-7) ---
-        const int streamId = compType & 0x03;
-        const bool hasFilter = (compType & 0x04) != 0;
-
-        int off = 1; // past control byte
-        int filterId = 0; // default: Copy
-        int numColors = 0;
-        int paletteDataBytes = 0;
-
         if (hasFilter) {
-            if (peek.size() <= off) return false;
-            filterId = static_cast<quint8>(peek.at(off));
+            if (available <= off) return false;
+            filterId = p[off];
             off++;
         }
 
         if (filterId == 1) { // Palette filter
-            if (peek.size() <= off) return false;
-            numColors = static_cast<quint8>(peek.at(off)) + 1;
+            if (available <= off) return false;
+            numColors = p[off] + 1;
             off++;
-            paletteDataBytes = numColors * tpixelSize;
-            if (peek.size() < off + paletteDataBytes) return false;
-            off += paletteDataBytes;
+            off += numColors * tpixelSize;
         }
 
         // Calculate uncompressed data size
-        int dataSize = 0;
         if (filterId == 1) {
             dataSize = (numColors <= 2) ? (((rect.w + 7) / 8) * rect.h)
                                         : (rect.w * rect.h);
@@ -965,125 +1394,141 @@ bool QVncClient::Private::handleTightEncoding(const Rectangle &rect)
             dataSize = rect.w * rect.h * tpixelSize;
         }
 
-        qint64 totalNeeded;
-        int compressedLength = 0;
-        int lenBytes = 0;
-
         if (dataSize < 12) {
             // Small data: sent raw, no compact length, no zlib
             totalNeeded = off + dataSize;
         } else {
             // Larger data: compact length + zlib compressed
-            lenBytes = parseCompactLength(peek, off, &compressedLength);
+            lenBytes = parseCompactLength(off, &dataLength);
             if (lenBytes == 0) return false;
-            totalNeeded = off + lenBytes + compressedLength;
+            totalNeeded = off + lenBytes + dataLength;
         }
+    }
 
-        if (socket->bytesAvailable() < totalNeeded) return false;
+    if (available < totalNeeded) return false;
 
-        // --- All data available: consume ---
-        socket->read(1); // control byte
-        if (hasFilter) socket->read(1); // filter ID
+    // --- All data available: consume. p stays valid until the next fill ---
+    receiveBuffer.skip(totalNeeded);
 
-        // Read palette
-        QVector<QRgb> palette;
-        if (filterId == 1) {
-            socket->read(1); // numColors - 1
-            QByteArray paletteRaw = socket->read(paletteDataBytes);
-            palette.resize(numColors);
-            int pOff = 0;
-            for (int i = 0; i < numColors; i++)
-                palette[i] = toRgb(readTPixel(paletteRaw.constData(), pOff));
-        }
+    // Process stream reset flags (bits 0-3)
+    for (int i = 0; i < 4; i++) {
+        if (compControl & (1 << i))
+            tightData->zlibStream[i].end();
+    }
 
-        // Read pixel data (raw or zlib-compressed)
-        QByteArray pixelData;
+    if (compType == 0x08) {
+        const QRgb color = converter.pixel(p + 1);
+        decodeRect(rect, [rect, color](QVncPixelWriter &writer) {
+            writer.fillRect(rect.x, rect.y, rect.w, rect.h, color);
+        });
+        return true;
+
+    } else if (compType == 0x09) {
+        handleTightJpeg(rect, p + 1 + lenBytes, dataLength);
+        return true;
+
+    } else {
+        const int streamId = compType & 0x03;
+
+        // Read palette (at most 256 colours)
+        std::array<QRgb, 256> palette;
+        if (filterId == 1)
+            converter.convertRow(p + 3, palette.data(), numColors); // past control, filter, count
+
+        // Pixel data: raw in the receive buffer, or zlib-compressed
+        QByteArray pixelData;
+        const uchar *src = nullptr;
+        qint64 pixelDataSize = dataSize;
         if (dataSize < 12) {
-            pixelData = socket->read(dataSize);
+            src = keepPayload(p + off, dataSize, &pixelData);
         } else {
-            socket->read(lenBytes); // compact length bytes
-            QByteArray compressedData = socket->read(compressedLength);
-
-            // Ensure zlib stream is initialized
-            if (!tightData->zlibStreamActive[streamId]) {
-                memset(&tightData->zlibStream[streamId], 0, sizeof(z_stream));
-                tightData->zlibStream[streamId].zalloc = Z_NULL;
-                tightData->zlibStream[streamId].zfree = Z_NULL;
-                tightData->zlibStream[streamId].opaque = Z_NULL;
-                inflateInit(&tightData->zlibStream[streamId]);
-                tightData->zlibStreamActive[streamId] = true;
-            }
-
-            pixelData = decompressTightData(streamId, compressedData, dataSize);
+            pixelData = decompressTightData(streamId, p + off + lenBytes, dataLength, dataSize);
             if (pixelData.isEmpty()) {
                 qCWarning(lcVncClient) << "Failed to decompress Tight Basic data";
                 return true;
             }
+            src = reinterpret_cast<const uchar *>(pixelData.constData());
+            pixelDataSize = pixelData.size();
+        }
+
+        if (filterId != 1 && pixelDataSize < dataSize) {
+            qCWarning(lcVncClient) << "Tight Basic data truncated";
+            return true;
         }
 
         // --- Decode pixels based on filter ---
-        if (filterId == 1) {
-            // Palette filter
-            if (numColors <= 2) {
-                // 1 bit per pixel, rows padded to byte boundary
-                int byteIdx = 0;
-                for (int y = 0; y < rect.h; y++) {
-                    int bitOff = 0;
-                    for (int x = 0; x < rect.w; x++) {
-                        if (byteIdx >= pixelData.size()) break;
-                        int index = (static_cast<quint8>(pixelData.at(byteIdx)) >> (7 - bitOff)) & 1;
-                        if (index < numColors)
-                            image.setPixel(rect.x + x, rect.y + y, palette[index]);
-                        if (++bitOff == 8) { bitOff = 0; byteIdx++; }
+        decodeRect(rect, [this, rect, filterId, numColors, palette, src, pixelDataSize,
+                          pixelData](QVncPixelWriter &writer) {
+            const QVncPixelConverter &converter = tpixelConverter;
+            const int tpixelSize = converter.bytesPerPixel();
+            if (filterId == 1) {
+                // Palette filter
+                const QRgb black = qRgb(0, 0, 0);
+                if (numColors <= 2) {
+                    // 1 bit per pixel, rows padded to byte boundary
+                    const int rowBytes = (rect.w + 7) / 8;
+                    for (int y = 0; y < rect.h; y++) {
+                        if ((y + 1) * rowBytes > pixelDataSize) break;
+                        const uchar *row = src + y * rowBytes;
+                        QRgb *dst = writer.beginRow(rect.x, rect.y + y, rect.w);
+                        for (int x = 0; x < rect.w; x++) {
+                            const int index = (row[x / 8] >> (7 - (x % 8))) & 1;
+                            dst[x] = (index < numColors) ? palette[index] : black;
+                        }
+                        writer.endRow();
+                    }
+                } else {
+                    // 8 bits per pixel
+                    for (int y = 0; y < rect.h; y++) {
+                        if ((y + 1) * rect.w > pixelDataSize) break;
+                        const uchar *row = src + y * rect.w;
+                        QRgb *dst = writer.beginRow(rect.x, rect.y + y, rect.w);
+                        for (int x = 0; x < rect.w; x++)
+                            dst[x] = (row[x] < numColors) ? palette[row[x]] : black;
+                        writer.endRow();
                     }
-                    if (bitOff > 0) { byteIdx++; } // pad to byte boundary
                 }
-            } else {
-                // 8 bits per pixel
+            } else if (filterId == 2) {
+                // Gradient filter: predict pixel from neighbors, data is error term.
+                // The prediction works on channel values in 0..max, modulo
+                // max + 1, so the rows are kept as raw pixel values.
+                // Tight rectangles are at most 2048 pixels wide, so the
+                // rows normally live on the stack.
+                const int shift[3] = { pixelFormat.redShift, pixelFormat.greenShift, pixelFormat.blueShift };
+                const int max[3] = { qMax<int>(pixelFormat.redMax, 1), qMax<int>(pixelFormat.greenMax, 1),
+                                     qMax<int>(pixelFormat.blueMax, 1) };
+                QVarLengthArray<quint32, 2 * 2048> rows(2 * rect.w);
+                QVarLengthArray<QRgb, 2048> pixels(rect.w);
+                quint32 *prevRow = rows.data();
+                quint32 *row = rows.data() + rect.w;
+                const uchar *est = src;
                 for (int y = 0; y < rect.h; y++) {
-                    for (int x = 0; x < rect.w; x++) {
-                        int idx = y * rect.w + x;
-                        if (idx >= pixelData.size()) break;
-                        int ci = static_cast<quint8>(pixelData.at(idx));
-                        if (ci < numColors)
-                            image.setPixel(rect.x + x, rect.y + y, palette[ci]);
+                    for (int x = 0; x < rect.w; x++, est += tpixelSize) {
+                        const quint32 e = converter.value(est);
+                        quint32 value = 0;
+                        for (int c = 0; c < 3; c++) {
+                            const int l = x > 0 ? int(row[x - 1] >> shift[c]) & max[c] : 0;
+                            const int a = y > 0 ? int(prevRow[x] >> shift[c]) & max[c] : 0;
+                            const int al = x > 0 && y > 0 ? int(prevRow[x - 1] >> shift[c]) & max[c] : 0;
+                            const int predicted = qBound(0, l + a - al, max[c]);
+                            const int error = int(e >> shift[c]) & max[c];
+                            value |= quint32((predicted + error) % (max[c] + 1)) << shift[c];
+                        }
+                        row[x] = value;
+                        pixels[x] = converter.toRgb(value);
                     }
+                    writer.writeRect(rect.x, rect.y + y, rect.w, 1, pixels.constData(), rect.w);
+                    std::swap(prevRow, row);
                 }
-            }
-        } else if (filterId == 2) {
-            // Gradient filter: predict pixel from neighbors, data is error term
-            QVector<QRgb> prevRow(rect.w, qRgb(0, 0, 0));
-            QVector<QRgb> row(rect.w);
-            int dOff = 0;
-            for (int y = 0; y < rect.h; y++) {
-                for (int x = 0; x < rect.w; x++) {
-                    quint32 est = readTPixel(pixelData.constData(), dOff);
-                    int eR = (est >> pixelFormat.redShift) & 0xFF;
-                    int eG = (est >> pixelFormat.greenShift) & 0xFF;
-                    int eB = (est >> pixelFormat.blueShift) & 0xFF;
-
-                    int lR = 0, lG = 0, lB = 0;
-                    int aR = 0, aG = 0, aB = 0;
-                    int alR = 0, alG = 0, alB = 0;
-                    if (x > 0) { lR = qRed(row[x-1]); lG = qGreen(row[x-1]); lB = qBlue(row[x-1]); }
-                    if (y > 0) { aR = qRed(prevRow[x]); aG = qGreen(prevRow[x]); aB = qBlue(prevRow[x]); }
-                    if (x > 0 && y > 0) { alR = qRed(prevRow[x-1]); alG = qGreen(prevRow[x-1]); alB = qBlue(prevRow[x-1]); }
-
-                    QRgb rgb = qRgb((qBound(0, lR + aR - alR, 255) + eR) & 0xFF,
-                                    (qBound(0, lG + aG - alG, 255) + eG) & 0xFF,
-                                    (qBound(0, lB + aB - alB, 255) + eB) & 0xFF);
-                    row[x] = rgb;
-                    image.setPixel(rect.x + x, rect.y + y, rgb);
+            } else {
+                // Copy filter (filter 0 or default)
+                for (int y = 0; y < rect.h; y++) {
+                    QRgb *dst = writer.beginRow(rect.x, rect.y + y, rect.w);
+                    converter.convertRow(src + y * rect.w * tpixelSize, dst, rect.w);
+                    writer.endRow();
                 }
-                prevRow = row;
             }
-        } else {
-            // Copy filter (filter 0 or default)
-            int dOff = 0;
-            for (int y = 0; y < rect.h; y++)
-                for (int x = 0; x < rect.w; x++)
-                    image.setPixel(rect.x + x, rect.y + y, toRgb(readTPixel(pixelData.constData(), dOff)));
-        }
+        });
 
         return true;
     }
@@ -1095,29 +1540,22 @@ bool QVncClient::Private::handleTightEncoding(const Rectangle &rect)
     Processes a JPEG-compressed rectangle in Tight encoding.
     
     \param rect The rectangle dimensions.
+    \param data The JPEG data (caller already ensured it is complete).
     \param dataLength The length of the JPEG data in bytes.
-    \return true if successful, false if there was an error.
+    \return true once the rectangle has been consumed; decode errors are
+    only logged.
+
+    The image is decoded straight into the framebuffer at the position of
+    \a rect, on a decode worker when those are enabled.
 */
-bool QVncClient::Private::handleTightJpeg(const Rectangle &rect, int dataLength)
+bool QVncClient::Private::handleTightJpeg(const Rectangle &rect, const uchar *data, int dataLength)
 {
-    // Read JPEG data (caller already ensured data is available)
-    QByteArray jpegData = socket->read(dataLength);
-    if (jpegData.size() < dataLength) {
-        qCWarning(lcVncClient) << "Failed to read JPEG data for Tight encoding";
-        return false;
-    }
-    
-    // Decode JPEG image using Qt
-    QImage jpegImage;
-    if (!jpegImage.loadFromData(jpegData, "JPEG")) {
-        qCWarning(lcVncClient) << "Failed to decode JPEG data for Tight encoding";
-        return false;
-    }
-    
-    // Copy the JPEG image to the framebuffer
-    QPainter painter(&image);
-    painter.drawImage(rect.x, rect.y, jpegImage);
-    
+    QByteArray payload;
+    const uchar *jpeg = keepPayload(data, dataLength, &payload);
+    decodeRect(rect, [this, rect, jpeg, dataLength, payload](QVncPixelWriter &writer) {
+        if (!jpegDecoder.decode(jpeg, dataLength, writer, rect.x, rect.y))
+            qCWarning(lcVncClient) << "Failed to decode JPEG data for Tight encoding";
+    });
     return true;
 }
 
@@ -1128,27 +1566,30 @@ bool QVncClient::Private::handleTightJpeg(const Rectangle &rect, int dataLength)
     
     \param streamId The zlib stream ID (0-3).
     \param data The compressed data.
+    \param size The length of the compressed data.
     \param expectedBytes The expected size of the decompressed data.
     \return The decompressed data, or an empty array on error.
+
+    The data lives in the scratch buffer of the stream and is overwritten by
+    the next rectangle of the same stream, unless it is still referenced.
 */
-QByteArray QVncClient::Private::decompressTightData(int streamId, const QByteArray &data, int expectedBytes)
+QByteArray QVncClient::Private::decompressTightData(int streamId, const uchar *data, int size, int expectedBytes)
 {
-    QByteArray uncompressedData;
-    uncompressedData.resize(expectedBytes);
-    
-    tightData->zlibStream[streamId].next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
-    tightData->zlibStream[streamId].avail_in = data.size();
-    tightData->zlibStream[streamId].next_out = reinterpret_cast<Bytef*>(uncompressedData.data());
-    tightData->zlibStream[streamId].avail_out = uncompressedData.size();
-    
-    // Perform decompression
-    int result = inflate(&tightData->zlibStream[streamId], Z_SYNC_FLUSH);
-    if (result != Z_OK && result != Z_STREAM_END) {
-        qCWarning(lcVncClient) << "Zlib inflation failed with error code:" << result;
+    QByteArray &uncompressedData = tightData->inflateBuffer[streamId].resize(expectedBytes);
+    QVncInflater &stream = tightData->zlibStream[streamId];
+
+    // Perform decompression; the stream begins with the first rectangle
+    stream.setInput(data, size);
+    qsizetype uncompressedSize = 0;
+    const qint64 started = clock.nsecsElapsed();
+    const QVncInflater::Result result = stream.inflate(reinterpret_cast<uchar *>(uncompressedData.data()),
+                                                       uncompressedData.size(), &uncompressedSize);
+    statistics.inflateNsecs += clock.nsecsElapsed() - started;
+    if (result == QVncInflater::Error) {
+        qCWarning(lcVncClient) << "Zlib inflation failed:" << stream.errorString();
         return QByteArray();
     }
-    
-    int uncompressedSize = uncompressedData.size() - tightData->zlibStream[streamId].avail_out;
+
     uncompressedData.resize(uncompressedSize);
     
     return uncompressedData;
@@ -1164,11 +1605,11 @@ QByteArray QVncClient::Private::decompressTightData(int streamId, const QByteArr
 */
 void QVncClient::Private::parseProtocolVersion()
 {
-    if (socket->bytesAvailable() < 12) {
-        qCDebug(lcVncClient) << "Waiting for more protocol version data:" << socket->peek(12);
+    if (receiveBuffer.bytesAvailable() < 12) {
+        qCDebug(lcVncClient) << "Waiting for more protocol version data:" << receiveBuffer.peek(12);
         return;
     }
-    const auto value = socket->read(12);
+    const auto value = receiveBuffer.read(12);
     if (value == "RFB 003.003\n")
         q->setProtocolVersion(ProtocolVersion33);
     else if (value == "RFB 003.007\n")
@@ -1190,15 +1631,15 @@ void QVncClient::Private::protocolVersionChanged(ProtocolVersion protocolVersion
     qCDebug(lcVncClient) << "Protocol version changed to:" << protocolVersion;
     switch (protocolVersion) {
     case ProtocolVersion33:
-        socket->write("RFB 003.003\n");
+        write("RFB 003.003\n");
         state = SecurityState;
         break;
     case ProtocolVersion37:
-        socket->write("RFB 003.007\n");
+        write("RFB 003.007\n");
         state = SecurityState;
         break;
     case ProtocolVersion38:
-        socket->write("RFB 003.008\n");
+        write("RFB 003.008\n");
         state = SecurityState;
         break;
     default:
@@ -1233,8 +1674,8 @@ void QVncClient::Private::parseSecurity()
 */
 void QVncClient::Private::parseSecurity33()
 {
-    if (socket->bytesAvailable() < 4) {
-        qCDebug(lcVncClient) << "Waiting for more security data:" << socket->peek(4);
+    if (receiveBuffer.bytesAvailable() < 4) {
+        qCDebug(lcVncClient) << "Waiting for more security data:" << receiveBuffer.peek(4);
         return;
     }
     quint32_be data;
@@ -1251,8 +1692,8 @@ void QVncClient::Private::parseSecurity33()
 */
 void QVncClient::Private::parseSecurity37()
 {
-    if (socket->bytesAvailable() < 1) {
-        qCDebug(lcVncClient) << "Waiting for security type count:" << socket->peek(1);
+    if (receiveBuffer.bytesAvailable() < 1) {
+        qCDebug(lcVncClient) << "Waiting for security type count:" << receiveBuffer.peek(1);
         return;
     }
     quint8 numberOfSecurityTypes = 0;
@@ -1261,8 +1702,8 @@ void QVncClient::Private::parseSecurity37()
         parseSecurityReason();
         return;
     }
-    if (socket->bytesAvailable() < numberOfSecurityTypes) {
-        qCDebug(lcVncClient) << "Waiting for security types:" << socket->peek(numberOfSecurityTypes);
+    if (receiveBuffer.bytesAvailable() < numberOfSecurityTypes) {
+        qCDebug(lcVncClient) << "Waiting for security types:" << receiveBuffer.peek(numberOfSecurityTypes);
         return;
     }
     QList<quint8> securityTypes;
@@ -1370,17 +1811,17 @@ void QVncClient::Private::securityTypeChanged(SecurityType securityType)
 */
 void QVncClient::Private::parseSecurityReason()
 {
-    if (socket->bytesAvailable() < 4) {
-        qCDebug(lcVncClient) << "Waiting for reason length:" << socket->peek(4);
+    if (receiveBuffer.bytesAvailable() < 4) {
+        qCDebug(lcVncClient) << "Waiting for reason length:" << receiveBuffer.peek(4);
         return;
     }
     quint32_be reasonLength;
     read(&reasonLength);
-    if (socket->bytesAvailable() < reasonLength) {
-        qCDebug(lcVncClient) << "Waiting for reason data:" << socket->peek(reasonLength);
+    if (receiveBuffer.bytesAvailable() < reasonLength) {
+        qCDebug(lcVncClient) << "Waiting for reason data:" << receiveBuffer.peek(reasonLength);
         return;
     }
-    qCWarning(lcVncClient) << "Security failure reason:" << socket->read(reasonLength);
+    qCWarning(lcVncClient) << "Security failure reason:" << receiveBuffer.read(reasonLength);
 }
 
 /*!
@@ -1392,9 +1833,9 @@ void QVncClient::Private::parseSecurityReason()
 */
 void QVncClient::Private::parseVncAuthentication()
 {
-    if (socket->bytesAvailable() < 16)
+    if (receiveBuffer.bytesAvailable() < 16)
         return;
-    vncChallenge = socket->read(16);
+    vncChallenge = receiveBuffer.read(16);
     if (password.isEmpty()) {
         emit q->passwordRequested();
         return;
@@ -1413,8 +1854,7 @@ void QVncClient::Private::parseVncAuthentication()
 void QVncClient::Private::sendVncAuthResponse()
 {
     const QByteArray response = vncEncryptChallenge(password, vncChallenge);
-    if (isValid())
-        socket->write(response);
+    write(response);
     vncChallenge.clear();
 
     switch (protocolVersion) {
@@ -1433,7 +1873,7 @@ void QVncClient::Private::sendVncAuthResponse()
 
 void QVncClient::Private::parseVeNCryptVersion()
 {
-    if (socket->bytesAvailable() < 2)
+    if (receiveBuffer.bytesAvailable() < 2)
         return;
     quint8 major, minor;
     read(&major);
@@ -1450,25 +1890,25 @@ void QVncClient::Private::parseVeNCryptVersion()
 void QVncClient::Private::parseVeNCryptSubTypes()
 {
     // Peek-before-consume: need at least status(1) + count(1)
-    if (socket->bytesAvailable() < 2)
+    if (receiveBuffer.bytesAvailable() < 2)
         return;
-    const QByteArray header = socket->peek(2);
+    const QByteArray header = receiveBuffer.peek(2);
     const quint8 status = static_cast<quint8>(header[0]);
     if (status != 0) {
-        socket->read(1); // consume status
+        receiveBuffer.read(1); // consume status
         qCWarning(lcVncClient) << "VeNCrypt version not accepted by server";
         return;
     }
     const quint8 count = static_cast<quint8>(header[1]);
     if (count == 0) {
-        socket->read(2); // consume status + count
+        receiveBuffer.read(2); // consume status + count
         qCWarning(lcVncClient) << "VeNCrypt: no sub-types offered";
         return;
     }
     // Need status(1) + count(1) + count*4 bytes
-    if (socket->bytesAvailable() < 2 + count * 4)
+    if (receiveBuffer.bytesAvailable() < 2 + count * 4)
         return;
-    socket->read(2); // consume status + count
+    receiveBuffer.read(2); // consume status + count
     QList<quint32> subTypes;
     for (int i = 0; i < count; i++) {
         quint32_be subType;
@@ -1508,7 +1948,7 @@ void QVncClient::Private::parseVeNCryptSubTypes()
 
 void QVncClient::Private::parseVeNCryptAck()
 {
-    if (socket->bytesAvailable() < 1)
+    if (receiveBuffer.bytesAvailable() < 1)
         return;
     quint8 ack;
     read(&ack);
@@ -1548,7 +1988,32 @@ void QVncClient::Private::startTLSHandshake()
         return;
     }
     state = VeNCryptTLSState;
+    // What was sent before the handshake must not be encrypted
+    flushSendBuffer();
     sslSocket->setPeerVerifyMode(QSslSocket::QueryPeer);
+    // The socket may be reused; drop what an earlier handshake connected
+    QObject::disconnect(sslSocket, &QSslSocket::newSessionTicketReceived, q, nullptr);
+    QObject::disconnect(sslSocket, &QSslSocket::encrypted, q, nullptr);
+    if (fastReconnect) {
+        // Resume the previous session with the same server instead of a
+        // full handshake; the server falls back to one if it cannot
+        const QString peer = sslSocket->peerName() + u':' + QString::number(sslSocket->peerPort());
+        QSslConfiguration configuration = sslSocket->sslConfiguration();
+        configuration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        if (peer == tlsSessionPeer && !tlsSessionTicket.isEmpty())
+            configuration.setSessionTicket(tlsSessionTicket);
+        sslSocket->setSslConfiguration(configuration);
+        const auto keepTicket = [this, sslSocket, peer]() {
+            const QByteArray ticket = sslSocket->sslConfiguration().sessionTicket();
+            if (ticket.isEmpty())
+                return;
+            tlsSessionPeer = peer;
+            tlsSessionTicket = ticket;
+        };
+        // TLS 1.3 sends tickets after the handshake
+        QObject::connect(sslSocket, &QSslSocket::newSessionTicketReceived, q, keepTicket);
+        QObject::connect(sslSocket, &QSslSocket::encrypted, q, keepTicket);
+    }
     QObject::connect(sslSocket, &QSslSocket::encrypted, q, [this]() {
         tlsHandshakeFinished();
     });
@@ -1601,12 +2066,11 @@ void QVncClient::Private::sendPlainAuthResponse()
     const QByteArray passBytes = password.toUtf8();
     quint32_be userLen(static_cast<quint32>(userBytes.size()));
     quint32_be passLen(static_cast<quint32>(passBytes.size()));
+    SendBatch batch(this);
     write(userLen);
     write(passLen);
-    if (isValid()) {
-        socket->write(userBytes);
-        socket->write(passBytes);
-    }
+    write(userBytes);
+    write(passBytes);
     state = SecurityResultState;
 }
 
@@ -1614,15 +2078,15 @@ void QVncClient::Private::parseAppleDH()
 {
 #ifdef USE_OPENSSL
     // Server sends: generator(2) + keyLength(2) + prime(keyLength) + pubKey(keyLength)
-    if (socket->bytesAvailable() < 4)
+    if (receiveBuffer.bytesAvailable() < 4)
         return;
-    const QByteArray header = socket->peek(4);
+    const QByteArray header = receiveBuffer.peek(4);
     const quint16 generator = (static_cast<quint8>(header[0]) << 8)
                             | static_cast<quint8>(header[1]);
     const quint16 keyLength = (static_cast<quint8>(header[2]) << 8)
                             | static_cast<quint8>(header[3]);
     const qint64 totalSize = 4 + static_cast<qint64>(keyLength) * 2;
-    if (socket->bytesAvailable() < totalSize)
+    if (receiveBuffer.bytesAvailable() < totalSize)
         return;
 
     if (username.isEmpty()) {
@@ -1635,9 +2099,9 @@ void QVncClient::Private::parseAppleDH()
     }
 
     // Consume the header
-    socket->read(4);
-    const QByteArray primeBytes = socket->read(keyLength);
-    const QByteArray serverPubBytes = socket->read(keyLength);
+    receiveBuffer.read(4);
+    const QByteArray primeBytes = receiveBuffer.read(keyLength);
+    const QByteArray serverPubBytes = receiveBuffer.read(keyLength);
 
     qCDebug(lcVncClient) << "Apple DH: generator=" << generator
                          << "keyLength=" << keyLength;
@@ -1715,9 +2179,10 @@ void QVncClient::Private::parseAppleDH()
         clientPubBytes.data() + keyLength - pubLen));
 
     // Send: ciphertext(128) + clientPublicKey(keyLength)
-    if (isValid()) {
-        socket->write(ciphertext);
-        socket->write(clientPubBytes);
+    {
+        SendBatch batch(this);
+        write(ciphertext);
+        write(clientPubBytes);
     }
 
     // Clean up
@@ -1752,7 +2217,7 @@ void QVncClient::Private::parseAppleDH()
 */
 void QVncClient::Private::parseSecurityResult()
 {
-    if (socket->bytesAvailable() < 4)
+    if (receiveBuffer.bytesAvailable() < 4)
         return;
     quint32_be result;
     read(&result);
@@ -1772,12 +2237,26 @@ void QVncClient::Private::parseSecurityResult()
     Sends the client initialization message to the server.
     
     This message indicates whether the connection will be shared with other clients.
+
+    On a fast reconnect the server is most likely the one the kept
+    framebuffer came from. SetPixelFormat, SetEncodings and the first
+    FramebufferUpdateRequest then go out in the same write instead of
+    waiting a round trip for ServerInit; parserServerInit() corrects what
+    turns out to be different.
 */
 void QVncClient::Private::clientInit()
 {
+    SendBatch batch(this);
     quint8 sharedFlag = 1;
     write(sharedFlag);
     state = ServerInitState;
+    if (fastReconnect && !image.isNull() && framebufferUpdatesEnabled) {
+        setPixelFormat(pixelFormat);
+        sentEncodings = encodingList();
+        setEncodings(sentEncodings);
+        framebufferUpdateRequest(false);
+        initPipelined = true;
+    }
 }
 
 /*!
@@ -1787,8 +2266,15 @@ void QVncClient::Private::clientInit()
 */
 void QVncClient::Private::parserServerInit()
 {
-    if (socket->bytesAvailable() < 2 + 2 + 16 + 4) {
-        qCDebug(lcVncClient) << "Waiting for server init data:" << socket->peek(2 + 2 + 16 + 4);
+    const qint64 headerSize = 2 + 2 + 16 + 4;
+    if (receiveBuffer.bytesAvailable() < headerSize) {
+        qCDebug(lcVncClient) << "Waiting for server init data:" << receiveBuffer.peek(headerSize);
+        return;
+    }
+    // Nothing is consumed until the server name is complete as well
+    const quint32 nameLength = qFromBigEndian<quint32>(receiveBuffer.data() + headerSize - 4);
+    if (receiveBuffer.bytesAvailable() < headerSize + nameLength) {
+        qCDebug(lcVncClient) << "Waiting for name data:" << nameLength << "bytes";
         return;
     }
 
@@ -1798,51 +2284,51 @@ void QVncClient::Private::parserServerInit()
     read(&framebufferHeight);
     qCDebug(lcVncClient) << "Framebuffer size:" << framebufferWidth << "x" << framebufferHeight;
     
-    frameBufferWidth = framebufferWidth;
-    frameBufferHeight = framebufferHeight;
-    emit q->framebufferSizeChanged(frameBufferWidth, frameBufferHeight);
-    
-    image = QImage(framebufferWidth, framebufferHeight, QImage::Format_ARGB32);
-    image.fill(Qt::white);
+    // A framebuffer kept across a reconnect stays if the size still fits
+    const bool sizeChanged = image.isNull() || framebufferWidth != frameBufferWidth
+            || framebufferHeight != frameBufferHeight;
+    if (sizeChanged) {
+        resizeFramebuffer(framebufferWidth, framebufferHeight);
+        // Receivers may take a new imageView() here
+        emit q->framebufferSizeChanged(frameBufferWidth, frameBufferHeight);
+        emit q->screensChanged();
+    }
 
-    read(&pixelFormat);
+    read(&serverPixelFormat);
     qCDebug(lcVncClient) << "Pixel format:";
-    qCDebug(lcVncClient) << "  Bits per pixel:" << pixelFormat.bitsPerPixel;
-    qCDebug(lcVncClient) << "  Depth:" << pixelFormat.depth;
-    qCDebug(lcVncClient) << "  Big endian:" << pixelFormat.bigEndianFlag;
-    qCDebug(lcVncClient) << "  True color:" << pixelFormat.trueColourFlag;
-    qCDebug(lcVncClient) << "  Red:" << pixelFormat.redMax << pixelFormat.redShift;
-    qCDebug(lcVncClient) << "  Green:" << pixelFormat.greenMax << pixelFormat.greenShift;
-    qCDebug(lcVncClient) << "  Blue:" << pixelFormat.blueMax << pixelFormat.blueShift;
-
-    quint32_be nameLength;
-    read(&nameLength);
+    qCDebug(lcVncClient) << "  Bits per pixel:" << serverPixelFormat.bitsPerPixel;
+    qCDebug(lcVncClient) << "  Depth:" << serverPixelFormat.depth;
+    qCDebug(lcVncClient) << "  Big endian:" << serverPixelFormat.bigEndianFlag;
+    qCDebug(lcVncClient) << "  True color:" << serverPixelFormat.trueColourFlag;
+    qCDebug(lcVncClient) << "  Red:" << serverPixelFormat.redMax << serverPixelFormat.redShift;
+    qCDebug(lcVncClient) << "  Green:" << serverPixelFormat.greenMax << serverPixelFormat.greenShift;
+    qCDebug(lcVncClient) << "  Blue:" << serverPixelFormat.blueMax << serverPixelFormat.blueShift;
+
+    receiveBuffer.skip(4); // name length
     qCDebug(lcVncClient) << "Name length:" << nameLength;
-    if (socket->bytesAvailable() < nameLength) {
-        qCDebug(lcVncClient) << "Waiting for name data:" << socket->peek(nameLength);
-        return;
-    }
-    const auto nameString = socket->read(nameLength);
+    const auto nameString = receiveBuffer.read(nameLength);
     qCDebug(lcVncClient) << "Server name:" << nameString;
     state = WaitingState;
 
-    setPixelFormat();
+    if (initPipelined) {
+        initPipelined = false;
+        // The first request was for the old size
+        if (sizeChanged)
+            refreshPending = true;
+        // A different server, whose own format is preferred
+        if (!(preferredPixelFormat() == pixelFormat))
+            pixelFormatPending = true;
+        sendServerScale();
+        return;
+    }
+
+    pixelFormat = preferredPixelFormat();
+    updatePixelConverters();
+    setPixelFormat(pixelFormat);
+    pixelFormatPending = false;
     
-    // Set supported encodings based on available libraries
-    const QList<qint32> encodings {
-#ifdef USE_ZLIB
-        Tight,
-#endif
-        ZRLE,
-        Hextile,
-        RawEncoding,
-        CursorPseudoEncoding,
-        CursorPosPseudoEncoding,
-#ifdef USE_ZLIB
-        ExtendedClipboardPseudoEncoding,
-#endif
-    };
-    setEncodings(encodings);
+    sendEncodings();
+    sendServerScale();
     if (framebufferUpdatesEnabled)
         framebufferUpdateRequest(false);
 }
@@ -1851,14 +2337,71 @@ void QVncClient::Private::parserServerInit()
     \internal
     Sends a SetPixelFormat message to the server.
     
-    This message configures the pixel format that the server should use when
-    sending framebuffer updates.
+    This message configures the pixel format \a format that the server should
+    use when sending framebuffer updates.
 */
-void QVncClient::Private::setPixelFormat()
+void QVncClient::Private::setPixelFormat(const PixelFormat &format)
 {
+    SendBatch batch(this);
     write(SetPixelFormat);
     write("   "); // padding
-    write(pixelFormat);
+    write(format);
+}
+
+/*!
+    \internal
+    Sends the pixel format for the current preference if it differs from the
+    one in use, and rebuilds the converters to match.
+
+    Must only be called while no FramebufferUpdateRequest is outstanding:
+    an update already on its way would still be encoded in the old format.
+*/
+bool QVncClient::Private::applyPixelFormat()
+{
+    pixelFormatPending = false;
+    const PixelFormat format = preferredPixelFormat();
+    if (format == pixelFormat)
+        return false;
+    decodeQueue.waitForDone(); // queued jobs use the current converters
+    qCDebug(lcVncClient) << "Switching to" << format.bitsPerPixel << "bits per pixel";
+    pixelFormat = format;
+    updatePixelConverters();
+    setPixelFormat(pixelFormat);
+    return true;
+}
+
+void QVncClient::Private::requestPixelFormatChange()
+{
+    if (state != WaitingState)
+        return; // picked up by parserServerInit()
+    if (continuousUpdatesActive) {
+        // Updates keep coming, so there is never a gap between requests.
+        // Fence the new format instead: with SyncNext the server answers
+        // once it has applied the message after the fence, so everything
+        // before the response is still in the old format and everything
+        // after it in the new one.
+        if (pixelFormatFencePending) {
+            pixelFormatPending = true; // once the current switch is done
+            return;
+        }
+        pixelFormatPending = false;
+        const PixelFormat format = preferredPixelFormat();
+        if (format == pixelFormat)
+            return;
+        fencedPixelFormat = format;
+        pixelFormatFencePending = true;
+        SendBatch batch(this);
+        sendFence(FenceRequest | FenceSyncNext, QByteArrayLiteral("pixelformat"));
+        setPixelFormat(format);
+        return;
+    }
+    if (fbu.active || fbu.finishPending || requestScheduled()) {
+        pixelFormatPending = true;
+        return;
+    }
+    // The framebuffer keeps its contents; refresh all of it in the new format
+    if (applyPixelFormat() && framebufferUpdatesEnabled)
+        framebufferUpdateRequest(false);
 }
 
 /*!
@@ -1869,6 +2412,7 @@ void QVncClient::Private::setPixelFormat()
 */
 void QVncClient::Private::setEncodings(const QList<qint32> &encodings)
 {
+    SendBatch batch(this);
     write(SetEncodings);
     write(" "); // padding
     write(quint16_be(encodings.length()));
@@ -1876,32 +2420,111 @@ void QVncClient::Private::setEncodings(const QList<qint32> &encodings)
         write(qint32_be(encoding));
 }
 
+QList<qint32> QVncClient::Private::encodingList() const
+{
+    const QVncEncodingTuner::Levels &tuned = encodingTuner.levels();
+    const bool preferRaw = compressionLevel < 0 && tuned.preferRaw;
+
+    // Set supported encodings based on available libraries
+    QList<qint32> encodings { CopyRect };
+    if (preferRaw)
+        encodings.append(RawEncoding);
+    // Only with a decoder, which is optional even with FFmpeg
+    if (QVncH264Decoder::isAvailable())
+        encodings.append(OpenH264);
+#ifdef USE_ZLIB
+    encodings.append(Tight);
+#endif
+    encodings.append(ZRLE);
+    encodings.append(Hextile);
+    if (!preferRaw)
+        encodings.append(RawEncoding);
+    encodings.append({
+        CursorPseudoEncoding,
+        CursorPosPseudoEncoding,
+        ExtendedDesktopSizePseudoEncoding,
+        DesktopSizePseudoEncoding,
+        FencePseudoEncoding,
+        ContinuousUpdatesPseudoEncoding,
+#ifdef USE_ZLIB
+        ExtendedClipboardPseudoEncoding,
+#endif
+        QualityLevel0PseudoEncoding + (qualityLevel >= 0 ? qualityLevel : tuned.quality),
+        CompressLevel0PseudoEncoding + (compressionLevel >= 0 ? compressionLevel : tuned.compression),
+    });
+    return encodings;
+}
+
+void QVncClient::Private::sendEncodings()
+{
+    if (state != WaitingState)
+        return; // sent by parserServerInit()
+    const QList<qint32> encodings = encodingList();
+    if (encodings == sentEncodings)
+        return;
+    sentEncodings = encodings;
+    setEncodings(encodings);
+}
+
 /*!
     \internal
     Sends a FramebufferUpdateRequest message to the server.
     
     \param incremental If true, only changed parts of the framebuffer are requested.
-    \param rect The rectangle to update, or empty for the entire framebuffer.
+    \param rect The rectangle to update, or empty for requestArea().
 */
 void QVncClient::Private::framebufferUpdateRequest(bool incremental, const QRect &rect)
 {
+    updateRequestPending = true;
+    lastRequestTime = clock.nsecsElapsed();
+    lastRequestIncremental = incremental;
+    SendBatch batch(this);
     write(FramebufferUpdateRequest);
     write(quint8(incremental ? 1 : 0));
+    const QRect area = rect.isEmpty() ? requestArea() : rect;
     Rectangle rectangle;
-    if (rect.isEmpty()) {
-        rectangle.x = 0;
-        rectangle.y = 0;
-        rectangle.w = frameBufferWidth;
-        rectangle.h = frameBufferHeight;
-    } else {
-        rectangle.x = rect.x();
-        rectangle.y = rect.y();
-        rectangle.w = rect.width();
-        rectangle.h = rect.height();
-    }
+    rectangle.x = area.x();
+    rectangle.y = area.y();
+    rectangle.w = area.width();
+    rectangle.h = area.height();
     write(rectangle);
 }
 
+QRect QVncClient::Private::requestArea() const
+{
+    const QRect framebuffer(0, 0, frameBufferWidth, frameBufferHeight);
+    const QRect area = viewport & framebuffer;
+    return area.isEmpty() ? framebuffer : area;
+}
+
+void QVncClient::Private::requestViewport()
+{
+    if (state != WaitingState || !framebufferUpdatesEnabled)
+        return; // the first request covers the viewport
+    if (continuousUpdatesActive) {
+        enableContinuousUpdates(true); // moves the area
+        framebufferUpdateRequest(false);
+        return;
+    }
+    if (fbu.active || fbu.finishPending || requestScheduled()) {
+        refreshPending = true;
+        return;
+    }
+    framebufferUpdateRequest(false);
+}
+
+void QVncClient::Private::sendServerScale()
+{
+    if (state != WaitingState || serverScale == sentServerScale)
+        return; // sent by parserServerInit()
+    qCDebug(lcVncClient) << "Requesting framebuffer scaled by 1 /" << serverScale;
+    sentServerScale = serverScale;
+    SendBatch batch(this);
+    write(SetScale);
+    write(quint8(serverScale));
+    write(quint16(0)); // padding
+}
+
 /*!
     \internal
     Parses and dispatches incoming server messages.
@@ -1919,7 +2542,7 @@ void QVncClient::Private::parseServerMessages()
         messageType = static_cast<quint8>(pendingServerMessage);
         pendingServerMessage = -1;
     } else {
-        if (socket->bytesAvailable() < 1) return;
+        if (receiveBuffer.bytesAvailable() < 1) return;
         read(&messageType);
     }
     switch (messageType) {
@@ -1930,29 +2553,145 @@ void QVncClient::Private::parseServerMessages()
         if (!serverCutText())
             pendingServerMessage = messageType;
         break;
+    case EndOfContinuousUpdates:
+        endOfContinuousUpdates();
+        break;
+    case ServerFence:
+        if (!serverFence())
+            pendingServerMessage = messageType;
+        break;
     default:
         qCWarning(lcVncClient) << "Unknown message type:" << messageType;
     }
 }
 
+bool QVncClient::Private::serverFence()
+{
+    if (receiveBuffer.bytesAvailable() < 8) return false;
+    const uchar *p = receiveBuffer.data();
+    const quint32 flags = qFromBigEndian<quint32>(p + 3);
+    const int length = p[7];
+    if (receiveBuffer.bytesAvailable() < 8 + length) return false;
+    receiveBuffer.skip(8);
+    const QByteArray payload = receiveBuffer.read(length);
+
+    if (!fenceSupported) {
+        qCDebug(lcVncClient) << "Server supports fences";
+        fenceSupported = true;
+        startContinuousUpdates();
+    }
+
+    if (flags & FenceRequest) {
+        // Earlier updates have to be in the framebuffer before the answer
+        if (flags & FenceBlockBefore)
+            decodeQueue.waitForDone();
+        // Answer with the flags we understand, which are all of them but
+        // the request bit
+        sendFence(flags & (FenceBlockBefore | FenceBlockAfter | FenceSyncNext), payload);
+        return true;
+    }
+    if (fenceRequestTime >= 0) {
+        addRoundTrip(clock.nsecsElapsed() - fenceRequestTime);
+        fenceRequestTime = -1;
+    }
+
+    if (pixelFormatFencePending && payload == "pixelformat") {
+        // Everything from here on is in the new format
+        pixelFormatFencePending = false;
+        decodeQueue.waitForDone(); // queued jobs use the current converters
+        qCDebug(lcVncClient) << "Switching to" << fencedPixelFormat.bitsPerPixel << "bits per pixel";
+        pixelFormat = fencedPixelFormat;
+        updatePixelConverters();
+        // The framebuffer keeps its contents; refresh all of it in the new format
+        framebufferUpdateRequest(false);
+        if (pixelFormatPending)
+            requestPixelFormatChange();
+        startContinuousUpdates();
+    }
+    return true;
+}
+
+void QVncClient::Private::endOfContinuousUpdates()
+{
+    if (!continuousUpdatesSupported) {
+        qCDebug(lcVncClient) << "Server supports continuous updates";
+        continuousUpdatesSupported = true;
+        startContinuousUpdates();
+        return;
+    }
+    // Stopped, normally because updates were disabled
+    qCDebug(lcVncClient) << "Continuous updates stopped";
+    continuousUpdatesActive = false;
+    // Enabled again before the server acknowledged; a pending format
+    // switch restarts them once its fence returns
+    if (!pixelFormatFencePending)
+        startContinuousUpdates();
+    // Stopped for updateInterval, back to requests
+    if (!continuousUpdatesActive && !fbu.finishPending && !requestScheduled())
+        requestNextUpdate();
+}
+
+void QVncClient::Private::sendFence(quint32 flags, const QByteArray &payload)
+{
+    if (flags & FenceRequest)
+        fenceRequestTime = clock.nsecsElapsed();
+    SendBatch batch(this);
+    write(ClientFence);
+    write(quint8(0)); // padding
+    write(quint16(0));
+    write(quint32_be(flags));
+    write(quint8(qMin(payload.size(), qsizetype(64))));
+    write(reinterpret_cast<const uchar *>(payload.constData()), qMin(payload.size(), qsizetype(64)));
+}
+
+void QVncClient::Private::enableContinuousUpdates(bool enable)
+{
+    SendBatch batch(this);
+    write(EnableContinuousUpdates);
+    write(quint8(enable ? 1 : 0));
+    const QRect area = requestArea();
+    Rectangle rectangle;
+    rectangle.x = area.x();
+    rectangle.y = area.y();
+    rectangle.w = area.width();
+    rectangle.h = area.height();
+    write(rectangle);
+}
+
+void QVncClient::Private::startContinuousUpdates()
+{
+    if (!fenceSupported || !continuousUpdatesSupported || continuousUpdatesActive
+            || !framebufferUpdatesEnabled || updateInterval > 0 || state != WaitingState)
+        return;
+    // A format change waiting for a gap between requests is sent now,
+    // while there still is one
+    if (pixelFormatPending && !fbu.active && !fbu.finishPending && !updateRequestPending
+            && applyPixelFormat()) {
+        framebufferUpdateRequest(false);
+    }
+    qCDebug(lcVncClient) << "Enabling continuous updates";
+    continuousUpdatesActive = true;
+    enableContinuousUpdates(true);
+}
+
 bool QVncClient::Private::serverCutText()
 {
-    if (socket->bytesAvailable() < 7) return false;
+    if (receiveBuffer.bytesAvailable() < 7) return false;
 
     // Peek at header to determine total message size before consuming any bytes
-    const QByteArray header = socket->peek(7);
+    const QByteArray header = receiveBuffer.peek(7);
     const qint32 length = qFromBigEndian<qint32>(header.constData() + 3);
     const qint64 payloadSize = (length >= 0)
         ? static_cast<qint64>(length)
         : static_cast<qint64>(static_cast<quint32>(-length));
-    if (socket->bytesAvailable() < 7 + payloadSize) return false;
+    if (receiveBuffer.bytesAvailable() < 7 + payloadSize) return false;
 
     // Full message available — consume header
-    socket->read(7); // padding(3) + length(4)
+    receiveBuffer.read(7); // padding(3) + length(4)
 
     if (length >= 0) {
         // Legacy: Latin-1 text
-        const QByteArray data = socket->read(length);
+        const QByteArray data = receiveBuffer.read(length);
         const QString text = QString::fromLatin1(data);
         qCDebug(lcVncClient) << "ServerCutText:" << text.length() << "chars";
         emit q->clipboardTextReceived(text);
@@ -1960,10 +2699,10 @@ bool QVncClient::Private::serverCutText()
     }
 #ifdef USE_ZLIB
     // Extended clipboard: length is negative, absolute value is payload size
-    handleExtendedClipboard(socket->read(static_cast<quint32>(-length)));
+    handleExtendedClipboard(receiveBuffer.read(static_cast<quint32>(-length)));
 #else
     // Skip extended clipboard data when zlib is not available
-    socket->read(static_cast<quint32>(-length));
+    receiveBuffer.skip(static_cast<quint32>(-length));
 #endif
     return true;
 }
@@ -1981,13 +2720,14 @@ void QVncClient::Private::clientCutText(const QString &text)
     }
 #endif
     // Legacy: Latin-1 text
+    SendBatch batch(this);
     const quint8 messageType = ClientCutText;
     write(messageType);
-    socket->write("\0\0\0", 3); // padding
+    write(reinterpret_cast<const uchar *>("\0\0\0"), 3); // padding
     const QByteArray data = text.toLatin1();
     quint32_be length(data.size());
     write(length);
-    socket->write(data);
+    write(data);
 }
 
 void QVncClient::Private::clientCutImage(const QImage &image)
@@ -2007,13 +2747,14 @@ void QVncClient::Private::clientCutImage(const QImage &image)
 void QVncClient::Private::sendExtendedClipboardMessage(const QByteArray &payload)
 {
     if (!socket) return;
+    SendBatch batch(this);
     const quint8 messageType = ClientCutText;
     write(messageType);
-    socket->write("\0\0\0", 3); // padding
+    write(reinterpret_cast<const uchar *>("\0\0\0"), 3); // padding
     // Negative length signals extended clipboard
     const qint32_be negLength(-static_cast<qint32>(payload.size()));
     write(negLength);
-    socket->write(payload);
+    write(payload);
 }
 
 void QVncClient::Private::sendExtendedClipboardCaps()
@@ -2073,30 +2814,12 @@ void QVncClient::Private::sendExtendedClipboardProvide(quint32 formats, const QM
         uncompressed.append(d);
     }
 
-    // Zlib-compress the payload
-    if (!clipboardDeflateActive) {
-        memset(&clipboardDeflateStream, 0, sizeof(clipboardDeflateStream));
-        if (deflateInit(&clipboardDeflateStream, Z_DEFAULT_COMPRESSION) != Z_OK) {
-            qCWarning(lcVncClient) << "Failed to init zlib deflate for clipboard";
-            return;
-        }
-        clipboardDeflateActive = true;
-    } else {
-        deflateReset(&clipboardDeflateStream);
-    }
-
-    QByteArray compressed;
-    compressed.resize(deflateBound(&clipboardDeflateStream, uncompressed.size()));
-    clipboardDeflateStream.next_in = reinterpret_cast<Bytef *>(uncompressed.data());
-    clipboardDeflateStream.avail_in = uncompressed.size();
-    clipboardDeflateStream.next_out = reinterpret_cast<Bytef *>(compressed.data());
-    clipboardDeflateStream.avail_out = compressed.size();
-
-    if (deflate(&clipboardDeflateStream, Z_FINISH) != Z_STREAM_END) {
+    // Zlib-compress the payload, one finished stream per message
+    const QByteArray compressed = clipboardDeflateStream.compress(uncompressed, QVncDeflater::Finish);
+    if (compressed.isNull()) {
         qCWarning(lcVncClient) << "Failed to compress clipboard data";
         return;
     }
-    compressed.resize(clipboardDeflateStream.total_out);
 
     // Build the full message: 4-byte flags + compressed data
     const quint32 flags = formats | ClipboardProvide;
@@ -2242,48 +2965,46 @@ void QVncClient::Private::handleExtendedClipboard(const QByteArray &data)
         if (data.size() <= 4)
             return;
 
-        // Initialize inflate stream if needed
-        if (!clipboardInflateActive) {
-            memset(&clipboardInflateStream, 0, sizeof(clipboardInflateStream));
-            if (inflateInit(&clipboardInflateStream) != Z_OK) {
-                qCWarning(lcVncClient) << "Failed to init zlib inflate for clipboard";
-                return;
-            }
-            clipboardInflateActive = true;
-        } else {
-            inflateReset(&clipboardInflateStream);
+        // Each message is a stream of its own
+        if (!clipboardInflateStream.reset()) {
+            qCWarning(lcVncClient) << "Failed to init zlib inflate for clipboard";
+            return;
         }
 
         // Decompress with growing buffer (capped to prevent zip bombs)
         constexpr qint64 maxDecompressedSize = 256 * 1024 * 1024; // 256 MB
         const int compressedSize = data.size() - 4;
-        QByteArray decompressed;
-        decompressed.resize(qMin(static_cast<qint64>(compressedSize) * 4, maxDecompressedSize));
-        clipboardInflateStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData() + 4));
-        clipboardInflateStream.avail_in = compressedSize;
+        // Clipboards are rarely large; do not hold on to a big one
+        constexpr qint64 maxKeptSize = 1024 * 1024;
+        QByteArray *buffer = &clipboardBuffer.resize(qMin(static_cast<qint64>(compressedSize) * 4, maxDecompressedSize));
+        clipboardInflateStream.setInput(reinterpret_cast<const uchar *>(data.constData() + 4), compressedSize);
 
         qint64 totalOut = 0;
-        int ret;
+        QVncInflater::Result ret;
         do {
-            clipboardInflateStream.next_out = reinterpret_cast<Bytef *>(decompressed.data() + totalOut);
-            clipboardInflateStream.avail_out = decompressed.size() - totalOut;
-            ret = inflate(&clipboardInflateStream, Z_SYNC_FLUSH);
-            totalOut = clipboardInflateStream.total_out;
-            if (clipboardInflateStream.avail_out == 0 && ret != Z_STREAM_END) {
-                const qint64 newSize = static_cast<qint64>(decompressed.size()) * 2;
+            qsizetype written = 0;
+            const qsizetype space = buffer->size() - totalOut;
+            ret = clipboardInflateStream.inflate(reinterpret_cast<uchar *>(buffer->data() + totalOut), space, &written);
+            totalOut += written;
+            if (ret == QVncInflater::Ok && written == 0) // truncated
+                break;
+            if (written == space && ret != QVncInflater::StreamEnd) {
+                const qint64 newSize = static_cast<qint64>(buffer->size()) * 2;
                 if (newSize > maxDecompressedSize) {
                     qCWarning(lcVncClient) << "Clipboard decompressed data exceeds size limit";
+                    clipboardBuffer.trim(maxKeptSize);
                     return;
                 }
-                decompressed.resize(newSize);
+                buffer = &clipboardBuffer.grow(newSize, totalOut);
             }
-        } while (ret == Z_OK);
+        } while (ret == QVncInflater::Ok);
 
-        if (ret != Z_STREAM_END && ret != Z_OK) {
-            qCWarning(lcVncClient) << "Failed to decompress clipboard data:" << ret;
+        if (ret != QVncInflater::StreamEnd) {
+            qCWarning(lcVncClient) << "Failed to decompress clipboard data:" << clipboardInflateStream.errorString();
             return;
         }
-        decompressed.resize(totalOut);
+        buffer->resize(totalOut);
+        const QByteArray decompressed = *buffer;
 
         // Parse size+data pairs per format bit
         int offset = 0;
@@ -2309,6 +3030,7 @@ void QVncClient::Private::handleExtendedClipboard(const QByteArray &data)
             }
             offset += size;
         }
+        clipboardBuffer.trim(maxKeptSize);
     } else if (action & ClipboardPeek) {
         // Server asks what formats we have; respond with notify
         quint32 notifyFormats = 0;
@@ -2332,13 +3054,24 @@ void QVncClient::Private::handleExtendedClipboard(const QByteArray &data)
 */
 void QVncClient::Private::framebufferUpdate()
 {
-    if (socket->bytesAvailable() < 3) return;
-    socket->read(1); // padding
+    if (receiveBuffer.bytesAvailable() < 3) return;
+    // With continuous updates the next update can come while workers still
+    // decode the last one; report that one complete before touching pixels
+    if (fbu.finishPending)
+        decodeQueue.waitForDone();
+    receiveBuffer.read(1); // padding
     quint16_be numberOfRectangles;
     read(&numberOfRectangles);
     fbu.totalRects = numberOfRectangles;
     fbu.currentRect = 0;
     fbu.active = true;
+    fbu.startOffset = streamPosition();
+    const qint64 now = clock.nsecsElapsed();
+    encodingTuner.updateStarted(fbu.startOffset, now);
+    fbu.requestTime = updateRequestPending ? lastRequestTime : -1;
+    if (updateRequestPending && !lastRequestIncremental)
+        addRoundTrip(now - lastRequestTime);
+    updateRequestPending = false;
     fbu.rectHeaderRead = false;
     qCDebug(lcVncClient) << "FramebufferUpdate: rectangles:" << fbu.totalRects;
     processFramebufferRects();
@@ -2348,18 +3081,23 @@ void QVncClient::Private::processFramebufferRects()
 {
     while (fbu.currentRect < fbu.totalRects) {
         if (!fbu.rectHeaderRead) {
-            if (socket->bytesAvailable() < 12) return;
+            if (receiveBuffer.bytesAvailable() < 12) return;
             read(&fbu.rect);
             qint32_be encodingType;
             read(&encodingType);
             fbu.encoding = encodingType;
             fbu.rectHeaderRead = true;
+            fbu.rectQueued = false;
+            fbu.rectOffset = streamPosition() - 12;
+            fbu.rectNsecs = 0;
             fbu.hextileTX = 0;
             fbu.hextileTY = 0;
+            fbu.hextileOffset = 0;
         }
 
         bool ok = false;
         bool isPseudoEncoding = false;
+        const qint64 started = clock.nsecsElapsed();
         switch (fbu.encoding) {
         case ZRLE:
             ok = handleZRLEEncoding(fbu.rect);
@@ -2372,9 +3110,15 @@ void QVncClient::Private::processFramebufferRects()
         case Hextile:
             ok = handleHextileEncoding(fbu.rect);
             break;
+        case OpenH264:
+            ok = handleOpenH264Encoding(fbu.rect);
+            break;
         case RawEncoding:
             ok = handleRawEncoding(fbu.rect);
             break;
+        case CopyRect:
+            ok = handleCopyRectEncoding(fbu.rect);
+            break;
         case CursorPseudoEncoding:
             ok = handleRichCursorEncoding(fbu.rect);
             isPseudoEncoding = true;
@@ -2383,23 +3127,125 @@ void QVncClient::Private::processFramebufferRects()
             ok = handleCursorPosEncoding(fbu.rect);
             isPseudoEncoding = true;
             break;
+        case DesktopSizePseudoEncoding:
+            ok = handleDesktopSizeEncoding(fbu.rect);
+            isPseudoEncoding = true;
+            break;
+        case ExtendedDesktopSizePseudoEncoding:
+            ok = handleExtendedDesktopSizeEncoding(fbu.rect);
+            isPseudoEncoding = true;
+            break;
         default:
             qCWarning(lcVncClient) << "Unsupported encoding:" << fbu.encoding;
             ok = true; // skip
             break;
         }
 
+        const qint64 nsecs = clock.nsecsElapsed() - started;
+        const qint64 pixels = isPseudoEncoding ? 0 : qint64(fbu.rect.w) * fbu.rect.h;
+        if (!isPseudoEncoding)
+            encodingTuner.addDecodeTime(fbu.encoding, nsecs, ok ? pixels : 0);
+        fbu.rectNsecs += nsecs;
         if (!ok) return; // not enough data, will resume on next readyRead
 
-        if (!isPseudoEncoding)
-            emit q->imageChanged(QRect(fbu.rect.x, fbu.rect.y, fbu.rect.w, fbu.rect.h));
+        QVncEncodingStatistics &counters = statistics.encodings[fbu.encoding];
+        ++counters.rects;
+        counters.pixels += pixels;
+        counters.bytes += streamPosition() - fbu.rectOffset;
+        counters.decodeNsecs += fbu.rectNsecs;
+        // Queued rects report their delay once decoded
+        if (!isPseudoEncoding && !fbu.rectQueued)
+            addQueueDelay(started - lastFillTime);
+
+        // Queued rects report their change once decoded
+        if (!isPseudoEncoding && !fbu.rectQueued)
+            rectChanged(QRect(fbu.rect.x, fbu.rect.y, fbu.rect.w, fbu.rect.h));
         fbu.rectHeaderRead = false;
         fbu.currentRect++;
+        // Large updates give the event loop a turn between rectangles
+        if (reading && fbu.currentRect < fbu.totalRects && readBudgetExceeded())
+            return;
     }
     fbu.active = false;
+    const qint64 updateBytes = streamPosition() - fbu.startOffset;
+    if (encodingTuner.updateFinished(updateBytes, streamPosition(), clock.nsecsElapsed())) {
+        const QVncEncodingTuner::Levels &levels = encodingTuner.levels();
+        qCDebug(lcVncClient) << "Measured" << encodingTuner.throughput() * 8 / 1e6 << "Mbit/s,"
+                             << "quality" << levels.quality << "compression" << levels.compression
+                             << (levels.preferRaw ? "preferring Raw" : "");
+        sendEncodings();
+    }
+    if (!decodeQueue.isIdle()) {
+        fbu.finishPending = true; // see the idle handler
+        return;
+    }
+    finishFramebufferUpdate();
+}
+
+/*!
+    \internal
+    Completes a framebuffer update once all of its rectangles are decoded
+    and asks for the next one.
+*/
+void QVncClient::Private::finishFramebufferUpdate()
+{
+    fbu.finishPending = false;
+    ++statistics.updates;
+    if (fbu.requestTime >= 0) {
+        const qint64 latency = clock.nsecsElapsed() - fbu.requestTime;
+        ++statistics.updateLatencySamples;
+        statistics.updateLatencyNsecs += latency;
+        statistics.lastUpdateLatencyNsecs = latency;
+        fbu.requestTime = -1;
+    }
+    if (!damage.isEmpty()) {
+        const QRegion region = damage.take();
+        frontBuffers.publish(image, region);
+        emit q->imageRegionChanged(region);
+    }
     emit q->framebufferUpdated();
-    if (framebufferUpdatesEnabled)
-        framebufferUpdateRequest();
+    // The server sends the next update on its own
+    if (continuousUpdatesActive) {
+        if (refreshPending && framebufferUpdatesEnabled) {
+            refreshPending = false;
+            enableContinuousUpdates(true); // for the new framebuffer size
+            framebufferUpdateRequest(false);
+        }
+        if (pixelFormatPending)
+            requestPixelFormatChange();
+        return;
+    }
+    requestNextUpdate();
+}
+
+void QVncClient::Private::requestNextUpdate()
+{
+    if (!framebufferUpdatesEnabled)
+        return;
+    const qint64 wait = updateInterval - (clock.nsecsElapsed() - lastRequestTime) / 1000000;
+    if (wait > 0) {
+        requestTimer->start(int(wait));
+        return;
+    }
+    // A new pixel format has to go out before the next request
+    const bool formatChanged = pixelFormatPending && applyPixelFormat();
+    framebufferUpdateRequest(!formatChanged && !refreshPending);
+    refreshPending = false;
+}
+
+void QVncClient::Private::applyUpdateInterval()
+{
+    if (state != WaitingState)
+        return;
+    if (updateInterval == 0)
+        startContinuousUpdates();
+    else if (continuousUpdatesActive && framebufferUpdatesEnabled)
+        enableContinuousUpdates(false); // acknowledged by EndOfContinuousUpdates
+    // Sooner or later than planned
+    if (requestTimer->isActive()) {
+        requestTimer->stop();
+        requestNextUpdate();
+    }
 }
 
 /*!
@@ -2408,65 +3254,82 @@ void QVncClient::Private::processFramebufferRects()
 
     The server sends the cursor shape as pixel data plus a bitmask.
     Rect header fields: x=hotspotX, y=hotspotY, w=cursorWidth, h=cursorHeight.
+
+    Shapes seen before are taken from the cursor cache instead of being
+    decoded again, and cursorChanged() is only emitted when the shape or
+    the hotspot differ from the current cursor.
 */
 bool QVncClient::Private::handleRichCursorEncoding(const Rectangle &rect)
 {
     const int w = rect.w;
     const int h = rect.h;
+    const QPoint hotspot(rect.x, rect.y);
 
     // Empty cursor (invisible)
     if (w == 0 || h == 0) {
+        if (cursorImage.isNull() && cursorKey.isEmpty() && cursorHotspot == hotspot)
+            return true;
         cursorImage = QImage();
-        cursorHotspot = QPoint(rect.x, rect.y);
+        cursorKey.clear();
+        cursorHotspot = hotspot;
         emit q->cursorChanged();
         return true;
     }
 
-    const int bpp = pixelFormat.bitsPerPixel / 8;
+    const int bpp = pixelConverter.bytesPerPixel();
     const qint64 pixelDataSize = static_cast<qint64>(w) * h * bpp;
     const int maskRowBytes = (w + 7) / 8;
     const qint64 maskSize = static_cast<qint64>(maskRowBytes) * h;
     const qint64 totalNeeded = pixelDataSize + maskSize;
 
-    if (socket->bytesAvailable() < totalNeeded)
+    if (receiveBuffer.bytesAvailable() < totalNeeded)
         return false;
 
-    const QByteArray pixelData = socket->read(pixelDataSize);
-    const QByteArray maskData = socket->read(maskSize);
-
-    QImage cursor(w, h, QImage::Format_ARGB32);
-    cursor.fill(Qt::transparent);
-
-    int pixelOffset = 0;
-    for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            // Check bitmask (MSB first within each byte)
-            const int maskByteIndex = y * maskRowBytes + (x / 8);
-            const int maskBit = 7 - (x % 8);
-            const bool visible = (maskData.at(maskByteIndex) >> maskBit) & 1;
-
-            if (visible) {
-                // Decode pixel using current pixelFormat (same as handleRawEncoding)
-                switch (bpp) {
-                case 4: {
-                    quint32 color;
-                    memcpy(&color, pixelData.constData() + pixelOffset, 4);
-                    const auto r = (color >> pixelFormat.redShift) & pixelFormat.redMax;
-                    const auto g = (color >> pixelFormat.greenShift) & pixelFormat.greenMax;
-                    const auto b = (color >> pixelFormat.blueShift) & pixelFormat.blueMax;
-                    cursor.setPixel(x, y, qRgba(r, g, b, 255));
-                    break;
+    const uchar *src = receiveBuffer.data();
+    const uchar *mask = src + pixelDataSize;
+    QByteArray key = QVncCursorCache::key(w, h, src, totalNeeded);
+    receiveBuffer.skip(totalNeeded);
+
+    // Busy and arrow toggles resend the same shape over and over
+    if (key == cursorKey) {
+        if (cursorHotspot == hotspot)
+            return true;
+        cursorHotspot = hotspot;
+        emit q->cursorChanged();
+        return true;
+    }
+
+    QImage cursor = cursorCache.find(key);
+    if (cursor.isNull()) {
+        cursor = QImage(w, h, QImage::Format_ARGB32);
+        QVncPixelWriter writer(cursor);
+        for (int y = 0; y < h; y++, src += w * bpp) {
+            QRgb *dst = writer.scanLine(y);
+            pixelConverter.convertRow(src, dst, w);
+            // Clear pixels hidden by the bitmask (MSB first within each
+            // byte); mostly whole bytes are opaque or hidden
+            const uchar *maskRow = mask + y * maskRowBytes;
+            for (int x = 0; x < w; x += 8) {
+                const uchar bits = maskRow[x / 8];
+                const int n = qMin(8, w - x);
+                if (bits == 0xff)
+                    continue;
+                if (bits == 0) {
+                    std::fill_n(dst + x, n, QRgb(0));
+                    continue;
                 }
-                default:
-                    break;
+                for (int i = 0; i < n; i++) {
+                    if (!(bits & (0x80 >> i)))
+                        dst[x + i] = 0;
                 }
             }
-            pixelOffset += bpp;
         }
+        cursorCache.insert(key, cursor);
     }
 
     cursorImage = cursor;
-    cursorHotspot = QPoint(rect.x, rect.y);
+    cursorKey = std::move(key);
+    cursorHotspot = hotspot;
     emit q->cursorChanged();
     return true;
 }
@@ -2485,74 +3348,297 @@ bool QVncClient::Private::handleCursorPosEncoding(const Rectangle &rect)
     return true;
 }
 
-void QVncClient::Private::restartFramebufferUpdates()
+/*!
+    \internal
+    Handles DesktopSize pseudo-encoding (-223).
+
+    The server resized the framebuffer to the rect's width and height, for
+    example after SetScale or a change of the remote display's resolution.
+    No additional data follows. Rectangles after this one are for the new
+    framebuffer, which keeps the pixels both sizes cover until the next
+    request refreshes all of it.
+*/
+bool QVncClient::Private::handleDesktopSizeEncoding(const Rectangle &rect)
 {
-    if (state == WaitingState && !fbu.active)
-        framebufferUpdateRequest(false);
+    if (rect.w == frameBufferWidth && rect.h == frameBufferHeight)
+        return true;
+    qCDebug(lcVncClient) << "Framebuffer resized to" << rect.w << "x" << rect.h;
+    resizeFramebuffer(rect.w, rect.h);
+    damage.clear();
+    damage.add(image.rect());
+    refreshPending = true;
+    // Receivers may take a new imageView() here
+    emit q->framebufferSizeChanged(frameBufferWidth, frameBufferHeight);
+    if (screenLayout.isEmpty())
+        emit q->screensChanged(); // the one screen covers the framebuffer
+    return true;
 }
 
 /*!
     \internal
-    Handles raw-encoded rectangle data.
-    
-    \param rect The rectangle dimensions.
-    
-    Raw encoding sends uncompressed pixel data for each pixel in the rectangle.
+    Handles ExtendedDesktopSize pseudo-encoding (-308).
+
+    Like DesktopSize, but followed by the screen layout: a U8 number of
+    screens, 3 bytes of padding, and per screen a U32 id, U16 x, y, width
+    and height, and U32 flags. The rect's x is the reason for the change
+    and y the status of a request of ours, which is only reported; this
+    client does not send SetDesktopSize.
 */
-bool QVncClient::Private::handleRawEncoding(const Rectangle &rect)
+bool QVncClient::Private::handleExtendedDesktopSizeEncoding(const Rectangle &rect)
 {
-    const qint64 needed = static_cast<qint64>(rect.w) * rect.h * pixelFormat.bitsPerPixel / 8;
-    if (socket->bytesAvailable() < needed)
+    constexpr int headerSize = 4;
+    constexpr int screenSize = 16;
+    if (receiveBuffer.bytesAvailable() < headerSize)
+        return false;
+    const uchar *p = receiveBuffer.data();
+    const int count = p[0];
+    if (receiveBuffer.bytesAvailable() < headerSize + count * screenSize)
         return false;
 
-    for (int y = 0; y < rect.h; y++) {
-        for (int x = 0; x < rect.w; x++) {
-            switch (pixelFormat.bitsPerPixel) {
-            case 32: {
-                quint32_le color;
-                read(&color);
-                const auto r = (color >> pixelFormat.redShift) & pixelFormat.redMax;
-                const auto g = (color >> pixelFormat.greenShift) & pixelFormat.greenMax;
-                const auto b = (color >> pixelFormat.blueShift) & pixelFormat.blueMax;
-                image.setPixel(rect.x + x, rect.y + y, qRgb(r, g, b));
-                break; }
-            default:
-                qCWarning(lcVncClient) << pixelFormat.bitsPerPixel << "bits per pixel not supported";
-                return true; // skip
-            }
-        }
+    QList<QVncScreen> layout;
+    layout.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const uchar *screen = p + headerSize + i * screenSize;
+        QVncScreen info;
+        info.id = qFromBigEndian<quint32>(screen);
+        info.geometry = QRect(qFromBigEndian<quint16>(screen + 4), qFromBigEndian<quint16>(screen + 6),
+                              qFromBigEndian<quint16>(screen + 8), qFromBigEndian<quint16>(screen + 10));
+        info.flags = qFromBigEndian<quint32>(screen + 12);
+        layout.append(info);
     }
+    receiveBuffer.skip(headerSize + count * screenSize);
+
+    if (rect.y != 0) {
+        qCWarning(lcVncClient) << "Desktop size change refused by the server, status" << rect.y;
+        return true;
+    }
+    qCDebug(lcVncClient) << "Desktop size" << rect.w << "x" << rect.h << "with" << count
+                         << "screens, reason" << rect.x;
+    const bool resized = rect.w != frameBufferWidth || rect.h != frameBufferHeight;
+    if (resized) {
+        resizeFramebuffer(rect.w, rect.h);
+        damage.clear();
+        damage.add(image.rect());
+        refreshPending = true;
+        emit q->framebufferSizeChanged(frameBufferWidth, frameBufferHeight);
+    }
+    if (layout != screenLayout || resized)
+        setScreens(layout);
     return true;
 }
 
 /*!
     \internal
-    Handles hextile-encoded rectangle data.
-    
-    \param rect The rectangle dimensions.
-    
-    Hextile encoding divides the rectangle into 16x16 tiles, each with its own
-    subencoding that can include background colors, foreground colors, and subrectangles.
+    Resizes the framebuffer to \a width x \a height, keeping the pixels
+    the old and the new size both cover; the rest is white.
+
+    When nobody holds a copy of the framebuffer and the new size fits into
+    its memory, for example when a monitor is unplugged or the remote
+    resolution goes down and back up, the memory is kept: the new image
+    uses the old one's stride, so the pixels it keeps do not even move.
 */
-bool QVncClient::Private::handleHextileEncoding(const Rectangle &rect)
+void QVncClient::Private::resizeFramebuffer(int width, int height)
 {
-    const int tileWidth = 16;
-    const int tileHeight = 16;
-    const int bpp = pixelFormat.bitsPerPixel / 8;
+    decodeQueue.waitForDone(); // jobs write into the old framebuffer
+    const QImage::Format format = QImage::Format_RGB32;
+    const int oldWidth = image.width();
+    const int oldHeight = image.height();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    // A decoder writing into a shared image moved it to new memory
+    const int rows = image.constBits() == framebufferMemory.bits ? framebufferMemory.rows : oldHeight;
+    if (!image.isNull() && image.isDetached() && width > 0 && height > 0
+            && qsizetype(width) * 4 <= bytesPerLine && height <= rows) {
+        // The old image owns the memory until the new one is released
+        QImage *owner = new QImage(std::move(image));
+        image = QImage(owner->bits(), width, height, bytesPerLine, format,
+                       [](void *owner) { delete static_cast<QImage *>(owner); }, owner);
+        framebufferMemory = { image.constBits(), rows };
+        // What was outside the old size is left over from before
+        const QRect kept(0, 0, oldWidth, oldHeight);
+        const QRgb blank = lazyFramebuffer ? qRgb(0, 0, 0) : qRgb(255, 255, 255);
+        for (const QRect &exposed : QRegion(image.rect()) - kept) {
+            for (int y = exposed.top(); y <= exposed.bottom(); y++)
+                std::fill_n(reinterpret_cast<QRgb *>(image.scanLine(y)) + exposed.x(), exposed.width(), blank);
+        }
+    } else {
+        // Lazily allocated memory starts out black and is not touched here
+        QImage resized = lazyFramebuffer ? QVncFramebufferMemory::allocate(width, height) : QImage();
+        if (resized.isNull()) {
+            resized = QImage(width, height, format);
+            resized.fill(Qt::white);
+        }
+        const int keptRows = qMin(height, oldHeight);
+        const size_t rowSize = size_t(qMin(width, oldWidth)) * 4;
+        for (int y = 0; y < keptRows; y++)
+            memcpy(resized.scanLine(y), image.constScanLine(y), rowSize);
+        image = resized;
+        framebufferMemory = { image.constBits(), height };
+    }
+    frameBufferWidth = width;
+    frameBufferHeight = height;
+}
 
-    quint32 &backgroundColor = fbu.hextileBG;
-    quint32 &foregroundColor = fbu.hextileFG;
+void QVncClient::Private::setScreens(const QList<QVncScreen> &layout)
+{
+    screenLayout = layout;
+    emit q->screensChanged();
+}
 
-    for (int &ty = fbu.hextileTY; ty < rect.h; ty += tileHeight) {
-        const int th = qMin(tileHeight, rect.h - ty);
+void QVncClient::Private::restartFramebufferUpdates()
+{
+    if (state != WaitingState)
+        return;
+    requestTimer->stop();
+    if (!framebufferUpdatesEnabled) {
+        if (continuousUpdatesActive)
+            enableContinuousUpdates(false); // acknowledged by EndOfContinuousUpdates
+        return;
+    }
+    if (!fbu.active) {
+        if (pixelFormatPending && !updateRequestPending && !continuousUpdatesActive)
+            applyPixelFormat();
+        framebufferUpdateRequest(false);
+        refreshPending = false;
+    }
+    startContinuousUpdates();
+}
+
+/*!
+    \internal
+    Handles raw-encoded rectangle data.
+    
+    \param rect The rectangle dimensions.
+    
+    Raw encoding sends uncompressed pixel data for each pixel in the rectangle.
+*/
+bool QVncClient::Private::handleRawEncoding(const Rectangle &rect)
+{
+    const qint64 needed = static_cast<qint64>(rect.w) * rect.h * pixelFormat.bitsPerPixel / 8;
+    if (receiveBuffer.bytesAvailable() < needed)
+        return false;
+
+    if (pixelFormat.bitsPerPixel != 8 && pixelFormat.bitsPerPixel != 16 && pixelFormat.bitsPerPixel != 32) {
+        qCWarning(lcVncClient) << pixelFormat.bitsPerPixel << "bits per pixel not supported";
+        receiveBuffer.skip(needed);
+        return true;
+    }
+
+    QByteArray payload;
+    const uchar *data = keepPayload(receiveBuffer.data(), needed, &payload);
+    receiveBuffer.skip(needed);
+
+    // Convert one row at a time straight from the payload
+    decodeRect(rect, [this, rect, data, payload](QVncPixelWriter &writer) {
+        const qsizetype rowBytes = qsizetype(rect.w) * pixelConverter.bytesPerPixel();
+        const uchar *src = data;
+        for (int y = 0; y < rect.h; y++, src += rowBytes) {
+            QRgb *dst = writer.beginRow(rect.x, rect.y + y, rect.w);
+            pixelConverter.convertRow(src, dst, rect.w);
+            writer.endRow();
+        }
+    });
+    return true;
+}
+
+/*!
+    \internal
+    Handles Open H.264 rectangle data.
+
+    \param rect The rectangle, which identifies the H.264 stream.
+
+    The payload is a 4 byte length, 4 bytes of flags that reset this or all
+    streams, and one access unit of the stream. The frame is decoded into
+    the framebuffer at \a rect, on a decode worker when those are enabled;
+    rectangles of the same stream overlap, so they are decoded in order.
+*/
+bool QVncClient::Private::handleOpenH264Encoding(const Rectangle &rect)
+{
+    if (receiveBuffer.bytesAvailable() < 8)
+        return false;
+    const uchar *header = receiveBuffer.data();
+    const qint64 length = qFromBigEndian<quint32>(header);
+    const quint32 flags = qFromBigEndian<quint32>(header + 4);
+    if (receiveBuffer.bytesAvailable() < 8 + length)
+        return false;
+    receiveBuffer.skip(8);
+
+    const QRect area(rect.x, rect.y, rect.w, rect.h);
+    const std::shared_ptr<QVncH264Decoder::Context> context = h264Decoder.context(area, flags);
+    if (!context || length == 0) {
+        if (!context && length > 0)
+            qCWarning(lcVncClient) << "No H.264 decoder for Open H.264 rectangle";
+        receiveBuffer.skip(length);
+        return true;
+    }
+
+    QByteArray payload;
+    const uchar *data = keepPayload(receiveBuffer.data(), length, &payload);
+    receiveBuffer.skip(length);
+    decodeRect(rect, [context, data, length, payload, area](QVncPixelWriter &writer) {
+        if (!QVncH264Decoder::decode(*context, data, length, writer, area))
+            qCWarning(lcVncClient) << "Failed to decode H.264 data for Open H.264 encoding";
+    });
+    return true;
+}
+
+/*!
+    \internal
+    Handles CopyRect-encoded rectangle data.
+
+    \param rect The destination rectangle.
+
+    The server only sends the position of a source rectangle that the client
+    already has, so scrolls and window moves cost 4 bytes instead of pixel
+    data. Source and destination may overlap.
+*/
+bool QVncClient::Private::handleCopyRectEncoding(const Rectangle &rect)
+{
+    if (receiveBuffer.bytesAvailable() < 4)
+        return false;
+
+    quint16_be srcX;
+    read(&srcX);
+    quint16_be srcY;
+    read(&srcY);
+
+    // The source has to be complete, so this waits for jobs writing to it
+    const int x = srcX;
+    const int y = srcY;
+    decodeRect(rect, [rect, x, y](QVncPixelWriter &writer) {
+        writer.copyRect(x, y, rect.x, rect.y, rect.w, rect.h);
+    }, QRect(x, y, rect.w, rect.h));
+    return true;
+}
+
+/*!
+    \internal
+    Handles hextile-encoded rectangle data.
+    
+    \param rect The rectangle dimensions.
+    
+    Hextile encoding divides the rectangle into 16x16 tiles, each with its own
+    subencoding that can include background colors, foreground colors, and subrectangles.
+*/
+bool QVncClient::Private::handleHextileEncoding(const Rectangle &rect)
+{
+    const int tileWidth = 16;
+    const int tileHeight = 16;
+    const int bpp = pixelFormat.bitsPerPixel / 8;
+
+    // Find the end of the rectangle before consuming anything. Scanning
+    // resumes where it stopped when the data was incomplete.
+    const qint64 available = receiveBuffer.bytesAvailable();
+    const uchar *data = receiveBuffer.data();
+    qint64 &offset = fbu.hextileOffset;
+
+    for (int &ty = fbu.hextileTY; ty < rect.h; ty += tileHeight) {
+        const int th = qMin(tileHeight, rect.h - ty);
 
         for (int &tx = fbu.hextileTX; tx < rect.w; tx += tileWidth) {
             const int tw = qMin(tileWidth, rect.w - tx);
 
-            // Peek at subencoding to calculate tile data size before consuming
-            if (socket->bytesAvailable() < 1) return false;
-            const QByteArray peek = socket->peek(qMin(socket->bytesAvailable(), qint64(2048)));
-            const quint8 subencoding = static_cast<quint8>(peek.at(0));
+            if (available <= offset) return false;
+            const quint8 subencoding = data[offset];
 
             qint64 tileBytes = 1; // subencoding byte
             if (subencoding & RawSubencoding) {
@@ -2562,97 +3648,99 @@ bool QVncClient::Private::handleHextileEncoding(const Rectangle &rect)
                 if (subencoding & AnySubrects) {
                     if (subencoding & ForegroundSpecified) tileBytes += bpp;
                     tileBytes += 1; // numSubrects byte
-                    if (peek.size() < tileBytes) return false;
-                    const quint8 numSubrects = static_cast<quint8>(peek.at(tileBytes - 1));
+                    if (available < offset + tileBytes) return false;
+                    const quint8 numSubrects = data[offset + tileBytes - 1];
                     const int subrectSize = (subencoding & SubrectsColoured) ? bpp + 2 : 2;
                     tileBytes += numSubrects * subrectSize;
                 }
             }
 
-            if (socket->bytesAvailable() < tileBytes) return false;
+            if (available < offset + tileBytes) return false;
+            offset += tileBytes;
+        }
+        fbu.hextileTX = 0;
+    }
+    fbu.hextileTY = 0;
+
+    // All tiles available — consume and decode
+    const qint64 size = offset;
+    offset = 0;
+    QByteArray payload;
+    const uchar *p = keepPayload(data, size, &payload);
+    receiveBuffer.skip(size);
+
+    decodeRect(rect, [this, rect, p, payload](QVncPixelWriter &writer) {
+        decodeHextile(p, rect, writer);
+    });
+    return true;
+}
+
+/*!
+    \internal
+    Decodes the complete hextile data \a p of \a rect into \a writer.
+*/
+void QVncClient::Private::decodeHextile(const uchar *p, const Rectangle &rect, QVncPixelWriter &writer) const
+{
+    const int tileWidth = 16;
+    const int tileHeight = 16;
+    const int bpp = pixelConverter.bytesPerPixel();
+
+    QRgb backgroundColor = 0;
+    QRgb foregroundColor = 0;
+
+    for (int ty = 0; ty < rect.h; ty += tileHeight) {
+        const int th = qMin(tileHeight, rect.h - ty);
 
-            // All tile data available — consume and process
-            quint8 sub;
-            read(&sub);
+        for (int tx = 0; tx < rect.w; tx += tileWidth) {
+            const int tw = qMin(tileWidth, rect.w - tx);
+            const quint8 sub = *p++;
+            const int px = rect.x + tx;
+            const int py = rect.y + ty;
 
             if (sub & RawSubencoding) {
-                for (int y = 0; y < th; y++) {
-                    for (int x = 0; x < tw; x++) {
-                        if (bpp == 4) {
-                            quint32_le color;
-                            read(&color);
-                            const auto r = (color >> pixelFormat.redShift) & pixelFormat.redMax;
-                            const auto g = (color >> pixelFormat.greenShift) & pixelFormat.greenMax;
-                            const auto b = (color >> pixelFormat.blueShift) & pixelFormat.blueMax;
-                            image.setPixel(rect.x + tx + x, rect.y + ty + y, qRgb(r, g, b));
-                        }
-                    }
+                for (int y = 0; y < th; y++, p += tw * bpp) {
+                    QRgb *dst = writer.beginRow(px, py + y, tw);
+                    pixelConverter.convertRow(p, dst, tw);
+                    writer.endRow();
                 }
                 continue;
             }
 
             if (sub & BackgroundSpecified) {
-                if (bpp == 4) {
-                    quint32_le bg;
-                    read(&bg);
-                    backgroundColor = bg;
-                }
+                backgroundColor = pixelConverter.pixel(p);
+                p += bpp;
             }
 
-            for (int y = 0; y < th; y++) {
-                for (int x = 0; x < tw; x++) {
-                    const auto r = (backgroundColor >> pixelFormat.redShift) & pixelFormat.redMax;
-                    const auto g = (backgroundColor >> pixelFormat.greenShift) & pixelFormat.greenMax;
-                    const auto b = (backgroundColor >> pixelFormat.blueShift) & pixelFormat.blueMax;
-                    image.setPixel(rect.x + tx + x, rect.y + ty + y, qRgb(r, g, b));
-                }
-            }
+            writer.fillRect(px, py, tw, th, backgroundColor);
 
             if (sub & AnySubrects) {
                 if (sub & ForegroundSpecified) {
-                    if (bpp == 4) {
-                        quint32_le fg;
-                        read(&fg);
-                        foregroundColor = fg;
-                    }
+                    foregroundColor = pixelConverter.pixel(p);
+                    p += bpp;
                 }
 
-                quint8 numSubrects;
-                read(&numSubrects);
+                const quint8 numSubrects = *p++;
 
                 for (int i = 0; i < numSubrects; i++) {
-                    quint32 color = foregroundColor;
+                    QRgb color = foregroundColor;
                     if (sub & SubrectsColoured) {
-                        if (bpp == 4) {
-                            quint32_le c;
-                            read(&c);
-                            color = c;
-                        }
+                        color = pixelConverter.pixel(p);
+                        p += bpp;
                     }
-                    quint8 xy, wh;
-                    read(&xy);
-                    read(&wh);
+                    const quint8 xy = *p++;
+                    const quint8 wh = *p++;
 
                     const int sx = (xy >> 4) & 0xf;
                     const int sy = xy & 0xf;
-                    const int sw = ((wh >> 4) & 0xf) + 1;
-                    const int sh = (wh & 0xf) + 1;
-
-                    for (int y = 0; y < sh && sy + y < th; y++) {
-                        for (int x = 0; x < sw && sx + x < tw; x++) {
-                            const auto r = (color >> pixelFormat.redShift) & pixelFormat.redMax;
-                            const auto g = (color >> pixelFormat.greenShift) & pixelFormat.greenMax;
-                            const auto b = (color >> pixelFormat.blueShift) & pixelFormat.blueMax;
-                            image.setPixel(rect.x + tx + sx + x, rect.y + ty + sy + y, qRgb(r, g, b));
-                        }
-                    }
+                    const int sw = qMin(((wh >> 4) & 0xf) + 1, tw - sx);
+                    const int sh = qMin((wh & 0xf) + 1, th - sy);
+
+                    if (sw > 0 && sh > 0)
+                        writer.fillRect(px + sx, py + sy, sw, sh, color);
                 }
             }
         }
-        fbu.hextileTX = 0;
     }
-    fbu.hextileTY = 0;
-    return true;
 }
 
 /*!
@@ -2666,61 +3754,70 @@ bool QVncClient::Private::handleHextileEncoding(const Rectangle &rect)
 */
 bool QVncClient::Private::handleZRLEEncoding(const Rectangle &rect)
 {
-    // Peek at the 4-byte length prefix to check total availability
-    if (socket->bytesAvailable() < 4) return false;
-    const QByteArray lenPeek = socket->peek(4);
-    quint32_be zlibDataLength;
-    memcpy(&zlibDataLength, lenPeek.constData(), 4);
-
-    if (zlibDataLength == 0) {
-        socket->read(4); // consume the length
-        return true;
-    }
+    // Look at the 4-byte length prefix to check total availability
+    if (receiveBuffer.bytesAvailable() < 4) return false;
+    const quint32 zlibDataLength = qFromBigEndian<quint32>(receiveBuffer.data());
 
-    if (socket->bytesAvailable() < 4 + static_cast<qint64>(zlibDataLength))
+    if (receiveBuffer.bytesAvailable() < 4 + static_cast<qint64>(zlibDataLength))
         return false;
 
-    // All data available — consume
-    read(&zlibDataLength);
-    QByteArray compressedData = socket->read(zlibDataLength);
+    // All data available — consume, inflating straight from the receive buffer
+    const uchar *compressedData = receiveBuffer.data() + 4;
+    receiveBuffer.skip(4 + static_cast<qint64>(zlibDataLength));
+    if (zlibDataLength == 0)
+        return true;
 
     // Decompress using persistent zlib stream (dictionary reuse across rects)
-    QByteArray uncompressedData;
 #ifdef USE_ZLIB
-    if (!zrleStreamActive) {
-        memset(&zrleStream, 0, sizeof(zrleStream));
-        zrleStream.zalloc = Z_NULL;
-        zrleStream.zfree = Z_NULL;
-        zrleStream.opaque = Z_NULL;
-        zrleStream.avail_in = 0;
-        zrleStream.next_in = Z_NULL;
-        if (inflateInit(&zrleStream) != Z_OK) {
-            qCWarning(lcVncClient) << "Failed to initialize ZRLE zlib stream";
-            return true;
-        }
-        zrleStreamActive = true;
+    if (!zrleStream.isActive() && !zrleStream.reset()) {
+        qCWarning(lcVncClient) << "Failed to initialize ZRLE zlib stream";
+        return true;
     }
-
-    zrleStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressedData.data()));
-    zrleStream.avail_in = compressedData.size();
-
-    do {
-        int prevSize = uncompressedData.size();
-        uncompressedData.resize(prevSize + 65536);
-        zrleStream.next_out = reinterpret_cast<Bytef*>(uncompressedData.data() + prevSize);
-        zrleStream.avail_out = 65536;
-
-        int ret = inflate(&zrleStream, Z_SYNC_FLUSH);
-        uncompressedData.resize(prevSize + 65536 - zrleStream.avail_out);
-
-        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
-            qCWarning(lcVncClient) << "ZRLE zlib inflate failed:" << ret;
+    zrleStream.setInput(compressedData, zlibDataLength);
+
+    // Inflate into the reused buffer, sized for raw tiles, which is as large
+    // as tiles normally get. Plain RLE runs of one pixel can take more, up
+    // to the bound; the buffer grows for those.
+    const qsizetype cpixel = cpixelConverter.bytesPerPixel();
+    const qsizetype tiles = qsizetype((rect.w + 63) / 64) * ((rect.h + 63) / 64);
+    const qsizetype estimate = qsizetype(rect.w) * rect.h * cpixel + tiles;
+    const qsizetype bound = qsizetype(rect.w) * rect.h * (cpixel + 1) + tiles * (1 + 127 * cpixel);
+    // Rectangles this large are rare; do not hold on to the memory
+    constexpr qsizetype maxKeptSize = 16 * 1024 * 1024;
+    QByteArray *uncompressed = &zrleBuffer.resize(qMax<qsizetype>(estimate, 65536));
+    qsizetype produced = 0;
+    for (;;) {
+        const qsizetype space = uncompressed->size() - produced;
+        qsizetype written = 0;
+        const qint64 started = clock.nsecsElapsed();
+        const QVncInflater::Result ret = zrleStream.inflate(reinterpret_cast<uchar *>(uncompressed->data() + produced),
+                                                            space, &written);
+        statistics.inflateNsecs += clock.nsecsElapsed() - started;
+        produced += written;
+
+        if (ret == QVncInflater::Error) {
+            qCWarning(lcVncClient) << "ZRLE zlib inflate failed:" << zrleStream.errorString();
+            if (estimate > maxKeptSize)
+                zrleBuffer.trim(maxKeptSize);
             return true;
         }
-        if (ret == Z_STREAM_END || zrleStream.avail_in == 0)
+        // A full buffer may leave output in the stream even when all input
+        // is consumed, such as the end of a match; it belongs to this rect
+        if (ret == QVncInflater::StreamEnd || written < space)
+            break;
+        // Only malformed data gets past the bound
+        if (uncompressed->size() >= bound) {
+            qCWarning(lcVncClient) << "ZRLE data exceeds the rectangle";
             break;
-    } while (zrleStream.avail_out == 0);
+        }
+        uncompressed = &zrleBuffer.grow(qMin(2 * uncompressed->size(), bound), produced);
+    }
+    uncompressed->resize(produced);
+    const QByteArray uncompressedData = *uncompressed;
+    if (estimate > maxKeptSize)
+        zrleBuffer.trim(maxKeptSize);
 #else
+    const QByteArray uncompressedData;
     qCWarning(lcVncClient) << "ZRLE encoding requires zlib support";
     return true;
 #endif
@@ -2730,173 +3827,316 @@ bool QVncClient::Private::handleZRLEEncoding(const Rectangle &rect)
         return true;
     }
 
-    // CPIXEL size: 3 bytes when bpp=32, trueColor, all maxes <= 255
-    const int cpixelSize = (pixelFormat.bitsPerPixel == 32 && pixelFormat.trueColourFlag
-        && pixelFormat.redMax <= 255 && pixelFormat.greenMax <= 255
-        && pixelFormat.blueMax <= 255) ? 3 : (pixelFormat.bitsPerPixel / 8);
+    // The zlib stream is ordered, the tiles it inflated to are not
+    decodeRect(rect, [this, rect, uncompressedData](QVncPixelWriter &writer) {
+        decodeZrle(uncompressedData, rect, writer);
+    });
+    return true;
+}
 
-    const char *buf = uncompressedData.constData();
-    const int bufSize = uncompressedData.size();
-    int dataOffset = 0;
+/*!
+    \internal
+    Returns the offset in \a buf just past the ZRLE tile of \a tw x \a th
+    pixels starting at \a offset, without decoding it, or -1 if the tile is
+    truncated or uses an unknown subencoding.
+*/
+static int zrleTileEnd(const uchar *buf, int bufSize, int offset, int tw, int th, int cpixelSize)
+{
+    if (offset >= bufSize)
+        return -1;
+    const quint8 subencoding = buf[offset++];
+    const int totalPixels = tw * th;
+
+    // Skips a run length; returns false when the data ends first
+    auto skipRunLength = [&](int *runLength) {
+        *runLength = 0;
+        quint8 b;
+        do {
+            if (offset >= bufSize) return false;
+            b = buf[offset++];
+            *runLength += b;
+        } while (b == 255);
+        *runLength += 1;
+        return true;
+    };
 
-    // Helper to read a CPIXEL from the decompressed buffer
-    auto readCPixel = [&]() -> quint32 {
-        quint32 color = 0;
-        if (dataOffset + cpixelSize > bufSize) return 0;
-        if (cpixelSize == 3) {
-            if (pixelFormat.bigEndianFlag) {
-                color = (static_cast<quint8>(buf[dataOffset]) << 16)
-                      | (static_cast<quint8>(buf[dataOffset + 1]) << 8)
-                      | static_cast<quint8>(buf[dataOffset + 2]);
+    if (subencoding == 0) {
+        offset += totalPixels * cpixelSize;
+    } else if (subencoding == 1) {
+        offset += cpixelSize;
+    } else if (subencoding >= 2 && subencoding <= 16) {
+        const int bitsPerIndex = (subencoding == 2) ? 1 : (subencoding <= 4) ? 2 : 4;
+        offset += subencoding * cpixelSize + th * ((tw * bitsPerIndex + 7) / 8);
+    } else if (subencoding == 128) {
+        for (int pixels = 0, runLength = 0; pixels < totalPixels; pixels += runLength) {
+            offset += cpixelSize;
+            if (!skipRunLength(&runLength)) return -1;
+        }
+    } else if (subencoding >= 130) {
+        offset += (subencoding - 128) * cpixelSize;
+        for (int pixels = 0; pixels < totalPixels;) {
+            if (offset >= bufSize) return -1;
+            if (buf[offset++] & 0x80) {
+                int runLength;
+                if (!skipRunLength(&runLength)) return -1;
+                pixels += runLength;
             } else {
-                color = static_cast<quint8>(buf[dataOffset])
-                      | (static_cast<quint8>(buf[dataOffset + 1]) << 8)
-                      | (static_cast<quint8>(buf[dataOffset + 2]) << 16);
+                pixels++;
             }
-        } else if (cpixelSize == 4) {
-            memcpy(&color, buf + dataOffset, 4);
-        } else if (cpixelSize == 2) {
-            memcpy(&color, buf + dataOffset, 2);
-        } else {
-            color = static_cast<quint8>(buf[dataOffset]);
         }
-        dataOffset += cpixelSize;
-        return color;
-    };
+    } else {
+        return -1;
+    }
+    return offset <= bufSize ? offset : -1;
+}
 
-    auto toRgb = [&](quint32 color) -> QRgb {
-        const auto r = (color >> pixelFormat.redShift) & pixelFormat.redMax;
-        const auto g = (color >> pixelFormat.greenShift) & pixelFormat.greenMax;
-        const auto b = (color >> pixelFormat.blueShift) & pixelFormat.blueMax;
-        return qRgb(r, g, b);
-    };
+/*!
+    \internal
+    Decodes the inflated ZRLE tiles \a data of \a rect into \a writer.
 
+    With decode workers, large rectangles are split: a quick scan finds
+    where each tile starts, then the tiles are decoded in parallel.
+*/
+void QVncClient::Private::decodeZrle(const QByteArray &data, const Rectangle &rect, QVncPixelWriter &writer) const
+{
     // Each tile is 64x64 pixels
     const int tileWidth = 64;
     const int tileHeight = 64;
+    // Below this the scan costs more than the threads gain
+    const int minParallelTiles = 16;
+
+    const uchar *buf = reinterpret_cast<const uchar *>(data.constData());
+    const int bufSize = data.size();
+    const int columns = (rect.w + tileWidth - 1) / tileWidth;
+    const int rows = (rect.h + tileHeight - 1) / tileHeight;
+
+    if (decodeQueue.workerCount() < 2 || columns * rows < minParallelTiles) {
+        int dataOffset = 0;
+        for (int ty = 0; ty < rect.h && dataOffset >= 0; ty += tileHeight) {
+            const int th = qMin(tileHeight, rect.h - ty);
+            for (int tx = 0; tx < rect.w && dataOffset >= 0; tx += tileWidth) {
+                const int tw = qMin(tileWidth, rect.w - tx);
+                dataOffset = decodeZrleTile(buf, bufSize, dataOffset, rect.x + tx, rect.y + ty, tw, th, writer);
+            }
+        }
+        return;
+    }
 
-    for (int ty = 0; ty < rect.h; ty += tileHeight) {
-        const int th = qMin(tileHeight, rect.h - ty);
+    // Phase 1: tile offsets. Decoding stops at the first damaged tile,
+    // as the tiles after it cannot be located.
+    const int cpixelSize = cpixelConverter.bytesPerPixel();
+    QList<int> offsets;
+    offsets.reserve(columns * rows);
+    for (int offset = 0; offset >= 0 && offsets.size() < columns * rows;) {
+        const int i = offsets.size();
+        const int tw = qMin(tileWidth, rect.w - (i % columns) * tileWidth);
+        const int th = qMin(tileHeight, rect.h - (i / columns) * tileHeight);
+        offsets.append(offset);
+        offset = zrleTileEnd(buf, bufSize, offset, tw, th, cpixelSize);
+    }
 
-        for (int tx = 0; tx < rect.w; tx += tileWidth) {
-            const int tw = qMin(tileWidth, rect.w - tx);
+    // Phase 2: every tile on its own
+    decodeQueue.parallelFor(offsets.size(), [&](int i) {
+        const int tx = (i % columns) * tileWidth;
+        const int ty = (i / columns) * tileHeight;
+        QVncPixelWriter tileWriter = writer;
+        decodeZrleTile(buf, bufSize, offsets.at(i), rect.x + tx, rect.y + ty,
+                       qMin(tileWidth, rect.w - tx), qMin(tileHeight, rect.h - ty), tileWriter);
+    });
+}
 
-            if (dataOffset >= bufSize) {
-                qCWarning(lcVncClient) << "ZRLE data truncated (subencoding)";
-                return true;
-            }
+/*!
+    \internal
+    Decodes the ZRLE tile at \a dataOffset of \a buf into the \a tw x
+    \a th pixels at \a px, \a py. Returns the offset of the next tile, or -1
+    if the data ended before the tile did.
+*/
+int QVncClient::Private::decodeZrleTile(const uchar *buf, int bufSize, int dataOffset,
+                                        int px, int py, int tw, int th, QVncPixelWriter &writer) const
+{
+    // CPIXEL size: 3 bytes when bpp=32, trueColor, all maxes <= 255
+    const QVncPixelConverter &converter = cpixelConverter;
+    const int cpixelSize = converter.bytesPerPixel();
 
-            const quint8 subencoding = static_cast<quint8>(buf[dataOffset++]);
-
-            if (subencoding == 0) {
-                // Raw pixels: cpixelSize * tw * th bytes
-                for (int y = 0; y < th; y++)
-                    for (int x = 0; x < tw; x++)
-                        image.setPixel(rect.x + tx + x, rect.y + ty + y, toRgb(readCPixel()));
-
-            } else if (subencoding == 1) {
-                // Solid tile: 1 CPIXEL
-                QRgb rgb = toRgb(readCPixel());
-                for (int y = 0; y < th; y++)
-                    for (int x = 0; x < tw; x++)
-                        image.setPixel(rect.x + tx + x, rect.y + ty + y, rgb);
-
-            } else if (subencoding >= 2 && subencoding <= 16) {
-                // Packed palette: palette size = subencoding value
-                const int paletteSize = subencoding;
-                QVector<QRgb> palette(paletteSize);
-                for (int i = 0; i < paletteSize; i++)
-                    palette[i] = toRgb(readCPixel());
-
-                const int bitsPerIndex = (paletteSize == 2) ? 1
-                                       : (paletteSize <= 4) ? 2 : 4;
-                const int bytesPerRow = (tw * bitsPerIndex + 7) / 8;
-
-                for (int y = 0; y < th; y++) {
-                    int rowStart = dataOffset;
-                    int bitPos = 0;
-                    for (int x = 0; x < tw; x++) {
-                        int byteIdx = dataOffset + bitPos / 8;
-                        if (byteIdx >= bufSize) break;
-                        int shift = 8 - bitsPerIndex - (bitPos % 8);
-                        int mask = (1 << bitsPerIndex) - 1;
-                        int index = (static_cast<quint8>(buf[byteIdx]) >> shift) & mask;
-                        bitPos += bitsPerIndex;
-                        if (index < paletteSize)
-                            image.setPixel(rect.x + tx + x, rect.y + ty + y, palette[index]);
-                    }
-                    dataOffset = rowStart + bytesPerRow;
-                }
+    // Helper to read a CPIXEL from the decompressed buffer
+    auto readCPixel = [&]() -> QRgb {
+        if (dataOffset + cpixelSize > bufSize) return qRgb(0, 0, 0);
+        const QRgb rgb = converter.pixel(buf + dataOffset);
+        dataOffset += cpixelSize;
+        return rgb;
+    };
 
-            } else if (subencoding == 128) {
-                // Plain RLE: (CPIXEL, runLength) pairs
-                const int totalPixels = tw * th;
-                int pixels = 0;
-                while (pixels < totalPixels) {
-                    QRgb rgb = toRgb(readCPixel());
-                    int runLength = 0;
-                    quint8 b;
-                    do {
-                        if (dataOffset >= bufSize) break;
-                        b = static_cast<quint8>(buf[dataOffset++]);
-                        runLength += b;
-                    } while (b == 255);
-                    runLength += 1;
-
-                    for (int i = 0; i < runLength && pixels < totalPixels; i++, pixels++) {
-                        image.setPixel(rect.x + tx + pixels % tw,
-                                       rect.y + ty + pixels / tw, rgb);
-                    }
-                }
+    // Tiles are decoded into a local buffer (stride tw) so that RLE runs,
+    // which wrap from one tile row to the next, become plain span fills.
+    QRgb tile[64 * 64];
+    QRgb palette[128];
+
+    // Commits the decoded prefix of the tile buffer; a truncated tile
+    // leaves the rest of the framebuffer untouched.
+    auto writeTile = [&](int pixels) {
+        const int rows = pixels / tw;
+        writer.writeRect(px, py, tw, rows, tile, tw);
+        if (pixels % tw)
+            writer.writeRect(px, py + rows, pixels % tw, 1, tile + rows * tw, tw);
+    };
 
-            } else if (subencoding >= 130) {
-                // Palette RLE: palette of (sub - 128) CPIXELs, then RLE with indices
-                const int paletteSize = subencoding - 128;
-                QVector<QRgb> palette(paletteSize);
-                for (int i = 0; i < paletteSize; i++)
-                    palette[i] = toRgb(readCPixel());
+    if (dataOffset >= bufSize) {
+        qCWarning(lcVncClient) << "ZRLE data truncated (subencoding)";
+        return -1;
+    }
 
-                const int totalPixels = tw * th;
-                int pixels = 0;
-                while (pixels < totalPixels) {
-                    if (dataOffset >= bufSize) break;
-                    quint8 indexByte = static_cast<quint8>(buf[dataOffset++]);
-
-                    if (indexByte & 0x80) {
-                        // Run: index = low 7 bits, followed by run length
-                        int paletteIndex = indexByte & 0x7F;
-                        int runLength = 0;
-                        quint8 b;
-                        do {
-                            if (dataOffset >= bufSize) break;
-                            b = static_cast<quint8>(buf[dataOffset++]);
-                            runLength += b;
-                        } while (b == 255);
-                        runLength += 1;
-
-                        QRgb rgb = (paletteIndex < paletteSize)
-                                 ? palette[paletteIndex] : qRgb(0, 0, 0);
-                        for (int i = 0; i < runLength && pixels < totalPixels; i++, pixels++) {
-                            image.setPixel(rect.x + tx + pixels % tw,
-                                           rect.y + ty + pixels / tw, rgb);
-                        }
-                    } else {
-                        // Single pixel
-                        QRgb rgb = (indexByte < paletteSize)
-                                 ? palette[indexByte] : qRgb(0, 0, 0);
-                        image.setPixel(rect.x + tx + pixels % tw,
-                                       rect.y + ty + pixels / tw, rgb);
-                        pixels++;
-                    }
-                }
+    const quint8 subencoding = buf[dataOffset++];
+
+    if (subencoding == 0) {
+        // Raw pixels: cpixelSize * tw * th bytes
+        const int rowBytes = tw * cpixelSize;
+        for (int y = 0; y < th; y++) {
+            if (dataOffset + rowBytes > bufSize) break;
+            QRgb *dst = writer.beginRow(px, py + y, tw);
+            converter.convertRow(buf + dataOffset, dst, tw);
+            writer.endRow();
+            dataOffset += rowBytes;
+        }
 
+    } else if (subencoding == 1) {
+        // Solid tile: 1 CPIXEL
+        writer.fillRect(px, py, tw, th, readCPixel());
+
+    } else if (subencoding >= 2 && subencoding <= 16) {
+        // Packed palette: palette size = subencoding value
+        const int paletteSize = subencoding;
+        for (int i = 0; i < paletteSize; i++)
+            palette[i] = readCPixel();
+
+        const int bitsPerIndex = (paletteSize == 2) ? 1
+                               : (paletteSize <= 4) ? 2 : 4;
+        const int bytesPerRow = (tw * bitsPerIndex + 7) / 8;
+        const int mask = (1 << bitsPerIndex) - 1;
+
+        for (int y = 0; y < th; y++) {
+            if (dataOffset + bytesPerRow > bufSize) break;
+            const quint8 *src = buf + dataOffset;
+            QRgb *dst = writer.beginRow(px, py + y, tw);
+            int bitPos = 0;
+            for (int x = 0; x < tw; x++, bitPos += bitsPerIndex) {
+                const int shift = 8 - bitsPerIndex - (bitPos % 8);
+                const int index = (src[bitPos / 8] >> shift) & mask;
+                dst[x] = (index < paletteSize) ? palette[index] : qRgb(0, 0, 0);
+            }
+            writer.endRow();
+            dataOffset += bytesPerRow;
+        }
+
+    } else if (subencoding == 128) {
+        // Plain RLE: (CPIXEL, runLength) pairs
+        const int totalPixels = tw * th;
+        int pixels = 0;
+        while (pixels < totalPixels) {
+            if (dataOffset >= bufSize) break;
+            QRgb rgb = readCPixel();
+            int runLength = 0;
+            quint8 b;
+            do {
+                if (dataOffset >= bufSize) break;
+                b = buf[dataOffset++];
+                runLength += b;
+            } while (b == 255);
+            runLength = qMin(runLength + 1, totalPixels - pixels);
+
+            std::fill_n(tile + pixels, runLength, rgb);
+            pixels += runLength;
+        }
+        writeTile(pixels);
+
+    } else if (subencoding >= 130) {
+        // Palette RLE: palette of (sub - 128) CPIXELs, then RLE with indices
+        const int paletteSize = subencoding - 128;
+        for (int i = 0; i < paletteSize; i++)
+            palette[i] = readCPixel();
+
+        const int totalPixels = tw * th;
+        int pixels = 0;
+        while (pixels < totalPixels) {
+            if (dataOffset >= bufSize) break;
+            quint8 indexByte = buf[dataOffset++];
+
+            if (indexByte & 0x80) {
+                // Run: index = low 7 bits, followed by run length
+                int paletteIndex = indexByte & 0x7F;
+                int runLength = 0;
+                quint8 b;
+                do {
+                    if (dataOffset >= bufSize) break;
+                    b = buf[dataOffset++];
+                    runLength += b;
+                } while (b == 255);
+                runLength = qMin(runLength + 1, totalPixels - pixels);
+
+                QRgb rgb = (paletteIndex < paletteSize)
+                         ? palette[paletteIndex] : qRgb(0, 0, 0);
+                std::fill_n(tile + pixels, runLength, rgb);
+                pixels += runLength;
             } else {
-                // Unused subencodings (17-127, 129): skip tile
-                qCWarning(lcVncClient) << "ZRLE unsupported subencoding:" << subencoding;
+                // Single pixel
+                tile[pixels++] = (indexByte < paletteSize)
+                               ? palette[indexByte] : qRgb(0, 0, 0);
             }
         }
+        writeTile(pixels);
+
+    } else {
+        // Unused subencodings (17-127, 129): skip tile
+        qCWarning(lcVncClient) << "ZRLE unsupported subencoding:" << subencoding;
     }
-    return true;
+    return dataOffset;
+}
+
+/*!
+    \internal
+    Returns the map from Qt keys to VNC key codes. It is built once and
+    shared by all clients.
+*/
+static const QHash<int, quint32> &vncKeyMap()
+{
+    static const QHash<int, quint32> map = []() {
+        const QList<quint32> keyList {
+            Qt::Key_Backspace, 0xff08,
+            Qt::Key_Tab, 0xff09,
+            Qt::Key_Return, 0xff0d,
+            Qt::Key_Enter, 0xff0d,
+            Qt::Key_Insert, 0xff63,
+            Qt::Key_Delete, 0xffff,
+            Qt::Key_Home, 0xff50,
+            Qt::Key_End, 0xff57,
+            Qt::Key_PageUp, 0xff55,
+            Qt::Key_PageDown, 0xff56,
+            Qt::Key_Left, 0xff51,
+            Qt::Key_Up, 0xff52,
+            Qt::Key_Right, 0xff53,
+            Qt::Key_Down, 0xff54,
+            Qt::Key_F1, 0xffbe,
+            Qt::Key_F2, 0xffbf,
+            Qt::Key_F3, 0xffc0,
+            Qt::Key_F4, 0xffc1,
+            Qt::Key_F5, 0xffc2,
+            Qt::Key_F6, 0xffc3,
+            Qt::Key_F7, 0xffc4,
+            Qt::Key_F8, 0xffc5,
+            Qt::Key_F9, 0xffc6,
+            Qt::Key_F10, 0xffc7,
+            Qt::Key_F11, 0xffc8,
+            Qt::Key_F12, 0xffc9,
+            Qt::Key_Shift, 0xffe1,
+            Qt::Key_Control, 0xffe3,
+            Qt::Key_Meta, 0xffe7,
+            Qt::Key_Alt, 0xffe9
+        };
+        QHash<int, quint32> map;
+        for (int i = 0; i < keyList.length(); i += 2)
+            map.insert(static_cast<int>(keyList.at(i)), keyList.at(i + 1));
+        return map;
+    }();
+    return map;
 }
 
 /*!
@@ -2908,16 +4148,20 @@ bool QVncClient::Private::handleZRLEEncoding(const Rectangle &rect)
 void QVncClient::Private::keyEvent(QKeyEvent *e)
 {
     if (!socket || state != WaitingState) return;
+    SendBatch batch(this);
+    // The key applies where the pointer is now
+    flushPointerMove();
     const quint8 messageType = KeyEvent;
     write(messageType);
     const quint8 downFlag = e->type() == QEvent::KeyPress ? 1 : 0;
     write(downFlag);
-    socket->write("  "); // padding
+    write("  "); // padding
 
     const auto key = e->key();
+    const QHash<int, quint32> &keyMap = vncKeyMap();
     quint32_be code;
-    if (keyMap.contains(key))
-        code = keyMap.value(key);
+    if (const auto it = keyMap.constFind(key); it != keyMap.cend())
+        code = *it;
     else if (!e->text().isEmpty())
         code = e->text().at(0).unicode();
     qCDebug(lcVncClient) << "Key event:" << e->type() << key << code;
@@ -2927,25 +4171,71 @@ void QVncClient::Private::keyEvent(QKeyEvent *e)
 /*!
     \internal
     Translates Qt mouse events to VNC pointer events and sends them to the server.
+
+    With a pointerEventInterval, moves that come sooner than the interval
+    after the previous PointerEvent are held back, and only the last one is
+    sent when the interval has passed. A change of the button mask is
+    always sent right away, in order and at its own position; a move held
+    back before it is dropped, as the button event moves the pointer too.
     
     \param e The mouse event to be processed and sent.
 */
 void QVncClient::Private::pointerEvent(QMouseEvent *e)
 {
     if (!socket || state != WaitingState) return;
-    const quint8 messageType = PointerEvent;
-    write(messageType);
 
     quint8 buttonMask = 0;
     if (e->buttons() & Qt::LeftButton) buttonMask |= 1;
     if (e->buttons() & Qt::MiddleButton) buttonMask |= 2;
     if (e->buttons() & Qt::RightButton) buttonMask |= 4;
+    const QPoint pos(qRound(e->position().x()), qRound(e->position().y()));
+
+    if (pointerEventInterval > 0 && buttonMask == pointerButtons && lastPointerTime >= 0) {
+        const qint64 wait = lastPointerTime + pointerEventInterval * qint64(1000000) - clock.nsecsElapsed();
+        if (wait > 0) {
+            pendingPointerPos = pos;
+            pointerMovePending = true;
+            if (!pointerTimer->isActive())
+                pointerTimer->start(int((wait + 999999) / 1000000));
+            return;
+        }
+    }
+    pointerTimer->stop();
+    pointerMovePending = false;
+    sendPointerEvent(buttonMask, pos);
+}
+
+void QVncClient::Private::sendPointerEvent(quint8 buttonMask, const QPoint &pos)
+{
+    pointerButtons = buttonMask;
+    lastPointerTime = clock.nsecsElapsed();
+    SendBatch batch(this);
+    write(quint8(PointerEvent));
     write(buttonMask);
+    write(quint16_be(pos.x()));
+    write(quint16_be(pos.y()));
+}
 
-    quint16_be x(qRound(e->position().x()));
-    write(x);
-    quint16_be y(qRound(e->position().y()));
-    write(y);
+/*!
+    \internal
+    Sends the move held back by pointer coalescing, if there is one.
+*/
+void QVncClient::Private::flushPointerMove()
+{
+    if (!pointerMovePending)
+        return;
+    pointerTimer->stop();
+    pointerMovePending = false;
+    if (state == WaitingState)
+        sendPointerEvent(pointerButtons, pendingPointerPos);
+}
+
+void QVncClient::Private::applyLowDelay()
+{
+    // Without a connection QAbstractSocket ignores the option; it is set
+    // again once connected
+    if (socket && socket->state() == QAbstractSocket::ConnectedState)
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, lowDelay ? 1 : 0);
 }
 
 /*!
@@ -3070,24 +4360,132 @@ int QVncClient::framebufferHeight() const
     return d->frameBufferHeight;
 }
 
+/*!
+    Returns the screens of the remote desktop, in framebuffer coordinates.
+
+    Servers that support the ExtendedDesktopSize pseudo-encoding report
+    the layout of their monitors; set a screen's geometry as the viewport
+    to receive updates for that screen only. For other servers, the list
+    has one screen covering the framebuffer. It is empty before the
+    server announced the framebuffer size.
+
+    \sa screensChanged(), setViewport()
+*/
+QList<QVncScreen> QVncClient::screens() const
+{
+    if (!d->screenLayout.isEmpty() || d->image.isNull())
+        return d->screenLayout;
+    QVncScreen screen;
+    screen.geometry = QRect(0, 0, d->frameBufferWidth, d->frameBufferHeight);
+    return { screen };
+}
+
 /*!
     Returns the current framebuffer image.
     
     This image represents the current state of the remote desktop.
     It is updated each time framebuffer updates are received from the server.
-    
-    \sa imageChanged()
+
+    The returned image shares the framebuffer. As long as a copy of it is
+    kept, the next framebuffer update has to copy the whole framebuffer
+    before writing to it, so the copy keeps its contents. Renderers that
+    only read the pixels should use imageView() or framebufferBits()
+    instead.
+
+    \sa imageChanged(), imageView()
 */
 QImage QVncClient::image() const
 {
     return d->image;
 }
 
+/*!
+    Returns a read-only image over the framebuffer that does not share it.
+
+    Unlike image(), the view and its copies never make the client copy the
+    framebuffer: they point at the memory the client decodes into and show
+    every change as it is written. Modifying the view detaches it from the
+    framebuffer, like any QImage created on read-only memory.
+
+    The view is valid until the next framebufferSizeChanged(), which is
+    emitted whenever the framebuffer is reallocated. A view has to be taken
+    again after that, and also after a copy returned by image() was kept
+    during an update, since the client then writes into a new buffer.
+
+    With decode threads enabled (see decodeThreadCount), rectangles are
+    written while the client keeps parsing, so the pixels are only
+    guaranteed to be complete while imageRegionChanged() or
+    framebufferUpdated() are handled.
+
+    \sa framebufferBits(), imageRegionChanged()
+*/
+QImage QVncClient::imageView() const
+{
+    const QImage &image = d->image;
+    if (image.isNull())
+        return QImage();
+    return QImage(image.constBits(), image.width(), image.height(), image.bytesPerLine(),
+                  image.format());
+}
+
+/*!
+    \overload
+
+    Returns a read-only image over the part of the framebuffer in \a rect,
+    clipped to the framebuffer, without copying it. With a lazily
+    allocated framebuffer, only this part of the memory is read.
+
+    The same validity rules as for imageView() apply.
+*/
+QImage QVncClient::imageView(const QRect &rect) const
+{
+    const QImage &image = d->image;
+    const QRect area = rect & image.rect();
+    if (area.isEmpty())
+        return QImage();
+    return QImage(image.constScanLine(area.y()) + area.x() * 4, area.width(), area.height(),
+                  image.bytesPerLine(), image.format());
+}
+
+/*!
+    Returns the pixels of the framebuffer, or \nullptr before the server
+    announced its size.
+
+    Rows are framebufferBytesPerLine() bytes apart and in
+    framebufferFormat(). The same validity rules as for imageView() apply.
+
+    \sa imageView()
+*/
+const uchar *QVncClient::framebufferBits() const
+{
+    return d->image.isNull() ? nullptr : d->image.constBits();
+}
+
+/*!
+    Returns the number of bytes between the rows of framebufferBits().
+*/
+qsizetype QVncClient::framebufferBytesPerLine() const
+{
+    return d->image.bytesPerLine();
+}
+
+/*!
+    Returns the format of framebufferBits(), which is always
+    QImage::Format_RGB32 once connected and QImage::Format_Invalid before.
+*/
+QImage::Format QVncClient::framebufferFormat() const
+{
+    return d->image.format();
+}
+
 /*!
     Returns the cursor image received from the server via RichCursor pseudo-encoding.
     The image has Format_ARGB32 with transparent pixels where the bitmask is 0.
     Returns a null QImage if no cursor data has been received.
 
+    Shapes the server sent before are taken from a cache, so switching back
+    to a cursor returns an image sharing its data with the earlier one.
+
     \sa cursorHotspot(), cursorChanged()
 */
 QImage QVncClient::cursorImage() const
@@ -3151,8 +4549,520 @@ void QVncClient::setFramebufferUpdatesEnabled(bool enabled)
         return;
     d->framebufferUpdatesEnabled = enabled;
     emit framebufferUpdatesEnabledChanged(enabled);
-    if (enabled)
-        d->restartFramebufferUpdates();
+    d->restartFramebufferUpdates();
+}
+
+/*!
+    Returns the pixel format the client asks the server to send.
+
+    \sa setPixelFormatPreference(), pixelFormatPreferenceChanged()
+*/
+QVncClient::PixelFormatPreference QVncClient::pixelFormatPreference() const
+{
+    return d->pixelFormatPreference;
+}
+
+/*!
+    Sets the pixel format the client asks the server to send to \a preference.
+
+    The preference may be changed at any time. During a session the new
+    format is requested as soon as no framebuffer update is in flight,
+    followed by a full refresh; image() keeps its size and format.
+
+    \sa pixelFormatPreference(), pixelFormatPreferenceChanged()
+*/
+void QVncClient::setPixelFormatPreference(PixelFormatPreference preference)
+{
+    if (d->pixelFormatPreference == preference)
+        return;
+    d->pixelFormatPreference = preference;
+    emit pixelFormatPreferenceChanged(preference);
+    d->requestPixelFormatChange();
+}
+
+/*!
+    Returns the number of threads decoding framebuffer rectangles, or 0 if
+    they are decoded in the thread the client lives in.
+
+    \sa setDecodeThreadCount(), decodeThreadCountChanged()
+*/
+int QVncClient::decodeThreadCount() const
+{
+    return d->decodeQueue.maxThreadCount();
+}
+
+/*!
+    Decodes framebuffer rectangles on up to \a count worker threads.
+
+    The protocol is still parsed in the client's thread, in order; only the
+    pixel decoding of each rectangle moves to the workers. A value of 0, the
+    default, decodes everything in the client's thread.
+
+    While the client belongs to a QVncClientManager, it decodes on the
+    threads of the manager instead.
+
+    \sa decodeThreadCount(), decodeThreadCountChanged()
+*/
+void QVncClient::setDecodeThreadCount(int count)
+{
+    count = qMax(0, count);
+    if (decodeThreadCount() == count)
+        return;
+    d->decodeQueue.setMaxThreadCount(count);
+    emit decodeThreadCountChanged(count);
+}
+
+/*!
+    \internal
+    Decodes on \a pool, shared with other clients, or on the client's own
+    threads again if \a pool is \nullptr.
+*/
+void QVncClient::setSharedDecodePool(QThreadPool *pool)
+{
+    d->decodeQueue.setSharedPool(pool);
+}
+
+/*!
+    Returns how completed frames are handed to consumers.
+
+    \sa setBufferingMode(), frame()
+*/
+QVncClient::BufferingMode QVncClient::bufferingMode() const
+{
+    return d->bufferingMode;
+}
+
+/*!
+    Keeps completed frames in front buffers according to \a mode.
+
+    The default, SingleBuffered, keeps only the framebuffer the client
+    decodes into. DoubleBuffered and TripleBuffered add one or two front
+    buffers that frame() hands out; see bufferingMode.
+
+    \sa bufferingMode(), frame()
+*/
+void QVncClient::setBufferingMode(BufferingMode mode)
+{
+    if (d->bufferingMode == mode)
+        return;
+    d->bufferingMode = mode;
+    d->setFrontBufferCount(mode == TripleBuffered ? 2 : mode == DoubleBuffered ? 1 : 0);
+    emit bufferingModeChanged(mode);
+}
+
+/*!
+    Returns the part of the framebuffer updates are requested for, or an
+    empty rectangle for all of it.
+
+    \sa setViewport(), viewportChanged()
+*/
+QRect QVncClient::viewport() const
+{
+    return d->viewport;
+}
+
+/*!
+    Requests framebuffer updates only for \a viewport, in framebuffer
+    coordinates. An empty rectangle, the default, requests the whole
+    framebuffer, as does one that lies outside of it.
+
+    Outside the viewport the framebuffer is not kept up to date. When the
+    viewport changes during a session, it is refreshed in full.
+
+    \sa viewport(), viewportChanged()
+*/
+void QVncClient::setViewport(const QRect &viewport)
+{
+    const QRect normalized = viewport.isEmpty() ? QRect() : viewport;
+    if (d->viewport == normalized)
+        return;
+    d->viewport = normalized;
+    d->requestViewport();
+    emit viewportChanged(normalized);
+}
+
+/*!
+    Returns the factor the server is asked to scale the framebuffer down by.
+
+    \sa setServerScale(), serverScaleChanged()
+*/
+int QVncClient::serverScale() const
+{
+    return d->serverScale;
+}
+
+/*!
+    Asks the server to send the framebuffer scaled down by \a scale, from
+    1, the default, to 255.
+
+    This uses the SetScale message of UltraVNC, which other servers do not
+    know and answer by closing the connection; only set it for servers
+    known to support it. The server reports the scaled size through
+    framebufferSizeChanged(), and pointer events are in scaled coordinates.
+
+    \sa serverScale(), serverScaleChanged()
+*/
+void QVncClient::setServerScale(int scale)
+{
+    scale = qBound(1, scale, 255);
+    if (d->serverScale == scale)
+        return;
+    d->serverScale = scale;
+    d->sendServerScale();
+    emit serverScaleChanged(scale);
+}
+
+/*!
+    Returns the minimum time between framebuffer update requests, in
+    milliseconds.
+
+    \sa setUpdateInterval(), updateIntervalChanged()
+*/
+int QVncClient::updateInterval() const
+{
+    return d->updateInterval;
+}
+
+/*!
+    Waits at least \a msec milliseconds between framebuffer update
+    requests. 0, the default, requests the next update as soon as the
+    previous one has been received.
+
+    A session that is not shown can be throttled this way to use less
+    bandwidth and CPU. Continuous updates are not used while an interval
+    is set, since the server would not wait for requests.
+
+    \sa updateInterval(), QVncClientManager::setClientVisible()
+*/
+void QVncClient::setUpdateInterval(int msec)
+{
+    msec = qMax(0, msec);
+    if (d->updateInterval == msec)
+        return;
+    d->updateInterval = msec;
+    d->applyUpdateInterval();
+    emit updateIntervalChanged(msec);
+}
+
+/*!
+    Returns how long the client handles received data before it lets the
+    event loop run, in milliseconds, or 0 for no limit.
+
+    \sa setReadTimeBudget(), readByteBudget()
+*/
+int QVncClient::readTimeBudget() const
+{
+    return d->readTimeBudget;
+}
+
+/*!
+    Handles received data for at most \a msec milliseconds before letting
+    the event loop run. 0, the default, handles everything received so far
+    in one go.
+
+    The budget is checked between messages and between the rectangles of
+    a framebuffer update; what is left is handled right after the event
+    loop has processed pending events, such as input and painting.
+
+    \sa readTimeBudget(), setReadByteBudget()
+*/
+void QVncClient::setReadTimeBudget(int msec)
+{
+    msec = qMax(0, msec);
+    if (d->readTimeBudget == msec)
+        return;
+    d->readTimeBudget = msec;
+    emit readTimeBudgetChanged(msec);
+}
+
+/*!
+    Returns how many received bytes the client handles before it lets the
+    event loop run, or 0 for no limit.
+
+    \sa setReadByteBudget(), readTimeBudget()
+*/
+qint64 QVncClient::readByteBudget() const
+{
+    return d->readByteBudget;
+}
+
+/*!
+    Handles at most about \a bytes of received data before letting the
+    event loop run. 0, the default, sets no limit. The message or rectangle
+    that crosses the budget is still handled in full.
+
+    \sa readByteBudget(), setReadTimeBudget()
+*/
+void QVncClient::setReadByteBudget(qint64 bytes)
+{
+    bytes = qMax<qint64>(0, bytes);
+    if (d->readByteBudget == bytes)
+        return;
+    d->readByteBudget = bytes;
+    emit readByteBudgetChanged(bytes);
+}
+
+/*!
+    Returns the counters the client keeps about the session since the
+    socket was set or resetStatistics() was called.
+
+    The counters are plain additions in the code paths they measure, cheap
+    enough to be always on. Times are in nanoseconds. Decode times include
+    parsing and, with decode threads, the time the rectangle took on a
+    worker; inflating zlib data is counted in the encoding's decode time
+    as well as in QVncStatistics::inflateNsecs.
+
+    \sa resetStatistics()
+*/
+QVncStatistics QVncClient::statistics() const
+{
+    return d->statistics;
+}
+
+/*!
+    Sets all counters returned by statistics() back to zero.
+*/
+void QVncClient::resetStatistics()
+{
+    d->statistics = QVncStatistics();
+}
+
+/*!
+    Returns the minimum time between two pointer moves sent to the server,
+    in milliseconds, or 0 to send every move.
+
+    \sa setPointerEventInterval()
+*/
+int QVncClient::pointerEventInterval() const
+{
+    return d->pointerEventInterval;
+}
+
+/*!
+    Sends pointer moves at most every \a msec milliseconds; of the moves in
+    between, only the last one is sent. Button presses and releases are
+    always sent right away. 0, the default, sends every move.
+
+    \sa pointerEventInterval()
+*/
+void QVncClient::setPointerEventInterval(int msec)
+{
+    msec = qMax(0, msec);
+    if (d->pointerEventInterval == msec)
+        return;
+    d->pointerEventInterval = msec;
+    if (msec == 0)
+        d->flushPointerMove();
+    emit pointerEventIntervalChanged(msec);
+}
+
+/*!
+    Returns whether the socket sends small messages without delay.
+
+    \sa setLowDelay()
+*/
+bool QVncClient::lowDelay() const
+{
+    return d->lowDelay;
+}
+
+/*!
+    Sets QAbstractSocket::LowDelayOption on the socket if \a enabled is
+    true, so that input events are not held back by Nagle's algorithm.
+
+    \sa lowDelay()
+*/
+void QVncClient::setLowDelay(bool enabled)
+{
+    if (d->lowDelay == enabled)
+        return;
+    d->lowDelay = enabled;
+    d->applyLowDelay();
+    emit lowDelayChanged(enabled);
+}
+
+/*!
+    Returns whether the framebuffer is kept when the connection drops or a
+    new socket is set.
+
+    \sa setFastReconnect()
+*/
+bool QVncClient::fastReconnect() const
+{
+    return d->fastReconnect;
+}
+
+/*!
+    Keeps the framebuffer, the screens and the cursor across connections if
+    \a enabled is true, and shortens the handshake of the next connection.
+
+    \sa fastReconnect()
+*/
+void QVncClient::setFastReconnect(bool enabled)
+{
+    if (d->fastReconnect == enabled)
+        return;
+    d->fastReconnect = enabled;
+    emit fastReconnectChanged(enabled);
+}
+
+/*!
+    Returns whether framebuffer memory is only allocated where the server
+    writes to it.
+
+    \sa setLazyFramebuffer()
+*/
+bool QVncClient::lazyFramebuffer() const
+{
+    return d->lazyFramebuffer;
+}
+
+/*!
+    Allocates the framebuffer from memory that the system only provides
+    where pixels are written if \a enabled is true, instead of allocating
+    and filling all of it when the size is known.
+
+    For very large framebuffers that are only partly shown, such as video
+    walls with a viewport, this saves both the memory and the time to
+    touch it up front. Pixels the server has not sent yet are black rather
+    than white. The framebuffer is still one image, so image(),
+    imageView() and framebufferBits() are unchanged; reading it does not
+    cost memory either, but copying it does, so combine it with
+    SingleBuffered buffering and read regions with imageView(const QRect &).
+
+    Takes effect when the framebuffer is next allocated, on the next
+    connection or size change. Off by default.
+
+    \sa lazyFramebuffer(), viewport
+*/
+void QVncClient::setLazyFramebuffer(bool enabled)
+{
+    if (d->lazyFramebuffer == enabled)
+        return;
+    d->lazyFramebuffer = enabled;
+    emit lazyFramebufferChanged(enabled);
+}
+
+/*!
+    Returns the latest complete frame.
+
+    With DoubleBuffered or TripleBuffered buffering, this is a copy of the
+    framebuffer taken when the last framebuffer update was complete. It
+    never shows part of an update, holding it never makes the client copy
+    the framebuffer, and it may be called from any thread, for example by
+    a recorder or a render thread. The frame is null until the first one
+    is complete.
+
+    With SingleBuffered, the default, this is the same as image() and may
+    only be called from the thread the client lives in.
+
+    \sa bufferingMode, framebufferUpdated()
+*/
+QImage QVncClient::frame() const
+{
+    if (d->bufferingMode == SingleBuffered)
+        return d->image;
+    return d->frontBuffers.frame();
+}
+
+/*!
+    Starts writing everything received from the server to \a fileName,
+    with the time each chunk arrived. Returns \c false if the file cannot
+    be created.
+
+    The recording can be replayed through a client without a server, either
+    as fast as possible to profile decoding or in real time to reproduce a
+    session. Start recording before setting the socket to capture the
+    handshake, which a replay needs. What the client sends is not recorded.
+
+    \note Recordings contain the unencrypted session, including screen
+    contents and anything typed that was echoed on screen.
+
+    \sa stopRecording(), isRecording(), QVncFrameRecorder
+*/
+bool QVncClient::startRecording(const QString &fileName)
+{
+    if (d->recorder.open(fileName))
+        return true;
+    qCWarning(lcVncClient) << "Cannot record session to" << fileName << ":" << d->recorder.errorString();
+    return false;
+}
+
+/*!
+    Stops a recording started with startRecording() and closes the file.
+
+    \sa startRecording()
+*/
+void QVncClient::stopRecording()
+{
+    d->recorder.close();
+}
+
+/*!
+    Returns \c true while the received stream is being recorded.
+
+    \sa startRecording()
+*/
+bool QVncClient::isRecording() const
+{
+    return d->recorder.isOpen();
+}
+
+/*!
+    Returns the Tight JPEG quality level requested from the server, or -1
+    when the client picks it automatically.
+
+    \sa setQualityLevel(), compressionLevel()
+*/
+int QVncClient::qualityLevel() const
+{
+    return d->qualityLevel;
+}
+
+/*!
+    Requests JPEG quality \a level, from 0 (smallest) to 9 (best), for
+    Tight rectangles. -1, the default, lets the client choose the level
+    from the measured throughput of the connection.
+
+    \sa qualityLevel(), setCompressionLevel()
+*/
+void QVncClient::setQualityLevel(int level)
+{
+    level = qBound(-1, level, 9);
+    if (d->qualityLevel == level)
+        return;
+    d->qualityLevel = level;
+    d->sendEncodings();
+    emit qualityLevelChanged(level);
+}
+
+/*!
+    Returns the compression level requested from the server, or -1 when
+    the client picks it automatically.
+
+    \sa setCompressionLevel(), qualityLevel()
+*/
+int QVncClient::compressionLevel() const
+{
+    return d->compressionLevel;
+}
+
+/*!
+    Requests compression \a level, from 0 (fastest) to 9 (smallest).
+    -1, the default, lets the client choose: high compression on slow
+    links, little on fast ones, and Raw ahead of the compressing encodings
+    when the link is fast enough and decoding is what holds the client back.
+
+    \sa compressionLevel(), setQualityLevel()
+*/
+void QVncClient::setCompressionLevel(int level)
+{
+    level = qBound(-1, level, 9);
+    if (d->compressionLevel == level)
+        return;
+    d->compressionLevel = level;
+    d->sendEncodings();
+    emit compressionLevelChanged(level);
 }
 
 /*!
@@ -6,12 +6,64 @@
 #include <QtVncClient/qtvncclientglobal.h>
 #include <QtNetwork/QTcpSocket>
 #include <QtGui/QImage>
+#include <QtGui/QRegion>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
+#include <QtCore/QHash>
 #include <QtCore/QScopedPointer>
 
 QT_BEGIN_NAMESPACE
 
+class QThreadPool;
+
+// One screen of the remote desktop, from the ExtendedDesktopSize pseudo-encoding
+struct QVncScreen
+{
+    quint32 id = 0;
+    QRect geometry;     // in framebuffer coordinates
+    quint32 flags = 0;
+
+    friend bool operator==(const QVncScreen &a, const QVncScreen &b)
+    {
+        return a.id == b.id && a.geometry == b.geometry && a.flags == b.flags;
+    }
+    friend bool operator!=(const QVncScreen &a, const QVncScreen &b) { return !(a == b); }
+};
+Q_DECLARE_TYPEINFO(QVncScreen, Q_RELOCATABLE_TYPE);
+
+// What the rectangles of one encoding cost, see QVncStatistics
+struct QVncEncodingStatistics
+{
+    qint64 rects = 0;
+    qint64 pixels = 0;
+    qint64 bytes = 0;           // received, rectangle headers included
+    qint64 decodeNsecs = 0;     // client thread and decode workers
+};
+Q_DECLARE_TYPEINFO(QVncEncodingStatistics, Q_PRIMITIVE_TYPE);
+
+// Counters kept by QVncClient, see QVncClient::statistics()
+struct QVncStatistics
+{
+    qint64 bytesReceived = 0;
+    qint64 updates = 0;                         // complete framebuffer updates
+    QHash<qint32, QVncEncodingStatistics> encodings; // by RFB encoding number
+    qint64 inflateNsecs = 0;                    // zlib, for ZRLE and Tight
+
+    // From a FramebufferUpdateRequest to the complete frame
+    qint64 updateLatencySamples = 0;
+    qint64 updateLatencyNsecs = 0;              // sum over the samples
+    qint64 lastUpdateLatencyNsecs = -1;
+
+    // Until the server answered a full update request or a fence
+    qint64 roundTripNsecs = -1;                 // last measured
+    qint64 minRoundTripNsecs = -1;
+
+    // From reading a rectangle off the socket to the start of its decoding
+    qint64 queueDelaySamples = 0;
+    qint64 queueDelayNsecs = 0;                 // sum over the samples
+    qint64 maxQueueDelayNsecs = 0;
+};
+
 class Q_VNCCLIENT_EXPORT QVncClient : public QObject
 {
     Q_OBJECT
@@ -21,6 +73,20 @@ class Q_VNCCLIENT_EXPORT QVncClient : public QObject
     Q_PROPERTY(QString password READ password WRITE setPassword NOTIFY passwordChanged)
     Q_PROPERTY(QString username READ username WRITE setUsername NOTIFY usernameChanged)
     Q_PROPERTY(bool framebufferUpdatesEnabled READ framebufferUpdatesEnabled WRITE setFramebufferUpdatesEnabled NOTIFY framebufferUpdatesEnabledChanged)
+    Q_PROPERTY(PixelFormatPreference pixelFormatPreference READ pixelFormatPreference WRITE setPixelFormatPreference NOTIFY pixelFormatPreferenceChanged)
+    Q_PROPERTY(int decodeThreadCount READ decodeThreadCount WRITE setDecodeThreadCount NOTIFY decodeThreadCountChanged)
+    Q_PROPERTY(int qualityLevel READ qualityLevel WRITE setQualityLevel NOTIFY qualityLevelChanged)
+    Q_PROPERTY(int compressionLevel READ compressionLevel WRITE setCompressionLevel NOTIFY compressionLevelChanged)
+    Q_PROPERTY(BufferingMode bufferingMode READ bufferingMode WRITE setBufferingMode NOTIFY bufferingModeChanged)
+    Q_PROPERTY(QRect viewport READ viewport WRITE setViewport NOTIFY viewportChanged)
+    Q_PROPERTY(int serverScale READ serverScale WRITE setServerScale NOTIFY serverScaleChanged)
+    Q_PROPERTY(int updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged)
+    Q_PROPERTY(int readTimeBudget READ readTimeBudget WRITE setReadTimeBudget NOTIFY readTimeBudgetChanged)
+    Q_PROPERTY(qint64 readByteBudget READ readByteBudget WRITE setReadByteBudget NOTIFY readByteBudgetChanged)
+    Q_PROPERTY(int pointerEventInterval READ pointerEventInterval WRITE setPointerEventInterval NOTIFY pointerEventIntervalChanged)
+    Q_PROPERTY(bool lowDelay READ lowDelay WRITE setLowDelay NOTIFY lowDelayChanged)
+    Q_PROPERTY(bool fastReconnect READ fastReconnect WRITE setFastReconnect NOTIFY fastReconnectChanged)
+    Q_PROPERTY(bool lazyFramebuffer READ lazyFramebuffer WRITE setLazyFramebuffer NOTIFY lazyFramebufferChanged)
 public:
     enum ProtocolVersion {
         ProtocolVersionUnknown,
@@ -59,6 +125,21 @@ public:
     };
     Q_ENUM(VeNCryptSubType)
 
+    enum PixelFormatPreference {
+        PixelFormatServer,
+        PixelFormatNative,
+        PixelFormatRgb565,
+        PixelFormatBgr233,
+    };
+    Q_ENUM(PixelFormatPreference)
+
+    enum BufferingMode {
+        SingleBuffered,
+        DoubleBuffered,
+        TripleBuffered,
+    };
+    Q_ENUM(BufferingMode)
+
     explicit QVncClient(QObject *parent = nullptr);
     ~QVncClient() override;
 
@@ -69,11 +150,40 @@ public:
     // Get framebuffer size
     int framebufferWidth() const;
     int framebufferHeight() const;
+    QList<QVncScreen> screens() const;
+
+    // Counters since the socket was set or the last resetStatistics()
+    QVncStatistics statistics() const;
+    void resetStatistics();
 
     bool framebufferUpdatesEnabled() const;
+    PixelFormatPreference pixelFormatPreference() const;
+    int decodeThreadCount() const;
+    int qualityLevel() const;
+    int compressionLevel() const;
+    BufferingMode bufferingMode() const;
+    QRect viewport() const;
+    int serverScale() const;
+    int updateInterval() const;
+    int readTimeBudget() const;
+    qint64 readByteBudget() const;
+    int pointerEventInterval() const;
+    bool lowDelay() const;
+    bool fastReconnect() const;
+    bool lazyFramebuffer() const;
 
     // Get current image
     QImage image() const;
+
+    // Framebuffer access without sharing the image
+    QImage imageView() const;
+    QImage imageView(const QRect &rect) const;
+    const uchar *framebufferBits() const;
+    qsizetype framebufferBytesPerLine() const;
+    QImage::Format framebufferFormat() const;
+
+    // Latest complete frame, see bufferingMode
+    QImage frame() const;
     QString password() const;
     QString username() const;
 
@@ -82,6 +192,11 @@ public:
     QPoint cursorHotspot() const;
     QPoint cursorPos() const;
 
+    // Record the stream received from the server
+    bool startRecording(const QString &fileName);
+    void stopRecording();
+    bool isRecording() const;
+
     // Process input events
     void handleKeyEvent(QKeyEvent *e);
     void handlePointerEvent(QMouseEvent *e);
@@ -91,6 +206,20 @@ public slots:
     void setPassword(const QString &password);
     void setUsername(const QString &username);
     void setFramebufferUpdatesEnabled(bool enabled);
+    void setPixelFormatPreference(PixelFormatPreference preference);
+    void setDecodeThreadCount(int count);
+    void setQualityLevel(int level);
+    void setCompressionLevel(int level);
+    void setBufferingMode(BufferingMode mode);
+    void setViewport(const QRect &viewport);
+    void setServerScale(int scale);
+    void setUpdateInterval(int msec);
+    void setReadTimeBudget(int msec);
+    void setReadByteBudget(qint64 bytes);
+    void setPointerEventInterval(int msec);
+    void setLowDelay(bool enabled);
+    void setFastReconnect(bool enabled);
+    void setLazyFramebuffer(bool enabled);
     void sendClipboardText(const QString &text);
     void sendClipboardImage(const QImage &image);
 
@@ -98,18 +227,37 @@ private:
     void setProtocolVersion(ProtocolVersion protocolVersion);
     void setSecurityType(SecurityType securityType);
 
+    friend class QVncClientManager;
+    void setSharedDecodePool(QThreadPool *pool);
+
 signals:
     void socketChanged(QTcpSocket *socket);
     void protocolVersionChanged(ProtocolVersion protocolVersion);
     void securityTypeChanged(SecurityType securityType);
     void framebufferSizeChanged(int width, int height);
+    void screensChanged();
     void imageChanged(const QRect &rect);
+    void imageRegionChanged(const QRegion &region);
     void connectionStateChanged(bool connected);
     void passwordChanged(const QString &password);
     void passwordRequested();
     void usernameChanged(const QString &username);
     void usernameRequested();
     void framebufferUpdatesEnabledChanged(bool enabled);
+    void pixelFormatPreferenceChanged(PixelFormatPreference preference);
+    void decodeThreadCountChanged(int count);
+    void qualityLevelChanged(int level);
+    void compressionLevelChanged(int level);
+    void bufferingModeChanged(BufferingMode mode);
+    void viewportChanged(const QRect &viewport);
+    void serverScaleChanged(int scale);
+    void updateIntervalChanged(int msec);
+    void readTimeBudgetChanged(int msec);
+    void readByteBudgetChanged(qint64 bytes);
+    void pointerEventIntervalChanged(int msec);
+    void lowDelayChanged(bool enabled);
+    void fastReconnectChanged(bool enabled);
+    void lazyFramebufferChanged(bool enabled);
     void framebufferUpdated();
     void cursorChanged();
     void cursorPosChanged(const QPoint &pos);
@@ -0,0 +1,206 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncclientmanager.h"
+#include "qvncclient.h"
+
+#include <QtCore/QThreadPool>
+
+QT_BEGIN_NAMESPACE
+
+class QVncClientManager::Private
+{
+public:
+    struct Entry {
+        QVncClient *client;
+        bool visible;
+        QMetaObject::Connection destroyed;
+    };
+
+    qsizetype indexOf(const QVncClient *client) const
+    {
+        for (qsizetype i = 0; i < entries.size(); ++i) {
+            if (entries.at(i).client == client)
+                return i;
+        }
+        return -1;
+    }
+
+    // Hands the client back to its own settings
+    static void release(const Entry &entry)
+    {
+        QObject::disconnect(entry.destroyed);
+        entry.client->setSharedDecodePool(nullptr);
+        if (!entry.visible)
+            entry.client->setUpdateInterval(0);
+    }
+
+    QThreadPool pool;
+    QList<Entry> entries;
+    int hiddenUpdateInterval = 1000;
+};
+
+/*!
+    \class QVncClientManager
+    \inmodule QtVncClient
+    \brief Shares resources between many QVncClient sessions.
+
+    An application watching hundreds of machines runs one QVncClient per
+    machine. Added to a manager, the clients decode on one thread pool
+    instead of one pool each, so the number of threads no longer grows
+    with the number of sessions. Each decode job is queued behind the jobs
+    of sessions with less work in flight, so a session receiving a large
+    update does not hold back the others.
+
+    Sessions that are not shown can be marked hidden with
+    setClientVisible(). Their update requests are throttled to one every
+    hiddenUpdateInterval milliseconds, which saves bandwidth on both ends
+    and decoding time in the application.
+
+    The manager does not own its clients. A client that is destroyed is
+    removed automatically; when the manager is destroyed, its clients go
+    back to decoding on their own threads.
+
+    \sa QVncClient::decodeThreadCount, QVncClient::updateInterval
+*/
+
+/*!
+    Constructs a manager with the given \a parent. It decodes on as many
+    threads as there are CPU cores.
+*/
+QVncClientManager::QVncClientManager(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+/*!
+    Destroys the manager. Its clients wait for their decode jobs to finish
+    and go back to their own decode threads and update interval.
+*/
+QVncClientManager::~QVncClientManager()
+{
+    for (const Private::Entry &entry : std::as_const(d->entries))
+        Private::release(entry);
+}
+
+/*!
+    Returns the clients of this manager, in the order they were added.
+*/
+QList<QVncClient *> QVncClientManager::clients() const
+{
+    QList<QVncClient *> clients;
+    clients.reserve(d->entries.size());
+    for (const Private::Entry &entry : std::as_const(d->entries))
+        clients.append(entry.client);
+    return clients;
+}
+
+/*!
+    Adds \a client to the manager. It decodes on the manager's threads from
+    now on and is visible until setClientVisible() says otherwise.
+
+    \sa removeClient()
+*/
+void QVncClientManager::addClient(QVncClient *client)
+{
+    if (!client || d->indexOf(client) >= 0)
+        return;
+    Private::Entry entry { client, true, {} };
+    entry.destroyed = connect(client, &QObject::destroyed, this, [this, client]() {
+        // The client has already waited for its decode jobs
+        const qsizetype i = d->indexOf(client);
+        if (i >= 0)
+            d->entries.removeAt(i);
+    });
+    d->entries.append(entry);
+    client->setSharedDecodePool(&d->pool);
+}
+
+/*!
+    Removes \a client from the manager. It goes back to decoding on its own
+    threads, and a hidden client to requesting updates without delay.
+
+    \sa addClient()
+*/
+void QVncClientManager::removeClient(QVncClient *client)
+{
+    const qsizetype i = d->indexOf(client);
+    if (i < 0)
+        return;
+    Private::release(d->entries.takeAt(i));
+}
+
+/*!
+    Returns \c true unless \a client was marked hidden with
+    setClientVisible().
+*/
+bool QVncClientManager::isClientVisible(QVncClient *client) const
+{
+    const qsizetype i = d->indexOf(client);
+    return i < 0 || d->entries.at(i).visible;
+}
+
+/*!
+    Marks \a client as shown or hidden according to \a visible.
+
+    A hidden client requests framebuffer updates at most once every
+    hiddenUpdateInterval milliseconds; a visible one as often as the
+    server sends them. The manager sets QVncClient::updateInterval
+    accordingly.
+*/
+void QVncClientManager::setClientVisible(QVncClient *client, bool visible)
+{
+    const qsizetype i = d->indexOf(client);
+    if (i < 0 || d->entries.at(i).visible == visible)
+        return;
+    d->entries[i].visible = visible;
+    client->setUpdateInterval(visible ? 0 : d->hiddenUpdateInterval);
+}
+
+/*!
+    \property QVncClientManager::decodeThreadCount
+    \brief The number of threads decoding for all clients of the manager.
+
+    The default is the number of CPU cores.
+*/
+int QVncClientManager::decodeThreadCount() const
+{
+    return d->pool.maxThreadCount();
+}
+
+void QVncClientManager::setDecodeThreadCount(int count)
+{
+    count = qMax(1, count);
+    if (decodeThreadCount() == count)
+        return;
+    d->pool.setMaxThreadCount(count);
+    emit decodeThreadCountChanged(count);
+}
+
+/*!
+    \property QVncClientManager::hiddenUpdateInterval
+    \brief The minimum time between update requests of hidden clients, in
+    milliseconds.
+
+    The default is 1000. Changes apply to clients that are hidden already.
+*/
+int QVncClientManager::hiddenUpdateInterval() const
+{
+    return d->hiddenUpdateInterval;
+}
+
+void QVncClientManager::setHiddenUpdateInterval(int msec)
+{
+    msec = qMax(0, msec);
+    if (d->hiddenUpdateInterval == msec)
+        return;
+    d->hiddenUpdateInterval = msec;
+    for (const Private::Entry &entry : std::as_const(d->entries)) {
+        if (!entry.visible)
+            entry.client->setUpdateInterval(msec);
+    }
+    emit hiddenUpdateIntervalChanged(msec);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,49 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef QVNCCLIENTMANAGER_H
+#define QVNCCLIENTMANAGER_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QObject>
+#include <QtCore/QList>
+#include <QtCore/QScopedPointer>
+
+QT_BEGIN_NAMESPACE
+
+class QVncClient;
+
+class Q_VNCCLIENT_EXPORT QVncClientManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int decodeThreadCount READ decodeThreadCount WRITE setDecodeThreadCount NOTIFY decodeThreadCountChanged)
+    Q_PROPERTY(int hiddenUpdateInterval READ hiddenUpdateInterval WRITE setHiddenUpdateInterval NOTIFY hiddenUpdateIntervalChanged)
+public:
+    explicit QVncClientManager(QObject *parent = nullptr);
+    ~QVncClientManager() override;
+
+    QList<QVncClient *> clients() const;
+    void addClient(QVncClient *client);
+    void removeClient(QVncClient *client);
+
+    bool isClientVisible(QVncClient *client) const;
+    void setClientVisible(QVncClient *client, bool visible);
+
+    int decodeThreadCount() const;
+    int hiddenUpdateInterval() const;
+
+public slots:
+    void setDecodeThreadCount(int count);
+    void setHiddenUpdateInterval(int msec);
+
+signals:
+    void decodeThreadCountChanged(int count);
+    void hiddenUpdateIntervalChanged(int msec);
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCCLIENTMANAGER_H
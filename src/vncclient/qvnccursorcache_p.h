@@ -0,0 +1,85 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Decoded RichCursor shapes, most recently used first.
+//
+// Applications switch between a handful of cursors, busy and arrow while
+// loading, text and arrow over a form, and the server sends the full shape
+// each time. Shapes are looked up by their size and the pixel and mask
+// bytes as sent, so a shape seen before is not decoded again. The bytes
+// themselves are the key: a match is exact, not a hash collision. Since the
+// pixel bytes depend on the pixel format, the cache is cleared when it
+// changes. At most maxBytes of images and keys are kept; the least
+// recently used shapes go first.
+//
+
+#ifndef QVNCCURSORCACHE_P_H
+#define QVNCCURSORCACHE_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QtEndian>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+class QVncCursorCache
+{
+public:
+    explicit QVncCursorCache(qsizetype maxBytes = 1024 * 1024)
+    {
+        m_images.setMaxCost(maxBytes);
+    }
+
+    static QByteArray key(int width, int height, const uchar *data, qsizetype size)
+    {
+        QByteArray key;
+        key.reserve(4 + size);
+        const quint16_be dimensions[2] = { quint16_be(width), quint16_be(height) };
+        key.append(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+        key.append(reinterpret_cast<const char *>(data), size);
+        return key;
+    }
+
+    // A null image if the shape is not cached
+    QImage find(const QByteArray &key)
+    {
+        if (const QImage *image = m_images.object(key)) {
+            ++m_hits;
+            return *image;
+        }
+        ++m_misses;
+        return QImage();
+    }
+
+    void insert(const QByteArray &key, const QImage &image)
+    {
+        m_images.insert(key, new QImage(image), key.size() + image.sizeInBytes());
+    }
+
+    void clear() { m_images.clear(); }
+    qsizetype count() const { return m_images.count(); }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+
+private:
+    QCache<QByteArray, QImage> m_images;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCCURSORCACHE_P_H
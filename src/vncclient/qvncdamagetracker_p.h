@@ -0,0 +1,105 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Collects the rectangles of one framebuffer update into a region that is
+// reported once when the update is complete.
+//
+// Servers split an update into many small rectangles: Hextile and ZRLE
+// tiles, Tight stripes, one per changed glyph. Repainting them one by one
+// costs more than repainting the area they cover, so neighbours are merged
+// as they arrive. Two rectangles are merged when their bounding rectangle
+// is at most an eighth larger than what they cover; tiles sent in scan
+// order grow into rows and the rows into one block. Only the last few
+// rectangles are looked at, which is where the neighbours of a new one are.
+// An update that is still scattered over more than maxRects rectangles is
+// reported as its bounding rectangle.
+//
+
+#ifndef QVNCDAMAGETRACKER_P_H
+#define QVNCDAMAGETRACKER_P_H
+
+#include <QtCore/QList>
+#include <QtCore/QRect>
+#include <QtGui/QRegion>
+
+QT_BEGIN_NAMESPACE
+
+class QVncDamageTracker
+{
+public:
+    static constexpr int maxRects = 32;
+
+    bool isEmpty() const { return m_rects.isEmpty(); }
+    const QList<QRect> &rects() const { return m_rects; }
+    QRect boundingRect() const { return m_bounds; }
+
+    void clear()
+    {
+        m_rects.clear();
+        m_bounds = QRect();
+    }
+
+    void add(QRect rect)
+    {
+        if (rect.isEmpty())
+            return;
+        m_bounds |= rect;
+        // A merged rectangle may now fit one it could not before
+        while (mergeInto(rect)) { }
+        m_rects.append(rect);
+        if (m_rects.size() > maxRects)
+            m_rects = { m_bounds };
+    }
+
+    // The damage so far, leaving the tracker empty for the next update
+    QRegion take()
+    {
+        QRegion region;
+        for (const QRect &rect : std::as_const(m_rects))
+            region += rect;
+        clear();
+        return region;
+    }
+
+private:
+    static constexpr int lookBack = 4;
+
+    static qint64 area(const QRect &rect) { return qint64(rect.width()) * rect.height(); }
+
+    // Replaces \a rect with its union with a close recent rectangle, which
+    // is taken out of the list
+    bool mergeInto(QRect &rect)
+    {
+        const int first = qMax(0, int(m_rects.size()) - lookBack);
+        for (int i = int(m_rects.size()) - 1; i >= first; i--) {
+            const QRect &other = m_rects.at(i);
+            const QRect united = other.united(rect);
+            const qint64 covered = area(other) + area(rect) - area(other.intersected(rect));
+            if ((area(united) - covered) * 8 <= area(united)) {
+                rect = united;
+                m_rects.removeAt(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QList<QRect> m_rects;
+    QRect m_bounds;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCDAMAGETRACKER_P_H
@@ -0,0 +1,233 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Decode workers for framebuffer rectangles.
+//
+// The protocol is parsed (and zlib streams inflated) in order in the thread
+// that owns the socket. Decoding the pixels of a rectangle only depends on
+// its own payload, so that part can be handed to a thread pool. The only
+// ordering that matters is between rectangles that touch the same pixels:
+// a job whose area overlaps one still in flight waits for it to finish
+// first. Completion callbacks run in the thread of the context object.
+//
+// The pool is either the queue's own or one shared by many sessions, see
+// QVncClientManager. A shared pool runs the jobs of every session, so the
+// queue counts its own jobs to wait for them, and gives each job a lower
+// priority the more jobs its session already has queued: a session
+// decoding a large update cannot hold back the first rectangle of
+// another one.
+//
+
+#ifndef QVNCDECODEQUEUE_P_H
+#define QVNCDECODEQUEUE_P_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QRect>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+#include <functional>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QVncDecodeQueue
+{
+public:
+    explicit QVncDecodeQueue(QObject *context) : m_context(context) {}
+    ~QVncDecodeQueue() { clear(); }
+
+    QVncDecodeQueue(const QVncDecodeQueue &) = delete;
+    QVncDecodeQueue &operator=(const QVncDecodeQueue &) = delete;
+
+    // 0 disables the workers; jobs then run synchronously in start().
+    // Without effect on the thread count while a shared pool is set.
+    void setMaxThreadCount(int count)
+    {
+        count = qMax(0, count);
+        if (count == m_threadCount)
+            return;
+        waitForDone();
+        m_threadCount = count;
+        if (count == 0) {
+            m_ownPool.reset();
+            return;
+        }
+        if (!m_ownPool)
+            m_ownPool.reset(new QThreadPool);
+        m_ownPool->setMaxThreadCount(count);
+    }
+
+    int maxThreadCount() const { return m_threadCount; }
+
+    // Runs jobs on \a pool instead of the queue's own, nullptr to go back
+    QThreadPool *sharedPool() const { return m_sharedPool; }
+    void setSharedPool(QThreadPool *pool)
+    {
+        if (pool == m_sharedPool)
+            return;
+        waitForDone();
+        m_sharedPool = pool;
+    }
+
+    bool isEnabled() const { return pool(); }
+    // Threads the jobs may run on, those of the shared pool if there is one
+    int workerCount() const { return pool() ? pool()->maxThreadCount() : 0; }
+    bool isIdle() const { return m_inFlight.isEmpty(); }
+
+    // Called in the context thread whenever the last job in flight is done.
+    void setIdleHandler(std::function<void()> handler) { m_idle = std::move(handler); }
+
+    // Runs \a job on a worker once nothing overlapping \a area is in flight,
+    // then \a done in the context thread. \a job must own all the data it
+    // reads.
+    void start(const QRect &area, std::function<void()> job, std::function<void()> done = {})
+    {
+        QThreadPool *threadPool = pool();
+        if (!threadPool) {
+            job();
+            if (done)
+                done();
+            return;
+        }
+        waitFor(area);
+        const quint64 id = ++m_lastId;
+        const int priority = -int(m_inFlight.size());
+        m_inFlight.append({ id, area, std::move(done) });
+        {
+            QMutexLocker locker(&m_finishedMutex);
+            ++m_running;
+        }
+        threadPool->start([this, id, job = std::move(job)]() mutable {
+            job();
+            job = nullptr; // release what it captured before reporting back
+            QMutexLocker locker(&m_finishedMutex);
+            m_finished.append(id);
+            QMetaObject::invokeMethod(m_context, [this]() { drain(); }, Qt::QueuedConnection);
+            // Last, so that waiting for the jobs also waits for this one
+            // to be done with the queue
+            if (--m_running == 0)
+                m_allFinished.wakeAll();
+        }, priority);
+    }
+
+    // Blocks until no job overlapping \a area is in flight.
+    void waitFor(const QRect &area)
+    {
+        for (const InFlight &job : std::as_const(m_inFlight)) {
+            if (job.area.intersects(area)) {
+                waitForDone();
+                return;
+            }
+        }
+    }
+
+    // Blocks until every job has finished and delivers their callbacks.
+    void waitForDone()
+    {
+        if (!m_inFlight.isEmpty()) {
+            waitForRunning();
+            drain();
+        }
+    }
+
+    // Calls \a body for 0 to \a count - 1 on the calling thread and on any
+    // idle workers, and returns once all calls are done. Safe to use from a
+    // job: the caller takes part, so it never waits for a busy pool.
+    void parallelFor(int count, const std::function<void(int)> &body) const
+    {
+        QAtomicInt next;
+        auto run = [&]() {
+            for (int i = next.fetchAndAddRelaxed(1); i < count; i = next.fetchAndAddRelaxed(1))
+                body(i);
+        };
+        QSemaphore finished;
+        int helpers = 0;
+        if (QThreadPool *threadPool = pool()) {
+            const int wanted = qMin(count, threadPool->maxThreadCount()) - 1;
+            while (helpers < wanted && threadPool->tryStart([&]() { run(); finished.release(); }))
+                ++helpers;
+        }
+        run();
+        finished.acquire(helpers);
+    }
+
+    // Waits for running jobs but drops their callbacks, e.g. on disconnect.
+    void clear()
+    {
+        waitForRunning();
+        QMutexLocker locker(&m_finishedMutex);
+        m_finished.clear();
+        m_inFlight.clear();
+    }
+
+private:
+    struct InFlight {
+        quint64 id;
+        QRect area;
+        std::function<void()> done;
+    };
+
+    QThreadPool *pool() const { return m_sharedPool ? m_sharedPool : m_ownPool.get(); }
+
+    void waitForRunning()
+    {
+        QMutexLocker locker(&m_finishedMutex);
+        while (m_running > 0)
+            m_allFinished.wait(&m_finishedMutex);
+    }
+
+    void drain()
+    {
+        QList<quint64> finished;
+        {
+            QMutexLocker locker(&m_finishedMutex);
+            finished.swap(m_finished);
+        }
+        if (finished.isEmpty())
+            return;
+        for (const quint64 id : std::as_const(finished)) {
+            for (qsizetype i = 0; i < m_inFlight.size(); ++i) {
+                if (m_inFlight.at(i).id != id)
+                    continue;
+                const std::function<void()> done = m_inFlight.takeAt(i).done;
+                if (done)
+                    done();
+                break;
+            }
+        }
+        if (m_inFlight.isEmpty() && m_idle)
+            m_idle();
+    }
+
+    QObject *m_context;
+    std::unique_ptr<QThreadPool> m_ownPool;
+    QThreadPool *m_sharedPool = nullptr;
+    int m_threadCount = 0;
+    QList<InFlight> m_inFlight;
+    quint64 m_lastId = 0;
+    std::function<void()> m_idle;
+
+    QMutex m_finishedMutex;
+    QList<quint64> m_finished;
+    int m_running = 0;                  // jobs not done yet, guarded by m_finishedMutex
+    QWaitCondition m_allFinished;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCDECODEQUEUE_P_H
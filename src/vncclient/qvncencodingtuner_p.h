@@ -0,0 +1,226 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Picks the Tight quality and compression levels from what the connection
+// delivers.
+//
+// Every framebuffer update big enough to say something about the link is
+// measured: how many bytes it had, how long it took to arrive and how much
+// time the client spent decoding it. Arrival is taken from the socket
+// reads, not from parsing: from the read that brought the first bytes of
+// the update to the one that completed it, counting what those reads
+// delivered. An update read in one go says nothing about the link, which
+// is what happens when the client is behind and the data waits in the
+// socket. Over windows of about a second this gives the throughput of the
+// link and whether the client is the bottleneck. The levels follow the throughput; on a fast
+// link with a busy client, Raw is preferred because it costs nothing to
+// decode. A new choice is only made after two windows agree on it, so a
+// single burst does not cause a SetEncodings round.
+//
+// Times are passed in, in nanoseconds from any fixed origin, so the
+// decisions can be tested without waiting for real time to pass.
+//
+
+#ifndef QVNCENCODINGTUNER_P_H
+#define QVNCENCODINGTUNER_P_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+
+QT_BEGIN_NAMESPACE
+
+class QVncEncodingTuner
+{
+public:
+    struct Levels {
+        int quality = 7;        // QualityLevel pseudo-encoding, 0-9
+        int compression = 6;    // CompressLevel pseudo-encoding, 0-9
+        bool preferRaw = false; // Raw ahead of the compressing encodings
+
+        friend bool operator==(const Levels &a, const Levels &b)
+        {
+            return a.quality == b.quality && a.compression == b.compression
+                    && a.preferRaw == b.preferRaw;
+        }
+        friend bool operator!=(const Levels &a, const Levels &b) { return !(a == b); }
+    };
+
+    // What one encoding cost the client so far.
+    struct Cost {
+        qint64 nsecs = 0;
+        qint64 pixels = 0;
+    };
+
+    void reset()
+    {
+        m_levels = Levels();
+        m_candidate = Levels();
+        m_throughput = 0;
+        m_windowBytes = 0;
+        m_windowTransfer = 0;
+        m_windowDecode = 0;
+        m_costs.clear();
+        m_fills.clear();
+        m_updateStart = -1;
+        m_windowStart = -1;
+    }
+
+    const Levels &levels() const { return m_levels; }
+    // Link throughput in bytes per second, 0 until measured.
+    double throughput() const { return m_throughput; }
+    const QHash<qint32, Cost> &costs() const { return m_costs; }
+
+    // Called after each socket read that took the stream to \a position.
+    void dataReceived(qint64 position, qint64 now)
+    {
+        // Bounded, for reads that are not parsed for a long time
+        if (m_fills.size() >= maxFills)
+            m_fills.removeFirst();
+        m_fills.append(Fill{ position, now });
+    }
+
+    // Called once the header of an update starting at stream \a position
+    // is parsed.
+    void updateStarted(qint64 position, qint64 now)
+    {
+        m_updateStart = now;
+        m_updateDecode = 0;
+        // Older reads only brought earlier messages
+        while (!m_fills.isEmpty() && m_fills.first().position <= position)
+            m_fills.removeFirst();
+        m_firstFill = fillReaching(position + 1);
+    }
+
+    void addDecodeTime(qint32 encoding, qint64 nsecs, qint64 pixels)
+    {
+        Cost &cost = m_costs[encoding];
+        cost.nsecs += nsecs;
+        cost.pixels += pixels;
+        m_updateDecode += nsecs;
+    }
+
+    // Called once the \a bytes of an update, ending at stream \a position,
+    // are parsed. Returns true when levels() changed and should be sent to
+    // the server.
+    bool updateFinished(qint64 bytes, qint64 position, qint64 now)
+    {
+        if (m_updateStart < 0)
+            return false;
+        const qint64 elapsed = now - m_updateStart;
+        m_updateStart = -1;
+        // Small updates arrive in one segment and only measure latency
+        if (bytes < minUpdateBytes)
+            return false;
+        if (m_windowStart < 0)
+            m_windowStart = now - elapsed;
+        m_windowDecode += m_updateDecode;
+        // What the reads after the first one delivered, in the time between
+        // them; nothing if the whole update was read at once
+        const Fill last = fillReaching(position);
+        if (m_firstFill.position >= 0 && last.position > m_firstFill.position
+                && last.time - m_firstFill.time >= minTransferNsecs) {
+            m_windowBytes += last.position - m_firstFill.position;
+            m_windowTransfer += last.time - m_firstFill.time;
+        }
+        const qint64 windowLength = now - m_windowStart;
+        if (windowLength < windowNsecs)
+            return false;
+
+        if (m_windowTransfer > 0) {
+            const double throughput = m_windowBytes * 1e9 / m_windowTransfer;
+            m_throughput = m_throughput > 0 ? (m_throughput + throughput) / 2 : throughput;
+        }
+        const double decodeShare = double(m_windowDecode) / windowLength;
+        m_windowBytes = 0;
+        m_windowTransfer = 0;
+        m_windowDecode = 0;
+        m_windowStart = now;
+        if (m_throughput <= 0)
+            return false;
+
+        const Levels target = levelsFor(m_throughput, decodeShare);
+        const bool confirmed = target == m_candidate;
+        m_candidate = target;
+        if (!confirmed || target == m_levels)
+            return false;
+        m_levels = target;
+        return true;
+    }
+
+private:
+    struct Fill {
+        qint64 position = -1;   // stream position after the read
+        qint64 time = -1;
+    };
+
+    // The first read that took the stream to \a position or beyond
+    Fill fillReaching(qint64 position) const
+    {
+        for (const Fill &fill : m_fills) {
+            if (fill.position >= position)
+                return fill;
+        }
+        return {};
+    }
+
+    Levels levelsFor(double throughput, double decodeShare) const
+    {
+        const double mbits = throughput * 8 / 1e6;
+        Levels levels;
+        if (mbits >= 50) {
+            levels.quality = 9;
+            levels.compression = 1;
+        } else if (mbits >= 10) {
+            levels.quality = 8;
+            levels.compression = 2;
+        } else if (mbits >= 2) {
+            levels.quality = 6;
+            levels.compression = 5;
+        } else if (mbits >= 0.5) {
+            levels.quality = 4;
+            levels.compression = 7;
+        } else {
+            levels.quality = 2;
+            levels.compression = 9;
+        }
+        // Once on Raw, decoding is cheap by definition; only a slower link
+        // is a reason to go back
+        levels.preferRaw = m_levels.preferRaw ? mbits >= 200
+                                              : mbits >= 500 && decodeShare >= 0.5;
+        return levels;
+    }
+
+    static constexpr qint64 minUpdateBytes = 16 * 1024;
+    static constexpr qint64 minTransferNsecs = 100 * 1000;
+    static constexpr qint64 windowNsecs = 1000 * 1000 * 1000;
+    static constexpr qsizetype maxFills = 256;
+
+    Levels m_levels;
+    Levels m_candidate;
+    double m_throughput = 0;
+    qint64 m_updateStart = -1;
+    qint64 m_updateDecode = 0;
+    Fill m_firstFill;           // the read that brought the start of the update
+    QList<Fill> m_fills;        // reads not parsed past yet, oldest first
+    qint64 m_windowStart = -1;
+    qint64 m_windowBytes = 0;
+    qint64 m_windowTransfer = 0;
+    qint64 m_windowDecode = 0;
+    QHash<qint32, Cost> m_costs;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCENCODINGTUNER_P_H
@@ -0,0 +1,82 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncframebuffermemory_p.h"
+
+#if defined(Q_OS_WIN)
+#include <qt_windows.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <cstdlib>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+struct Mapping {
+    void *data;
+    size_t size;
+};
+
+void *reserve(size_t size)
+{
+#if defined(Q_OS_WIN)
+    // Committed memory is zero and only backed by pages once touched
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(Q_OS_UNIX)
+#ifdef MAP_NORESERVE
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#else
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return data == MAP_FAILED ? nullptr : data;
+#else
+    // Large blocks come straight from the system, already zero
+    return calloc(size, 1);
+#endif
+}
+
+void release(void *info)
+{
+    Mapping *mapping = static_cast<Mapping *>(info);
+#if defined(Q_OS_WIN)
+    VirtualFree(mapping->data, 0, MEM_RELEASE);
+#elif defined(Q_OS_UNIX)
+    munmap(mapping->data, mapping->size);
+#else
+    free(mapping->data);
+#endif
+    delete mapping;
+}
+}
+
+QImage QVncFramebufferMemory::allocate(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return QImage();
+    const qsizetype bytesPerLine = qsizetype(width) * 4;
+    const size_t size = size_t(bytesPerLine) * size_t(height);
+    void *data = reserve(size);
+    if (!data)
+        return QImage();
+    // Not owned by QImage, but writable: only copied while shared, like its own
+    return QImage(static_cast<uchar *>(data), width, height, bytesPerLine, QImage::Format_RGB32,
+                  release, new Mapping { data, size });
+}
+
+qsizetype QVncFramebufferMemory::pageSize()
+{
+#if defined(Q_OS_WIN)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#elif defined(Q_OS_UNIX)
+    return sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,50 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Framebuffer memory that is only allocated where it is written.
+//
+// A QImage allocates its pixels up front, and filling it touches all of
+// them: a 16K wide video wall costs over 500 MB per session before the
+// first update, even if only part of it is ever shown. This memory is
+// instead reserved from the system as zero pages, which it maps on first
+// write, in page sized pieces (1024 pixels of a row with 4 KiB pages).
+// On Linux, reading a page that was never written costs no memory
+// either. The framebuffer starts out black rather than white, and stays
+// one contiguous image, so decoders, imageView() and framebufferBits()
+// work on it unchanged. Pages are only given back when it is freed.
+//
+
+#ifndef QVNCFRAMEBUFFERMEMORY_P_H
+#define QVNCFRAMEBUFFERMEMORY_P_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtGui/QImage>
+
+QT_BEGIN_NAMESPACE
+
+class Q_VNCCLIENT_EXPORT QVncFramebufferMemory
+{
+public:
+    // A black QImage::Format_RGB32 image over lazily allocated memory, or
+    // a null image if the system cannot reserve it
+    static QImage allocate(int width, int height);
+
+    // The page size the memory is allocated in
+    static qsizetype pageSize();
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCFRAMEBUFFERMEMORY_P_H
@@ -0,0 +1,491 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncframerecorder.h"
+#include "qvncframerecorder_p.h"
+#include "qvncclient.h"
+#include "qvnczlib_p.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QtEndian>
+#include <cstring>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+using namespace QVncFrameRecording;
+
+class QVncFrameRecorder::Private
+{
+public:
+    struct Frame {
+        qint64 time = 0;
+        QSize size;
+        quint32 rects = 0;
+        QByteArray payload;
+    };
+
+    void capture(bool force = false);
+    void write();
+
+    QVncClient *client = nullptr;
+    QList<QMetaObject::Connection> connections;
+    qint64 maxQueuedBytes = 64 * 1024 * 1024;
+    QElapsedTimer clock;
+    QSize recordedSize;     // framebuffer size of the last frame queued
+    QRegion pending;        // changed since the last frame queued
+
+    QFile file;
+    std::unique_ptr<QThread> writer;
+
+    // Shared with the writer thread
+    QMutex mutex;
+    QWaitCondition wake;
+    QList<Frame> queue;
+    qint64 queuedBytes = 0;
+    bool stopping = false;
+    bool failed = false;
+    quint32 flags = 0;
+    quint64 framesWritten = 0;
+    quint64 framesCoalesced = 0;
+    qint64 bytesWritten = 0;
+    QString error;
+};
+
+/*!
+    \internal
+    Copies the pixels changed since the last frame, or all of them after a
+    size change, and queues them for the writer. If the writer is behind by
+    more than maxQueuedBytes, nothing is copied: the changes stay pending
+    and go out with the next update, so the caller never waits. \a force
+    queues them regardless.
+*/
+void QVncFrameRecorder::Private::capture(bool force)
+{
+    if (!writer || !client)
+        return;
+    const uchar *bits = client->framebufferBits();
+    if (!bits)
+        return;
+    const qint64 time = clock.nsecsElapsed();
+    const QSize size(client->framebufferWidth(), client->framebufferHeight());
+    const QRect framebuffer(QPoint(), size);
+    const QRegion region = size == recordedSize ? pending & framebuffer : QRegion(framebuffer);
+    if (region.isEmpty())
+        return;
+
+    qint64 bytes = 0;
+    for (const QRect &rect : region)
+        bytes += rectHeaderSize + qint64(rect.width()) * rect.height() * 4;
+    {
+        QMutexLocker locker(&mutex);
+        if (failed)
+            return;
+        if (!force && !queue.isEmpty() && queuedBytes + bytes > maxQueuedBytes) {
+            ++framesCoalesced;
+            return;
+        }
+    }
+
+    // The only copy of the pixels, and only of those that changed
+    QByteArray payload(bytes, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(payload.data());
+    const qsizetype bytesPerLine = client->framebufferBytesPerLine();
+    quint32 rects = 0;
+    for (const QRect &rect : region) {
+        qToLittleEndian<quint16>(quint16(rect.x()), out);
+        qToLittleEndian<quint16>(quint16(rect.y()), out + 2);
+        qToLittleEndian<quint16>(quint16(rect.width()), out + 4);
+        qToLittleEndian<quint16>(quint16(rect.height()), out + 6);
+        out += rectHeaderSize;
+        for (int y = rect.top(); y <= rect.bottom(); y++) {
+            qToLittleEndian<quint32>(bits + y * bytesPerLine + rect.left() * 4, rect.width(), out);
+            out += rect.width() * 4;
+        }
+        ++rects;
+    }
+
+    QMutexLocker locker(&mutex);
+    queue.append({ time, size, rects, std::move(payload) });
+    queuedBytes += bytes;
+    wake.wakeOne();
+    locker.unlock();
+    pending = QRegion();
+    recordedSize = size;
+}
+
+/*!
+    \internal
+    The writer thread: compresses and writes the queued frames in order
+    until close() asks it to stop and the queue is empty.
+*/
+void QVncFrameRecorder::Private::write()
+{
+    QVncDeflater deflater(1);
+    for (;;) {
+        QMutexLocker locker(&mutex);
+        while (queue.isEmpty() && !stopping)
+            wake.wait(&mutex);
+        if (queue.isEmpty())
+            return;
+        const Frame frame = queue.takeFirst();
+        const bool compress = flags & Compressed;
+        locker.unlock();
+
+        const QByteArray stored = compress ? deflater.compress(frame.payload, QVncDeflater::Finish)
+                                           : frame.payload;
+        uchar header[frameHeaderSize];
+        qToLittleEndian<quint64>(frame.time, header);
+        qToLittleEndian<quint16>(quint16(frame.size.width()), header + 8);
+        qToLittleEndian<quint16>(quint16(frame.size.height()), header + 10);
+        qToLittleEndian<quint32>(frame.rects, header + 12);
+        qToLittleEndian<quint32>(quint32(frame.payload.size()), header + 16);
+        qToLittleEndian<quint32>(quint32(stored.size()), header + 20);
+        const bool ok = !stored.isNull()
+                && file.write(reinterpret_cast<const char *>(header), frameHeaderSize) == frameHeaderSize
+                && file.write(stored) == stored.size();
+
+        locker.relock();
+        queuedBytes -= frame.payload.size();
+        if (!ok) {
+            failed = true;
+            error = stored.isNull() ? QStringLiteral("Failed to compress a frame") : file.errorString();
+            queue.clear();
+            queuedBytes = 0;
+            qCWarning(lcVncClient) << "Failed to write frame recording:" << error;
+            return;
+        }
+        ++framesWritten;
+        bytesWritten += frameHeaderSize + stored.size();
+    }
+}
+
+/*!
+    \class QVncFrameRecorder
+    \inmodule QtVncClient
+    \brief Records the framebuffer of a QVncClient as it changes.
+
+    Archiving a session by grabbing QVncClient::image() at a fixed rate
+    copies and encodes the whole framebuffer for every frame, even while
+    nothing changes. A frame recorder instead follows the client and, each
+    time an update is complete, copies only the rectangles that changed,
+    stamped with the time. A writer thread compresses them and appends
+    them to the file, so the decoders never wait for the disk. While the
+    screen is idle, no frames are written and nothing is copied.
+
+    The writer is given at most maxQueuedBytes of pixels at a time. When
+    it falls behind, updates are not copied; their changes are merged and
+    recorded with the next update that finds room, so the recording skips
+    intermediate frames rather than slowing down the session.
+    framesCoalesced() counts the updates merged this way.
+
+    The file holds the changed rectangles of each frame, compressed with
+    zlib when the library is built with it. The first frame, and the first
+    after the framebuffer size changes, covers the whole framebuffer, so
+    any frame can be reconstructed by applying the ones before it.
+
+    \code
+    QVncFrameRecorder recorder;
+    recorder.setClient(&client);
+    recorder.open(QStringLiteral("session.qvncframes"));
+    \endcode
+
+    \note Recordings contain everything shown on the remote screen. Store
+    them accordingly.
+
+    \sa QVncClient::startRecording(), QVncClient::imageRegionChanged()
+*/
+
+/*!
+    Constructs a frame recorder with the given \a parent.
+*/
+QVncFrameRecorder::QVncFrameRecorder(QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+}
+
+/*!
+    Destroys the frame recorder, closing the recording.
+*/
+QVncFrameRecorder::~QVncFrameRecorder()
+{
+    close();
+}
+
+/*!
+    \property QVncFrameRecorder::client
+    \brief The client whose framebuffer is recorded.
+
+    While a recording is open, setting a client records its whole
+    framebuffer as the next frame.
+*/
+QVncClient *QVncFrameRecorder::client() const
+{
+    return d->client;
+}
+
+void QVncFrameRecorder::setClient(QVncClient *client)
+{
+    if (d->client == client)
+        return;
+    for (const QMetaObject::Connection &connection : std::as_const(d->connections))
+        disconnect(connection);
+    d->connections.clear();
+    d->client = client;
+    d->recordedSize = QSize();
+    d->pending = QRegion();
+    if (client) {
+        d->connections.append(connect(client, &QVncClient::imageRegionChanged, this,
+                                      [this](const QRegion &region) { d->pending += region; }));
+        d->connections.append(connect(client, &QVncClient::framebufferUpdated, this,
+                                      [this]() { d->capture(); }));
+        // A new framebuffer starts with a complete frame
+        d->connections.append(connect(client, &QVncClient::framebufferSizeChanged, this,
+                                      [this]() { d->recordedSize = QSize(); }));
+        d->connections.append(connect(client, &QVncClient::connectionStateChanged, this,
+                                      [this]() { d->recordedSize = QSize(); }));
+        d->connections.append(connect(client, &QObject::destroyed, this,
+                                      [this]() { setClient(nullptr); }));
+        d->capture();
+    }
+    emit clientChanged(client);
+}
+
+/*!
+    \property QVncFrameRecorder::maxQueuedBytes
+    \brief The most pixel data handed to the writer thread and not written
+    yet, in bytes.
+
+    An update that would exceed it while the writer is busy is merged into
+    the next one instead. A single frame larger than this is still
+    recorded once the writer has caught up. The default is 64 MiB.
+*/
+qint64 QVncFrameRecorder::maxQueuedBytes() const
+{
+    return d->maxQueuedBytes;
+}
+
+void QVncFrameRecorder::setMaxQueuedBytes(qint64 bytes)
+{
+    bytes = qMax<qint64>(0, bytes);
+    if (d->maxQueuedBytes == bytes)
+        return;
+    {
+        QMutexLocker locker(&d->mutex);
+        d->maxQueuedBytes = bytes;
+    }
+    emit maxQueuedBytesChanged(bytes);
+}
+
+/*!
+    Creates \a fileName, replacing an existing file, and starts recording
+    into it. The current framebuffer of the client, if any, is the first
+    frame. Returns \c false if the file cannot be written, see
+    errorString().
+
+    \sa close()
+*/
+bool QVncFrameRecorder::open(const QString &fileName)
+{
+    close();
+    d->file.setFileName(fileName);
+    if (!d->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        d->error = d->file.errorString();
+        return false;
+    }
+    d->flags = QVncInflater::backend() ? Compressed : 0;
+    uchar header[headerSize];
+    memcpy(header, magic, sizeof(magic));
+    qToLittleEndian<quint32>(formatVersion, header + 8);
+    qToLittleEndian<quint32>(d->flags, header + 12);
+    if (d->file.write(reinterpret_cast<const char *>(header), headerSize) != headerSize) {
+        d->error = d->file.errorString();
+        d->file.close();
+        return false;
+    }
+
+    d->stopping = false;
+    d->failed = false;
+    d->error.clear();
+    d->framesWritten = 0;
+    d->framesCoalesced = 0;
+    d->bytesWritten = headerSize;
+    d->recordedSize = QSize();
+    d->pending = QRegion();
+    d->clock.start();
+    d->writer.reset(QThread::create([this]() { d->write(); }));
+    d->writer->setObjectName(QStringLiteral("QVncFrameRecorder"));
+    d->writer->start(QThread::LowPriority);
+    d->capture();
+    return true;
+}
+
+/*!
+    Records the changes still pending, waits until every frame is written
+    and closes the file.
+
+    \sa open()
+*/
+void QVncFrameRecorder::close()
+{
+    if (!d->writer)
+        return;
+    d->capture(true);
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stopping = true;
+        d->wake.wakeAll();
+    }
+    d->writer->wait();
+    d->writer.reset();
+    d->queue.clear();
+    d->queuedBytes = 0;
+    d->file.close();
+}
+
+/*!
+    Returns \c true while a recording is open.
+*/
+bool QVncFrameRecorder::isOpen() const
+{
+    return bool(d->writer);
+}
+
+/*!
+    Returns a description of the last error opening or writing the
+    recording. After a write error the recording stops taking frames.
+*/
+QString QVncFrameRecorder::errorString() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->error;
+}
+
+/*!
+    Returns the number of frames written to the current recording.
+*/
+quint64 QVncFrameRecorder::framesWritten() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->framesWritten;
+}
+
+/*!
+    Returns the number of updates of the current recording that were
+    merged into a later frame because the writer was behind.
+
+    \sa maxQueuedBytes
+*/
+quint64 QVncFrameRecorder::framesCoalesced() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->framesCoalesced;
+}
+
+/*!
+    Returns the size of the current recording written so far, in bytes.
+*/
+qint64 QVncFrameRecorder::bytesWritten() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->bytesWritten;
+}
+
+bool QVncFrameReader::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return fail(m_file.errorString());
+    uchar header[headerSize];
+    if (m_file.read(reinterpret_cast<char *>(header), headerSize) != headerSize
+            || memcmp(header, magic, sizeof(magic)) != 0
+            || qFromLittleEndian<quint32>(header + 8) != formatVersion) {
+        m_file.close();
+        return fail(QStringLiteral("Not a frame recording"));
+    }
+    m_flags = qFromLittleEndian<quint32>(header + 12);
+    if ((m_flags & Compressed) && !QVncInflater::backend()) {
+        m_file.close();
+        return fail(QStringLiteral("Compressed frame recording, but built without zlib"));
+    }
+    m_error.clear();
+    return true;
+}
+
+void QVncFrameReader::close()
+{
+    m_file.close();
+    m_time = 0;
+    m_region = QRegion();
+    m_image = QImage();
+}
+
+bool QVncFrameReader::fail(const QString &error)
+{
+    m_error = error;
+    return false;
+}
+
+bool QVncFrameReader::readFrame()
+{
+    if (!m_file.isOpen())
+        return false;
+    uchar header[frameHeaderSize];
+    const qint64 got = m_file.read(reinterpret_cast<char *>(header), frameHeaderSize);
+    if (got == 0)
+        return false;
+    if (got != frameHeaderSize)
+        return fail(QStringLiteral("Frame recording is truncated"));
+    const QSize size(qFromLittleEndian<quint16>(header + 8), qFromLittleEndian<quint16>(header + 10));
+    const quint32 rects = qFromLittleEndian<quint32>(header + 12);
+    const qint64 payloadSize = qFromLittleEndian<quint32>(header + 16);
+    const qint64 storedSize = qFromLittleEndian<quint32>(header + 20);
+    const QByteArray stored = m_file.read(storedSize);
+    if (stored.size() != storedSize)
+        return fail(QStringLiteral("Frame recording is truncated"));
+
+    QByteArray payload = stored;
+    if (m_flags & Compressed) {
+        payload = QByteArray(payloadSize, Qt::Uninitialized);
+        QVncInflater inflater;
+        qsizetype written = 0;
+        inflater.setInput(reinterpret_cast<const uchar *>(stored.constData()), stored.size());
+        if (inflater.inflate(reinterpret_cast<uchar *>(payload.data()), payload.size(), &written)
+                    != QVncInflater::StreamEnd
+                || written != payloadSize)
+            return fail(QStringLiteral("Corrupt frame"));
+    }
+
+    if (m_image.size() != size) {
+        m_image = QImage(size, QImage::Format_RGB32);
+        m_image.fill(Qt::black);
+    }
+    const QRect framebuffer(QPoint(), size);
+    const uchar *in = reinterpret_cast<const uchar *>(payload.constData());
+    const uchar *end = in + payload.size();
+    m_region = QRegion();
+    for (quint32 i = 0; i < rects; i++) {
+        if (end - in < rectHeaderSize)
+            return fail(QStringLiteral("Corrupt frame"));
+        const QRect rect(qFromLittleEndian<quint16>(in), qFromLittleEndian<quint16>(in + 2),
+                         qFromLittleEndian<quint16>(in + 4), qFromLittleEndian<quint16>(in + 6));
+        in += rectHeaderSize;
+        if (!framebuffer.contains(rect) || end - in < qint64(rect.width()) * rect.height() * 4)
+            return fail(QStringLiteral("Corrupt frame"));
+        for (int y = rect.top(); y <= rect.bottom(); y++) {
+            qFromLittleEndian<quint32>(in, rect.width(), m_image.scanLine(y) + rect.left() * 4);
+            in += rect.width() * 4;
+        }
+        m_region += rect;
+    }
+    m_time = qint64(qFromLittleEndian<quint64>(header));
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,50 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef QVNCFRAMERECORDER_H
+#define QVNCFRAMERECORDER_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QObject>
+#include <QtCore/QScopedPointer>
+
+QT_BEGIN_NAMESPACE
+
+class QVncClient;
+
+class Q_VNCCLIENT_EXPORT QVncFrameRecorder : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVncClient *client READ client WRITE setClient NOTIFY clientChanged)
+    Q_PROPERTY(qint64 maxQueuedBytes READ maxQueuedBytes WRITE setMaxQueuedBytes NOTIFY maxQueuedBytesChanged)
+public:
+    explicit QVncFrameRecorder(QObject *parent = nullptr);
+    ~QVncFrameRecorder() override;
+
+    QVncClient *client() const;
+    qint64 maxQueuedBytes() const;
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    quint64 framesWritten() const;
+    quint64 framesCoalesced() const;
+    qint64 bytesWritten() const;
+
+public slots:
+    void setClient(QVncClient *client);
+    void setMaxQueuedBytes(qint64 bytes);
+
+signals:
+    void clientChanged(QVncClient *client);
+    void maxQueuedBytesChanged(qint64 bytes);
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCFRAMERECORDER_H
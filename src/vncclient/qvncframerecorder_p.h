@@ -0,0 +1,82 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// The frame recording format of QVncFrameRecorder, and a reader for it.
+//
+// A recording holds the framebuffer as it was after each update, as the
+// rectangles that changed. The file is a 16 byte header followed by the
+// frames, all integers little endian:
+//
+//   header:  "QVNCFRAM", quint32 version (1), quint32 flags
+//   frame:   quint64 nanoseconds since the start, quint16 width,
+//            quint16 height, quint32 rectangle count, quint32 payload size,
+//            quint32 stored size, stored size bytes
+//   payload: per rectangle quint16 x, y, width, height, then its pixels
+//            row by row as quint32 0x00RRGGBB
+//
+// With flag 1 (Compressed), each payload is stored as a finished zlib
+// stream of its own; otherwise as it is. The first frame, and the first
+// after the framebuffer size changes, covers the whole framebuffer. A
+// recording cut short by a crash loses only its last, incomplete frame.
+//
+
+#ifndef QVNCFRAMERECORDER_P_H
+#define QVNCFRAMERECORDER_P_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QFile>
+#include <QtGui/QImage>
+#include <QtGui/QRegion>
+
+QT_BEGIN_NAMESPACE
+
+namespace QVncFrameRecording {
+constexpr char magic[8] = { 'Q', 'V', 'N', 'C', 'F', 'R', 'A', 'M' };
+constexpr quint32 formatVersion = 1;
+constexpr quint32 Compressed = 1;
+constexpr qint64 headerSize = 16;
+constexpr qint64 frameHeaderSize = 24;
+constexpr qint64 rectHeaderSize = 8;
+}
+
+class Q_VNCCLIENT_EXPORT QVncFrameReader
+{
+public:
+    bool open(const QString &fileName);
+    void close();
+    QString errorString() const { return m_error; }
+
+    // Applies the next frame to image(). Returns false at the end of the
+    // recording or on an error, when errorString() is set.
+    bool readFrame();
+
+    qint64 time() const { return m_time; }
+    QRegion region() const { return m_region; }
+    const QImage &image() const { return m_image; }
+
+private:
+    bool fail(const QString &error);
+
+    QFile m_file;
+    quint32 m_flags = 0;
+    qint64 m_time = 0;
+    QRegion m_region;
+    QImage m_image;
+    QString m_error;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCFRAMERECORDER_P_H
@@ -0,0 +1,131 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Completed frames for consumers that must never see a half-decoded one.
+//
+// The client keeps decoding into its own framebuffer, the back buffer.
+// When an update is complete, publish() brings one of the front buffers up
+// to date by copying only what changed since that buffer was last
+// published, and makes it the one frame() hands out. frame() returns a
+// shared QImage, so a consumer holding a frame keeps it intact: the next
+// publish() goes to a buffer nobody holds. With one front buffer there
+// is none while the frame is held, and the held buffer is replaced by a
+// full copy; with two, the other one is usually free.
+//
+// frame() may be called from any thread. The mutex only guards handing out
+// the front buffer; buffers being brought up to date are not the front
+// one, so the decoder never waits for a consumer, and a consumer waits at
+// most for a single buffer switch.
+//
+
+#ifndef QVNCFRONTBUFFERS_P_H
+#define QVNCFRONTBUFFERS_P_H
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtGui/QImage>
+#include <QtGui/QRegion>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+class QVncFrontBuffers
+{
+public:
+    int count() const { return int(m_buffers.size()); }
+
+    // Uses \a count front buffers, 0 to publish nothing. Drops all frames.
+    void setCount(int count)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_buffers = QList<Buffer>(qMax(0, count));
+        m_front = -1;
+    }
+
+    // Drops all frames, for a new connection or framebuffer size
+    void clear()
+    {
+        QMutexLocker locker(&m_mutex);
+        for (Buffer &buffer : m_buffers)
+            buffer = Buffer();
+        m_front = -1;
+    }
+
+    // The latest published frame, or a null image
+    QImage frame() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_front < 0 ? QImage() : m_buffers.at(m_front).image;
+    }
+
+    // Publishes \a back, a complete frame that differs from the previous
+    // one in \a damage. Must not run while \a back is being written.
+    void publish(const QImage &back, const QRegion &damage)
+    {
+        if (m_buffers.isEmpty() || back.isNull())
+            return;
+        for (Buffer &buffer : m_buffers)
+            buffer.stale += damage;
+        for (int i = 0; i < m_buffers.size(); i++) {
+            Buffer &buffer = m_buffers[i];
+            if (i != m_front && (buffer.image.isNull() || buffer.image.isDetached())) {
+                update(buffer, back);
+                QMutexLocker locker(&m_mutex);
+                m_front = i;
+                return;
+            }
+        }
+        // Every other buffer is held, update the one frame() hands out
+        QMutexLocker locker(&m_mutex);
+        update(m_buffers[m_front], back);
+    }
+
+private:
+    struct Buffer {
+        QImage image;
+        QRegion stale; // changed in the back buffer since this was published
+    };
+
+    static void update(Buffer &buffer, const QImage &back)
+    {
+        // A held frame stays as it is; so does one of the wrong size
+        if (!buffer.image.isDetached() || buffer.image.size() != back.size()
+                || buffer.image.format() != back.format()) {
+            buffer.image = back.copy();
+        } else {
+            const int bytesPerPixel = back.depth() / 8;
+            uchar *bits = buffer.image.bits();
+            for (const QRect &stale : buffer.stale) {
+                const QRect rect = stale & back.rect();
+                const qsizetype offset = qsizetype(rect.x()) * bytesPerPixel;
+                const size_t size = size_t(rect.width()) * bytesPerPixel;
+                for (int y = rect.top(); y <= rect.bottom(); y++) {
+                    memcpy(bits + y * buffer.image.bytesPerLine() + offset,
+                           back.constScanLine(y) + offset, size);
+                }
+            }
+        }
+        buffer.stale = QRegion();
+    }
+
+    mutable QMutex m_mutex;
+    QList<Buffer> m_buffers;
+    int m_front = -1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCFRONTBUFFERS_P_H
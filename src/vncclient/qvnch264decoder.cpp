@@ -0,0 +1,319 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvnch264decoder_p.h"
+
+#include <QtCore/QList>
+
+#ifdef USE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+QT_BEGIN_NAMESPACE
+
+#ifdef USE_FFMPEG
+namespace {
+// As many streams as servers use at once; the least recently used goes
+constexpr qsizetype maxContexts = 64;
+
+// QRgb as it is laid out in memory
+constexpr AVPixelFormat rgbFormat = Q_BYTE_ORDER == Q_BIG_ENDIAN ? AV_PIX_FMT_ARGB : AV_PIX_FMT_BGRA;
+
+// The video decoders to try, best first
+constexpr AVHWDeviceType hardwareTypes[] = {
+#if defined(Q_OS_DARWIN)
+    AV_HWDEVICE_TYPE_VIDEOTOOLBOX,
+#elif defined(Q_OS_WIN)
+    AV_HWDEVICE_TYPE_D3D11VA,
+    AV_HWDEVICE_TYPE_DXVA2,
+#else
+    AV_HWDEVICE_TYPE_VAAPI,
+#endif
+};
+
+quint64 contextKey(const QRect &rect)
+{
+    return quint64(quint16(rect.x())) << 48 | quint64(quint16(rect.y())) << 32
+            | quint64(quint16(rect.width())) << 16 | quint64(quint16(rect.height()));
+}
+}
+
+class QVncH264Decoder::Context
+{
+public:
+    ~Context()
+    {
+        sws_freeContext(sws);
+        av_packet_free(&packet);
+        av_frame_free(&transferred);
+        av_frame_free(&frame);
+        avcodec_free_context(&codec);
+    }
+
+    bool open(AVBufferRef *device, AVPixelFormat deviceFormat);
+    bool write(const AVFrame *decoded, QVncPixelWriter &writer, const QRect &rect);
+
+    AVCodecContext *codec = nullptr;
+    AVFrame *frame = nullptr;
+    AVFrame *transferred = nullptr;   // a hardware frame copied to memory
+    AVPacket *packet = nullptr;
+    SwsContext *sws = nullptr;
+    AVPixelFormat hardwareFormat = AV_PIX_FMT_NONE;
+    QList<QRgb> pixels;               // for rectangles partly outside
+};
+
+/*!
+    \internal
+    Picks the format of the video decoder if it can decode the stream, and
+    a software format otherwise, for example for a profile it does not
+    support.
+*/
+static AVPixelFormat selectFormat(AVCodecContext *codec, const AVPixelFormat *formats)
+{
+    const auto *context = static_cast<const QVncH264Decoder::Context *>(codec->opaque);
+    for (const AVPixelFormat *format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+        if (*format == context->hardwareFormat)
+            return *format;
+    }
+    for (const AVPixelFormat *format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+        const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(*format);
+        if (descriptor && !(descriptor->flags & AV_PIX_FMT_FLAG_HWACCEL))
+            return *format;
+    }
+    return AV_PIX_FMT_NONE;
+}
+
+bool QVncH264Decoder::Context::open(AVBufferRef *device, AVPixelFormat deviceFormat)
+{
+    const AVCodec *decoder = avcodec_find_decoder(AV_CODEC_ID_H264);
+    codec = decoder ? avcodec_alloc_context3(decoder) : nullptr;
+    frame = av_frame_alloc();
+    transferred = av_frame_alloc();
+    packet = av_packet_alloc();
+    if (!codec || !frame || !transferred || !packet)
+        return false;
+    // Every frame as soon as it is complete; frame threads would hold
+    // frames back to decode several at once
+    codec->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    codec->thread_type = FF_THREAD_SLICE;
+    if (device) {
+        codec->hw_device_ctx = av_buffer_ref(device);
+        hardwareFormat = deviceFormat;
+        codec->opaque = this;
+        codec->get_format = selectFormat;
+    }
+    return avcodec_open2(codec, decoder, nullptr) >= 0;
+}
+
+/*!
+    \internal
+    Converts \a decoded to QRgb straight into the framebuffer rows, cut to
+    \a rect.
+*/
+bool QVncH264Decoder::Context::write(const AVFrame *decoded, QVncPixelWriter &writer, const QRect &rect)
+{
+    if (decoded->format == hardwareFormat) {
+        av_frame_unref(transferred);
+        if (av_hwframe_transfer_data(transferred, decoded, 0) < 0)
+            return false;
+        decoded = transferred;
+    }
+    const int w = qMin(decoded->width, rect.width());
+    const int h = qMin(decoded->height, rect.height());
+    if (w <= 0 || h <= 0)
+        return true;
+    sws = sws_getCachedContext(sws, w, h, AVPixelFormat(decoded->format), w, h, rgbFormat,
+                               SWS_POINT, nullptr, nullptr, nullptr);
+    if (!sws)
+        return false;
+
+    const bool inside = rect.x() >= 0 && rect.y() >= 0
+            && rect.x() + w <= writer.width() && rect.y() + h <= writer.height();
+    uint8_t *dst[1];
+    int dstStride[1];
+    if (inside) {
+        dst[0] = reinterpret_cast<uint8_t *>(writer.scanLine(rect.y()) + rect.x());
+        dstStride[0] = int(writer.bytesPerLine());
+    } else {
+        // Decode aside and let the writer clip
+        pixels.resize(qsizetype(w) * h);
+        dst[0] = reinterpret_cast<uint8_t *>(pixels.data());
+        dstStride[0] = w * 4;
+    }
+    if (sws_scale(sws, decoded->data, decoded->linesize, 0, h, dst, dstStride) != h)
+        return false;
+    if (!inside)
+        writer.writeRect(rect.x(), rect.y(), w, h, pixels.constData(), w);
+    return true;
+}
+#else
+class QVncH264Decoder::Context
+{
+};
+#endif
+
+struct QVncH264Decoder::Private
+{
+#ifdef USE_FFMPEG
+    ~Private()
+    {
+        contexts.clear();
+        av_buffer_unref(&device);
+    }
+
+    void openDevice();
+
+    struct Entry {
+        quint64 key;
+        std::shared_ptr<Context> context;
+    };
+    QList<Entry> contexts;      // least recently used first
+    AVBufferRef *device = nullptr;
+    AVPixelFormat deviceFormat = AV_PIX_FMT_NONE;
+    const char *backend = nullptr;
+#endif
+};
+
+#ifdef USE_FFMPEG
+/*!
+    \internal
+    Opens the first video decoder of the platform that decodes H.264, once
+    per session. Contexts opened later share it.
+*/
+void QVncH264Decoder::Private::openDevice()
+{
+    if (backend)
+        return;
+    backend = "software";
+    const AVCodec *decoder = avcodec_find_decoder(AV_CODEC_ID_H264);
+    for (const AVHWDeviceType type : hardwareTypes) {
+        AVPixelFormat format = AV_PIX_FMT_NONE;
+        for (int i = 0; const AVCodecHWConfig *config = avcodec_get_hw_config(decoder, i); i++) {
+            if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) && config->device_type == type) {
+                format = config->pix_fmt;
+                break;
+            }
+        }
+        if (format == AV_PIX_FMT_NONE || av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0) < 0)
+            continue;
+        deviceFormat = format;
+        backend = av_hwdevice_get_type_name(type);
+        break;
+    }
+    qCDebug(lcVncClient) << "H.264 decoding:" << backend;
+}
+#endif
+
+QVncH264Decoder::QVncH264Decoder()
+    : d(new Private)
+{
+}
+
+QVncH264Decoder::~QVncH264Decoder() = default;
+
+bool QVncH264Decoder::isAvailable()
+{
+#ifdef USE_FFMPEG
+    static const bool available = avcodec_find_decoder(AV_CODEC_ID_H264) != nullptr;
+    return available;
+#else
+    return false;
+#endif
+}
+
+const char *QVncH264Decoder::backend() const
+{
+#ifdef USE_FFMPEG
+    return d->backend;
+#else
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<QVncH264Decoder::Context> QVncH264Decoder::context(const QRect &rect, quint32 flags)
+{
+#ifdef USE_FFMPEG
+    if (!isAvailable())
+        return {};
+    if (flags & ResetAllContexts)
+        d->contexts.clear();
+    const quint64 key = contextKey(rect);
+    for (qsizetype i = 0; i < d->contexts.size(); i++) {
+        if (d->contexts.at(i).key != key)
+            continue;
+        Private::Entry entry = d->contexts.takeAt(i);
+        if (flags & ResetContext)
+            break;
+        d->contexts.append(entry);
+        return entry.context;
+    }
+
+    d->openDevice();
+    auto context = std::make_shared<Context>();
+    if (!context->open(d->device, d->deviceFormat)) {
+        qCWarning(lcVncClient) << "Failed to open an H.264 decoder";
+        return {};
+    }
+    if (d->contexts.size() >= maxContexts)
+        d->contexts.removeFirst();
+    d->contexts.append({ key, context });
+    return context;
+#else
+    Q_UNUSED(rect);
+    Q_UNUSED(flags);
+    return {};
+#endif
+}
+
+qsizetype QVncH264Decoder::contextCount() const
+{
+#ifdef USE_FFMPEG
+    return d->contexts.size();
+#else
+    return 0;
+#endif
+}
+
+void QVncH264Decoder::reset()
+{
+#ifdef USE_FFMPEG
+    d->contexts.clear();
+#endif
+}
+
+bool QVncH264Decoder::decode(Context &context, const uchar *data, qsizetype size,
+                             QVncPixelWriter &writer, const QRect &rect)
+{
+#ifdef USE_FFMPEG
+    // Not reference counted, so FFmpeg takes a padded copy
+    context.packet->data = const_cast<uint8_t *>(data);
+    context.packet->size = int(size);
+    int result = avcodec_send_packet(context.codec, context.packet);
+    context.packet->data = nullptr;
+    context.packet->size = 0;
+    if (result < 0)
+        return false;
+    // Parameter sets alone give no frame
+    while ((result = avcodec_receive_frame(context.codec, context.frame)) >= 0) {
+        const bool ok = context.write(context.frame, writer, rect);
+        av_frame_unref(context.frame);
+        if (!ok)
+            return false;
+    }
+    return result == AVERROR(EAGAIN) || result == AVERROR_EOF;
+#else
+    Q_UNUSED(context);
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    Q_UNUSED(writer);
+    Q_UNUSED(rect);
+    return false;
+#endif
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,90 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Decoder for Open H.264 rectangles (encoding 50).
+//
+// The server keeps one H.264 stream per rectangle it encodes this way and
+// sends each frame of it as a rectangle at the same position and size. So
+// the decoder keeps one FFmpeg context per rectangle, for the session, and
+// the server resets them with the rectangle flags. Each payload is a whole
+// access unit and is decoded as one packet, without a parser holding it
+// back for the start of the next one. FFmpeg copies the packet, so the
+// payload can come straight from the receive buffer.
+//
+// With FFmpeg built with it, the first context opens the platform's video
+// decoder (VA-API, VideoToolbox, D3D11VA or DXVA2) and all contexts of the
+// session share it; without one, or if it fails to open, decoding is done
+// in software. Either way the frame is converted straight into the
+// framebuffer rows. Contexts are shared pointers, so decode jobs in flight
+// keep theirs while the session resets them; jobs of the same context
+// write the same rectangle, so the decode queue already runs them in
+// order. Without FFmpeg (USE_FFMPEG) nothing is available and the
+// encoding is not announced.
+//
+
+#ifndef QVNCH264DECODER_P_H
+#define QVNCH264DECODER_P_H
+
+#include "qvncpixel_p.h"
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QRect>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class Q_VNCCLIENT_EXPORT QVncH264Decoder
+{
+public:
+    enum Flag : quint32 {
+        ResetContext = 1,       // start the stream of this rectangle over
+        ResetAllContexts = 2,   // start all streams over
+    };
+
+    class Context;
+
+    QVncH264Decoder();
+    ~QVncH264Decoder();
+
+    QVncH264Decoder(const QVncH264Decoder &) = delete;
+    QVncH264Decoder &operator=(const QVncH264Decoder &) = delete;
+
+    // Whether FFmpeg was built in and can decode H.264
+    static bool isAvailable();
+
+    // The hardware device type decoding, "software", or nullptr until the
+    // first context is opened
+    const char *backend() const;
+
+    // Applies \a flags and returns the context of \a rect, opening it on
+    // first use. Returns nullptr if none can be opened.
+    std::shared_ptr<Context> context(const QRect &rect, quint32 flags);
+    qsizetype contextCount() const;
+    void reset();
+
+    // Decodes \a size bytes of \a data in \a context into \a writer at
+    // \a rect. Safe to call from any thread, for one context at a time.
+    static bool decode(Context &context, const uchar *data, qsizetype size,
+                       QVncPixelWriter &writer, const QRect &rect);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCH264DECODER_P_H
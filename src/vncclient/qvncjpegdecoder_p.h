@@ -0,0 +1,139 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// JPEG decoder for Tight rectangles.
+//
+// With libjpeg-turbo (USE_TURBOJPEG) the image is decompressed straight into
+// the framebuffer rows, in the framebuffer's byte order, with no intermediate
+// QImage. Decompressor handles are expensive to create, so they are kept
+// and reused; there is one per thread decoding at the same time. Without
+// libjpeg-turbo the Qt image plugin is used and the result is copied in
+// through the pixel writer.
+//
+
+#ifndef QVNCJPEGDECODER_P_H
+#define QVNCJPEGDECODER_P_H
+
+#include "qvncpixel_p.h"
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtGui/QImage>
+
+#ifdef USE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+class QVncJpegDecoder
+{
+public:
+    QVncJpegDecoder() = default;
+    ~QVncJpegDecoder()
+    {
+#ifdef USE_TURBOJPEG
+        for (tjhandle handle : std::as_const(m_handles))
+            tjDestroy(handle);
+#endif
+    }
+
+    QVncJpegDecoder(const QVncJpegDecoder &) = delete;
+    QVncJpegDecoder &operator=(const QVncJpegDecoder &) = delete;
+
+    // Decodes \a size bytes of JPEG \a data into \a writer at \a x, \a y.
+    // Safe to call from several threads at once.
+    bool decode(const uchar *data, int size, QVncPixelWriter &writer, int x, int y)
+    {
+#ifdef USE_TURBOJPEG
+        tjhandle handle = acquire();
+        if (!handle)
+            return false;
+        const bool ok = decode(handle, data, size, writer, x, y);
+        release(handle);
+        return ok;
+#else
+        QImage jpeg;
+        if (!jpeg.loadFromData(data, size, "JPEG"))
+            return false;
+        if (jpeg.format() != QImage::Format_RGB32)
+            jpeg.convertTo(QImage::Format_RGB32);
+        writer.writeRect(x, y, jpeg.width(), jpeg.height(),
+                         reinterpret_cast<const QRgb *>(jpeg.constBits()), jpeg.bytesPerLine() / 4);
+        return true;
+#endif
+    }
+
+private:
+#ifdef USE_TURBOJPEG
+    // QRgb as it is laid out in memory
+    static constexpr int pixelFormat = Q_BYTE_ORDER == Q_BIG_ENDIAN ? TJPF_XRGB : TJPF_BGRX;
+
+    bool decode(tjhandle handle, const uchar *data, int size, QVncPixelWriter &writer, int x, int y)
+    {
+        int width = 0;
+        int height = 0;
+        int subsampling = 0;
+        int colorspace = 0;
+        if (tjDecompressHeader3(handle, data, size, &width, &height, &subsampling, &colorspace) != 0)
+            return false;
+
+        // The X byte is always 0xff, as QImage::Format_RGB32 expects
+        if (x >= 0 && y >= 0 && x + width <= writer.width() && y + height <= writer.height()) {
+            uchar *dst = reinterpret_cast<uchar *>(writer.scanLine(y) + x);
+            return tjDecompress2(handle, data, size, dst, width, int(writer.bytesPerLine()), height,
+                                 pixelFormat, TJFLAG_FASTDCT) == 0;
+        }
+
+        // Partly outside the framebuffer: decode aside and let the writer clip
+        QList<QRgb> pixels(qsizetype(width) * height);
+        if (tjDecompress2(handle, data, size, reinterpret_cast<uchar *>(pixels.data()), width,
+                          width * 4, height, pixelFormat, TJFLAG_FASTDCT) != 0) {
+            return false;
+        }
+        writer.writeRect(x, y, width, height, pixels.constData(), width);
+        return true;
+    }
+
+    tjhandle acquire()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_idle.isEmpty())
+                return m_idle.takeLast();
+        }
+        tjhandle handle = tjInitDecompress();
+        if (handle) {
+            QMutexLocker locker(&m_mutex);
+            m_handles.append(handle);
+        }
+        return handle;
+    }
+
+    void release(tjhandle handle)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_idle.append(handle);
+    }
+
+    QMutex m_mutex;
+    QList<tjhandle> m_handles;
+    QList<tjhandle> m_idle;
+#endif
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCJPEGDECODER_P_H
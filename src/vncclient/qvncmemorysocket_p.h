@@ -0,0 +1,99 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// A QTcpSocket without a network behind it.
+//
+// The client only talks to its socket through QIODevice reads and writes,
+// state() and readyRead(), so this is enough to run it against a byte
+// stream held in memory: feed() appends server data and emits readyRead(),
+// and everything the client sends is collected. Used to benchmark and test
+// the protocol parser without a server.
+//
+
+#ifndef QVNCMEMORYSOCKET_P_H
+#define QVNCMEMORYSOCKET_P_H
+
+#include <QtCore/QByteArray>
+#include <QtNetwork/QTcpSocket>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+class QVncMemorySocket : public QTcpSocket
+{
+public:
+    explicit QVncMemorySocket(QObject *parent = nullptr)
+        : QTcpSocket(parent)
+    {
+        setOpenMode(QIODevice::ReadWrite | QIODevice::Unbuffered);
+        setSocketState(QAbstractSocket::ConnectedState);
+    }
+
+    ~QVncMemorySocket() override
+    {
+        // There is no socket engine for QAbstractSocket to abort
+        setSocketState(QAbstractSocket::UnconnectedState);
+        setOpenMode(QIODevice::NotOpen);
+    }
+
+    // Appends \a data to what the client can read and emits readyRead().
+    void feed(const QByteArray &data)
+    {
+        if (m_pos == m_incoming.size()) {
+            m_incoming = data; // shared, no copy
+            m_pos = 0;
+        } else {
+            m_incoming.append(data);
+        }
+        emit readyRead();
+    }
+
+    // Everything the client wrote so far.
+    QByteArray written() const { return m_written; }
+    void clearWritten() { m_written.clear(); }
+    // How many write() calls reached the socket
+    int writeCount() const { return m_writeCount; }
+    void setKeepWritten(bool keep) { m_keepWritten = keep; }
+
+    qint64 bytesAvailable() const override { return m_incoming.size() - m_pos; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const qint64 size = qMin(maxSize, bytesAvailable());
+        memcpy(data, m_incoming.constData() + m_pos, size);
+        m_pos += size;
+        return size;
+    }
+
+    qint64 writeData(const char *data, qint64 size) override
+    {
+        ++m_writeCount;
+        if (m_keepWritten)
+            m_written.append(data, size);
+        return size;
+    }
+
+private:
+    QByteArray m_incoming;
+    qsizetype m_pos = 0;
+    QByteArray m_written;
+    bool m_keepWritten = true;
+    int m_writeCount = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCMEMORYSOCKET_P_H
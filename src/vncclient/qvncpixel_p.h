@@ -0,0 +1,171 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Scanline kernels used by the framebuffer decoders.
+//
+// The decoders used to write every pixel through QImage::setPixel(), which
+// re-validates the coordinates and the format and may detach the image on
+// each call. QVncPixelWriter resolves the pixel pointer once and then works
+// on whole rows: decoders either fill a row in place or fill spans of one
+// colour. Rectangles sent by the server are clipped against the target here,
+// so the decoders never have to.
+//
+
+#ifndef QVNCPIXEL_P_H
+#define QVNCPIXEL_P_H
+
+#include <QtCore/QVarLengthArray>
+#include <QtGui/QImage>
+#include <algorithm>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+class QVncPixelWriter
+{
+public:
+    QVncPixelWriter() = default;
+
+    // Wraps raw 32-bit pixel memory with the given stride in bytes.
+    QVncPixelWriter(uchar *bits, qsizetype bytesPerLine, int width, int height)
+        : m_bits(bits), m_bytesPerLine(bytesPerLine), m_width(width), m_height(height)
+    {}
+
+    // Writes into a 32-bit QImage. bits() is called once here, so an image
+    // shared with a consumer is detached at most once per writer.
+    explicit QVncPixelWriter(QImage &image)
+        : QVncPixelWriter(image.depth() == 32 ? image.bits() : nullptr, image.bytesPerLine(),
+                          image.width(), image.height())
+    {}
+
+    bool isNull() const { return !m_bits; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    qsizetype bytesPerLine() const { return m_bytesPerLine; }
+
+    QRgb *scanLine(int y) const
+    {
+        return reinterpret_cast<QRgb *>(m_bits + y * m_bytesPerLine);
+    }
+
+    // Returns storage for \a w pixels of row \a y starting at \a x. When the
+    // row lies entirely inside the target this is the framebuffer itself;
+    // otherwise it is a scratch row whose visible part is copied by endRow().
+    // Every beginRow() must be paired with an endRow().
+    QRgb *beginRow(int x, int y, int w)
+    {
+        if (m_bits && y >= 0 && y < m_height && x >= 0 && w <= m_width - x) {
+            m_pendingW = 0;
+            return scanLine(y) + x;
+        }
+        m_scratch.resize(qMax(w, 1));
+        m_pendingX = x;
+        m_pendingY = y;
+        m_pendingW = w;
+        return m_scratch.data();
+    }
+
+    void endRow()
+    {
+        if (m_pendingW <= 0)
+            return;
+        const int w = m_pendingW;
+        m_pendingW = 0;
+        if (!m_bits || m_pendingY < 0 || m_pendingY >= m_height)
+            return;
+        const int x0 = qMax(m_pendingX, 0);
+        const int x1 = qMin(m_pendingX + w, m_width);
+        if (x1 > x0)
+            memcpy(scanLine(m_pendingY) + x0, m_scratch.constData() + (x0 - m_pendingX),
+                   (x1 - x0) * sizeof(QRgb));
+    }
+
+    // Fills a clipped rectangle with a single colour.
+    void fillRect(int x, int y, int w, int h, QRgb color)
+    {
+        if (!clip(&x, &y, &w, &h))
+            return;
+        for (int row = 0; row < h; ++row)
+            std::fill_n(scanLine(y + row) + x, w, color);
+    }
+
+    // Copies a 32-bit pixel block with stride \a srcStride (in pixels).
+    void writeRect(int x, int y, int w, int h, const QRgb *src, qsizetype srcStride)
+    {
+        int cx = x, cy = y;
+        if (!clip(&cx, &cy, &w, &h))
+            return;
+        src += (cy - y) * srcStride + (cx - x);
+        for (int row = 0; row < h; ++row)
+            memcpy(scanLine(cy + row) + cx, src + row * srcStride, w * sizeof(QRgb));
+    }
+
+    // Copies a rectangle within the target, as CopyRect does. Source and
+    // destination may overlap; both are clipped against the target.
+    void copyRect(int srcX, int srcY, int x, int y, int w, int h)
+    {
+        const int dx = x - srcX;
+        const int dy = y - srcY;
+        // Clip the source first, then the destination it maps to
+        if (!clip(&srcX, &srcY, &w, &h))
+            return;
+        x = srcX + dx;
+        y = srcY + dy;
+        int cx = x, cy = y;
+        if (!clip(&cx, &cy, &w, &h))
+            return;
+        srcX += cx - x;
+        srcY += cy - y;
+
+        // Walk rows away from the overlap; memmove handles it horizontally
+        const bool bottomUp = cy > srcY;
+        for (int i = 0; i < h; ++i) {
+            const int row = bottomUp ? h - 1 - i : i;
+            memmove(scanLine(cy + row) + cx, scanLine(srcY + row) + srcX, w * sizeof(QRgb));
+        }
+    }
+
+private:
+    bool clip(int *x, int *y, int *w, int *h) const
+    {
+        if (!m_bits)
+            return false;
+        const int x0 = qMax(*x, 0);
+        const int y0 = qMax(*y, 0);
+        const int x1 = qMin(*x + *w, m_width);
+        const int y1 = qMin(*y + *h, m_height);
+        if (x1 <= x0 || y1 <= y0)
+            return false;
+        *x = x0;
+        *y = y0;
+        *w = x1 - x0;
+        *h = y1 - y0;
+        return true;
+    }
+
+    uchar *m_bits = nullptr;
+    qsizetype m_bytesPerLine = 0;
+    int m_width = 0;
+    int m_height = 0;
+
+    int m_pendingX = 0;
+    int m_pendingY = 0;
+    int m_pendingW = 0;
+    QVarLengthArray<QRgb, 256> m_scratch;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCPIXEL_P_H
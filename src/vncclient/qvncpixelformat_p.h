@@ -0,0 +1,385 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Pixel format conversion for the framebuffer decoders.
+//
+// A QVncPixelConverter is built once whenever the pixel format is
+// negotiated. It selects a row kernel for the wire layout up front so the
+// decoders never branch on the byte order, the pixel size or the channel
+// layout per pixel. Byte-aligned 24/32-bit layouts are byte shuffles (with
+// NEON paths for whole rows, and SSSE3 ones picked when the CPU has it),
+// RGB565 has its own kernel, and everything else goes through per-channel
+// lookup tables.
+//
+
+#ifndef QVNCPIXELFORMAT_P_H
+#define QVNCPIXELFORMAT_P_H
+
+#include <QtCore/QtEndian>
+#include <QtCore/private/qsimd_p.h>
+#include <QtGui/QImage>
+#include <cstring>
+
+#if defined(QT_COMPILER_SUPPORTS_SSSE3)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+/*
+    PIXEL_FORMAT as sent in ServerInit and SetPixelFormat (RFC 6143, 7.4).
+    The layout matches the wire format so it can be read and written as is.
+*/
+struct QVncPixelFormat
+{
+    quint8 bitsPerPixel = 0;     ///< Bits per pixel (typically 8, 16, or 32)
+    quint8 depth = 0;            ///< Color depth
+    quint8 bigEndianFlag = 0;    ///< 1 if big-endian, 0 if little-endian
+    quint8 trueColourFlag = 0;   ///< 1 if true color, 0 if color map
+    quint16_be redMax;           ///< Maximum value for red channel
+    quint16_be greenMax;         ///< Maximum value for green channel
+    quint16_be blueMax;          ///< Maximum value for blue channel
+    quint8 redShift = 0;         ///< Bit shift for red channel
+    quint8 greenShift = 0;       ///< Bit shift for green channel
+    quint8 blueShift = 0;        ///< Bit shift for blue channel
+    quint8 padding1 = 0;         ///< Padding (unused)
+    quint8 padding2 = 0;         ///< Padding (unused)
+    quint8 padding3 = 0;         ///< Padding (unused)
+
+    // Size of a ZRLE CPIXEL: 3 bytes when a 32-bit true colour pixel
+    // carries no more than 8 bits per channel.
+    int cpixelSize() const
+    {
+        return (bitsPerPixel == 32 && trueColourFlag
+                && redMax <= 255 && greenMax <= 255 && blueMax <= 255) ? 3 : bitsPerPixel / 8;
+    }
+
+    // Size of a Tight TPIXEL: 3 bytes for 32-bit true colour with 8-bit channels.
+    int tpixelSize() const
+    {
+        return (bitsPerPixel == 32 && trueColourFlag
+                && redMax == 255 && greenMax == 255 && blueMax == 255) ? 3 : bitsPerPixel / 8;
+    }
+
+    static QVncPixelFormat trueColour(int bitsPerPixel, int depth, bool bigEndian,
+                                      int redMax, int greenMax, int blueMax,
+                                      int redShift, int greenShift, int blueShift)
+    {
+        QVncPixelFormat format;
+        format.bitsPerPixel = bitsPerPixel;
+        format.depth = depth;
+        format.bigEndianFlag = bigEndian ? 1 : 0;
+        format.trueColourFlag = 1;
+        format.redMax = redMax;
+        format.greenMax = greenMax;
+        format.blueMax = blueMax;
+        format.redShift = redShift;
+        format.greenShift = greenShift;
+        format.blueShift = blueShift;
+        return format;
+    }
+
+    // 0xffRRGGBB in host byte order: the memory layout of QImage::Format_RGB32.
+    static QVncPixelFormat native()
+    {
+        return trueColour(32, 24, Q_BYTE_ORDER == Q_BIG_ENDIAN,
+                          255, 255, 255, 16, 8, 0);
+    }
+
+    static QVncPixelFormat rgb565()
+    {
+        return trueColour(16, 16, false, 31, 63, 31, 11, 5, 0);
+    }
+
+    static QVncPixelFormat bgr233()
+    {
+        return trueColour(8, 8, false, 7, 7, 3, 0, 3, 6);
+    }
+
+    friend bool operator==(const QVncPixelFormat &a, const QVncPixelFormat &b)
+    {
+        return memcmp(&a, &b, sizeof(QVncPixelFormat)) == 0;
+    }
+    friend bool operator!=(const QVncPixelFormat &a, const QVncPixelFormat &b)
+    {
+        return !(a == b);
+    }
+};
+static_assert(sizeof(QVncPixelFormat) == 16, "QVncPixelFormat must match the wire layout");
+
+namespace QVncPixelKernels {
+
+template <int Bytes, bool BigEndian>
+static inline quint32 load(const uchar *p)
+{
+    if constexpr (Bytes == 4)
+        return BigEndian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+    else if constexpr (Bytes == 3)
+        return BigEndian ? (quint32(p[0]) << 16 | quint32(p[1]) << 8 | p[2])
+                         : (p[0] | quint32(p[1]) << 8 | quint32(p[2]) << 16);
+    else if constexpr (Bytes == 2)
+        return BigEndian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+    else
+        return p[0];
+}
+
+} // namespace QVncPixelKernels
+
+class QVncPixelConverter
+{
+public:
+    // Little-endian 32-bit 0x00RRGGBB, the common server default
+    QVncPixelConverter() { useBytes<4, 2, 1, 0>(); }
+
+    // Builds a converter for pixels of \a bytesPerPixel bytes in \a format.
+    // bytesPerPixel differs from bitsPerPixel / 8 for CPIXEL and TPIXEL.
+    QVncPixelConverter(const QVncPixelFormat &format, int bytesPerPixel)
+        : m_bytes(bytesPerPixel)
+        , m_bigEndian(format.bigEndianFlag)
+    {
+        m_shift[0] = format.redShift;
+        m_shift[1] = format.greenShift;
+        m_shift[2] = format.blueShift;
+        m_max[0] = format.redMax;
+        m_max[1] = format.greenMax;
+        m_max[2] = format.blueMax;
+        m_lut = m_max[0] <= 255 && m_max[1] <= 255 && m_max[2] <= 255;
+        for (int c = 0; c < 3; c++) {
+            if (m_max[c] == 0)
+                m_max[c] = 1;
+            if (m_lut) {
+                for (int v = 0; v <= m_max[c]; v++)
+                    m_table[c][v] = scale(v, m_max[c]) << (16 - 8 * c);
+            }
+        }
+        selectKernel();
+    }
+
+    int bytesPerPixel() const { return m_bytes; }
+
+    // Raw pixel value in host byte order.
+    quint32 value(const uchar *src) const
+    {
+        using namespace QVncPixelKernels;
+        switch (m_bytes) {
+        case 4: return m_bigEndian ? load<4, true>(src) : load<4, false>(src);
+        case 3: return m_bigEndian ? load<3, true>(src) : load<3, false>(src);
+        case 2: return m_bigEndian ? load<2, true>(src) : load<2, false>(src);
+        case 1: return src[0];
+        default: return 0;
+        }
+    }
+
+    QRgb toRgb(quint32 value) const
+    {
+        if (m_lut) {
+            return 0xff000000u
+                | m_table[0][(value >> m_shift[0]) & m_max[0]]
+                | m_table[1][(value >> m_shift[1]) & m_max[1]]
+                | m_table[2][(value >> m_shift[2]) & m_max[2]];
+        }
+        return qRgb(scale((value >> m_shift[0]) & m_max[0], m_max[0]),
+                    scale((value >> m_shift[1]) & m_max[1], m_max[1]),
+                    scale((value >> m_shift[2]) & m_max[2], m_max[2]));
+    }
+
+    QRgb pixel(const uchar *src) const { return m_pixel(*this, src); }
+
+    // Converts \a count pixels starting at \a src into \a dst.
+    void convertRow(const uchar *src, QRgb *dst, int count) const { m_row(*this, src, dst, count); }
+
+private:
+    // Expands a channel value in 0..max to 0..255, rounding to nearest.
+    static quint32 scale(quint32 v, quint32 max) { return (v * 255 + max / 2) / max; }
+
+    using PixelFunc = QRgb (*)(const QVncPixelConverter &, const uchar *);
+    using RowFunc = void (*)(const QVncPixelConverter &, const uchar *, QRgb *, int);
+
+    template <int Bytes, bool BigEndian>
+    static QRgb pixelGeneric(const QVncPixelConverter &c, const uchar *src)
+    {
+        return c.toRgb(QVncPixelKernels::load<Bytes, BigEndian>(src));
+    }
+
+    template <int Bytes, bool BigEndian>
+    static void rowGeneric(const QVncPixelConverter &c, const uchar *src, QRgb *dst, int count)
+    {
+        for (int i = 0; i < count; i++, src += Bytes)
+            dst[i] = c.toRgb(QVncPixelKernels::load<Bytes, BigEndian>(src));
+    }
+
+    // Byte-aligned 8-bit channels: red, green and blue sit at fixed byte
+    // offsets, so conversion is a gather of three bytes.
+    template <int Bytes, int R, int G, int B>
+    static QRgb pixelBytes(const QVncPixelConverter &, const uchar *src)
+    {
+        return 0xff000000u | quint32(src[R]) << 16 | quint32(src[G]) << 8 | src[B];
+    }
+
+    template <int Bytes, int R, int G, int B>
+    static void rowBytes(const QVncPixelConverter &c, const uchar *src, QRgb *dst, int count)
+    {
+        int i = 0;
+#if defined(__ARM_NEON) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        Q_UNUSED(c);
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x4_t out;
+            if constexpr (Bytes == 4) {
+                const uint8x16x4_t in = vld4q_u8(src + i * 4);
+                out.val[0] = in.val[B];
+                out.val[1] = in.val[G];
+                out.val[2] = in.val[R];
+            } else {
+                const uint8x16x3_t in = vld3q_u8(src + i * 3);
+                out.val[0] = in.val[B];
+                out.val[1] = in.val[G];
+                out.val[2] = in.val[R];
+            }
+            out.val[3] = vdupq_n_u8(0xff);
+            vst4q_u8(reinterpret_cast<uint8_t *>(dst + i), out);
+        }
+#else
+        Q_UNUSED(c);
+#endif
+        for (; i < count; i++)
+            dst[i] = pixelBytes<Bytes, R, G, B>(c, src + i * Bytes);
+    }
+
+#if defined(QT_COMPILER_SUPPORTS_SSSE3)
+    // Built for SSSE3 whatever the baseline; useBytes() only picks it on
+    // CPUs that have it.
+    template <int Bytes, int R, int G, int B>
+    QT_FUNCTION_TARGET(SSSE3)
+    static void rowBytesSsse3(const QVncPixelConverter &c, const uchar *src, QRgb *dst, int count)
+    {
+        int i = 0;
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.m_shuffle));
+        const __m128i alpha = _mm_set1_epi32(int(0xff000000u));
+        // Each iteration loads 16 bytes; for 3-byte pixels only 12 are used,
+        // so stop early enough never to read past the end of the row.
+        const int stop = Bytes == 4 ? count - 3 : count - 5;
+        for (; i < stop; i += 4) {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * Bytes));
+            const __m128i out = _mm_or_si128(_mm_shuffle_epi8(in, mask), alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), out);
+        }
+        for (; i < count; i++)
+            dst[i] = pixelBytes<Bytes, R, G, B>(c, src + i * Bytes);
+    }
+#endif
+
+    template <bool BigEndian>
+    static QRgb pixelRgb565(const QVncPixelConverter &c, const uchar *src)
+    {
+        const quint32 v = QVncPixelKernels::load<2, BigEndian>(src);
+        return 0xff000000u | c.m_table[0][v >> 11] | c.m_table[1][(v >> 5) & 0x3f] | c.m_table[2][v & 0x1f];
+    }
+
+    template <bool BigEndian>
+    static void rowRgb565(const QVncPixelConverter &c, const uchar *src, QRgb *dst, int count)
+    {
+        for (int i = 0; i < count; i++, src += 2)
+            dst[i] = pixelRgb565<BigEndian>(c, src);
+    }
+
+    template <int Bytes, int R, int G, int B>
+    void useBytes()
+    {
+        m_pixel = &pixelBytes<Bytes, R, G, B>;
+        m_row = &rowBytes<Bytes, R, G, B>;
+#if defined(QT_COMPILER_SUPPORTS_SSSE3)
+        if (qCpuHasFeature(SSSE3))
+            m_row = &rowBytesSsse3<Bytes, R, G, B>;
+#endif
+        // pshufb mask: output bytes B, G, R, (zero) for four pixels
+        for (int p = 0; p < 4; p++) {
+            m_shuffle[p * 4 + 0] = quint8(p * Bytes + B);
+            m_shuffle[p * 4 + 1] = quint8(p * Bytes + G);
+            m_shuffle[p * 4 + 2] = quint8(p * Bytes + R);
+            m_shuffle[p * 4 + 3] = 0x80;
+        }
+    }
+
+    template <int Bytes, bool BigEndian>
+    void useGeneric()
+    {
+        m_pixel = &pixelGeneric<Bytes, BigEndian>;
+        m_row = &rowGeneric<Bytes, BigEndian>;
+    }
+
+    // Byte offset of an 8-bit channel within a pixel, or -1 if unaligned.
+    int byteOffset(int channel) const
+    {
+        if (m_max[channel] != 255 || m_shift[channel] % 8 || m_shift[channel] / 8 >= m_bytes)
+            return -1;
+        return m_bigEndian ? m_bytes - 1 - m_shift[channel] / 8 : m_shift[channel] / 8;
+    }
+
+    void selectKernel()
+    {
+        const int r = byteOffset(0);
+        const int g = byteOffset(1);
+        const int b = byteOffset(2);
+        const int layout = (r >= 0 && g >= 0 && b >= 0) ? r * 100 + g * 10 + b : -1;
+        if (m_bytes == 4) {
+            switch (layout) {
+            case 210: useBytes<4, 2, 1, 0>(); return; // BGRX (little-endian 0x00RRGGBB)
+            case 12:  useBytes<4, 0, 1, 2>(); return; // RGBX
+            case 321: useBytes<4, 3, 2, 1>(); return; // XBGR (big-endian 0xRRGGBB00)
+            case 123: useBytes<4, 1, 2, 3>(); return; // XRGB (big-endian 0x00RRGGBB)
+            default: break;
+            }
+        } else if (m_bytes == 3) {
+            switch (layout) {
+            case 210: useBytes<3, 2, 1, 0>(); return; // BGR
+            case 12:  useBytes<3, 0, 1, 2>(); return; // RGB
+            default: break;
+            }
+        } else if (m_bytes == 2 && m_shift[0] == 11 && m_shift[1] == 5 && m_shift[2] == 0
+                   && m_max[0] == 31 && m_max[1] == 63 && m_max[2] == 31) {
+            if (m_bigEndian) {
+                m_pixel = &pixelRgb565<true>;
+                m_row = &rowRgb565<true>;
+            } else {
+                m_pixel = &pixelRgb565<false>;
+                m_row = &rowRgb565<false>;
+            }
+            return;
+        }
+
+        switch (m_bytes) {
+        case 4: m_bigEndian ? useGeneric<4, true>() : useGeneric<4, false>(); break;
+        case 3: m_bigEndian ? useGeneric<3, true>() : useGeneric<3, false>(); break;
+        case 2: m_bigEndian ? useGeneric<2, true>() : useGeneric<2, false>(); break;
+        default: useGeneric<1, false>(); m_bytes = 1; break;
+        }
+    }
+
+    int m_bytes = 4;
+    bool m_bigEndian = false;
+    bool m_lut = false;
+    quint8 m_shift[3] = { 16, 8, 0 };
+    quint32 m_max[3] = { 255, 255, 255 };
+    quint32 m_table[3][256] = {};
+    quint8 m_shuffle[16] = {};
+    PixelFunc m_pixel = nullptr;
+    RowFunc m_row = nullptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCPIXELFORMAT_P_H
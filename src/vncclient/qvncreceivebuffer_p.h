@@ -0,0 +1,121 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Receive buffer for the protocol parser.
+//
+// Everything the socket has is moved into one contiguous buffer once per
+// readyRead. Parsers look at data() to decide whether a message is complete
+// and decode straight from it, then skip() what they consumed; a message
+// that is not complete yet simply stays in the buffer until more arrives.
+// Pointers into the buffer stay valid until the next fill().
+//
+
+#ifndef QVNCRECEIVEBUFFER_P_H
+#define QVNCRECEIVEBUFFER_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+class QVncReceiveBuffer
+{
+public:
+    // Appends everything \a device has buffered. Returns the number of bytes added.
+    qint64 fill(QIODevice *device)
+    {
+        if (!device)
+            return 0;
+        const qint64 available = device->bytesAvailable();
+        if (available <= 0)
+            return 0;
+        compact();
+        const qsizetype used = m_data.size();
+        const qsizetype needed = used + available;
+        // Grow geometrically: large rectangles arrive in many small chunks
+        if (m_data.capacity() < needed)
+            m_data.reserve(qMax(needed, 2 * m_data.capacity()));
+        m_data.resize(needed);
+        const qint64 got = device->read(m_data.data() + used, available);
+        m_data.resize(used + qMax<qint64>(got, 0));
+        return qMax<qint64>(got, 0);
+    }
+
+    qint64 bytesAvailable() const { return m_data.size() - m_pos; }
+    bool isEmpty() const { return bytesAvailable() == 0; }
+
+    // Unconsumed data; at least bytesAvailable() bytes are readable.
+    const uchar *data() const
+    {
+        return reinterpret_cast<const uchar *>(m_data.constData()) + m_pos;
+    }
+
+    // Consumes \a size bytes. The memory is only reused by the next fill().
+    void skip(qint64 size)
+    {
+        m_pos += qBound<qint64>(0, size, bytesAvailable());
+    }
+
+    // Copies up to \a size bytes into \a out and consumes them.
+    qint64 read(char *out, qint64 size)
+    {
+        size = qMin(size, bytesAvailable());
+        if (size > 0)
+            memcpy(out, data(), size);
+        skip(size);
+        return size;
+    }
+
+    QByteArray read(qint64 size)
+    {
+        QByteArray result = peek(size);
+        skip(result.size());
+        return result;
+    }
+
+    QByteArray readAll() { return read(bytesAvailable()); }
+
+    QByteArray peek(qint64 size) const
+    {
+        return QByteArray(reinterpret_cast<const char *>(data()), qBound<qint64>(0, size, bytesAvailable()));
+    }
+
+    void clear()
+    {
+        m_data.resize(0);
+        m_pos = 0;
+    }
+
+private:
+    // Drops consumed bytes once they outweigh the rest, so the memmove is
+    // paid for by data that has already been parsed.
+    void compact()
+    {
+        if (m_pos == 0 || m_pos < bytesAvailable())
+            return;
+        const qint64 remaining = bytesAvailable();
+        memmove(m_data.data(), m_data.constData() + m_pos, remaining);
+        m_data.resize(remaining);
+        m_pos = 0;
+    }
+
+    QByteArray m_data;
+    qsizetype m_pos = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCRECEIVEBUFFER_P_H
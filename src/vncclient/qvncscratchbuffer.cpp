@@ -0,0 +1,11 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncscratchbuffer_p.h"
+
+QT_BEGIN_NAMESPACE
+
+// One counter for the whole library, also visible to tests linking it
+QAtomicInteger<quint64> QVncScratchBuffer::s_allocations;
+
+QT_END_NAMESPACE
@@ -0,0 +1,85 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Reusable output buffer for the inflate paths.
+//
+// Each zlib stream inflates into its own QVncScratchBuffer, which keeps its
+// memory across rectangles and updates. resize() only allocates when the
+// buffer has to grow, or when the previous contents are still referenced:
+// a decode job that captured them keeps them alive, and the buffer moves on
+// to new memory instead of overwriting them. In steady state, decoding in
+// the client's thread therefore allocates nothing. allocations() counts the
+// allocations process-wide so that tests can check this.
+//
+
+#ifndef QVNCSCRATCHBUFFER_P_H
+#define QVNCSCRATCHBUFFER_P_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QByteArray>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+class Q_VNCCLIENT_EXPORT QVncScratchBuffer
+{
+public:
+    // Makes the buffer \a size bytes long. The contents are undefined.
+    QByteArray &resize(qsizetype size)
+    {
+        if (!m_data.isDetached() || m_data.capacity() < size) {
+            s_allocations.fetchAndAddRelaxed(1);
+            // Grow geometrically so that a slowly growing peak settles quickly
+            const qsizetype capacity = m_data.isDetached() ? 2 * m_data.capacity() : m_data.capacity();
+            m_data = QByteArray(qMax(size, capacity), Qt::Uninitialized);
+        }
+        m_data.resize(size);
+        return m_data;
+    }
+
+    // Makes the buffer \a size bytes long, keeping the first \a keep bytes.
+    QByteArray &grow(qsizetype size, qsizetype keep)
+    {
+        if (m_data.isDetached() && m_data.capacity() >= size) {
+            m_data.resize(size);
+            return m_data;
+        }
+        const QByteArray previous = m_data;
+        resize(size);
+        memcpy(m_data.data(), previous.constData(), qMin(keep, previous.size()));
+        return m_data;
+    }
+
+    QByteArray &data() { return m_data; }
+
+    // Drops the memory if it is larger than \a maxKept bytes, for buffers that
+    // had to hold a rare spike.
+    void trim(qsizetype maxKept)
+    {
+        if (m_data.capacity() > maxKept)
+            m_data = QByteArray();
+    }
+
+    static quint64 allocations() { return s_allocations.loadRelaxed(); }
+
+private:
+    QByteArray m_data;
+    static QAtomicInteger<quint64> s_allocations;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCSCRATCHBUFFER_P_H
@@ -0,0 +1,74 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Send buffer for messages to the server.
+//
+// Messages are built field by field, which used to mean one socket write
+// per byte of padding. The fields are appended here instead and written
+// to the socket in one go once the message is complete. Between
+// beginBatch() and the matching endBatch() nothing is written, so the
+// replies to everything handled in one read pass, or a pointer event
+// followed by a key event, leave in a single write as well. Batches nest;
+// only the outermost one ends the batch.
+//
+
+#ifndef QVNCSENDBUFFER_P_H
+#define QVNCSENDBUFFER_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+
+QT_BEGIN_NAMESPACE
+
+class QVncSendBuffer
+{
+public:
+    qsizetype size() const { return m_data.size(); }
+    bool isEmpty() const { return m_data.isEmpty(); }
+    const QByteArray &data() const { return m_data; }
+
+    void append(const void *data, qsizetype size)
+    {
+        m_data.append(static_cast<const char *>(data), size);
+    }
+    void append(const QByteArray &data) { m_data.append(data); }
+
+    bool isBatching() const { return m_batchDepth > 0; }
+    void beginBatch() { ++m_batchDepth; }
+    // Returns true when the outermost batch ended and the buffer is due
+    bool endBatch() { return m_batchDepth > 0 && --m_batchDepth == 0; }
+
+    // Writes everything to \a device in one write() and empties the buffer.
+    // Without a device the data is dropped. Returns the number of bytes written.
+    qint64 flush(QIODevice *device)
+    {
+        if (m_data.isEmpty())
+            return 0;
+        const qint64 written = device ? device->write(m_data) : 0;
+        // Keep the capacity, the next message is about as large
+        m_data.resize(0);
+        return qMax<qint64>(written, 0);
+    }
+
+    void clear() { m_data.resize(0); }
+
+private:
+    QByteArray m_data;
+    int m_batchDepth = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCSENDBUFFER_P_H
@@ -0,0 +1,201 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncsessionrecording_p.h"
+#include "qvncmemorysocket_p.h"
+#include "qvncclient.h"
+
+#include <QtCore/QtEndian>
+#include <cstring>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+constexpr char magic[8] = { 'Q', 'V', 'N', 'C', 'S', 'E', 'S', 'S' };
+constexpr quint32 formatVersion = 1;
+constexpr qint64 headerSize = 16;
+constexpr qint64 chunkHeaderSize = 12;
+}
+
+bool QVncSessionRecorder::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    uchar header[headerSize];
+    memcpy(header, magic, sizeof(magic));
+    qToLittleEndian<quint32>(formatVersion, header + 8);
+    qToLittleEndian<quint32>(0, header + 12);
+    if (m_file.write(reinterpret_cast<const char *>(header), headerSize) != headerSize) {
+        m_file.close();
+        return false;
+    }
+    m_clock.start();
+    return true;
+}
+
+void QVncSessionRecorder::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+void QVncSessionRecorder::write(const uchar *data, qint64 size)
+{
+    if (!m_file.isOpen())
+        return;
+    // Chunks come from one socket read each, far below the 32-bit limit,
+    // but split anyway rather than write a size that does not fit
+    while (size > 0) {
+        const qint64 part = qMin<qint64>(size, std::numeric_limits<qint32>::max());
+        uchar header[chunkHeaderSize];
+        qToLittleEndian<quint64>(m_clock.nsecsElapsed(), header);
+        qToLittleEndian<quint32>(quint32(part), header + 8);
+        if (m_file.write(reinterpret_cast<const char *>(header), chunkHeaderSize) != chunkHeaderSize
+                || m_file.write(reinterpret_cast<const char *>(data), part) != part) {
+            qCWarning(lcVncClient) << "Failed to write session recording:" << m_file.errorString();
+            m_file.close();
+            return;
+        }
+        data += part;
+        size -= part;
+    }
+}
+
+QVncSessionPlayer::QVncSessionPlayer()
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&m_timer, &QTimer::timeout, [this]() {
+        // Everything that is due by now, so a late timer catches up
+        const qint64 now = m_clock.nsecsElapsed() + m_chunks.first().time;
+        while (m_next < m_chunks.size() && m_chunks.at(m_next).time <= now)
+            feed(m_chunks.at(m_next++));
+        scheduleNext();
+    });
+}
+
+QVncSessionPlayer::~QVncSessionPlayer()
+{
+    close();
+}
+
+bool QVncSessionPlayer::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    const qint64 size = m_file.size();
+    if (size > 0)
+        m_map = m_file.map(0, size);
+    if (!m_map || size < headerSize || memcmp(m_map, magic, sizeof(magic)) != 0
+            || qFromLittleEndian<quint32>(m_map + 8) != formatVersion) {
+        m_error = m_map ? QStringLiteral("Not a session recording") : m_file.errorString();
+        close();
+        return false;
+    }
+
+    qint64 offset = headerSize;
+    while (size - offset >= chunkHeaderSize) {
+        const uchar *header = m_map + offset;
+        const qint64 chunkSize = qFromLittleEndian<quint32>(header + 8);
+        if (chunkSize > qMin<qint64>(size - offset - chunkHeaderSize, std::numeric_limits<qint32>::max()))
+            break;
+        m_chunks.append({ qint64(qFromLittleEndian<quint64>(header)), header + chunkHeaderSize, qint32(chunkSize) });
+        m_totalBytes += chunkSize;
+        offset += chunkHeaderSize + chunkSize;
+    }
+    if (offset != size)
+        qCWarning(lcVncClient) << "Session recording" << fileName << "is truncated, playing the complete part";
+    return true;
+}
+
+void QVncSessionPlayer::close()
+{
+    stop();
+    m_chunks.clear();
+    m_totalBytes = 0;
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+}
+
+qint64 QVncSessionPlayer::duration() const
+{
+    return m_chunks.isEmpty() ? 0 : m_chunks.last().time - m_chunks.first().time;
+}
+
+void QVncSessionPlayer::play(QVncClient *client, Pacing pacing, std::function<void()> finished)
+{
+    stop();
+    if (!client)
+        return;
+    m_client = client;
+    m_socket.reset(new QVncMemorySocket);
+    m_socket->setKeepWritten(false);
+    m_finished = std::move(finished);
+    m_next = 0;
+    m_playing = true;
+    client->setSocket(m_socket.get());
+    // The memory socket starts out connected; tell the client like a real one would
+    emit m_socket->connected();
+
+    if (pacing == AsFastAsPossible) {
+        while (m_playing && m_next < m_chunks.size())
+            feed(m_chunks.at(m_next++));
+        finish();
+        return;
+    }
+    m_clock.start();
+    scheduleNext();
+}
+
+void QVncSessionPlayer::stop()
+{
+    m_timer.stop();
+    m_playing = false;
+    m_finished = {};
+    if (m_client && m_client->socket() == m_socket.get())
+        m_client->setSocket(nullptr);
+    m_client = nullptr;
+    m_socket.reset();
+}
+
+void QVncSessionPlayer::feed(const Chunk &chunk)
+{
+    // No copy: the socket shares the mapped bytes until the client has read
+    // them, and stop() drops the socket before the file is unmapped
+    m_socket->feed(QByteArray::fromRawData(reinterpret_cast<const char *>(chunk.data), chunk.size));
+}
+
+void QVncSessionPlayer::scheduleNext()
+{
+    if (!m_playing)
+        return;
+    if (m_next >= m_chunks.size()) {
+        finish();
+        return;
+    }
+    const qint64 due = m_chunks.at(m_next).time - m_chunks.first().time - m_clock.nsecsElapsed();
+    m_timer.start(int(qBound<qint64>(0, due / 1000000, std::numeric_limits<int>::max())));
+}
+
+void QVncSessionPlayer::finish()
+{
+    if (!m_playing)
+        return;
+    m_playing = false;
+    const std::function<void()> finished = std::move(m_finished);
+    m_finished = {};
+    if (finished)
+        finished();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,126 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Recording and replay of the server-to-client byte stream.
+//
+// A recording holds every chunk the client pulled from its socket, with the
+// time it arrived. The file is a 16 byte header followed by the chunks, all
+// integers little endian:
+//
+//   header: "QVNCSESS", quint32 version (1), quint32 flags (0)
+//   chunk:  quint64 nanoseconds since the start, quint32 size, size bytes
+//
+// Nothing needs decoding, so the player maps the file and hands the chunks
+// to the client as they are. A recording cut short by a crash loses only
+// its last, incomplete chunk. What the client sent is not stored: a replay
+// ignores it, so any authentication works except encryption (VeNCrypt TLS),
+// which needs a real peer.
+//
+
+#ifndef QVNCSESSIONRECORDING_P_H
+#define QVNCSESSIONRECORDING_P_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
+#include <functional>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QVncClient;
+class QVncMemorySocket;
+
+class Q_VNCCLIENT_EXPORT QVncSessionRecorder
+{
+public:
+    // Creates \a fileName, replacing an existing file.
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_file.errorString(); }
+
+    // Appends \a size bytes just received, stamped with the current time.
+    void write(const uchar *data, qint64 size);
+
+private:
+    QFile m_file;
+    QElapsedTimer m_clock;
+};
+
+class Q_VNCCLIENT_EXPORT QVncSessionPlayer
+{
+public:
+    enum Pacing {
+        AsFastAsPossible,   // every chunk right away, in one go
+        RealTime,           // each chunk when it arrived in the recording
+    };
+
+    QVncSessionPlayer();
+    ~QVncSessionPlayer();
+
+    QVncSessionPlayer(const QVncSessionPlayer &) = delete;
+    QVncSessionPlayer &operator=(const QVncSessionPlayer &) = delete;
+
+    bool open(const QString &fileName);
+    void close();
+    QString errorString() const { return m_error; }
+
+    qsizetype chunkCount() const { return m_chunks.size(); }
+    qint64 totalBytes() const { return m_totalBytes; }
+    // Time from the first to the last chunk, in nanoseconds.
+    qint64 duration() const;
+
+    // Makes \a client read the recording from an in-memory socket and calls
+    // \a finished once the last chunk has been handed over. With
+    // AsFastAsPossible this happens before play() returns.
+    void play(QVncClient *client, Pacing pacing = AsFastAsPossible,
+              std::function<void()> finished = {});
+    // Detaches the client, which then resets like after a disconnect.
+    void stop();
+    bool isPlaying() const { return m_playing; }
+
+private:
+    struct Chunk {
+        qint64 time;
+        const uchar *data;
+        qint32 size;
+    };
+
+    void feed(const Chunk &chunk);
+    void scheduleNext();
+    void finish();
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+    QList<Chunk> m_chunks;
+    qint64 m_totalBytes = 0;
+    QString m_error;
+
+    QPointer<QVncClient> m_client;
+    std::unique_ptr<QVncMemorySocket> m_socket;
+    bool m_playing = false;
+    std::function<void()> m_finished;
+    qsizetype m_next = 0;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCSESSIONRECORDING_P_H
@@ -0,0 +1,217 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvnczlib_p.h"
+
+#if defined(USE_ZLIB_NG)
+#include <zlib-ng.h>
+#elif defined(USE_ZLIB)
+#include <zlib.h>
+#endif
+
+#include <cstring>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+#if defined(USE_ZLIB_NG)
+using ZStream = zng_stream;
+#define QVNC_Z(function) ::zng_ ## function
+#elif defined(USE_ZLIB)
+using ZStream = z_stream;
+#define QVNC_Z(function) ::function
+#endif
+
+#ifdef USE_ZLIB
+
+// zlib counts in 32 bits; larger buffers are filled over several calls
+static inline decltype(ZStream::avail_out) clampedSize(qsizetype size)
+{
+    return decltype(ZStream::avail_out)(qMin<qsizetype>(size, std::numeric_limits<decltype(ZStream::avail_out)>::max()));
+}
+
+struct QVncInflater::Stream
+{
+    ZStream z;
+    bool active = false;
+};
+
+QVncInflater::QVncInflater()
+    : d(new Stream)
+{
+    memset(&d->z, 0, sizeof(d->z));
+}
+
+QVncInflater::~QVncInflater()
+{
+    end();
+}
+
+const char *QVncInflater::backend()
+{
+#ifdef USE_ZLIB_NG
+    return "zlib-ng";
+#else
+    return "zlib";
+#endif
+}
+
+bool QVncInflater::isActive() const
+{
+    return d->active;
+}
+
+void QVncInflater::end()
+{
+    if (!d->active)
+        return;
+    QVNC_Z(inflateEnd)(&d->z);
+    memset(&d->z, 0, sizeof(d->z));
+    d->active = false;
+}
+
+bool QVncInflater::reset()
+{
+    if (d->active)
+        return QVNC_Z(inflateReset)(&d->z) == Z_OK;
+    d->active = QVNC_Z(inflateInit)(&d->z) == Z_OK;
+    return d->active;
+}
+
+void QVncInflater::setInput(const uchar *data, qsizetype size)
+{
+    d->z.next_in = reinterpret_cast<decltype(d->z.next_in)>(const_cast<uchar *>(data));
+    d->z.avail_in = decltype(d->z.avail_in)(size);
+}
+
+qsizetype QVncInflater::availableInput() const
+{
+    return d->z.avail_in;
+}
+
+QVncInflater::Result QVncInflater::inflate(uchar *out, qsizetype size, qsizetype *written)
+{
+    *written = 0;
+    if (!d->active && !reset())
+        return Error;
+    d->z.next_out = out;
+    d->z.avail_out = clampedSize(size);
+    const auto before = d->z.avail_out;
+    const int ret = QVNC_Z(inflate)(&d->z, Z_SYNC_FLUSH);
+    *written = before - d->z.avail_out;
+    switch (ret) {
+    case Z_OK:
+    case Z_BUF_ERROR: // no progress possible, more input or output needed
+        return Ok;
+    case Z_STREAM_END:
+        return StreamEnd;
+    default:
+        return Error;
+    }
+}
+
+const char *QVncInflater::errorString() const
+{
+    return d->z.msg ? d->z.msg : "unknown error";
+}
+
+struct QVncDeflater::Stream
+{
+    ZStream z;
+    int level = Z_DEFAULT_COMPRESSION;
+    bool active = false;
+};
+
+QVncDeflater::QVncDeflater(int level)
+    : d(new Stream)
+{
+    memset(&d->z, 0, sizeof(d->z));
+    d->level = level;
+}
+
+QVncDeflater::~QVncDeflater()
+{
+    end();
+}
+
+bool QVncDeflater::isActive() const
+{
+    return d->active;
+}
+
+void QVncDeflater::end()
+{
+    if (!d->active)
+        return;
+    QVNC_Z(deflateEnd)(&d->z);
+    memset(&d->z, 0, sizeof(d->z));
+    d->active = false;
+}
+
+bool QVncDeflater::reset()
+{
+    if (d->active)
+        return QVNC_Z(deflateReset)(&d->z) == Z_OK;
+    d->active = QVNC_Z(deflateInit)(&d->z, d->level) == Z_OK;
+    return d->active;
+}
+
+QByteArray QVncDeflater::compress(const QByteArray &data, Flush flush)
+{
+    if (!d->active && !reset())
+        return QByteArray();
+
+    // The bound covers a finished stream; a flush marker needs a few bytes more
+    QByteArray out(qsizetype(QVNC_Z(deflateBound)(&d->z, data.size())) + 64, Qt::Uninitialized);
+    d->z.next_in = reinterpret_cast<decltype(d->z.next_in)>(const_cast<char *>(data.constData()));
+    d->z.avail_in = decltype(d->z.avail_in)(data.size());
+    d->z.next_out = reinterpret_cast<decltype(d->z.next_out)>(out.data());
+    d->z.avail_out = clampedSize(out.size());
+
+    const int mode = flush == Finish ? Z_FINISH : flush == FullFlush ? Z_FULL_FLUSH : Z_SYNC_FLUSH;
+    const int ret = QVNC_Z(deflate)(&d->z, mode);
+    if (ret != (flush == Finish ? Z_STREAM_END : Z_OK) || d->z.avail_in != 0) {
+        // The peer could not follow the stream any more; begin a new one
+        end();
+        return QByteArray();
+    }
+    out.resize(out.size() - d->z.avail_out);
+
+    if (flush == Finish && !reset())
+        end();
+    return out;
+}
+
+#else // !USE_ZLIB
+
+struct QVncInflater::Stream {};
+
+QVncInflater::QVncInflater() = default;
+QVncInflater::~QVncInflater() = default;
+const char *QVncInflater::backend() { return nullptr; }
+bool QVncInflater::isActive() const { return false; }
+void QVncInflater::end() {}
+bool QVncInflater::reset() { return false; }
+void QVncInflater::setInput(const uchar *, qsizetype) {}
+qsizetype QVncInflater::availableInput() const { return 0; }
+
+QVncInflater::Result QVncInflater::inflate(uchar *, qsizetype, qsizetype *written)
+{
+    *written = 0;
+    return Error;
+}
+
+const char *QVncInflater::errorString() const { return "built without zlib"; }
+
+struct QVncDeflater::Stream {};
+
+QVncDeflater::QVncDeflater(int) {}
+QVncDeflater::~QVncDeflater() = default;
+bool QVncDeflater::isActive() const { return false; }
+void QVncDeflater::end() {}
+bool QVncDeflater::reset() { return false; }
+QByteArray QVncDeflater::compress(const QByteArray &, Flush) { return QByteArray(); }
+
+#endif // USE_ZLIB
+
+QT_END_NAMESPACE
@@ -0,0 +1,96 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Persistent inflate and deflate streams.
+//
+// Tight, ZRLE and the extended clipboard keep zlib streams whose dictionary
+// carries over from one rectangle or message to the next. They go through
+// QVncInflater and QVncDeflater rather than z_stream, so that the zlib
+// implementation is picked at build time without touching the decoders:
+// VNCCLIENT_ZLIB_BACKEND selects stock zlib (the default) or zlib-ng in its
+// native API, whose inflate copies matches and checksums with SIMD. Both
+// read and write the same format, so the server cannot tell them apart.
+//
+// A stream begins on first use, or after end(). reset() begins a new one
+// while keeping the allocated state. Built without zlib, every call fails
+// and backend() returns nullptr.
+//
+
+#ifndef QVNCZLIB_P_H
+#define QVNCZLIB_P_H
+
+#include <QtVncClient/qtvncclientglobal.h>
+#include <QtCore/QByteArray>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class Q_VNCCLIENT_EXPORT QVncInflater
+{
+public:
+    enum Result { Ok, StreamEnd, Error };
+
+    QVncInflater();
+    ~QVncInflater();
+
+    // The zlib implementation built in, or nullptr without one
+    static const char *backend();
+
+    bool isActive() const;
+    void end();
+    bool reset();
+
+    // The input stays referenced until it is consumed or replaced
+    void setInput(const uchar *data, qsizetype size);
+    qsizetype availableInput() const;
+
+    // Inflates up to \a size bytes into \a out and stores how many were
+    // written in \a written. Running out of input or output is not an error.
+    Result inflate(uchar *out, qsizetype size, qsizetype *written);
+    const char *errorString() const;
+
+private:
+    Q_DISABLE_COPY(QVncInflater)
+    struct Stream;
+    std::unique_ptr<Stream> d;
+};
+
+class Q_VNCCLIENT_EXPORT QVncDeflater
+{
+public:
+    enum Flush { SyncFlush, FullFlush, Finish };
+
+    // \a level is a zlib compression level, -1 for the default
+    explicit QVncDeflater(int level = -1);
+    ~QVncDeflater();
+
+    bool isActive() const;
+    void end();
+    bool reset();
+
+    // Compresses all of \a data, continuing the stream. Finish ends the
+    // stream, so the next call begins a new one. Returns a null array on error.
+    QByteArray compress(const QByteArray &data, Flush flush);
+
+private:
+    Q_DISABLE_COPY(QVncDeflater)
+    struct Stream;
+    std::unique_ptr<Stream> d;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCZLIB_P_H
@@ -0,0 +1,10 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QTVNCCLIENTWIDGETSGLOBAL_H
+#define QTVNCCLIENTWIDGETSGLOBAL_H
+
+#include <QtCore/qglobal.h>
+#include <QtVncClientWidgets/qtvncclientwidgetsexports.h>
+
+#endif // QTVNCCLIENTWIDGETSGLOBAL_H
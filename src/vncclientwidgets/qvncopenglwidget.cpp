@@ -0,0 +1,678 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvncopenglwidget.h"
+#include "qvncviewtransform_p.h"
+
+#include <QtVncClient/QVncClient>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QPointer>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QVector4D>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLShaderProgram>
+
+#include <cstring>
+
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+
+QT_BEGIN_NAMESPACE
+
+Q_STATIC_LOGGING_CATEGORY(lcVncOpenGLWidget, "qt.vncclient.openglwidget")
+
+namespace {
+
+// Framebuffer and cursor pixels are uploaded as they are in memory, four
+// bytes per pixel, and put back in order by the shader: B, G, R, A on
+// little endian hosts, A, R, G, B on big endian ones.
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#define QVNC_PIXEL_SWIZZLE "bgra"
+#else
+#define QVNC_PIXEL_SWIZZLE "gbar"
+#endif
+
+const char vertexShader[] =
+        "attribute vec2 vertex;\n"
+        "uniform vec4 target;\n" // left, top, width, height in device coordinates
+        "varying vec2 uv;\n"
+        "void main() {\n"
+        "    uv = vertex;\n"
+        "    gl_Position = vec4(target.x + vertex.x * target.z, target.y - vertex.y * target.w, 0.0, 1.0);\n"
+        "}\n";
+
+const char fragmentShader[] =
+        "#ifdef GL_ES\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "varying vec2 uv;\n"
+        "uniform sampler2D pixels;\n"
+        "uniform float opaque;\n"
+        "void main() {\n"
+        "    vec4 color = texture2D(pixels, uv)." QVNC_PIXEL_SWIZZLE ";\n"
+        "    gl_FragColor = vec4(color.rgb, max(color.a, opaque));\n"
+        "}\n";
+
+const GLfloat quadVertices[] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+
+// Past this many rectangles, uploading their bounds at once is cheaper
+constexpr int maxUploadRects = 64;
+
+GLuint createTexture(QOpenGLFunctions *f)
+{
+    GLuint texture = 0;
+    f->glGenTextures(1, &texture);
+    f->glBindTexture(GL_TEXTURE_2D, texture);
+    // Framebuffers are rarely a power of two; OpenGL ES 2 needs these for that
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+} // namespace
+
+class QVncOpenGLWidget::Private
+{
+public:
+    Private(QVncOpenGLWidget *parent);
+
+    QImage source() const;
+    QVncViewTransform transform() const;
+    void updateCursorShape();
+    void resizeTextures(QOpenGLFunctions *f, const QSize &size);
+    bool uploadFramebuffer(QOpenGLFunctions *f);
+    bool uploadThroughPixelBuffer(QOpenGLFunctions *f, const QImage &image, const QList<QRect> &rects,
+                                  const QPoint &origin);
+    void uploadDirectly(QOpenGLFunctions *f, const QImage &image, const QList<QRect> &rects,
+                        const QPoint &origin);
+    void uploadCursor(QOpenGLFunctions *f);
+    void draw(QOpenGLFunctions *f, GLuint texture, const QRectF &rect, bool opaque, bool smooth);
+    void forwardPointer(QMouseEvent *e);
+    void releaseResources();
+
+private:
+    QVncOpenGLWidget *q;
+
+public:
+    QPointer<QVncClient> client;
+    bool scaled = true;
+    bool cursorVisible = true;
+    QRegion dirty;                  // Framebuffer area not in the texture yet
+    bool cursorDirty = true;
+    QPoint pointer;                 // Where the cursor is drawn, in framebuffer pixels
+
+    QScopedPointer<QOpenGLShaderProgram> program;
+    QOpenGLBuffer quad;
+    QOpenGLBuffer pixelBuffers[2] = { QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer),
+                                      QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer) };
+    int nextPixelBuffer = 0;
+    bool rowLength = false;         // GL_UNPACK_ROW_LENGTH is supported
+    GLint maxTextureSize = 0;       // GL_MAX_TEXTURE_SIZE
+    struct Tile {
+        GLuint texture = 0;
+        QRect rect;                 // The framebuffer pixels it holds
+    };
+    QList<Tile> tiles;              // Framebuffer textures; several past maxTextureSize
+    QSize textureSize;
+    GLuint cursorTexture = 0;
+    QSize cursorSize;
+    QByteArray packed;              // Rows of one rectangle, without GL_UNPACK_ROW_LENGTH
+};
+
+QVncOpenGLWidget::Private::Private(QVncOpenGLWidget *parent)
+    : q(parent)
+{
+    q->setMouseTracking(true);
+    q->setFocusPolicy(Qt::StrongFocus);
+}
+
+/*!
+    \internal
+    Returns the pixels to show: the latest complete frame when the client
+    keeps front buffers, its framebuffer otherwise. Neither makes the
+    client copy its framebuffer.
+*/
+QImage QVncOpenGLWidget::Private::source() const
+{
+    if (!client)
+        return QImage();
+    return client->bufferingMode() == QVncClient::SingleBuffered ? client->imageView()
+                                                                 : client->frame();
+}
+
+QVncViewTransform QVncOpenGLWidget::Private::transform() const
+{
+    return QVncViewTransform(textureSize, q->size(), scaled);
+}
+
+/*!
+    \internal
+    Hides the local pointer while the remote cursor is drawn in its place.
+*/
+void QVncOpenGLWidget::Private::updateCursorShape()
+{
+    if (cursorVisible && client && !client->cursorImage().isNull())
+        q->setCursor(Qt::BlankCursor);
+    else
+        q->unsetCursor();
+}
+
+/*!
+    \internal
+    Allocates the framebuffer textures for a framebuffer of \a size: one
+    where the OpenGL implementation allows it, a grid of them for
+    framebuffers wider or taller than GL_MAX_TEXTURE_SIZE.
+*/
+void QVncOpenGLWidget::Private::resizeTextures(QOpenGLFunctions *f, const QSize &size)
+{
+    const int maxSize = maxTextureSize > 0 ? maxTextureSize : qMax(size.width(), size.height());
+    QList<QRect> rects;
+    for (int y = 0; y < size.height(); y += maxSize) {
+        for (int x = 0; x < size.width(); x += maxSize)
+            rects.append(QRect(x, y, qMin(maxSize, size.width() - x), qMin(maxSize, size.height() - y)));
+    }
+    if (rects.size() > 1) {
+        qCDebug(lcVncOpenGLWidget) << "Framebuffer of" << size << "split into" << rects.size()
+                                   << "textures of at most" << maxSize << "pixels";
+    }
+
+    while (tiles.size() > rects.size()) {
+        f->glDeleteTextures(1, &tiles.last().texture);
+        tiles.removeLast();
+    }
+    while (tiles.size() < rects.size())
+        tiles.append(Tile { createTexture(f), QRect() });
+    for (qsizetype i = 0; i < tiles.size(); i++) {
+        Tile &tile = tiles[i];
+        tile.rect = rects.at(i);
+        f->glBindTexture(GL_TEXTURE_2D, tile.texture);
+        f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tile.rect.width(), tile.rect.height(), 0,
+                        GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    textureSize = size;
+}
+
+/*!
+    \internal
+    Brings the framebuffer textures up to date. Only the area damaged since
+    the last upload is transferred. Returns \c false if there is nothing
+    to show.
+*/
+bool QVncOpenGLWidget::Private::uploadFramebuffer(QOpenGLFunctions *f)
+{
+    const QImage image = source();
+    if (image.isNull())
+        return false;
+
+    if (textureSize != image.size()) {
+        resizeTextures(f, image.size());
+        dirty = image.rect();
+    }
+    const QRegion region = dirty & image.rect();
+    dirty = QRegion();
+    if (region.isEmpty())
+        return true;
+
+    QList<QRect> rects(region.begin(), region.end());
+    if (rects.size() > maxUploadRects)
+        rects = { region.boundingRect() };
+    f->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (const Tile &tile : std::as_const(tiles)) {
+        QList<QRect> parts;
+        for (const QRect &rect : std::as_const(rects)) {
+            const QRect part = rect & tile.rect;
+            if (!part.isEmpty())
+                parts.append(part);
+        }
+        if (parts.isEmpty())
+            continue;
+        f->glBindTexture(GL_TEXTURE_2D, tile.texture);
+        if (!uploadThroughPixelBuffer(f, image, parts, tile.rect.topLeft()))
+            uploadDirectly(f, image, parts, tile.rect.topLeft());
+    }
+    return true;
+}
+
+/*!
+    \internal
+    Streams \a rects of \a image to the bound texture, which holds the
+    framebuffer from \a origin on, through a pixel buffer.
+
+    The rows are packed into buffer memory the driver provides, so the
+    transfer to the GPU no longer holds up this thread. Two buffers take
+    turns and each is orphaned before it is filled, so a transfer still in
+    progress never has to finish first. Returns \c false if pixel buffers
+    are not available, for example on OpenGL ES 2.
+*/
+bool QVncOpenGLWidget::Private::uploadThroughPixelBuffer(QOpenGLFunctions *f, const QImage &image,
+                                                         const QList<QRect> &rects, const QPoint &origin)
+{
+    QOpenGLBuffer &buffer = pixelBuffers[nextPixelBuffer];
+    if (!buffer.isCreated())
+        return false;
+
+    qsizetype size = 0;
+    for (const QRect &rect : rects)
+        size += qsizetype(rect.width()) * rect.height() * 4;
+    buffer.bind();
+    buffer.allocate(int(size));
+    uchar *out = static_cast<uchar *>(buffer.mapRange(0, int(size), QOpenGLBuffer::RangeWrite
+                                                      | QOpenGLBuffer::RangeInvalidateBuffer));
+    if (!out) {
+        buffer.release();
+        qCDebug(lcVncOpenGLWidget) << "Pixel buffers cannot be mapped, uploading directly";
+        for (QOpenGLBuffer &pixelBuffer : pixelBuffers)
+            pixelBuffer.destroy();
+        return false;
+    }
+    for (const QRect &rect : rects) {
+        const qsizetype rowSize = qsizetype(rect.width()) * 4;
+        for (int y = rect.top(); y <= rect.bottom(); y++, out += rowSize)
+            memcpy(out, image.constScanLine(y) + rect.x() * 4, rowSize);
+    }
+    buffer.unmap();
+
+    qintptr offset = 0;
+    for (const QRect &rect : rects) {
+        f->glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x() - origin.x(), rect.y() - origin.y(),
+                           rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                           reinterpret_cast<const void *>(offset));
+        offset += qintptr(rect.width()) * rect.height() * 4;
+    }
+    buffer.release();
+    nextPixelBuffer = (nextPixelBuffer + 1) % 2;
+    return true;
+}
+
+/*!
+    \internal
+    Uploads \a rects of \a image to the bound texture, which holds the
+    framebuffer from \a origin on, from client memory.
+*/
+void QVncOpenGLWidget::Private::uploadDirectly(QOpenGLFunctions *f, const QImage &image,
+                                               const QList<QRect> &rects, const QPoint &origin)
+{
+    if (rowLength)
+        f->glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(image.bytesPerLine() / 4));
+    for (const QRect &rect : rects) {
+        const uchar *pixels = image.constScanLine(rect.y()) + rect.x() * 4;
+        if (!rowLength && rect.width() != image.width()) {
+            // Without a row length, rows have to be contiguous
+            const qsizetype rowSize = qsizetype(rect.width()) * 4;
+            packed.resize(rowSize * rect.height());
+            uchar *out = reinterpret_cast<uchar *>(packed.data());
+            for (int y = rect.top(); y <= rect.bottom(); y++, out += rowSize)
+                memcpy(out, image.constScanLine(y) + rect.x() * 4, rowSize);
+            pixels = reinterpret_cast<const uchar *>(packed.constData());
+        }
+        f->glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x() - origin.x(), rect.y() - origin.y(),
+                           rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    if (rowLength)
+        f->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void QVncOpenGLWidget::Private::uploadCursor(QOpenGLFunctions *f)
+{
+    cursorDirty = false;
+    const QImage cursor = client ? client->cursorImage().convertToFormat(QImage::Format_ARGB32)
+                                 : QImage();
+    cursorSize = cursor.size();
+    if (cursor.isNull())
+        return;
+    if (!cursorTexture)
+        cursorTexture = createTexture(f);
+    f->glBindTexture(GL_TEXTURE_2D, cursorTexture);
+    f->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, cursor.width(), cursor.height(), 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, cursor.constBits());
+}
+
+/*!
+    \internal
+    Draws \a texture into \a rect, in widget coordinates. Scaled textures
+    are filtered linearly when \a smooth is set.
+*/
+void QVncOpenGLWidget::Private::draw(QOpenGLFunctions *f, GLuint texture, const QRectF &rect,
+                                     bool opaque, bool smooth)
+{
+    const qreal width = q->width();
+    const qreal height = q->height();
+    program->bind();
+    program->setUniformValue("target", QVector4D(2 * rect.x() / width - 1, 1 - 2 * rect.y() / height,
+                                                 2 * rect.width() / width, 2 * rect.height() / height));
+    program->setUniformValue("opaque", opaque ? 1.0f : 0.0f);
+    program->setUniformValue("pixels", 0);
+
+    f->glActiveTexture(GL_TEXTURE0);
+    f->glBindTexture(GL_TEXTURE_2D, texture);
+    const GLint filter = smooth ? GL_LINEAR : GL_NEAREST;
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+    quad.bind();
+    program->enableAttributeArray(0);
+    program->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+    f->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    program->disableAttributeArray(0);
+    quad.release();
+    program->release();
+}
+
+/*!
+    \internal
+    Sends \a e to the server in framebuffer coordinates.
+*/
+void QVncOpenGLWidget::Private::forwardPointer(QMouseEvent *e)
+{
+    if (!client)
+        return;
+    pointer = transform().toFramebuffer(e->position());
+    QMouseEvent mapped(e->type(), pointer, e->scenePosition(), e->globalPosition(), e->button(),
+                       e->buttons(), e->modifiers(), e->pointingDevice());
+    client->handlePointerEvent(&mapped);
+    // The cursor follows the pointer without waiting for the server
+    if (cursorVisible && !cursorSize.isEmpty())
+        q->update();
+}
+
+void QVncOpenGLWidget::Private::releaseResources()
+{
+    if (!program)
+        return;
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+    for (Tile &tile : tiles)
+        f->glDeleteTextures(1, &tile.texture);
+    tiles.clear();
+    if (cursorTexture)
+        f->glDeleteTextures(1, &cursorTexture);
+    cursorTexture = 0;
+    textureSize = QSize();
+    cursorSize = QSize();
+    cursorDirty = true;
+    quad.destroy();
+    for (QOpenGLBuffer &buffer : pixelBuffers)
+        buffer.destroy();
+    program.reset();
+}
+
+/*!
+    \class QVncOpenGLWidget
+    \inmodule QtVncClientWidgets
+
+    \brief The QVncOpenGLWidget class shows a QVncClient's framebuffer
+    through OpenGL.
+
+    The framebuffer is kept in a texture. For every framebuffer update,
+    only the region reported by QVncClient::imageRegionChanged() is
+    uploaded, streamed through pixel buffer objects where the OpenGL
+    implementation supports them. Scaling and drawing the remote cursor
+    are done by the GPU, so the CPU cost of showing a frame does not
+    depend on the size of the widget. Framebuffers larger than the largest
+    texture the OpenGL implementation supports are split over several
+    textures.
+
+    When the client keeps front buffers (see QVncClient::bufferingMode),
+    the widget shows the latest complete frame; otherwise it reads the
+    client's framebuffer directly, without copying it.
+
+    Keyboard and mouse events are forwarded to the client, with pointer
+    positions mapped to framebuffer coordinates.
+
+    A compatibility profile or OpenGL ES context is needed, which is what
+    QOpenGLWidget uses by default.
+*/
+
+/*!
+    Constructs a widget with the given \a parent.
+*/
+QVncOpenGLWidget::QVncOpenGLWidget(QWidget *parent)
+    : QOpenGLWidget(parent)
+    , d(new Private(this))
+{
+}
+
+/*!
+    Destroys the widget and releases its OpenGL resources.
+*/
+QVncOpenGLWidget::~QVncOpenGLWidget()
+{
+    if (d->program && context()) {
+        // Too late for aboutToBeDestroyed, which QOpenGLWidget emits after this
+        disconnect(context(), nullptr, this, nullptr);
+        makeCurrent();
+        d->releaseResources();
+        doneCurrent();
+    }
+}
+
+/*!
+    \property QVncOpenGLWidget::client
+    \brief The client whose framebuffer is shown.
+*/
+QVncClient *QVncOpenGLWidget::client() const
+{
+    return d->client;
+}
+
+void QVncOpenGLWidget::setClient(QVncClient *client)
+{
+    if (d->client == client)
+        return;
+    if (d->client)
+        disconnect(d->client, nullptr, this, nullptr);
+    d->client = client;
+    // The next paint uploads everything
+    d->textureSize = QSize();
+    d->cursorDirty = true;
+
+    if (client) {
+        connect(client, &QVncClient::imageRegionChanged, this, [this](const QRegion &region) {
+            d->dirty += region;
+            if (d->dirty.rectCount() > maxUploadRects)
+                d->dirty = d->dirty.boundingRect();
+            update();
+        });
+        connect(client, &QVncClient::framebufferSizeChanged, this, [this]() {
+            updateGeometry();
+            update();
+        });
+        connect(client, &QVncClient::cursorChanged, this, [this]() {
+            d->cursorDirty = true;
+            d->updateCursorShape();
+            update();
+        });
+        connect(client, &QVncClient::cursorPosChanged, this, [this](const QPoint &pos) {
+            d->pointer = pos;
+            update();
+        });
+        connect(client, &QVncClient::connectionStateChanged, this, [this]() {
+            update();
+        });
+    }
+    d->updateCursorShape();
+    updateGeometry();
+    update();
+    emit clientChanged(client);
+}
+
+/*!
+    \property QVncOpenGLWidget::scaled
+    \brief Whether the framebuffer is scaled to fit the widget.
+
+    When \c true, the default, the framebuffer fills the widget as far as
+    its aspect ratio allows and is centred. When \c false, it is shown at
+    its own size in the top left corner.
+*/
+bool QVncOpenGLWidget::isScaled() const
+{
+    return d->scaled;
+}
+
+void QVncOpenGLWidget::setScaled(bool scaled)
+{
+    if (d->scaled == scaled)
+        return;
+    d->scaled = scaled;
+    update();
+    emit scaledChanged(scaled);
+}
+
+/*!
+    \property QVncOpenGLWidget::cursorVisible
+    \brief Whether the cursor shape sent by the server is drawn.
+
+    The cursor is drawn at the local pointer position while the pointer is
+    over the widget, and where the server moved it to otherwise. The local
+    pointer is hidden while the remote cursor is shown. The default is
+    \c true.
+*/
+bool QVncOpenGLWidget::isCursorVisible() const
+{
+    return d->cursorVisible;
+}
+
+void QVncOpenGLWidget::setCursorVisible(bool visible)
+{
+    if (d->cursorVisible == visible)
+        return;
+    d->cursorVisible = visible;
+    d->updateCursorShape();
+    update();
+    emit cursorVisibleChanged(visible);
+}
+
+/*!
+    \reimp
+*/
+QSize QVncOpenGLWidget::sizeHint() const
+{
+    if (d->client && d->client->framebufferWidth() > 0)
+        return QSize(d->client->framebufferWidth(), d->client->framebufferHeight());
+    return QOpenGLWidget::sizeHint();
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::initializeGL()
+{
+    // A new context, for example after reparenting, starts from scratch
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, [this]() {
+        makeCurrent();
+        d->releaseResources();
+        doneCurrent();
+    }, Qt::UniqueConnection);
+
+    QScopedPointer<QOpenGLShaderProgram> program(new QOpenGLShaderProgram);
+    if (!program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader)
+            || !program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader)) {
+        qCWarning(lcVncOpenGLWidget) << "Failed to compile shaders:" << program->log();
+        return;
+    }
+    program->bindAttributeLocation("vertex", 0);
+    if (!program->link()) {
+        qCWarning(lcVncOpenGLWidget) << "Failed to link shaders:" << program->log();
+        return;
+    }
+    d->program.swap(program);
+
+    d->quad.create();
+    d->quad.bind();
+    d->quad.allocate(quadVertices, sizeof(quadVertices));
+    d->quad.release();
+
+    // Often 8192 or 16384, less than video walls need
+    context()->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &d->maxTextureSize);
+
+    // Row length and pixel buffers are core in OpenGL ES 3 and desktop OpenGL
+    const bool gles2 = context()->isOpenGLES() && context()->format().majorVersion() < 3;
+    d->rowLength = !gles2;
+    if (!gles2) {
+        for (QOpenGLBuffer &buffer : d->pixelBuffers) {
+            buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+            buffer.create();
+        }
+    }
+    d->textureSize = QSize();
+    d->cursorDirty = true;
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::paintGL()
+{
+    QOpenGLFunctions *f = context()->functions();
+    const QColor background = palette().color(backgroundRole());
+    f->glClearColor(background.redF(), background.greenF(), background.blueF(), 1);
+    f->glClear(GL_COLOR_BUFFER_BIT);
+    if (!d->program || !d->uploadFramebuffer(f))
+        return;
+
+    const QVncViewTransform transform = d->transform();
+    for (const Private::Tile &tile : std::as_const(d->tiles))
+        d->draw(f, tile.texture, transform.toView(QRectF(tile.rect)), true, transform.scale() != 1);
+
+    if (!d->cursorVisible)
+        return;
+    if (d->cursorDirty)
+        d->uploadCursor(f);
+    if (d->cursorSize.isEmpty())
+        return;
+    const QRectF cursor(d->pointer - d->client->cursorHotspot(), d->cursorSize);
+    f->glEnable(GL_BLEND);
+    f->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    d->draw(f, d->cursorTexture, transform.toView(cursor), false, transform.scale() != 1);
+    f->glDisable(GL_BLEND);
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::keyPressEvent(QKeyEvent *e)
+{
+    if (d->client)
+        d->client->handleKeyEvent(e);
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::keyReleaseEvent(QKeyEvent *e)
+{
+    if (d->client)
+        d->client->handleKeyEvent(e);
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::mousePressEvent(QMouseEvent *e)
+{
+    d->forwardPointer(e);
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::mouseMoveEvent(QMouseEvent *e)
+{
+    d->forwardPointer(e);
+}
+
+/*!
+    \reimp
+*/
+void QVncOpenGLWidget::mouseReleaseEvent(QMouseEvent *e)
+{
+    d->forwardPointer(e);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,57 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QVNCOPENGLWIDGET_H
+#define QVNCOPENGLWIDGET_H
+
+#include <QtVncClientWidgets/qtvncclientwidgetsglobal.h>
+#include <QtOpenGLWidgets/QOpenGLWidget>
+#include <QtCore/QScopedPointer>
+
+QT_BEGIN_NAMESPACE
+
+class QVncClient;
+
+class Q_VNCCLIENTWIDGETS_EXPORT QVncOpenGLWidget : public QOpenGLWidget
+{
+    Q_OBJECT
+    Q_PROPERTY(QVncClient *client READ client WRITE setClient NOTIFY clientChanged)
+    Q_PROPERTY(bool scaled READ isScaled WRITE setScaled NOTIFY scaledChanged)
+    Q_PROPERTY(bool cursorVisible READ isCursorVisible WRITE setCursorVisible NOTIFY cursorVisibleChanged)
+public:
+    explicit QVncOpenGLWidget(QWidget *parent = nullptr);
+    ~QVncOpenGLWidget() override;
+
+    QVncClient *client() const;
+    bool isScaled() const;
+    bool isCursorVisible() const;
+
+    QSize sizeHint() const override;
+
+public slots:
+    void setClient(QVncClient *client);
+    void setScaled(bool scaled);
+    void setCursorVisible(bool visible);
+
+signals:
+    void clientChanged(QVncClient *client);
+    void scaledChanged(bool scaled);
+    void cursorVisibleChanged(bool visible);
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+    void keyPressEvent(QKeyEvent *e) override;
+    void keyReleaseEvent(QKeyEvent *e) override;
+    void mousePressEvent(QMouseEvent *e) override;
+    void mouseMoveEvent(QMouseEvent *e) override;
+    void mouseReleaseEvent(QMouseEvent *e) override;
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCOPENGLWIDGET_H
@@ -0,0 +1,83 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+//
+// Where a framebuffer is shown in a view, and how view positions map back
+// to framebuffer pixels for pointer events.
+//
+// Unscaled, the framebuffer is shown 1:1 at the top left of the view.
+// Scaled, it fills the view as far as its aspect ratio allows and is
+// centred in the other direction.
+//
+
+#ifndef QVNCVIEWTRANSFORM_P_H
+#define QVNCVIEWTRANSFORM_P_H
+
+#include <QtCore/QRectF>
+#include <QtCore/QSize>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+class QVncViewTransform
+{
+public:
+    QVncViewTransform() = default;
+    QVncViewTransform(const QSize &framebuffer, const QSize &view, bool scaled)
+        : m_framebuffer(framebuffer)
+    {
+        if (framebuffer.isEmpty() || view.isEmpty())
+            return;
+        if (scaled) {
+            m_scale = qMin(qreal(view.width()) / framebuffer.width(),
+                           qreal(view.height()) / framebuffer.height());
+        }
+        const QSizeF size = framebuffer.toSizeF() * m_scale;
+        const QPointF topLeft = scaled ? QPointF((view.width() - size.width()) / 2,
+                                                 (view.height() - size.height()) / 2)
+                                       : QPointF();
+        m_target = QRectF(topLeft, size);
+    }
+
+    bool isNull() const { return m_target.isEmpty(); }
+    qreal scale() const { return m_scale; }
+    // The area of the view showing the framebuffer
+    QRectF target() const { return m_target; }
+
+    QRectF toView(const QRectF &rect) const
+    {
+        return QRectF(m_target.topLeft() + rect.topLeft() * m_scale, rect.size() * m_scale);
+    }
+
+    // The framebuffer pixel under \a pos, clamped to the framebuffer so
+    // dragging out of the view keeps the pointer at the edge
+    QPoint toFramebuffer(const QPointF &pos) const
+    {
+        if (isNull())
+            return QPoint();
+        const QPointF mapped = (pos - m_target.topLeft()) / m_scale;
+        return QPoint(qBound(0, int(std::floor(mapped.x())), m_framebuffer.width() - 1),
+                      qBound(0, int(std::floor(mapped.y())), m_framebuffer.height() - 1));
+    }
+
+private:
+    QSize m_framebuffer;
+    QRectF m_target;
+    qreal m_scale = 1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QVNCVIEWTRANSFORM_P_H
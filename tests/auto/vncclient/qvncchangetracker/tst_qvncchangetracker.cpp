@@ -0,0 +1,140 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QtEndian>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/QVncChangeTracker>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+
+#include "../shared/vnctestserver.h"
+
+class tst_qvncchangetracker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tiles();
+    void unchangedPixels();
+    void checksum();
+    void waitForStable();
+    void resize();
+};
+
+using QVncTest::squareUpdate;
+
+namespace {
+
+struct Session : QVncTest::Session
+{
+    Session()
+    {
+        tracker.setTileSize(2);
+        tracker.setClient(&client);
+    }
+
+    QVncChangeTracker tracker;
+};
+
+const QRect left(0, 0, 2, 2);
+const QRect right(2, 0, 2, 2);
+
+} // namespace
+
+void tst_qvncchangetracker::tiles()
+{
+    Session session;
+    QSignalSpy changed(&session.tracker, &QVncChangeTracker::changed);
+    const quint64 before = session.tracker.changeToken();
+
+    session.socket.feed(squareUpdate(0, QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(changed.first().at(0).value<QRegion>(), QRegion(left));
+    QVERIFY(session.tracker.changeToken() > before);
+    QVERIFY(session.tracker.hasChanged(left, before));
+    QVERIFY(!session.tracker.hasChanged(right, before));
+    QVERIFY(session.tracker.hasChanged(QRect(), before));
+    QCOMPARE(session.tracker.changedSince(before), QRegion(left));
+
+    // Areas are tile-granular: one pixel of a changed tile counts
+    QVERIFY(session.tracker.hasChanged(QRect(1, 1, 1, 1), before));
+    QVERIFY(!session.tracker.hasChanged(left, session.tracker.changeToken()));
+}
+
+void tst_qvncchangetracker::unchangedPixels()
+{
+    Session session;
+    QSignalSpy changed(&session.tracker, &QVncChangeTracker::changed);
+    session.socket.feed(squareUpdate(2, QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(changed.size(), 1);
+    const quint64 token = session.tracker.changeToken();
+
+    // The server sending the same pixels again is not a change
+    session.socket.feed(squareUpdate(2, QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(session.tracker.changeToken(), token);
+    QVERIFY(!session.tracker.hasChanged(right, token));
+}
+
+void tst_qvncchangetracker::checksum()
+{
+    Session session;
+    const quint64 initial = session.tracker.checksum(left);
+    const quint64 other = session.tracker.checksum(right);
+    const quint64 whole = session.tracker.checksum();
+
+    session.socket.feed(squareUpdate(0, QByteArray("\x30\x20\x10\x00", 4)));
+    const quint64 changed = session.tracker.checksum(left);
+    QVERIFY(changed != initial);
+    QCOMPARE(session.tracker.checksum(right), other);
+    QVERIFY(session.tracker.checksum() != whole);
+
+    // The same contents give the same checksum again
+    session.socket.feed(squareUpdate(0, QByteArray(4, '\0')));
+    QVERIFY(session.tracker.checksum(left) != changed);
+    session.socket.feed(squareUpdate(0, QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(session.tracker.checksum(left), changed);
+    session.socket.feed(squareUpdate(2, QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(session.tracker.checksum(right), changed);
+}
+
+void tst_qvncchangetracker::waitForStable()
+{
+    Session session;
+    QVERIFY(session.tracker.waitForStable(left, 20, 1000));
+    QVERIFY(session.tracker.msecsSinceChange(left) >= 20);
+
+    // Changing every few milliseconds, the area never settles
+    QTimer changer;
+    int i = 0;
+    connect(&changer, &QTimer::timeout, this, [&]() {
+        session.socket.feed(squareUpdate(0, QByteArray(4, char(++i))));
+    });
+    changer.start(5);
+    QVERIFY(!session.tracker.waitForStable(left, 200, 100));
+    // Tiles outside of it are stable
+    QVERIFY(session.tracker.waitForStable(right, 20, 1000));
+    changer.stop();
+    QVERIFY(session.tracker.waitForStable(left, 20, 1000));
+}
+
+void tst_qvncchangetracker::resize()
+{
+    Session session;
+    QSignalSpy changed(&session.tracker, &QVncChangeTracker::changed);
+    const quint64 before = session.tracker.changeToken();
+
+    // A new size starts over, with every tile changed
+    session.tracker.setTileSize(1);
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(changed.first().at(0).value<QRegion>(), QRegion(0, 0, 4, 2));
+    QCOMPARE(session.tracker.changedSince(before), QRegion(0, 0, 4, 2));
+
+    // No framebuffer, no tiles
+    session.client.setSocket(nullptr);
+    QCOMPARE(session.tracker.changedSince(0), QRegion());
+    QVERIFY(!session.tracker.hasChanged(QRect(), 0));
+}
+
+QTEST_MAIN(tst_qvncchangetracker)
+#include "tst_qvncchangetracker.moc"
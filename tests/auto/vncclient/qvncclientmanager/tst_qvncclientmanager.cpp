@@ -0,0 +1,92 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QtEndian>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/QVncClientManager>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+
+#include "../shared/vnctestserver.h"
+
+class tst_qvncclientmanager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void clients();
+    void hiddenClients();
+    void sharedDecoding();
+};
+
+using namespace QVncTest;
+
+void tst_qvncclientmanager::clients()
+{
+    QVncClientManager manager;
+    QVncClient first;
+    QScopedPointer<QVncClient> second(new QVncClient);
+    manager.addClient(&first);
+    manager.addClient(&first);
+    manager.addClient(second.data());
+    QCOMPARE(manager.clients(), (QList<QVncClient *> { &first, second.data() }));
+
+    manager.removeClient(&first);
+    QCOMPARE(manager.clients(), (QList<QVncClient *> { second.data() }));
+
+    // Destroyed clients leave on their own
+    second.reset();
+    QVERIFY(manager.clients().isEmpty());
+}
+
+void tst_qvncclientmanager::hiddenClients()
+{
+    QVncClientManager manager;
+    QVncClient client;
+    manager.addClient(&client);
+    QVERIFY(manager.isClientVisible(&client));
+    QCOMPARE(client.updateInterval(), 0);
+
+    manager.setClientVisible(&client, false);
+    QVERIFY(!manager.isClientVisible(&client));
+    QCOMPARE(client.updateInterval(), manager.hiddenUpdateInterval());
+    manager.setHiddenUpdateInterval(200);
+    QCOMPARE(client.updateInterval(), 200);
+
+    manager.setClientVisible(&client, true);
+    QCOMPARE(client.updateInterval(), 0);
+
+    // Leaving the manager ends the throttling
+    manager.setClientVisible(&client, false);
+    manager.removeClient(&client);
+    QCOMPARE(client.updateInterval(), 0);
+}
+
+void tst_qvncclientmanager::sharedDecoding()
+{
+    QScopedPointer<QVncClientManager> manager(new QVncClientManager);
+    manager->setDecodeThreadCount(2);
+    QCOMPARE(manager->decodeThreadCount(), 2);
+
+    QVncClient clients[3];
+    QVncMemorySocket sockets[3];
+    for (int i = 0; i < 3; i++) {
+        manager->addClient(&clients[i]);
+        clients[i].setSocket(&sockets[i]);
+        sockets[i].feed(handshake());
+    }
+    for (int i = 0; i < 3; i++)
+        sockets[i].feed(rawUpdate(QByteArray(3, char(0x10 * (i + 1))) + '\0'));
+    for (int i = 0; i < 3; i++) {
+        const int value = 0x10 * (i + 1);
+        QTRY_COMPARE(clients[i].image().pixel(3, 1), qRgb(value, value, value));
+    }
+
+    // Without the manager, the clients decode on their own again
+    manager.reset();
+    sockets[0].feed(rawUpdate(QByteArray("\x30\x20\x10\x00", 4)));
+    QTRY_COMPARE(clients[0].image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+}
+
+QTEST_MAIN(tst_qvncclientmanager)
+#include "tst_qvncclientmanager.moc"
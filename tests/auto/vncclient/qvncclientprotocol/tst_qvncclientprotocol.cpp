@@ -0,0 +1,991 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QtEndian>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/private/qvnch264decoder_p.h>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+#include <QtVncClient/private/qvnczlib_p.h>
+
+#include "../shared/vnctestserver.h"
+
+// Protocol behaviour against a scripted server: the test plays the server
+// side byte by byte and checks what the client answers.
+class tst_qvncclientprotocol : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void requestDriven();
+    void continuousUpdates();
+    void continuousUpdatesNeedFence();
+    void fenceResponse();
+    void continuousPixelFormatSwitch();
+    void fenceBlockBefore();
+    void continuousUpdatesWithDecodeThreads();
+    void disableContinuousUpdates();
+    void explicitLevels();
+    void damagePerUpdate();
+    void cursorCache();
+    void imageView();
+    void bufferedFrames();
+    void viewport();
+    void continuousViewport();
+    void desktopSize();
+    void desktopSizeKeepsPixels();
+    void extendedDesktopSize();
+    void serverScale();
+    void updateInterval();
+    void updateIntervalStopsContinuousUpdates();
+    void readByteBudget();
+    void singleWritePerMessage();
+    void repliesInOneWrite();
+    void pointerCoalescing();
+    void fastReconnect();
+    void statistics();
+    void openH264();
+    void lazyFramebuffer();
+    void tightGradientRgb565();
+    void zrleTiles();
+};
+
+using namespace QVncTest;
+
+namespace {
+
+QByteArray fence(quint32 flags, const QByteArray &payload)
+{
+    return QByteArray("\xf8\x00\x00\x00", 4) + u32(flags) + char(payload.size()) + payload;
+}
+
+// The encodings in the SetEncodings message the handshake ends with
+QList<qint32> announcedEncodings(const QByteArray &init)
+{
+    const int at = 12 + 1 + 1 + 20; // version, security type, ClientInit, SetPixelFormat
+    QList<qint32> encodings;
+    if (init.size() < at + 4 || init.at(at) != '\x02')
+        return encodings;
+    const int count = qFromBigEndian<quint16>(init.constData() + at + 2);
+    for (int i = 0; i < count; i++)
+        encodings.append(qFromBigEndian<qint32>(init.constData() + at + 4 + 4 * i));
+    return encodings;
+}
+
+// ZRLE subencodings, see zrleTile()
+enum ZrleTile { RawTile, SolidTile, PackedPaletteTile, PlainRleTile, PaletteRleTile };
+
+// Pixels a tile of \a kind can hold, at \a x, \a y of the framebuffer and
+// \a i of the tile
+QRgb zrlePixel(ZrleTile kind, int x, int y, int i)
+{
+    const QRgb colours[] = { qRgb(0xff, 0, 0), qRgb(0, 0xff, 0), qRgb(0, 0, 0xff), qRgb(0x10, 0x20, 0x30) };
+    switch (kind) {
+    case RawTile:
+        return qRgb(x * 5 & 0xff, y * 3 & 0xff, (x ^ y) & 0xff);
+    case SolidTile:
+        return qRgb(0x40, 0x80, 0xc0);
+    case PackedPaletteTile:
+        return colours[(x + y) % 4];
+    case PlainRleTile:
+        // Runs longer than 255, of 37, and wrapping from row to row
+        return i < 600 ? qRgb(1, 2, 3) : qRgb((i - 600) / 37 * 11 & 0xff, 0x20, 0x30);
+    case PaletteRleTile:
+        // Runs of 13 and single pixels
+        return i % 17 == 0 ? colours[3] : colours[i / 13 % 3];
+    }
+    return 0;
+}
+
+QByteArray cpixel(QRgb rgb)
+{
+    return QByteArray(1, char(qBlue(rgb))) + char(qGreen(rgb)) + char(qRed(rgb));
+}
+
+QByteArray runLength(int length)
+{
+    QByteArray out;
+    for (length -= 1; length >= 255; length -= 255)
+        out.append(char(255));
+    return out.append(char(length));
+}
+
+// \a tile of \a image as a ZRLE tile of \a kind
+QByteArray zrleTile(const QImage &image, const QRect &tile, ZrleTile kind)
+{
+    QList<QRgb> pixels;
+    QList<QRgb> palette;
+    for (int y = tile.top(); y <= tile.bottom(); y++) {
+        for (int x = tile.left(); x <= tile.right(); x++) {
+            pixels.append(image.pixel(x, y));
+            if (!palette.contains(pixels.last()))
+                palette.append(pixels.last());
+        }
+    }
+    // Runs as (index in palette, length)
+    QList<std::pair<int, int>> runs;
+    for (const QRgb pixel : std::as_const(pixels)) {
+        const int index = palette.indexOf(pixel);
+        if (!runs.isEmpty() && runs.last().first == index)
+            ++runs.last().second;
+        else
+            runs.append(std::make_pair(index, 1));
+    }
+
+    QByteArray out;
+    switch (kind) {
+    case RawTile:
+        out.append('\0');
+        for (const QRgb pixel : std::as_const(pixels))
+            out += cpixel(pixel);
+        break;
+    case SolidTile:
+        out.append('\1') += cpixel(pixels.first());
+        break;
+    case PackedPaletteTile: {
+        out.append(char(palette.size()));
+        for (const QRgb colour : std::as_const(palette))
+            out += cpixel(colour);
+        const int bits = palette.size() == 2 ? 1 : palette.size() <= 4 ? 2 : 4;
+        for (int y = 0; y < tile.height(); y++) {
+            // Rows start on a byte, indexes fill bytes from the top bit
+            QByteArray row((tile.width() * bits + 7) / 8, '\0');
+            for (int x = 0; x < tile.width(); x++) {
+                const int bit = x * bits;
+                const int index = palette.indexOf(pixels.at(y * tile.width() + x));
+                row[bit / 8] = char(row.at(bit / 8) | index << (8 - bits - bit % 8));
+            }
+            out += row;
+        }
+        break;
+    }
+    case PlainRleTile:
+        out.append(char(128));
+        for (const auto &run : std::as_const(runs))
+            out += cpixel(palette.at(run.first)) + runLength(run.second);
+        break;
+    case PaletteRleTile:
+        out.append(char(128 + palette.size()));
+        for (const QRgb colour : std::as_const(palette))
+            out += cpixel(colour);
+        for (const auto &run : std::as_const(runs)) {
+            if (run.second == 1)
+                out.append(char(run.first));
+            else
+                out.append(char(run.first | 128)) += runLength(run.second);
+        }
+        break;
+    }
+    return out;
+}
+
+const QByteArray endOfContinuousUpdates("\x96", 1);
+const QByteArray incrementalRequest = QByteArray("\x03\x01", 2) + rect(0, 0, 4, 2);
+const QByteArray fullRequest = QByteArray("\x03\x00", 2) + rect(0, 0, 4, 2);
+const QByteArray enableContinuous = QByteArray("\x96\x01", 2) + rect(0, 0, 4, 2);
+const QByteArray disableContinuous = QByteArray("\x96\x00", 2) + rect(0, 0, 4, 2);
+
+} // namespace
+
+void tst_qvncclientprotocol::requestDriven()
+{
+    Session session;
+    QSignalSpy updated(&session.client, &QVncClient::framebufferUpdated);
+    const QByteArray reply = session.exchange(rawUpdate(QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(updated.size(), 1);
+    QCOMPARE(reply, incrementalRequest);
+    QCOMPARE(session.client.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+}
+
+void tst_qvncclientprotocol::continuousUpdates()
+{
+    Session session;
+    QVERIFY(session.exchange(endOfContinuousUpdates).isEmpty());
+    const QByteArray reply = session.exchange(fence(0x80000000u, "x"));
+    QVERIFY(reply.contains(enableContinuous));
+
+    // Updates are no longer answered with requests
+    QSignalSpy updated(&session.client, &QVncClient::framebufferUpdated);
+    for (int i = 0; i < 3; i++)
+        QVERIFY(session.exchange(rawUpdate(QByteArray(4, char(i)))).isEmpty());
+    QCOMPARE(updated.size(), 3);
+}
+
+void tst_qvncclientprotocol::continuousUpdatesNeedFence()
+{
+    Session session;
+    QVERIFY(session.exchange(endOfContinuousUpdates).isEmpty());
+    QCOMPARE(session.exchange(rawUpdate(QByteArray(4, '\0'))), incrementalRequest);
+}
+
+void tst_qvncclientprotocol::fenceResponse()
+{
+    Session session;
+    // The request bit is cleared, known flags and the payload come back
+    const quint32 flags = 0x80000000u | 0x7 | 0x100;
+    QCOMPARE(session.exchange(fence(flags, "abc")), fence(0x7, "abc"));
+    // Responses need no answer
+    QVERIFY(session.exchange(fence(0x1, "abc")).isEmpty());
+}
+
+void tst_qvncclientprotocol::continuousPixelFormatSwitch()
+{
+    Session session;
+    session.exchange(endOfContinuousUpdates + fence(0x80000000u, QByteArray()));
+
+    session.client.setPixelFormatPreference(QVncClient::PixelFormatRgb565);
+    const QByteArray reply = session.socket.written();
+    session.socket.clearWritten();
+    // The fence comes first, so that its response marks the switch
+    QCOMPARE(quint8(reply.at(0)), quint8(248));
+    const quint32 flags = qFromBigEndian<quint32>(reply.constData() + 4);
+    QVERIFY(flags & 0x80000000u);
+    QVERIFY(flags & 0x4); // SyncNext
+    const QByteArray payload = reply.mid(9, reply.at(8));
+    const QByteArray setPixelFormat = reply.mid(9 + payload.size());
+    QCOMPARE(setPixelFormat.size(), 20);
+    QCOMPARE(setPixelFormat.at(0), '\0');
+    QCOMPARE(setPixelFormat.at(4), char(16)); // bits per pixel
+
+    // Updates sent before the server applied the new format, the response,
+    // and updates in the new format, all in one read
+    QList<QRgb> pixels;
+    connect(&session.client, &QVncClient::framebufferUpdated, this, [&]() {
+        pixels.append(session.client.image().pixel(0, 0));
+    });
+    const QByteArray answer = session.exchange(rawUpdate(QByteArray("\x00\x00\xff\x00", 4))
+                                               + fence(0x4, payload)
+                                               + rawUpdate(QByteArray("\x1f\x00", 2)));
+    // Then a full refresh in the new one
+    QCOMPARE(answer, fullRequest);
+    QCOMPARE(pixels, QList<QRgb>({ qRgb(255, 0, 0), qRgb(0, 0, 255) }));
+}
+
+void tst_qvncclientprotocol::fenceBlockBefore()
+{
+    Session session;
+    session.client.setDecodeThreadCount(2);
+    QSignalSpy updated(&session.client, &QVncClient::framebufferUpdated);
+
+    // The update is decoded on a worker; the response waits for it
+    const QByteArray reply = session.exchange(rawUpdate(QByteArray("\x30\x20\x10\x00", 4))
+                                              + fence(0x80000001u, "b"));
+    QCOMPARE(updated.size(), 1);
+    QCOMPARE(session.client.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+    QVERIFY(reply.endsWith(fence(0x1, "b")));
+}
+
+void tst_qvncclientprotocol::continuousUpdatesWithDecodeThreads()
+{
+    Session session;
+    session.client.setDecodeThreadCount(2);
+    session.exchange(endOfContinuousUpdates + fence(0x80000000u, QByteArray()));
+
+    // Each update is reported on its own, with only its own pixels written
+    QList<QRegion> regions;
+    QList<QRgb> right;
+    connect(&session.client, &QVncClient::imageRegionChanged, this, [&](const QRegion &region) {
+        regions.append(region);
+        right.append(session.client.image().pixel(3, 1));
+    });
+    session.exchange(squareUpdate(0, QByteArray(4, '\x10')) + squareUpdate(2, QByteArray(4, '\x20')));
+    QTRY_COMPARE(regions.size(), 2);
+    QCOMPARE(regions.at(0), QRegion(0, 0, 2, 2));
+    QCOMPARE(regions.at(1), QRegion(2, 0, 2, 2));
+    QCOMPARE(right.at(0), qRgb(255, 255, 255));
+    QCOMPARE(right.at(1), qRgb(0x20, 0x20, 0x20));
+}
+
+void tst_qvncclientprotocol::disableContinuousUpdates()
+{
+    Session session;
+    session.exchange(endOfContinuousUpdates + fence(0x80000000u, QByteArray()));
+
+    session.client.setFramebufferUpdatesEnabled(false);
+    QCOMPARE(session.socket.written(), disableContinuous);
+    session.socket.clearWritten();
+    // Updates already on their way, then the acknowledgement
+    QVERIFY(session.exchange(rawUpdate(QByteArray(4, '\0'))).isEmpty());
+    QVERIFY(session.exchange(endOfContinuousUpdates).isEmpty());
+
+    session.client.setFramebufferUpdatesEnabled(true);
+    const QByteArray reply = session.socket.written();
+    QVERIFY(reply.startsWith(fullRequest));
+    QVERIFY(reply.contains(enableContinuous));
+}
+
+void tst_qvncclientprotocol::explicitLevels()
+{
+    Session session;
+    QSignalSpy qualityChanged(&session.client, &QVncClient::qualityLevelChanged);
+
+    session.client.setQualityLevel(3);
+    QCOMPARE(qualityChanged.size(), 1);
+    QCOMPARE(session.client.qualityLevel(), 3);
+    QByteArray reply = session.socket.written();
+    session.socket.clearWritten();
+    QCOMPARE(reply.at(0), '\x02'); // SetEncodings
+    QVERIFY(reply.contains(u32(quint32(-32 + 3))));
+
+    // Nothing changed, nothing to send
+    session.client.setQualityLevel(3);
+    QVERIFY(session.socket.written().isEmpty());
+
+    session.client.setCompressionLevel(42);
+    QCOMPARE(session.client.compressionLevel(), 9);
+    QVERIFY(session.socket.written().contains(u32(quint32(-256 + 9))));
+    session.socket.clearWritten();
+
+    // Back to automatic
+    session.client.setQualityLevel(-5);
+    QCOMPARE(session.client.qualityLevel(), -1);
+    QVERIFY(!session.socket.written().contains(u32(quint32(-32 + 3))));
+}
+
+void tst_qvncclientprotocol::damagePerUpdate()
+{
+    Session session;
+    QSignalSpy rects(&session.client, &QVncClient::imageChanged);
+    QSignalSpy regions(&session.client, &QVncClient::imageRegionChanged);
+    bool regionFirst = false;
+    connect(&session.client, &QVncClient::framebufferUpdated, this, [&]() {
+        regionFirst = regions.size() == 1;
+    });
+
+    // Two rows as separate Raw rectangles, then a cursor shape
+    const QByteArray row = QByteArray(4, '\x40').repeated(4);
+    const QByteArray update = QByteArray("\x00\x00", 2) + u16(3)
+            + rect(0, 0, 4, 1) + u32(0) + row
+            + rect(0, 1, 4, 1) + u32(0) + row
+            + rect(0, 0, 1, 1) + u32(quint32(-239)) + QByteArray(4, '\0') + QByteArray(1, '\x80');
+    session.exchange(update);
+    QCOMPARE(rects.size(), 2);
+    QCOMPARE(regions.size(), 1);
+    QVERIFY(regionFirst);
+    QCOMPARE(regions.first().first().value<QRegion>(), QRegion(0, 0, 4, 2));
+
+    // Nothing drawn, nothing to report
+    session.exchange(QByteArray("\x00\x00", 2) + u16(0));
+    QCOMPARE(regions.size(), 1);
+}
+
+void tst_qvncclientprotocol::cursorCache()
+{
+    Session session;
+    QSignalSpy changed(&session.client, &QVncClient::cursorChanged);
+    const auto cursorUpdate = [](int hotX, const QByteArray &pixels, char mask) {
+        return QByteArray("\x00\x00", 2) + u16(1) + rect(hotX, 0, 2, 1) + u32(quint32(-239))
+                + pixels + QByteArray(1, mask);
+    };
+    const QByteArray arrow = cursorUpdate(0, QByteArray("\x00\x00\xff\x00\x00\xff\x00\x00", 8), '\x80');
+    const QByteArray busy = cursorUpdate(0, QByteArray("\xff\x00\x00\x00\xff\x00\x00\x00", 8), '\xc0');
+
+    session.exchange(arrow);
+    QCOMPARE(changed.size(), 1);
+    const QImage arrowImage = session.client.cursorImage();
+    QCOMPARE(arrowImage.size(), QSize(2, 1));
+    QCOMPARE(arrowImage.pixel(0, 0), qRgb(0xff, 0, 0));
+    QCOMPARE(qAlpha(arrowImage.pixel(1, 0)), 0);
+
+    // The same shape again is not a change
+    session.exchange(arrow);
+    QCOMPARE(changed.size(), 1);
+
+    // A new hotspot is, with the same image
+    session.exchange(cursorUpdate(1, QByteArray("\x00\x00\xff\x00\x00\xff\x00\x00", 8), '\x80'));
+    QCOMPARE(changed.size(), 2);
+    QCOMPARE(session.client.cursorHotspot(), QPoint(1, 0));
+    QCOMPARE(session.client.cursorImage().cacheKey(), arrowImage.cacheKey());
+
+    // Toggling back comes from the cache instead of being decoded again
+    session.exchange(busy);
+    QCOMPARE(changed.size(), 3);
+    QCOMPARE(session.client.cursorImage().pixel(1, 0), qRgb(0, 0, 0xff));
+    session.exchange(arrow);
+    QCOMPARE(changed.size(), 4);
+    QCOMPARE(session.client.cursorHotspot(), QPoint(0, 0));
+    QCOMPARE(session.client.cursorImage().cacheKey(), arrowImage.cacheKey());
+
+    // Hidden cursor
+    const QByteArray hidden = QByteArray("\x00\x00", 2) + u16(1) + rect(0, 0, 0, 0) + u32(quint32(-239));
+    session.exchange(hidden);
+    QCOMPARE(changed.size(), 5);
+    QVERIFY(session.client.cursorImage().isNull());
+    session.exchange(hidden);
+    QCOMPARE(changed.size(), 5);
+}
+
+void tst_qvncclientprotocol::imageView()
+{
+    Session session;
+    const uchar *bits = session.client.framebufferBits();
+    QVERIFY(bits);
+    QCOMPARE(session.client.framebufferBytesPerLine(), 16);
+    QCOMPARE(session.client.framebufferFormat(), QImage::Format_RGB32);
+
+    // A kept view follows the framebuffer instead of pinning a copy of it
+    const QImage view = session.client.imageView();
+    QCOMPARE(view.constBits(), bits);
+    session.exchange(rawUpdate(QByteArray("\x30\x20\x10\x00", 4)));
+    QCOMPARE(session.client.framebufferBits(), bits);
+    QCOMPARE(view.pixel(2, 1), qRgb(0x10, 0x20, 0x30));
+
+    // A kept image() keeps its contents, so the client moves to a new buffer
+    const QImage snapshot = session.client.image();
+    session.exchange(rawUpdate(QByteArray(4, '\0')));
+    QCOMPARE(snapshot.pixel(2, 1), qRgb(0x10, 0x20, 0x30));
+    QVERIFY(session.client.framebufferBits() != bits);
+    QCOMPARE(session.client.imageView().pixel(2, 1), qRgb(0, 0, 0));
+}
+
+void tst_qvncclientprotocol::bufferedFrames()
+{
+    Session session;
+    session.client.setBufferingMode(QVncClient::TripleBuffered);
+    const QImage initial = session.client.frame();
+    QCOMPARE(initial, session.client.image());
+
+    // Half an update is in the framebuffer, but not in the frame
+    const QByteArray row = QByteArray("\x30\x20\x10\x00", 4).repeated(4);
+    session.exchange(QByteArray("\x00\x00", 2) + u16(2) + rect(0, 0, 4, 1) + u32(0) + row);
+    QCOMPARE(session.client.image().pixel(0, 0), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(session.client.frame(), initial);
+
+    session.exchange(rect(0, 1, 4, 1) + u32(0) + row);
+    QCOMPARE(session.client.frame(), session.client.image());
+    QCOMPARE(initial.pixel(0, 0), qRgb(255, 255, 255));
+
+    session.client.setBufferingMode(QVncClient::SingleBuffered);
+    QCOMPARE(session.client.frame().constBits(), session.client.framebufferBits());
+}
+
+void tst_qvncclientprotocol::viewport()
+{
+    Session session;
+    QSignalSpy changed(&session.client, &QVncClient::viewportChanged);
+    // The request for the whole framebuffer is answered first
+    session.client.setViewport(QRect(1, 0, 2, 2));
+    QCOMPARE(changed.size(), 1);
+    QVERIFY(session.socket.written().isEmpty());
+    QCOMPARE(session.exchange(rawUpdate(QByteArray(4, '\0'))),
+             QByteArray("\x03\x00", 2) + rect(1, 0, 2, 2));
+    QCOMPARE(session.exchange(QByteArray("\x00\x00", 2) + u16(0)),
+             QByteArray("\x03\x01", 2) + rect(1, 0, 2, 2));
+
+    // Outside the framebuffer, all of it is requested
+    session.client.setViewport(QRect(10, 10, 2, 2));
+    QCOMPARE(session.exchange(QByteArray("\x00\x00", 2) + u16(0)), fullRequest);
+    QCOMPARE(session.exchange(QByteArray("\x00\x00", 2) + u16(0)), incrementalRequest);
+}
+
+void tst_qvncclientprotocol::continuousViewport()
+{
+    Session session;
+    session.exchange(endOfContinuousUpdates);
+    QVERIFY(session.exchange(fence(0x80000000u, "x")).contains(enableContinuous));
+
+    // The server learns the new area right away
+    session.client.setViewport(QRect(0, 1, 4, 1));
+    QCOMPARE(session.socket.written(), QByteArray("\x96\x01", 2) + rect(0, 1, 4, 1)
+             + QByteArray("\x03\x00", 2) + rect(0, 1, 4, 1));
+}
+
+void tst_qvncclientprotocol::desktopSize()
+{
+    Session session;
+    QSignalSpy resized(&session.client, &QVncClient::framebufferSizeChanged);
+    QSignalSpy regions(&session.client, &QVncClient::imageRegionChanged);
+    const QByteArray update = QByteArray("\x00\x00", 2) + u16(2)
+            + rect(0, 0, 2, 1) + u32(quint32(-223))
+            + rect(0, 0, 1, 1) + u32(0) + QByteArray("\x30\x20\x10\x00", 4);
+    QCOMPARE(session.exchange(update), QByteArray("\x03\x00", 2) + rect(0, 0, 2, 1));
+    QCOMPARE(resized.size(), 1);
+    QCOMPARE(resized.first().at(0).toInt(), 2);
+    QCOMPARE(resized.first().at(1).toInt(), 1);
+    QCOMPARE(session.client.image().size(), QSize(2, 1));
+    QCOMPARE(session.client.image().pixel(0, 0), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(regions.size(), 1);
+    QCOMPARE(regions.first().first().value<QRegion>(), QRegion(0, 0, 2, 1));
+}
+
+void tst_qvncclientprotocol::desktopSizeKeepsPixels()
+{
+    Session session;
+    session.exchange(rawUpdate(QByteArray("\x30\x20\x10\x00", 4)));
+    const uchar *bits = session.client.framebufferBits();
+    const auto desktopSize = [](int w, int h) {
+        return QByteArray("\x00\x00", 2) + u16(1) + rect(0, 0, w, h) + u32(quint32(-223));
+    };
+
+    // Smaller: the same memory, and the pixels it still covers
+    QCOMPARE(session.exchange(desktopSize(2, 1)), QByteArray("\x03\x00", 2) + rect(0, 0, 2, 1));
+    QCOMPARE(session.client.image().size(), QSize(2, 1));
+    QCOMPARE(session.client.framebufferBits(), bits);
+    QCOMPARE(session.client.image().pixel(1, 0), qRgb(0x10, 0x20, 0x30));
+
+    // Back to the old size: still the same memory, what was cut off is white
+    QCOMPARE(session.exchange(desktopSize(4, 2)), fullRequest);
+    QCOMPARE(session.client.framebufferBits(), bits);
+    QCOMPARE(session.client.image().pixel(1, 0), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(session.client.image().pixel(3, 1), qRgb(0xff, 0xff, 0xff));
+
+    // Larger than the allocation, or while a copy is held: new memory, same pixels
+    const QImage held = session.client.image();
+    QCOMPARE(session.exchange(desktopSize(3, 1)), QByteArray("\x03\x00", 2) + rect(0, 0, 3, 1));
+    QVERIFY(session.client.framebufferBits() != held.constBits());
+    QCOMPARE(session.client.image().pixel(1, 0), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(held.size(), QSize(4, 2));
+    session.exchange(desktopSize(16, 4));
+    QCOMPARE(session.client.image().size(), QSize(16, 4));
+    QCOMPARE(session.client.image().pixel(0, 0), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(session.client.image().pixel(15, 3), qRgb(0xff, 0xff, 0xff));
+}
+
+void tst_qvncclientprotocol::extendedDesktopSize()
+{
+    Session session;
+    QCOMPARE(session.client.screens().size(), 1);
+    QCOMPARE(session.client.screens().first().geometry, QRect(0, 0, 4, 2));
+
+    QSignalSpy screensChanged(&session.client, &QVncClient::screensChanged);
+    QSignalSpy resized(&session.client, &QVncClient::framebufferSizeChanged);
+    const QByteArray screens = QByteArray("\x02\x00\x00\x00", 4)
+            + u32(1) + rect(0, 0, 3, 2) + u32(0)
+            + u32(2) + rect(3, 0, 3, 2) + u32(0);
+    const QByteArray update = QByteArray("\x00\x00", 2) + u16(1)
+            + rect(0, 0, 6, 2) + u32(quint32(-308)) + screens;
+    // The layout is only handled once complete
+    QVERIFY(session.exchange(update.left(update.size() - 8)).isEmpty());
+    QCOMPARE(screensChanged.size(), 0);
+    QCOMPARE(session.exchange(update.mid(update.size() - 8)), QByteArray("\x03\x00", 2) + rect(0, 0, 6, 2));
+    QCOMPARE(resized.size(), 1);
+    QCOMPARE(screensChanged.size(), 1);
+    const QList<QVncScreen> layout = session.client.screens();
+    QCOMPARE(layout.size(), 2);
+    QCOMPARE(layout.at(0).id, 1u);
+    QCOMPARE(layout.at(0).geometry, QRect(0, 0, 3, 2));
+    QCOMPARE(layout.at(1).id, 2u);
+    QCOMPARE(layout.at(1).geometry, QRect(3, 0, 3, 2));
+
+    // The same layout again changes nothing
+    QCOMPARE(session.exchange(update), incrementalRequest.left(2) + rect(0, 0, 6, 2));
+    QCOMPARE(screensChanged.size(), 1);
+
+    // A refused request leaves everything as it is
+    session.exchange(QByteArray("\x00\x00", 2) + u16(1) + rect(1, 3, 8, 8) + u32(quint32(-308))
+                     + QByteArray("\x00\x00\x00\x00", 4));
+    QCOMPARE(session.client.framebufferWidth(), 6);
+    QCOMPARE(screensChanged.size(), 1);
+    QCOMPARE(resized.size(), 1);
+}
+
+void tst_qvncclientprotocol::serverScale()
+{
+    Session session;
+    QSignalSpy changed(&session.client, &QVncClient::serverScaleChanged);
+    session.client.setServerScale(2);
+    QCOMPARE(session.socket.written(), QByteArray("\x08\x02\x00\x00", 4));
+    session.socket.clearWritten();
+    session.client.setServerScale(2);
+    QVERIFY(session.socket.written().isEmpty());
+    session.client.setServerScale(0);
+    QCOMPARE(session.client.serverScale(), 1);
+    QCOMPARE(session.socket.written(), QByteArray("\x08\x01\x00\x00", 4));
+    QCOMPARE(changed.size(), 2);
+
+    // Set before connecting, it is sent with the encodings
+    QVncClient client;
+    client.setServerScale(3);
+    QVncMemorySocket socket;
+    client.setSocket(&socket);
+    socket.feed(handshake());
+    QVERIFY(socket.written().contains(QByteArray("\x08\x03\x00\x00", 4)));
+}
+
+void tst_qvncclientprotocol::updateInterval()
+{
+    Session session;
+    session.client.setUpdateInterval(500);
+    // The next request waits for the interval
+    QVERIFY(session.exchange(rawUpdate(QByteArray(4, '\0'))).isEmpty());
+    QTRY_COMPARE(session.socket.written(), incrementalRequest);
+    session.socket.clearWritten();
+
+    // Without the interval, a waiting request goes out right away
+    session.client.setUpdateInterval(60000);
+    QVERIFY(session.exchange(rawUpdate(QByteArray(4, '\0'))).isEmpty());
+    session.client.setUpdateInterval(0);
+    QCOMPARE(session.socket.written(), incrementalRequest);
+}
+
+void tst_qvncclientprotocol::updateIntervalStopsContinuousUpdates()
+{
+    Session session;
+    session.exchange(endOfContinuousUpdates);
+    QVERIFY(session.exchange(fence(0x80000000u, "x")).contains(enableContinuous));
+    QVERIFY(session.exchange(rawUpdate(QByteArray(4, '\0'))).isEmpty());
+
+    session.client.setUpdateInterval(500);
+    QCOMPARE(session.socket.written(), disableContinuous);
+    session.socket.clearWritten();
+    // Back to requests once the server has stopped sending updates
+    session.exchange(endOfContinuousUpdates);
+    QTRY_COMPARE(session.socket.written(), incrementalRequest);
+}
+
+void tst_qvncclientprotocol::readByteBudget()
+{
+    Session session;
+    QSignalSpy updated(&session.client, &QVncClient::framebufferUpdated);
+    QSignalSpy rects(&session.client, &QVncClient::imageChanged);
+
+    // Without a budget, everything received is handled at once
+    session.socket.feed(rawUpdate(QByteArray(4, '\0')).repeated(3));
+    QCOMPARE(updated.size(), 3);
+
+    // With one, the rest waits for the event loop
+    session.client.setReadByteBudget(1);
+    session.socket.feed(rawUpdate(QByteArray(4, '\0')).repeated(3));
+    QCOMPARE(updated.size(), 4);
+    QTRY_COMPARE(updated.size(), 6);
+
+    // Also between the rectangles of one update
+    rects.clear();
+    const QByteArray row = QByteArray(4, '\x40').repeated(4);
+    session.socket.feed(QByteArray("\x00\x00", 2) + u16(2)
+                        + rect(0, 0, 4, 1) + u32(0) + row
+                        + rect(0, 1, 4, 1) + u32(0) + row);
+    QCOMPARE(rects.size(), 1);
+    QCOMPARE(updated.size(), 6);
+    QTRY_COMPARE(updated.size(), 7);
+    QCOMPARE(rects.size(), 2);
+}
+
+void tst_qvncclientprotocol::singleWritePerMessage()
+{
+    Session session;
+    int writes = session.socket.writeCount();
+    QKeyEvent key(QEvent::KeyPress, Qt::Key_Return, Qt::NoModifier);
+    session.client.handleKeyEvent(&key);
+    QCOMPARE(session.socket.written(), QByteArray("\x04\x01\x00\x00", 4) + u32(0xff0d));
+    QCOMPARE(session.socket.writeCount(), writes + 1);
+    session.socket.clearWritten();
+
+    writes = session.socket.writeCount();
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(3, 1), QPointF(3, 1),
+                      Qt::RightButton, Qt::RightButton, Qt::NoModifier);
+    session.client.handlePointerEvent(&press);
+    QCOMPARE(session.socket.written(), QByteArray("\x05\x04", 2) + u16(3) + u16(1));
+    QCOMPARE(session.socket.writeCount(), writes + 1);
+}
+
+void tst_qvncclientprotocol::repliesInOneWrite()
+{
+    Session session;
+    const int writes = session.socket.writeCount();
+    const QByteArray reply = session.exchange(fence(0x80000000u, "x") + rawUpdate(QByteArray(4, '\0')));
+    QCOMPARE(reply, fence(0, "x") + incrementalRequest);
+    QCOMPARE(session.socket.writeCount(), writes + 1);
+}
+
+void tst_qvncclientprotocol::fastReconnect()
+{
+    Session session;
+    session.exchange(rawUpdate(QByteArray("\x30\x20\x10\x00", 4)));
+    session.client.setFastReconnect(true);
+    QSignalSpy sizes(&session.client, &QVncClient::framebufferSizeChanged);
+
+    // The last picture stays up while reconnecting
+    QVncMemorySocket second;
+    session.client.setSocket(&second);
+    QCOMPARE(sizes.size(), 0);
+    QCOMPARE(session.client.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+
+    // Set-up and the first request leave with ClientInit, in one write
+    second.feed(handshake().left(14));
+    second.clearWritten();
+    const int writes = second.writeCount();
+    second.feed(u32(0));
+    const QByteArray init = second.written();
+    QCOMPARE(second.writeCount(), writes + 1);
+    QVERIFY(init.startsWith(QByteArray("\x01\x00", 2))); // ClientInit, SetPixelFormat
+    QCOMPARE(init.at(21), '\x02');                           // SetEncodings
+    QVERIFY(init.endsWith(fullRequest));
+
+    // Same server: ServerInit needs no answer
+    second.clearWritten();
+    second.feed(handshake().mid(18));
+    QVERIFY(second.written().isEmpty());
+    QCOMPARE(sizes.size(), 0);
+    second.feed(rawUpdate(QByteArray("\x00\x00\x00\x00", 4)));
+    QCOMPARE(second.written(), incrementalRequest);
+    QCOMPARE(session.client.image().pixel(3, 1), qRgb(0, 0, 0));
+
+    // A server of another size gets a full refresh after the first update
+    QVncMemorySocket third;
+    session.client.setSocket(&third);
+    third.feed(handshake(2));
+    QCOMPARE(sizes.size(), 1);
+    QCOMPARE(session.client.framebufferWidth(), 2);
+    third.clearWritten();
+    third.feed(QByteArray("\x00\x00", 2) + u16(0));
+    QCOMPARE(third.written(), QByteArray("\x03\x00", 2) + rect(0, 0, 2, 2));
+
+    // Without fast reconnects the framebuffer goes with the connection
+    session.client.setFastReconnect(false);
+    QVncMemorySocket fourth;
+    session.client.setSocket(&fourth);
+    QCOMPARE(sizes.size(), 2);
+    QVERIFY(session.client.image().isNull());
+}
+
+void tst_qvncclientprotocol::pointerCoalescing()
+{
+    Session session;
+    const auto pointer = [&session](QEvent::Type type, int x, Qt::MouseButton button, Qt::MouseButtons buttons) {
+        QMouseEvent event(type, QPointF(x, 1), QPointF(x, 1), button, buttons, Qt::NoModifier);
+        session.client.handlePointerEvent(&event);
+    };
+    const auto message = [](char buttonMask, int x) {
+        return QByteArray("\x05", 1) + buttonMask + u16(x) + u16(1);
+    };
+    session.client.setPointerEventInterval(60000);
+
+    // The first move goes out, the ones after it wait for the interval
+    pointer(QEvent::MouseMove, 1, Qt::NoButton, Qt::NoButton);
+    pointer(QEvent::MouseMove, 2, Qt::NoButton, Qt::NoButton);
+    pointer(QEvent::MouseMove, 3, Qt::NoButton, Qt::NoButton);
+    QCOMPARE(session.socket.written(), message(0, 1));
+    session.socket.clearWritten();
+
+    // Button changes are sent right away and replace a waiting move
+    pointer(QEvent::MouseButtonPress, 4, Qt::LeftButton, Qt::LeftButton);
+    pointer(QEvent::MouseMove, 5, Qt::NoButton, Qt::LeftButton);
+    pointer(QEvent::MouseButtonRelease, 6, Qt::LeftButton, Qt::NoButton);
+    QCOMPARE(session.socket.written(), message(1, 4) + message(0, 6));
+    session.socket.clearWritten();
+
+    // A key event takes the waiting move along, in the same write
+    pointer(QEvent::MouseMove, 7, Qt::NoButton, Qt::NoButton);
+    const int writes = session.socket.writeCount();
+    QKeyEvent key(QEvent::KeyPress, Qt::Key_Return, Qt::NoModifier);
+    session.client.handleKeyEvent(&key);
+    QCOMPARE(session.socket.written(), message(0, 7) + QByteArray("\x04\x01\x00\x00", 4) + u32(0xff0d));
+    QCOMPARE(session.socket.writeCount(), writes + 1);
+    session.socket.clearWritten();
+
+    // Once the interval has passed, the last move is sent
+    session.client.setPointerEventInterval(50);
+    pointer(QEvent::MouseMove, 8, Qt::NoButton, Qt::NoButton);
+    pointer(QEvent::MouseMove, 9, Qt::NoButton, Qt::NoButton);
+    QVERIFY(session.socket.written().isEmpty());
+    QTRY_COMPARE(session.socket.written(), message(0, 9));
+}
+
+void tst_qvncclientprotocol::statistics()
+{
+    Session session;
+    QVncStatistics stats = session.client.statistics();
+    QCOMPARE(stats.bytesReceived, handshake().size());
+    QCOMPARE(stats.updates, 0);
+    QCOMPARE(stats.roundTripNsecs, -1);
+
+    // The answer to the first, full request
+    const QByteArray update = rawUpdate(QByteArray(4, '\0'));
+    session.exchange(update);
+    stats = session.client.statistics();
+    QCOMPARE(stats.updates, 1);
+    QCOMPARE(stats.encodings.size(), 1);
+    const QVncEncodingStatistics raw = stats.encodings.value(0);
+    QCOMPARE(raw.rects, 1);
+    QCOMPARE(raw.pixels, 8);
+    QCOMPARE(raw.bytes, update.size() - 4); // without the message header
+    QCOMPARE(stats.updateLatencySamples, 1);
+    QVERIFY(stats.lastUpdateLatencyNsecs >= 0);
+    QVERIFY(stats.roundTripNsecs >= 0);
+    QCOMPARE(stats.minRoundTripNsecs, stats.roundTripNsecs);
+    QCOMPARE(stats.queueDelaySamples, 1);
+
+    // Pseudo-encodings count rectangles but no pixels
+    session.exchange(QByteArray("\x00\x00", 2) + u16(1) + rect(1, 1, 0, 0) + u32(quint32(-232)));
+    stats = session.client.statistics();
+    QCOMPARE(stats.updates, 2);
+    QCOMPARE(stats.encodings.value(-232).rects, 1);
+    QCOMPARE(stats.encodings.value(-232).pixels, 0);
+    QCOMPARE(stats.encodings.value(-232).bytes, 12);
+    QCOMPARE(stats.queueDelaySamples, 1);
+
+    session.client.resetStatistics();
+    stats = session.client.statistics();
+    QCOMPARE(stats.bytesReceived, 0);
+    QCOMPARE(stats.updates, 0);
+    QVERIFY(stats.encodings.isEmpty());
+}
+
+void tst_qvncclientprotocol::openH264()
+{
+    QVncClient client;
+    QVncMemorySocket socket;
+    client.setSocket(&socket);
+    socket.feed(handshake());
+
+    // Announced only with a decoder to use it
+    const QList<qint32> encodings = announcedEncodings(socket.written());
+    QVERIFY(!encodings.isEmpty());
+    QCOMPARE(encodings.contains(50), QVncH264Decoder::isAvailable());
+    socket.clearWritten();
+
+    // A reset without a frame, a frame that does not decode, then Raw:
+    // either way the rectangles are consumed and the update completes
+    QSignalSpy updated(&client, &QVncClient::framebufferUpdated);
+    socket.feed(QByteArray("\x00\x00", 2) + u16(3)
+                + rect(0, 0, 4, 2) + u32(50) + u32(0) + u32(2)
+                + rect(0, 0, 4, 2) + u32(50) + u32(3) + u32(1) + QByteArray("\x00\x00\x01", 3)
+                + rect(0, 0, 4, 2) + u32(0) + QByteArray("\x30\x20\x10\x00", 4).repeated(8));
+    QCOMPARE(updated.size(), 1);
+    QCOMPARE(socket.written(), incrementalRequest);
+    QCOMPARE(client.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(client.statistics().encodings.value(50).rects, qint64(2));
+}
+
+void tst_qvncclientprotocol::lazyFramebuffer()
+{
+    QVncClient client;
+    QSignalSpy changed(&client, &QVncClient::lazyFramebufferChanged);
+    client.setLazyFramebuffer(true);
+    QCOMPARE(changed.size(), 1);
+    QVncMemorySocket socket;
+    client.setSocket(&socket);
+    socket.feed(handshake());
+
+    // Black until the server sends something
+    QCOMPARE(client.image().size(), QSize(4, 2));
+    QCOMPARE(client.image().pixel(3, 1), qRgb(0, 0, 0));
+    socket.feed(QByteArray("\x00\x00", 2) + u16(1) + rect(2, 0, 2, 2) + u32(0)
+                + QByteArray("\x30\x20\x10\x00", 4).repeated(4));
+    QCOMPARE(client.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(client.image().pixel(1, 1), qRgb(0, 0, 0));
+
+    // A view of part of it, clipped, pointing into the framebuffer
+    const QImage view = client.imageView(QRect(2, 0, 4, 2));
+    QCOMPARE(view.size(), QSize(2, 2));
+    QCOMPARE(view.constBits(), client.framebufferBits() + 2 * 4);
+    QCOMPARE(view.bytesPerLine(), client.framebufferBytesPerLine());
+    QCOMPARE(view.pixel(1, 1), qRgb(0x10, 0x20, 0x30));
+    QVERIFY(client.imageView(QRect(4, 0, 2, 2)).isNull());
+
+    // Growing keeps the pixels, the new part is black as well
+    socket.feed(QByteArray("\x00\x00", 2) + u16(1) + rect(0, 0, 6, 2) + u32(quint32(-223)));
+    QCOMPARE(client.image().size(), QSize(6, 2));
+    QCOMPARE(client.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(client.image().pixel(5, 1), qRgb(0, 0, 0));
+}
+
+void tst_qvncclientprotocol::tightGradientRgb565()
+{
+    QVncClient client;
+    client.setPixelFormatPreference(QVncClient::PixelFormatRgb565);
+    QVncMemorySocket socket;
+    client.setSocket(&socket);
+    socket.feed(handshake());
+    if (!announcedEncodings(socket.written()).contains(7))
+        QSKIP("Built without Tight");
+    socket.clearWritten();
+
+    // Channels in 0..31 and 0..63: the prediction is clamped to those and
+    // the sum wraps around them, not at 256
+    auto pixel = [](int r, int g, int b) {
+        const quint16_le value(quint16(r << 11 | g << 5 | b));
+        return QByteArray(reinterpret_cast<const char *>(&value), 2);
+    };
+    const QByteArray errors = pixel(20, 40, 10) + pixel(5, 10, 21)   // predicted 0, then left
+                            + pixel(10, 20, 27)                      // above, blue wraps
+                            + pixel(0, 0, 6);                        // clamped to 31, 63, 26
+    // Basic compression with an explicit filter, gradient; under 12 bytes
+    // so not compressed
+    socket.feed(QByteArray("\x00\x00", 2) + u16(1) + rect(0, 0, 2, 2) + u32(7)
+                + QByteArray("\x40\x02", 2) + errors);
+    QCOMPARE(socket.written(), incrementalRequest);
+
+    auto expected = [](int r, int g, int b) {
+        return qRgb((r * 255 + 15) / 31, (g * 255 + 31) / 63, (b * 255 + 15) / 31);
+    };
+    const QImage image = client.image();
+    QCOMPARE(image.pixel(0, 0), expected(20, 40, 10));
+    QCOMPARE(image.pixel(1, 0), expected(25, 50, 31));
+    QCOMPARE(image.pixel(0, 1), expected(30, 60, 5));
+    QCOMPARE(image.pixel(1, 1), expected(31, 63, 0));
+}
+
+void tst_qvncclientprotocol::zrleTiles()
+{
+    if (!QVncInflater::backend())
+        QSKIP("Built without zlib");
+
+    // 5x4 tiles, the last column and row cut short; every subencoding
+    const int width = 300;
+    const int height = 200;
+    QImage mixed(width, height, QImage::Format_RGB32);
+    QByteArray tiles;
+    for (int ty = 0, i = 0; ty < height; ty += 64) {
+        for (int tx = 0; tx < width; tx += 64, i++) {
+            const QRect tile(tx, ty, qMin(64, width - tx), qMin(64, height - ty));
+            const ZrleTile kind = ZrleTile(i % 5);
+            for (int y = tile.top(); y <= tile.bottom(); y++) {
+                for (int x = tile.left(); x <= tile.right(); x++)
+                    mixed.setPixel(x, y, zrlePixel(kind, x, y, (y - ty) * tile.width() + x - tx));
+            }
+            tiles += zrleTile(mixed, tile, kind);
+        }
+    }
+    // Then runs of single pixels only, which take more than raw pixels
+    QImage noise(width, height, QImage::Format_RGB32);
+    QByteArray runs;
+    for (int ty = 0; ty < height; ty += 64) {
+        for (int tx = 0; tx < width; tx += 64) {
+            const QRect tile(tx, ty, qMin(64, width - tx), qMin(64, height - ty));
+            for (int y = tile.top(); y <= tile.bottom(); y++) {
+                for (int x = tile.left(); x <= tile.right(); x++)
+                    noise.setPixel(x, y, qRgb(x & 0xff, y & 0xff, x * y & 0xff));
+            }
+            runs += zrleTile(noise, tile, PlainRleTile);
+        }
+    }
+    QVERIFY(runs.size() > width * height * 3);
+
+    // One stream for both rectangles, as the server sends it
+    QVncDeflater deflater;
+    auto update = [&](const QByteArray &data) {
+        const QByteArray compressed = deflater.compress(data, QVncDeflater::SyncFlush);
+        return QByteArray("\x00\x00", 2) + u16(1) + rect(0, 0, width, height) + u32(16)
+                + u32(compressed.size()) + compressed;
+    };
+    const QByteArray first = update(tiles);
+    const QByteArray second = update(runs);
+
+    // Tile by tile in order, and located first, then decoded in parallel
+    QVncClient clients[2];
+    QVncMemorySocket sockets[2];
+    clients[1].setDecodeThreadCount(4);
+    QSignalSpy updated0(&clients[0], &QVncClient::framebufferUpdated);
+    QSignalSpy updated1(&clients[1], &QVncClient::framebufferUpdated);
+    for (int i = 0; i < 2; i++) {
+        clients[i].setSocket(&sockets[i]);
+        sockets[i].feed(handshake(width, height));
+        sockets[i].feed(first);
+    }
+    QCOMPARE(updated0.size(), 1);
+    QTRY_COMPARE(updated1.size(), 1);
+    QCOMPARE(clients[0].image().convertToFormat(QImage::Format_RGB32), mixed);
+    QCOMPARE(clients[1].image().convertToFormat(QImage::Format_RGB32), mixed);
+
+    for (int i = 0; i < 2; i++)
+        sockets[i].feed(second);
+    QCOMPARE(updated0.size(), 2);
+    QTRY_COMPARE(updated1.size(), 2);
+    QCOMPARE(clients[0].image().convertToFormat(QImage::Format_RGB32), noise);
+    QCOMPARE(clients[1].image().convertToFormat(QImage::Format_RGB32), noise);
+}
+
+QTEST_MAIN(tst_qvncclientprotocol)
+#include "tst_qvncclientprotocol.moc"
@@ -0,0 +1,73 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvnccursorcache_p.h>
+
+class tst_qvnccursorcache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void keys();
+    void findAndInsert();
+    void leastRecentlyUsedFirst();
+};
+
+static QImage shape(int size, QRgb color)
+{
+    QImage image(size, size, QImage::Format_ARGB32);
+    image.fill(color);
+    return image;
+}
+
+void tst_qvnccursorcache::keys()
+{
+    const uchar bytes[] = { 1, 2, 3, 4, 5, 6 };
+    QCOMPARE(QVncCursorCache::key(2, 1, bytes, 6), QVncCursorCache::key(2, 1, bytes, 6));
+    // The same bytes in another shape are another cursor
+    QVERIFY(QVncCursorCache::key(2, 1, bytes, 6) != QVncCursorCache::key(1, 2, bytes, 6));
+    QVERIFY(QVncCursorCache::key(2, 1, bytes, 6) != QVncCursorCache::key(2, 1, bytes, 5));
+}
+
+void tst_qvnccursorcache::findAndInsert()
+{
+    QVncCursorCache cache;
+    const uchar bytes[] = { 1, 2, 3, 4 };
+    const QByteArray key = QVncCursorCache::key(1, 1, bytes, 4);
+    QVERIFY(cache.find(key).isNull());
+    QCOMPARE(cache.misses(), 1u);
+
+    const QImage image = shape(16, qRgb(1, 2, 3));
+    cache.insert(key, image);
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.find(key).cacheKey(), image.cacheKey());
+    QCOMPARE(cache.hits(), 1u);
+
+    cache.clear();
+    QCOMPARE(cache.count(), 0);
+    QVERIFY(cache.find(key).isNull());
+}
+
+void tst_qvnccursorcache::leastRecentlyUsedFirst()
+{
+    // Room for about two 32x32 shapes
+    QVncCursorCache cache(2 * 32 * 32 * 4 + 256);
+    const uchar a = 'a', b = 'b', c = 'c';
+    const QByteArray arrow = QVncCursorCache::key(32, 32, &a, 1);
+    const QByteArray busy = QVncCursorCache::key(32, 32, &b, 1);
+    const QByteArray text = QVncCursorCache::key(32, 32, &c, 1);
+    cache.insert(arrow, shape(32, qRgb(0xff, 0, 0)));
+    cache.insert(busy, shape(32, qRgb(0, 0xff, 0)));
+
+    // Using the arrow makes the busy cursor the oldest
+    QVERIFY(!cache.find(arrow).isNull());
+    cache.insert(text, shape(32, qRgb(0, 0, 0xff)));
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(cache.find(busy).isNull());
+    QCOMPARE(cache.find(arrow).pixel(0, 0), qRgb(0xff, 0, 0));
+    QCOMPARE(cache.find(text).pixel(0, 0), qRgb(0, 0, 0xff));
+}
+
+QTEST_MAIN(tst_qvnccursorcache)
+#include "tst_qvnccursorcache.moc"
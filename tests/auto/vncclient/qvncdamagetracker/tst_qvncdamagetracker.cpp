@@ -0,0 +1,75 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvncdamagetracker_p.h>
+
+class tst_qvncdamagetracker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void emptyIgnored();
+    void tilesMerge();
+    void overlapMerges();
+    void distantKept();
+    void scatteredCollapse();
+};
+
+void tst_qvncdamagetracker::emptyIgnored()
+{
+    QVncDamageTracker damage;
+    damage.add(QRect());
+    damage.add(QRect(5, 5, 0, 10));
+    QVERIFY(damage.isEmpty());
+    QVERIFY(damage.take().isEmpty());
+}
+
+void tst_qvncdamagetracker::tilesMerge()
+{
+    // Hextile order: 16x16 tiles left to right, top to bottom
+    QVncDamageTracker damage;
+    for (int y = 0; y < 32; y += 16) {
+        for (int x = 0; x < 64; x += 16)
+            damage.add(QRect(x, y, 16, 16));
+    }
+    QCOMPARE(damage.rects(), QList<QRect>({ QRect(0, 0, 64, 32) }));
+    QCOMPARE(damage.take(), QRegion(0, 0, 64, 32));
+    QVERIFY(damage.isEmpty());
+}
+
+void tst_qvncdamagetracker::overlapMerges()
+{
+    QVncDamageTracker damage;
+    damage.add(QRect(0, 0, 10, 10));
+    damage.add(QRect(5, 0, 10, 10));
+    damage.add(QRect(2, 2, 4, 4));
+    QCOMPARE(damage.rects(), QList<QRect>({ QRect(0, 0, 15, 10) }));
+}
+
+void tst_qvncdamagetracker::distantKept()
+{
+    // Two cursors blinking in opposite corners are not one big repaint
+    QVncDamageTracker damage;
+    damage.add(QRect(0, 0, 10, 10));
+    damage.add(QRect(100, 100, 10, 10));
+    QCOMPARE(damage.rects().size(), 2);
+    QCOMPARE(damage.boundingRect(), QRect(0, 0, 110, 110));
+    const QRegion region = damage.take();
+    QCOMPARE(region, QRegion(0, 0, 10, 10) + QRegion(100, 100, 10, 10));
+}
+
+void tst_qvncdamagetracker::scatteredCollapse()
+{
+    QVncDamageTracker damage;
+    for (int i = 0; i < QVncDamageTracker::maxRects; i++)
+        damage.add(QRect(i * 20, (i % 2) * 40, 5, 5));
+    QCOMPARE(damage.rects().size(), QVncDamageTracker::maxRects);
+
+    damage.add(QRect(1000, 0, 5, 5));
+    QCOMPARE(damage.rects(), QList<QRect>({ damage.boundingRect() }));
+    QCOMPARE(damage.boundingRect(), QRect(0, 0, 1005, 45));
+}
+
+QTEST_MAIN(tst_qvncdamagetracker)
+#include "tst_qvncdamagetracker.moc"
@@ -0,0 +1,187 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtVncClient/private/qvncdecodequeue_p.h>
+
+class tst_qvncdecodequeue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void synchronous();
+    void doneCallbacks();
+    void overlapOrder();
+    void parallelFor_data();
+    void parallelFor();
+    void clear();
+    void sharedPool();
+    void fairShare();
+};
+
+void tst_qvncdecodequeue::synchronous()
+{
+    QObject context; // drops queued completions when the test ends
+    QVncDecodeQueue queue(&context);
+    QVERIFY(!queue.isEnabled());
+
+    QList<int> order;
+    queue.start(QRect(0, 0, 4, 4), [&]() { order << 1; }, [&]() { order << 2; });
+    QCOMPARE(order, (QList<int> { 1, 2 }));
+    QVERIFY(queue.isIdle());
+}
+
+void tst_qvncdecodequeue::doneCallbacks()
+{
+    QObject context;
+    QVncDecodeQueue queue(&context);
+    queue.setMaxThreadCount(4);
+    QCOMPARE(queue.maxThreadCount(), 4);
+
+    QAtomicInt jobs;
+    int done = 0;
+    int idle = 0;
+    queue.setIdleHandler([&]() { idle++; });
+    for (int i = 0; i < 16; i++)
+        queue.start(QRect(i * 16, 0, 16, 16), [&]() { jobs.ref(); }, [&]() { done++; });
+
+    // Callbacks are delivered in the context thread
+    QTRY_COMPARE(done, 16);
+    QCOMPARE(jobs.loadRelaxed(), 16);
+    QVERIFY(queue.isIdle());
+    QVERIFY(idle >= 1);
+}
+
+void tst_qvncdecodequeue::overlapOrder()
+{
+    QObject context;
+    QVncDecodeQueue queue(&context);
+    queue.setMaxThreadCount(4);
+
+    QMutex mutex;
+    QList<int> order;
+    auto job = [&](int id, int delay) {
+        return [&, id, delay]() {
+            QThread::msleep(delay);
+            QMutexLocker locker(&mutex);
+            order << id;
+        };
+    };
+
+    // The second job overlaps the first and must not start before it is done
+    queue.start(QRect(0, 0, 16, 16), job(1, 50));
+    queue.start(QRect(8, 8, 16, 16), job(2, 0));
+    queue.waitForDone();
+    QCOMPARE(order, (QList<int> { 1, 2 }));
+}
+
+void tst_qvncdecodequeue::parallelFor_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("synchronous") << 0;
+    QTest::newRow("one") << 1;
+    QTest::newRow("four") << 4;
+}
+
+void tst_qvncdecodequeue::parallelFor()
+{
+    QFETCH(int, threads);
+
+    QObject context;
+    QVncDecodeQueue queue(&context);
+    queue.setMaxThreadCount(threads);
+
+    const int count = 1000;
+    QList<QAtomicInt> calls(count);
+    QAtomicInt *counters = calls.data();
+    queue.parallelFor(count, [counters](int i) { counters[i].ref(); });
+    for (int i = 0; i < count; i++)
+        QCOMPARE(calls.at(i).loadRelaxed(), 1);
+
+    // From inside a job, with the pool possibly busy
+    QAtomicInt nested;
+    for (int j = 0; j < 8; j++)
+        queue.start(QRect(j * 16, 0, 16, 16), [&]() { queue.parallelFor(64, [&](int) { nested.ref(); }); });
+    queue.waitForDone();
+    QCOMPARE(nested.loadRelaxed(), 8 * 64);
+}
+
+void tst_qvncdecodequeue::clear()
+{
+    QObject context;
+    QVncDecodeQueue queue(&context);
+    queue.setMaxThreadCount(2);
+
+    bool done = false;
+    queue.start(QRect(0, 0, 4, 4), []() { QThread::msleep(20); }, [&]() { done = true; });
+    queue.clear();
+    QVERIFY(queue.isIdle());
+    QCoreApplication::processEvents();
+    QVERIFY(!done);
+
+    queue.setMaxThreadCount(0);
+    QVERIFY(!queue.isEnabled());
+}
+
+void tst_qvncdecodequeue::sharedPool()
+{
+    QObject context;
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+    QVncDecodeQueue busy(&context);
+    QVncDecodeQueue other(&context);
+    busy.setSharedPool(&pool);
+    other.setSharedPool(&pool);
+    QVERIFY(other.isEnabled());
+    QCOMPARE(other.maxThreadCount(), 0);
+
+    // Waiting for one queue does not wait for the jobs of another
+    QSemaphore release;
+    busy.start(QRect(0, 0, 4, 4), [&]() { release.acquire(); });
+    bool done = false;
+    other.start(QRect(0, 0, 4, 4), []() {}, [&]() { done = true; });
+    other.waitForDone();
+    QVERIFY(done);
+    QVERIFY(!busy.isIdle());
+    release.release();
+    busy.waitForDone();
+    QVERIFY(busy.isIdle());
+
+    other.setSharedPool(nullptr);
+    QVERIFY(!other.isEnabled());
+}
+
+void tst_qvncdecodequeue::fairShare()
+{
+    QObject context;
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    QVncDecodeQueue busy(&context);
+    QVncDecodeQueue other(&context);
+    busy.setSharedPool(&pool);
+    other.setSharedPool(&pool);
+
+    QSemaphore release;
+    QMutex mutex;
+    QList<int> order;
+    auto record = [&](int id) {
+        return [&, id]() {
+            QMutexLocker locker(&mutex);
+            order << id;
+        };
+    };
+    busy.start(QRect(0, 0, 4, 4), [&]() { release.acquire(); });
+    busy.start(QRect(4, 0, 4, 4), record(1));
+    busy.start(QRect(8, 0, 4, 4), record(2));
+    other.start(QRect(0, 0, 4, 4), record(3));
+    release.release();
+    busy.waitForDone();
+    other.waitForDone();
+    // The first job of the other queue goes ahead of the busy queue's backlog
+    QCOMPARE(order, (QList<int> { 3, 1, 2 }));
+}
+
+QTEST_MAIN(tst_qvncdecodequeue)
+#include "tst_qvncdecodequeue.moc"
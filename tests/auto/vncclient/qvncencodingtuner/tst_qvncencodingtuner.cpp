@@ -0,0 +1,166 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvncencodingtuner_p.h>
+
+class tst_qvncencodingtuner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void smallUpdatesIgnored();
+    void levels_data();
+    void levels();
+    void needsConfirmation();
+    void rawOnFastLinkBusyClient();
+    void alreadyBuffered();
+    void costs();
+};
+
+static constexpr qint64 ms = 1000 * 1000;
+
+// Feeds back-to-back updates of \a bytes, each \a transfer + \a decode
+// nanoseconds long, for \a duration. Each update arrives in a read with
+// its header, then four more spread over \a transfer. Returns how often
+// levels changed.
+static int run(QVncEncodingTuner &tuner, qint64 &now, qint64 bytes, qint64 transfer,
+               qint64 decode, qint64 duration)
+{
+    static qint64 position = 0;
+    int changes = 0;
+    for (const qint64 end = now + duration; now < end;) {
+        const qint64 start = position;
+        tuner.dataReceived(start + 16, now);
+        tuner.updateStarted(start, now);
+        for (int i = 1; i <= 4; i++) {
+            position = start + bytes * i / 4;
+            tuner.dataReceived(position, now + transfer * i / 4);
+        }
+        tuner.addDecodeTime(7, decode, 1000);
+        now += transfer + decode;
+        if (tuner.updateFinished(bytes, position, now))
+            changes++;
+    }
+    return changes;
+}
+
+void tst_qvncencodingtuner::smallUpdatesIgnored()
+{
+    QVncEncodingTuner tuner;
+    qint64 now = 0;
+    QCOMPARE(run(tuner, now, 1024, 100 * ms, 0, 5000 * ms), 0);
+    QCOMPARE(tuner.throughput(), 0.0);
+    QCOMPARE(tuner.levels(), QVncEncodingTuner::Levels());
+}
+
+void tst_qvncencodingtuner::levels_data()
+{
+    QTest::addColumn<qint64>("bytes");
+    QTest::addColumn<int>("transferMs");
+    QTest::addColumn<int>("quality");
+    QTest::addColumn<int>("compression");
+
+    QTest::newRow("modem") << qint64(16 * 1024) << 1000 << 2 << 9;
+    QTest::newRow("dsl") << qint64(96 * 1024) << 1000 << 4 << 7;
+    QTest::newRow("wan") << qint64(50 * 1024) << 100 << 6 << 5;
+    QTest::newRow("office") << qint64(400 * 1024) << 100 << 8 << 2;
+    QTest::newRow("lan") << qint64(5 * 1024 * 1024) << 100 << 9 << 1;
+}
+
+void tst_qvncencodingtuner::levels()
+{
+    QFETCH(qint64, bytes);
+    QFETCH(int, transferMs);
+    QFETCH(int, quality);
+    QFETCH(int, compression);
+
+    QVncEncodingTuner tuner;
+    qint64 now = 0;
+    QCOMPARE(run(tuner, now, bytes, transferMs * ms, 0, 3000 * ms), 1);
+    QCOMPARE(tuner.levels().quality, quality);
+    QCOMPARE(tuner.levels().compression, compression);
+    QVERIFY(!tuner.levels().preferRaw);
+}
+
+void tst_qvncencodingtuner::needsConfirmation()
+{
+    QVncEncodingTuner tuner;
+    qint64 now = 0;
+    // The first window only proposes new levels, the second applies them
+    QCOMPARE(run(tuner, now, 5 * 1024 * 1024, 100 * ms, 0, 1000 * ms), 0);
+    QCOMPARE(tuner.levels(), QVncEncodingTuner::Levels());
+    QVERIFY(tuner.throughput() > 0);
+    QCOMPARE(run(tuner, now, 5 * 1024 * 1024, 100 * ms, 0, 1000 * ms), 1);
+    QCOMPARE(tuner.levels().quality, 9);
+}
+
+void tst_qvncencodingtuner::rawOnFastLinkBusyClient()
+{
+    QVncEncodingTuner tuner;
+    qint64 now = 0;
+    // 1 MiB in 5 ms on the wire, then as long again decoding
+    QVERIFY(run(tuner, now, 1024 * 1024, 5 * ms, 5 * ms, 3000 * ms) > 0);
+    QVERIFY(tuner.levels().preferRaw);
+    // Raw is cheap to decode; that alone is no reason to switch back
+    run(tuner, now, 1024 * 1024, 5 * ms, 0, 3000 * ms);
+    QVERIFY(tuner.levels().preferRaw);
+    // A slow link is
+    run(tuner, now, 64 * 1024, 100 * ms, 0, 5000 * ms);
+    QVERIFY(!tuner.levels().preferRaw);
+}
+
+void tst_qvncencodingtuner::alreadyBuffered()
+{
+    QVncEncodingTuner tuner;
+    // 20 Mbit/s, and a client that takes longer to decode an update than
+    // the link takes to bring it: each read finds what arrived while the
+    // client was busy, and updates are parsed long after they arrived
+    const double rate = 20e6 / 8 / 1e9; // bytes per ns
+    const qint64 bytes = 64 * 1024;
+    const qint64 decode = 30 * ms;
+    qint64 now = 0;
+    qint64 received = 0;
+    qint64 parsed = 0;
+    int changes = 0;
+    while (now < 5000 * ms) {
+        // Parse what is there, reading again when an update is incomplete
+        if (received < parsed + bytes) {
+            now = qMax(now, qint64((parsed + bytes) / rate));
+            received = qint64(now * rate);
+            tuner.dataReceived(received, now);
+        }
+        tuner.updateStarted(parsed, now);
+        tuner.addDecodeTime(7, decode, 1000);
+        now += decode;
+        parsed += bytes;
+        if (received < parsed) {
+            received = qint64(now * rate);
+            tuner.dataReceived(received, now);
+        }
+        if (tuner.updateFinished(bytes, parsed, now))
+            changes++;
+    }
+    QVERIFY(changes > 0);
+    // Measured at the rate of the link, and not fast enough for Raw
+    QVERIFY(tuner.throughput() > 0.8 * rate * 1e9);
+    QVERIFY(tuner.throughput() < 1.05 * rate * 1e9);
+    QCOMPARE(tuner.levels().quality, 8);
+    QVERIFY(!tuner.levels().preferRaw);
+}
+
+void tst_qvncencodingtuner::costs()
+{
+    QVncEncodingTuner tuner;
+    tuner.addDecodeTime(16, 300, 100);
+    tuner.addDecodeTime(16, 100, 0); // call without enough data
+    tuner.addDecodeTime(5, 50, 10);
+    QCOMPARE(tuner.costs().value(16).nsecs, 400);
+    QCOMPARE(tuner.costs().value(16).pixels, 100);
+    QCOMPARE(tuner.costs().value(5).pixels, 10);
+    tuner.reset();
+    QVERIFY(tuner.costs().isEmpty());
+}
+
+QTEST_MAIN(tst_qvncencodingtuner)
+#include "tst_qvncencodingtuner.moc"
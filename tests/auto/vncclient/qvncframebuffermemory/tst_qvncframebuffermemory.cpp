@@ -0,0 +1,88 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvncframebuffermemory_p.h>
+
+class tst_qvncframebuffermemory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void allocate();
+    void invalidSize();
+    void copyWhileShared();
+    void allocatedOnWrite();
+};
+
+void tst_qvncframebuffermemory::allocate()
+{
+    QImage image = QVncFramebufferMemory::allocate(3, 2);
+    QVERIFY(!image.isNull());
+    QCOMPARE(image.size(), QSize(3, 2));
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(image.bytesPerLine(), 12);
+    QVERIFY(image.isDetached());
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 3; x++)
+            QCOMPARE(image.pixel(x, y), qRgb(0, 0, 0));
+    }
+
+    // Written in place
+    const uchar *bits = image.constBits();
+    image.setPixel(2, 1, qRgb(0x10, 0x20, 0x30));
+    QCOMPARE(image.constBits(), bits);
+    QCOMPARE(image.pixel(2, 1), qRgb(0x10, 0x20, 0x30));
+}
+
+void tst_qvncframebuffermemory::invalidSize()
+{
+    QVERIFY(QVncFramebufferMemory::allocate(0, 10).isNull());
+    QVERIFY(QVncFramebufferMemory::allocate(10, -1).isNull());
+    QVERIFY(QVncFramebufferMemory::pageSize() > 0);
+}
+
+void tst_qvncframebuffermemory::copyWhileShared()
+{
+    QImage image = QVncFramebufferMemory::allocate(4, 4);
+    const QImage copy = image;
+    image.setPixel(0, 0, qRgb(255, 0, 0));
+    QCOMPARE(copy.pixel(0, 0), qRgb(0, 0, 0));
+    QCOMPARE(image.pixel(0, 0), qRgb(255, 0, 0));
+}
+
+#ifdef Q_OS_LINUX
+static qint64 residentBytes()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * QVncFramebufferMemory::pageSize() : -1;
+}
+#endif
+
+void tst_qvncframebuffermemory::allocatedOnWrite()
+{
+#ifdef Q_OS_LINUX
+    const qint64 before = residentBytes();
+    QVERIFY(before > 0);
+    // 128 MB, of which one 256x256 tile is written and a few rows read
+    QImage image = QVncFramebufferMemory::allocate(8192, 4096);
+    QVERIFY(!image.isNull());
+    for (int y = 1024; y < 1024 + 256; y++)
+        std::fill_n(reinterpret_cast<QRgb *>(image.scanLine(y)) + 4096, 256, qRgb(1, 2, 3));
+    qint64 sum = 0;
+    for (int y = 0; y < 4096; y += 512)
+        sum += qRed(reinterpret_cast<const QRgb *>(image.constScanLine(y))[8191]);
+    QCOMPARE(sum, 0);
+    QCOMPARE(image.pixel(4096 + 255, 1024 + 255), qRgb(1, 2, 3));
+    QVERIFY2(residentBytes() - before < 16 * 1024 * 1024,
+             qPrintable(QString::number(residentBytes() - before)));
+#else
+    QSKIP("Needs /proc/self/statm");
+#endif
+}
+
+QTEST_MAIN(tst_qvncframebuffermemory)
+#include "tst_qvncframebuffermemory.moc"
@@ -0,0 +1,138 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/QVncFrameRecorder>
+#include <QtVncClient/private/qvncframerecorder_p.h>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+
+#include "../shared/vnctestserver.h"
+
+class tst_qvncframerecorder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void changedRects();
+    void idle();
+    void backpressure();
+    void notARecording();
+
+private:
+    QString fileName() { return m_dir.filePath(QStringLiteral("frames%1").arg(++m_files)); }
+
+    QTemporaryDir m_dir;
+    int m_files = 0;
+};
+
+using QVncTest::squareUpdate;
+using QVncTest::u16;
+
+namespace {
+
+struct Session : QVncTest::Session
+{
+    Session() { recorder.setClient(&client); }
+
+    QVncFrameRecorder recorder;
+};
+
+} // namespace
+
+void tst_qvncframerecorder::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void tst_qvncframerecorder::changedRects()
+{
+    Session session;
+    const QString file = fileName();
+    QVERIFY(session.recorder.open(file));
+    QVERIFY(session.recorder.isOpen());
+    const QImage before = session.client.image();
+    session.socket.feed(squareUpdate(2, QByteArray("\x30\x20\x10\x00", 4)));
+    session.recorder.close();
+    QVERIFY(!session.recorder.isOpen());
+    QCOMPARE(session.recorder.framesWritten(), quint64(2));
+    QCOMPARE(session.recorder.bytesWritten(), QFileInfo(file).size());
+
+    QVncFrameReader reader;
+    QVERIFY2(reader.open(file), qPrintable(reader.errorString()));
+    // The whole framebuffer first, then only what changed
+    QVERIFY(reader.readFrame());
+    QCOMPARE(reader.region(), QRegion(0, 0, 4, 2));
+    QCOMPARE(reader.image(), before);
+    const qint64 first = reader.time();
+    QVERIFY(reader.readFrame());
+    QCOMPARE(reader.region(), QRegion(2, 0, 2, 2));
+    QCOMPARE(reader.image(), session.client.image());
+    QCOMPARE(reader.image().pixel(3, 1), qRgb(0x10, 0x20, 0x30));
+    QVERIFY(reader.time() >= first);
+    QVERIFY(!reader.readFrame());
+    QVERIFY(reader.errorString().isEmpty());
+}
+
+void tst_qvncframerecorder::idle()
+{
+    Session session;
+    const QString file = fileName();
+    QVERIFY(session.recorder.open(file));
+
+    // Updates without rectangles, and no updates at all, cost nothing
+    session.socket.feed(QByteArray("\x00\x00", 2) + u16(0));
+    QTest::qWait(50);
+    session.recorder.close();
+    QCOMPARE(session.recorder.framesWritten(), quint64(1));
+    QCOMPARE(session.recorder.bytesWritten(), QFileInfo(file).size());
+}
+
+void tst_qvncframerecorder::backpressure()
+{
+    Session session;
+    const QString file = fileName();
+    // Nothing fits while the writer is busy, so updates merge until it is idle
+    session.recorder.setMaxQueuedBytes(0);
+    QVERIFY(session.recorder.open(file));
+    const int updates = 50;
+    for (int i = 0; i < updates; i++)
+        session.socket.feed(squareUpdate(i % 2 * 2, QByteArray(4, char(i))));
+    session.recorder.close();
+    QVERIFY(session.recorder.framesWritten() + session.recorder.framesCoalesced() >= quint64(updates) + 1);
+
+    // Merged or not, the last frame is the last state
+    QVncFrameReader reader;
+    QVERIFY(reader.open(file));
+    quint64 frames = 0;
+    while (reader.readFrame())
+        ++frames;
+    QVERIFY(reader.errorString().isEmpty());
+    QCOMPARE(frames, session.recorder.framesWritten());
+    QCOMPARE(reader.image(), session.client.image());
+}
+
+void tst_qvncframerecorder::notARecording()
+{
+    const QString file = fileName();
+    QFile out(file);
+    QVERIFY(out.open(QIODevice::WriteOnly));
+    out.write("QVNCSESS\x01\x00\x00\x00\x00\x00\x00\x00", 16);
+    out.close();
+
+    QVncFrameReader reader;
+    QVERIFY(!reader.open(file));
+    QVERIFY(!reader.errorString().isEmpty());
+    QVERIFY(!reader.readFrame());
+
+    QVncFrameRecorder recorder;
+    QVERIFY(!recorder.open(m_dir.filePath(QStringLiteral("missing/frames"))));
+    QVERIFY(!recorder.isOpen());
+    QVERIFY(!recorder.errorString().isEmpty());
+}
+
+QTEST_MAIN(tst_qvncframerecorder)
+#include "tst_qvncframerecorder.moc"
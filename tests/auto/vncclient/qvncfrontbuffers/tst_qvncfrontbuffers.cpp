@@ -0,0 +1,114 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvncfrontbuffers_p.h>
+
+class tst_qvncfrontbuffers : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void disabled();
+    void damageCopiedInPlace();
+    void heldFrameKept();
+    void tripleRotates();
+    void sizeChange();
+};
+
+static QImage backBuffer(int width = 4, int height = 2)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    return image;
+}
+
+void tst_qvncfrontbuffers::disabled()
+{
+    QVncFrontBuffers buffers;
+    buffers.publish(backBuffer(), QRegion());
+    QVERIFY(buffers.frame().isNull());
+}
+
+void tst_qvncfrontbuffers::damageCopiedInPlace()
+{
+    QVncFrontBuffers buffers;
+    buffers.setCount(1);
+    QImage back = backBuffer();
+    buffers.publish(back, QRegion());
+    const uchar *bits = nullptr;
+    {
+        const QImage frame = buffers.frame();
+        QCOMPARE(frame, back);
+        QVERIFY(frame.constBits() != back.constBits());
+        bits = frame.constBits();
+    }
+
+    back.setPixel(1, 1, qRgb(0, 0, 255));
+    buffers.publish(back, QRegion(1, 1, 1, 1));
+    const QImage frame = buffers.frame();
+    QCOMPARE(frame.constBits(), bits);
+    QCOMPARE(frame, back);
+}
+
+void tst_qvncfrontbuffers::heldFrameKept()
+{
+    QVncFrontBuffers buffers;
+    buffers.setCount(1);
+    QImage back = backBuffer();
+    buffers.publish(back, QRegion());
+    const QImage held = buffers.frame();
+
+    back.setPixel(0, 0, qRgb(0, 255, 0));
+    buffers.publish(back, QRegion(0, 0, 1, 1));
+    QCOMPARE(held.pixel(0, 0), qRgb(255, 0, 0));
+    QCOMPARE(buffers.frame(), back);
+    QVERIFY(buffers.frame().constBits() != held.constBits());
+}
+
+void tst_qvncfrontbuffers::tripleRotates()
+{
+    QVncFrontBuffers buffers;
+    buffers.setCount(2);
+    QImage back = backBuffer();
+    buffers.publish(back, QRegion());
+    QImage first = buffers.frame();
+
+    // The held frame stays, the next one goes to the other buffer
+    back.setPixel(0, 0, qRgb(0, 255, 0));
+    buffers.publish(back, QRegion(0, 0, 1, 1));
+    const uchar *secondBits = buffers.frame().constBits();
+    QVERIFY(secondBits != first.constBits());
+    QCOMPARE(first.pixel(0, 0), qRgb(255, 0, 0));
+
+    // With the first still held, the second is updated in place
+    back.setPixel(3, 1, qRgb(0, 255, 0));
+    buffers.publish(back, QRegion(3, 1, 1, 1));
+    QCOMPARE(buffers.frame().constBits(), secondBits);
+    QCOMPARE(buffers.frame(), back);
+    QCOMPARE(first.pixel(3, 1), qRgb(255, 0, 0));
+
+    // Once released, the first catches up on everything it missed
+    const uchar *firstBits = first.constBits();
+    first = QImage();
+    back.setPixel(2, 0, qRgb(0, 0, 255));
+    buffers.publish(back, QRegion(2, 0, 1, 1));
+    QCOMPARE(buffers.frame().constBits(), firstBits);
+    QCOMPARE(buffers.frame(), back);
+}
+
+void tst_qvncfrontbuffers::sizeChange()
+{
+    QVncFrontBuffers buffers;
+    buffers.setCount(2);
+    buffers.publish(backBuffer(), QRegion());
+    buffers.publish(backBuffer(8, 8), QRegion(0, 0, 8, 8));
+    buffers.publish(backBuffer(8, 8), QRegion());
+    QCOMPARE(buffers.frame().size(), QSize(8, 8));
+
+    buffers.clear();
+    QVERIFY(buffers.frame().isNull());
+}
+
+QTEST_MAIN(tst_qvncfrontbuffers)
+#include "tst_qvncfrontbuffers.moc"
@@ -0,0 +1,98 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvnch264decoder_p.h>
+
+class tst_qvnch264decoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void contextPerRect();
+    void resetFlags();
+    void leastRecentlyUsedFirst();
+    void undecodableData();
+};
+
+void tst_qvnch264decoder::initTestCase()
+{
+    QVncH264Decoder decoder;
+    if (!QVncH264Decoder::isAvailable()) {
+        QVERIFY(!decoder.context(QRect(0, 0, 64, 64), 0));
+        QSKIP("Built without an H.264 decoder");
+    }
+    QVERIFY(decoder.context(QRect(0, 0, 64, 64), 0));
+    qDebug() << "Backend:" << decoder.backend();
+}
+
+void tst_qvnch264decoder::contextPerRect()
+{
+    QVncH264Decoder decoder;
+    QVERIFY(!decoder.backend());
+    const auto first = decoder.context(QRect(0, 0, 64, 64), 0);
+    QVERIFY(first);
+    QVERIFY(decoder.backend());
+    QCOMPARE(decoder.context(QRect(0, 0, 64, 64), 0), first);
+    // Another position or size is another stream
+    QVERIFY(decoder.context(QRect(64, 0, 64, 64), 0) != first);
+    QVERIFY(decoder.context(QRect(0, 0, 64, 32), 0) != first);
+    QCOMPARE(decoder.contextCount(), 3);
+
+    decoder.reset();
+    QCOMPARE(decoder.contextCount(), 0);
+    QVERIFY(decoder.context(QRect(0, 0, 64, 64), 0) != first);
+}
+
+void tst_qvnch264decoder::resetFlags()
+{
+    QVncH264Decoder decoder;
+    const auto first = decoder.context(QRect(0, 0, 64, 64), 0);
+    const auto other = decoder.context(QRect(64, 0, 64, 64), 0);
+
+    const auto reset = decoder.context(QRect(0, 0, 64, 64), QVncH264Decoder::ResetContext);
+    QVERIFY(reset != first);
+    QCOMPARE(decoder.context(QRect(64, 0, 64, 64), 0), other);
+    QCOMPARE(decoder.contextCount(), 2);
+
+    QVERIFY(decoder.context(QRect(0, 0, 64, 64), QVncH264Decoder::ResetAllContexts) != reset);
+    QCOMPARE(decoder.contextCount(), 1);
+    QVERIFY(decoder.context(QRect(64, 0, 64, 64), 0) != other);
+}
+
+void tst_qvnch264decoder::leastRecentlyUsedFirst()
+{
+    QVncH264Decoder decoder;
+    const auto kept = decoder.context(QRect(0, 0, 16, 16), 0);
+    const auto dropped = decoder.context(QRect(16, 0, 16, 16), 0);
+    for (int i = 2; i < 64; i++)
+        decoder.context(QRect(i * 16, 0, 16, 16), 0);
+    QCOMPARE(decoder.contextCount(), 64);
+
+    // Using the first one again makes the second the oldest
+    QCOMPARE(decoder.context(QRect(0, 0, 16, 16), 0), kept);
+    decoder.context(QRect(0, 16, 16, 16), 0);
+    QCOMPARE(decoder.contextCount(), 64);
+    QCOMPARE(decoder.context(QRect(0, 0, 16, 16), 0), kept);
+    QVERIFY(decoder.context(QRect(16, 0, 16, 16), 0) != dropped);
+}
+
+void tst_qvnch264decoder::undecodableData()
+{
+    QVncH264Decoder decoder;
+    const QRect rect(0, 0, 4, 2);
+    const auto context = decoder.context(rect, 0);
+    QImage image(4, 2, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    QVncPixelWriter writer(image);
+
+    // Not a frame: nothing is written, whether or not it is an error
+    const QByteArray garbage("\x00\x00\x00\x01\x09\xf0", 6);
+    QVncH264Decoder::decode(*context, reinterpret_cast<const uchar *>(garbage.constData()),
+                            garbage.size(), writer, rect);
+    QCOMPARE(image.pixel(3, 1), qRgb(255, 255, 255));
+}
+
+QTEST_MAIN(tst_qvnch264decoder)
+#include "tst_qvnch264decoder.moc"
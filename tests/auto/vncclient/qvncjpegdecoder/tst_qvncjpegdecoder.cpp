@@ -0,0 +1,104 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtGui/QImage>
+#include <QtGui/QImageWriter>
+#include <QtVncClient/private/qvncjpegdecoder_p.h>
+
+class tst_qvncjpegdecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void decode_data();
+    void decode();
+    void invalidData();
+};
+
+static QByteArray encodeJpeg(const QImage &image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", 95);
+    return data;
+}
+
+static QImage gradient(int w, int h)
+{
+    QImage image(w, h, QImage::Format_RGB32);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            image.setPixel(x, y, qRgb(x * 255 / w, y * 255 / h, 128));
+    return image;
+}
+
+static bool fuzzyEqual(QRgb a, QRgb b)
+{
+    const int tolerance = 12;
+    return qAbs(qRed(a) - qRed(b)) <= tolerance && qAbs(qGreen(a) - qGreen(b)) <= tolerance
+            && qAbs(qBlue(a) - qBlue(b)) <= tolerance && qAlpha(a) == 255;
+}
+
+void tst_qvncjpegdecoder::initTestCase()
+{
+    if (!QImageWriter::supportedImageFormats().contains("jpeg"))
+        QSKIP("No JPEG support to create test data");
+}
+
+void tst_qvncjpegdecoder::decode_data()
+{
+    QTest::addColumn<QPoint>("position");
+
+    QTest::newRow("inside") << QPoint(8, 4);
+    QTest::newRow("origin") << QPoint(0, 0);
+    QTest::newRow("clipped-right") << QPoint(40, 10);
+    QTest::newRow("clipped-left") << QPoint(-16, -8);
+}
+
+void tst_qvncjpegdecoder::decode()
+{
+    QFETCH(QPoint, position);
+
+    const QImage source = gradient(32, 24);
+    const QByteArray jpeg = encodeJpeg(source);
+
+    QImage framebuffer(64, 48, QImage::Format_RGB32);
+    framebuffer.fill(Qt::black);
+    QVncPixelWriter writer(framebuffer);
+    QVncJpegDecoder decoder;
+    QVERIFY(decoder.decode(reinterpret_cast<const uchar *>(jpeg.constData()), jpeg.size(),
+                           writer, position.x(), position.y()));
+
+    const QRect target(position, source.size());
+    for (int y = 0; y < framebuffer.height(); y++) {
+        for (int x = 0; x < framebuffer.width(); x++) {
+            const QRgb actual = framebuffer.pixel(x, y);
+            if (target.contains(x, y))
+                QVERIFY2(fuzzyEqual(actual, source.pixel(x - position.x(), y - position.y())),
+                         qPrintable(QStringLiteral("at %1,%2").arg(x).arg(y)));
+            else
+                QCOMPARE(actual, qRgb(0, 0, 0));
+        }
+    }
+}
+
+void tst_qvncjpegdecoder::invalidData()
+{
+    QImage framebuffer(16, 16, QImage::Format_RGB32);
+    framebuffer.fill(Qt::black);
+    const QImage expected = framebuffer.copy();
+    QVncPixelWriter writer(framebuffer);
+    QVncJpegDecoder decoder;
+
+    const QByteArray garbage(64, 'x');
+    QVERIFY(!decoder.decode(reinterpret_cast<const uchar *>(garbage.constData()), garbage.size(),
+                            writer, 0, 0));
+    QCOMPARE(framebuffer, expected);
+}
+
+QTEST_MAIN(tst_qvncjpegdecoder)
+#include "tst_qvncjpegdecoder.moc"
@@ -0,0 +1,265 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtGui/QImage>
+#include <QtVncClient/private/qvncpixel_p.h>
+#include <QtVncClient/private/qvncpixelformat_p.h>
+
+class tst_qvncpixel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rowInside();
+    void rowClipped_data();
+    void rowClipped();
+    void fillRect_data();
+    void fillRect();
+    void writeRectClipped();
+    void copyRect_data();
+    void copyRect();
+    void converter_data();
+    void converter();
+    void nativeFormat();
+};
+
+static QImage referenceImage(int w, int h)
+{
+    QImage image(w, h, QImage::Format_ARGB32);
+    image.fill(Qt::white);
+    return image;
+}
+
+void tst_qvncpixel::rowInside()
+{
+    QImage image = referenceImage(8, 4);
+    QVncPixelWriter writer(image);
+    QRgb *row = writer.beginRow(2, 1, 4);
+    QCOMPARE(row, reinterpret_cast<QRgb *>(image.scanLine(1)) + 2);
+    for (int x = 0; x < 4; x++)
+        row[x] = qRgb(x, 0, 0);
+    writer.endRow();
+
+    for (int x = 0; x < 8; x++) {
+        const QRgb expected = (x >= 2 && x < 6) ? qRgb(x - 2, 0, 0) : qRgb(255, 255, 255);
+        QCOMPARE(image.pixel(x, 1), expected);
+    }
+}
+
+void tst_qvncpixel::rowClipped_data()
+{
+    QTest::addColumn<QRect>("row");
+
+    QTest::newRow("left") << QRect(-3, 0, 6, 1);
+    QTest::newRow("right") << QRect(5, 2, 6, 1);
+    QTest::newRow("both") << QRect(-2, 3, 12, 1);
+    QTest::newRow("above") << QRect(0, -1, 8, 1);
+    QTest::newRow("below") << QRect(0, 4, 8, 1);
+}
+
+void tst_qvncpixel::rowClipped()
+{
+    QFETCH(QRect, row);
+
+    QImage image = referenceImage(8, 4);
+    QImage expected = referenceImage(8, 4);
+    for (int x = 0; x < row.width(); x++) {
+        if (expected.rect().contains(row.x() + x, row.y()))
+            expected.setPixel(row.x() + x, row.y(), qRgb(0, x, 0));
+    }
+
+    QVncPixelWriter writer(image);
+    QRgb *dst = writer.beginRow(row.x(), row.y(), row.width());
+    for (int x = 0; x < row.width(); x++)
+        dst[x] = qRgb(0, x, 0);
+    writer.endRow();
+
+    QCOMPARE(image, expected);
+}
+
+void tst_qvncpixel::fillRect_data()
+{
+    QTest::addColumn<QRect>("rect");
+
+    QTest::newRow("inside") << QRect(1, 1, 3, 2);
+    QTest::newRow("full") << QRect(0, 0, 8, 4);
+    QTest::newRow("overlapping") << QRect(6, 2, 5, 5);
+    QTest::newRow("outside") << QRect(9, 0, 2, 2);
+    QTest::newRow("empty") << QRect(2, 2, 0, 0);
+}
+
+void tst_qvncpixel::fillRect()
+{
+    QFETCH(QRect, rect);
+
+    QImage image = referenceImage(8, 4);
+    QImage expected = referenceImage(8, 4);
+    for (int y = 0; y < rect.height(); y++) {
+        for (int x = 0; x < rect.width(); x++) {
+            if (expected.rect().contains(rect.x() + x, rect.y() + y))
+                expected.setPixel(rect.x() + x, rect.y() + y, qRgb(10, 20, 30));
+        }
+    }
+
+    QVncPixelWriter writer(image);
+    writer.fillRect(rect.x(), rect.y(), rect.width(), rect.height(), qRgb(10, 20, 30));
+
+    QCOMPARE(image, expected);
+}
+
+void tst_qvncpixel::writeRectClipped()
+{
+    QRgb tile[4 * 3];
+    for (int i = 0; i < 4 * 3; i++)
+        tile[i] = qRgb(i, i, i);
+
+    QImage image = referenceImage(8, 4);
+    QVncPixelWriter writer(image);
+    writer.writeRect(-1, 2, 4, 3, tile, 4);
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 8; x++) {
+            QRgb expected = qRgb(255, 255, 255);
+            if (y >= 2 && x < 3)
+                expected = tile[(y - 2) * 4 + (x + 1)];
+            QCOMPARE(image.pixel(x, y), expected);
+        }
+    }
+}
+
+void tst_qvncpixel::copyRect_data()
+{
+    QTest::addColumn<QPoint>("source");
+    QTest::addColumn<QRect>("target");
+
+    QTest::newRow("disjoint") << QPoint(0, 0) << QRect(5, 2, 3, 2);
+    QTest::newRow("scroll-up") << QPoint(0, 1) << QRect(0, 0, 8, 3);
+    QTest::newRow("scroll-down") << QPoint(0, 0) << QRect(0, 1, 8, 3);
+    QTest::newRow("shift-left") << QPoint(2, 0) << QRect(0, 0, 6, 4);
+    QTest::newRow("shift-right") << QPoint(0, 0) << QRect(2, 0, 6, 4);
+    QTest::newRow("diagonal") << QPoint(1, 1) << QRect(2, 2, 5, 2);
+    QTest::newRow("target-clipped") << QPoint(0, 0) << QRect(6, 3, 4, 4);
+    QTest::newRow("source-clipped") << QPoint(6, 2) << QRect(0, 0, 4, 4);
+}
+
+void tst_qvncpixel::copyRect()
+{
+    QFETCH(QPoint, source);
+    QFETCH(QRect, target);
+
+    QImage image = referenceImage(8, 4);
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 8; x++)
+            image.setPixel(x, y, qRgb(x, y, 0));
+    const QImage original = image.copy();
+
+    QImage expected = original.copy();
+    for (int y = 0; y < target.height(); y++) {
+        for (int x = 0; x < target.width(); x++) {
+            const QPoint from = source + QPoint(x, y);
+            const QPoint to = target.topLeft() + QPoint(x, y);
+            if (original.rect().contains(from) && expected.rect().contains(to))
+                expected.setPixel(to, original.pixel(from));
+        }
+    }
+
+    QVncPixelWriter writer(image);
+    writer.copyRect(source.x(), source.y(), target.x(), target.y(), target.width(), target.height());
+
+    QCOMPARE(image, expected);
+}
+
+void tst_qvncpixel::converter_data()
+{
+    QTest::addColumn<int>("bitsPerPixel");
+    QTest::addColumn<bool>("bigEndian");
+    QTest::addColumn<int>("bytesPerPixel");
+    QTest::addColumn<QList<int>>("max");
+    QTest::addColumn<QList<int>>("shift");
+
+    const QList<int> max888 { 255, 255, 255 };
+    for (const bool bigEndian : { false, true }) {
+        const char *suffix = bigEndian ? "be" : "le";
+        QTest::addRow("bgrx8888-%s", suffix) << 32 << bigEndian << 4 << max888 << QList<int> { 16, 8, 0 };
+        QTest::addRow("rgbx8888-%s", suffix) << 32 << bigEndian << 4 << max888 << QList<int> { 0, 8, 16 };
+        QTest::addRow("xbgr8888-%s", suffix) << 32 << bigEndian << 4 << max888 << QList<int> { 24, 16, 8 };
+        QTest::addRow("cpixel-bgr888-%s", suffix) << 32 << bigEndian << 3 << max888 << QList<int> { 16, 8, 0 };
+        QTest::addRow("cpixel-rgb888-%s", suffix) << 32 << bigEndian << 3 << max888 << QList<int> { 0, 8, 16 };
+        QTest::addRow("rgb565-%s", suffix) << 16 << bigEndian << 2 << QList<int> { 31, 63, 31 } << QList<int> { 11, 5, 0 };
+        QTest::addRow("rgb555-%s", suffix) << 16 << bigEndian << 2 << QList<int> { 31, 31, 31 } << QList<int> { 10, 5, 0 };
+        QTest::addRow("bgr233-%s", suffix) << 8 << bigEndian << 1 << QList<int> { 7, 7, 3 } << QList<int> { 0, 3, 6 };
+        QTest::addRow("rgb101010-%s", suffix) << 32 << bigEndian << 4 << QList<int> { 1023, 1023, 1023 } << QList<int> { 20, 10, 0 };
+    }
+}
+
+void tst_qvncpixel::converter()
+{
+    QFETCH(int, bitsPerPixel);
+    QFETCH(bool, bigEndian);
+    QFETCH(int, bytesPerPixel);
+    QFETCH(QList<int>, max);
+    QFETCH(QList<int>, shift);
+
+    QVncPixelFormat format;
+    format.bitsPerPixel = bitsPerPixel;
+    format.depth = bitsPerPixel == 32 ? 24 : bitsPerPixel;
+    format.bigEndianFlag = bigEndian;
+    format.trueColourFlag = 1;
+    format.redMax = max.at(0);
+    format.greenMax = max.at(1);
+    format.blueMax = max.at(2);
+    format.redShift = shift.at(0);
+    format.greenShift = shift.at(1);
+    format.blueShift = shift.at(2);
+    const QVncPixelConverter converter(format, bytesPerPixel);
+    QCOMPARE(converter.bytesPerPixel(), bytesPerPixel);
+
+    // Odd lengths exercise both the vector body and the scalar tail
+    const int count = 37;
+    QByteArray src(count * bytesPerPixel, Qt::Uninitialized);
+    for (int i = 0; i < src.size(); i++)
+        src[i] = char(i * 37 + 11);
+    const uchar *p = reinterpret_cast<const uchar *>(src.constData());
+
+    QList<QRgb> row(count);
+    converter.convertRow(p, row.data(), count);
+
+    for (int i = 0; i < count; i++) {
+        quint32 value = 0;
+        for (int b = 0; b < bytesPerPixel; b++) {
+            const int byte = bigEndian ? b : bytesPerPixel - 1 - b;
+            value = (value << 8) | p[i * bytesPerPixel + byte];
+        }
+        auto channel = [&](int c) {
+            const int m = max.at(c);
+            return int((((value >> shift.at(c)) & m) * 255 + m / 2) / m);
+        };
+        const QRgb expected = qRgb(channel(0), channel(1), channel(2));
+        QCOMPARE(row.at(i), expected);
+        QCOMPARE(converter.pixel(p + i * bytesPerPixel), expected);
+    }
+}
+
+void tst_qvncpixel::nativeFormat()
+{
+    // The native format is the byte layout of QImage::Format_RGB32, so
+    // framebuffer memory converts to itself.
+    QImage image(37, 2, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); y++)
+        for (int x = 0; x < image.width(); x++)
+            image.setPixel(x, y, qRgb(x * 7, y * 50 + x, 255 - x));
+
+    const QVncPixelFormat format = QVncPixelFormat::native();
+    QCOMPARE(format.tpixelSize(), 3);
+    const QVncPixelConverter converter(format, format.bitsPerPixel / 8);
+    QList<QRgb> row(image.width());
+    for (int y = 0; y < image.height(); y++) {
+        converter.convertRow(image.constScanLine(y), row.data(), image.width());
+        for (int x = 0; x < image.width(); x++)
+            QCOMPARE(row.at(x), image.pixel(x, y));
+    }
+}
+
+QTEST_MAIN(tst_qvncpixel)
+#include "tst_qvncpixel.moc"
@@ -0,0 +1,104 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtVncClient/private/qvncreceivebuffer_p.h>
+
+class tst_qvncreceivebuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fillAndRead();
+    void incompleteMessage();
+    void compaction();
+};
+
+static QByteArray pattern(int size, int seed = 0)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; i++)
+        data[i] = char(i * 7 + seed);
+    return data;
+}
+
+void tst_qvncreceivebuffer::fillAndRead()
+{
+    QByteArray source = pattern(100);
+    QBuffer device(&source);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+
+    QVncReceiveBuffer buffer;
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(buffer.fill(&device), 100);
+    QCOMPARE(buffer.bytesAvailable(), 100);
+    QCOMPARE(device.bytesAvailable(), 0);
+    QCOMPARE(buffer.fill(&device), 0);
+
+    QCOMPARE(buffer.peek(4), source.left(4));
+    QCOMPARE(buffer.bytesAvailable(), 100);
+
+    quint32 value = 0;
+    QCOMPARE(buffer.read(reinterpret_cast<char *>(&value), 4), 4);
+    QCOMPARE(memcmp(&value, source.constData(), 4), 0);
+
+    QCOMPARE(buffer.read(6), source.mid(4, 6));
+    buffer.skip(10);
+    QCOMPARE(buffer.data()[0], uchar(source.at(20)));
+    QCOMPARE(buffer.readAll(), source.mid(20));
+    QVERIFY(buffer.isEmpty());
+
+    // Reads past the end are truncated, like QIODevice
+    QCOMPARE(buffer.read(4), QByteArray());
+    QCOMPARE(buffer.fill(nullptr), 0);
+}
+
+void tst_qvncreceivebuffer::incompleteMessage()
+{
+    // A message split across two readyReads is seen whole after the second fill
+    const QByteArray message = pattern(64, 3);
+    QByteArray first = message.left(20);
+    QByteArray second = message.mid(20);
+    QBuffer firstDevice(&first);
+    QBuffer secondDevice(&second);
+    QVERIFY(firstDevice.open(QIODevice::ReadOnly));
+    QVERIFY(secondDevice.open(QIODevice::ReadOnly));
+
+    QVncReceiveBuffer buffer;
+    buffer.fill(&firstDevice);
+    QVERIFY(buffer.bytesAvailable() < message.size());
+    buffer.fill(&secondDevice);
+    QCOMPARE(buffer.bytesAvailable(), message.size());
+    QCOMPARE(QByteArray(reinterpret_cast<const char *>(buffer.data()), message.size()), message);
+}
+
+void tst_qvncreceivebuffer::compaction()
+{
+    // Interleave fills with partial consumption so compaction happens
+    // with data still pending; the stream must come out unchanged.
+    const QByteArray stream = pattern(10000, 1);
+    QVncReceiveBuffer buffer;
+    QByteArray received;
+    int offset = 0;
+    int chunk = 1;
+    while (offset < stream.size()) {
+        QByteArray part = stream.mid(offset, chunk);
+        offset += part.size();
+        QBuffer device(&part);
+        QVERIFY(device.open(QIODevice::ReadOnly));
+        buffer.fill(&device);
+
+        // Consume a bit less than what is there
+        const qint64 take = buffer.bytesAvailable() - buffer.bytesAvailable() / 3;
+        const uchar *p = buffer.data();
+        received.append(reinterpret_cast<const char *>(p), take);
+        buffer.skip(take);
+        chunk = chunk * 3 % 997 + 1;
+    }
+    received += buffer.readAll();
+    QCOMPARE(received, stream);
+}
+
+QTEST_MAIN(tst_qvncreceivebuffer)
+#include "tst_qvncreceivebuffer.moc"
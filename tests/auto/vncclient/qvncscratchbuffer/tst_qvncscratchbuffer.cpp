@@ -0,0 +1,78 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvncscratchbuffer_p.h>
+
+class tst_qvncscratchbuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void steadyState();
+    void sharedContents();
+    void grow();
+    void trim();
+};
+
+void tst_qvncscratchbuffer::steadyState()
+{
+    QVncScratchBuffer buffer;
+    buffer.resize(4096);
+    const quint64 allocations = QVncScratchBuffer::allocations();
+
+    // Same or smaller sizes, as rectangles of one stream come in
+    for (int i = 0; i < 100; i++) {
+        QByteArray &data = buffer.resize(1 + (i * 37) % 4096);
+        QCOMPARE(data.size(), 1 + (i * 37) % 4096);
+        const QByteArray view = data; // released again before the next one
+        Q_UNUSED(view);
+    }
+    QCOMPARE(QVncScratchBuffer::allocations(), allocations);
+
+    // Growing allocates once
+    buffer.resize(5000);
+    QCOMPARE(QVncScratchBuffer::allocations(), allocations + 1);
+    buffer.resize(4000);
+    buffer.resize(5000);
+    QCOMPARE(QVncScratchBuffer::allocations(), allocations + 1);
+}
+
+void tst_qvncscratchbuffer::sharedContents()
+{
+    QVncScratchBuffer buffer;
+    QByteArray &first = buffer.resize(16);
+    first.fill('a');
+    const QByteArray kept = first; // as a queued decode job does
+
+    const quint64 allocations = QVncScratchBuffer::allocations();
+    QByteArray &second = buffer.resize(16);
+    second.fill('b');
+    QCOMPARE(QVncScratchBuffer::allocations(), allocations + 1);
+    QCOMPARE(kept, QByteArray(16, 'a'));
+    QCOMPARE(buffer.data(), QByteArray(16, 'b'));
+}
+
+void tst_qvncscratchbuffer::grow()
+{
+    QVncScratchBuffer buffer;
+    QByteArray &data = buffer.resize(8);
+    memcpy(data.data(), "01234567", 8);
+
+    QByteArray &grown = buffer.grow(1024, 8);
+    QCOMPARE(grown.size(), 1024);
+    QCOMPARE(grown.left(8), QByteArray("01234567"));
+}
+
+void tst_qvncscratchbuffer::trim()
+{
+    QVncScratchBuffer buffer;
+    buffer.resize(1024);
+    buffer.trim(2048);
+    QVERIFY(buffer.data().capacity() >= 1024);
+    buffer.trim(512);
+    QCOMPARE(buffer.data().capacity(), 0);
+}
+
+QTEST_MAIN(tst_qvncscratchbuffer)
+#include "tst_qvncscratchbuffer.moc"
@@ -0,0 +1,72 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QtEndian>
+#include <QtVncClient/private/qvncsendbuffer_p.h>
+
+class tst_qvncsendbuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void appendAndFlush();
+    void nestedBatches();
+    void withoutDevice();
+};
+
+void tst_qvncsendbuffer::appendAndFlush()
+{
+    QBuffer device;
+    QVERIFY(device.open(QIODevice::WriteOnly));
+
+    QVncSendBuffer buffer;
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(buffer.flush(&device), 0);
+
+    const quint8 type = 4;
+    buffer.append(&type, 1);
+    buffer.append(QByteArray("\x01\x00\x00", 3));
+    const quint32_be key(0xff0d);
+    buffer.append(&key, sizeof(key));
+    QCOMPARE(buffer.size(), 8);
+    QCOMPARE(buffer.data(), QByteArray("\x04\x01\x00\x00\x00\x00\xff\x0d", 8));
+    QVERIFY(device.data().isEmpty());
+
+    QCOMPARE(buffer.flush(&device), 8);
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(device.data(), QByteArray("\x04\x01\x00\x00\x00\x00\xff\x0d", 8));
+}
+
+void tst_qvncsendbuffer::nestedBatches()
+{
+    QVncSendBuffer buffer;
+    QVERIFY(!buffer.isBatching());
+    buffer.beginBatch();
+    buffer.beginBatch();
+    QVERIFY(buffer.isBatching());
+    QVERIFY(!buffer.endBatch());
+    QVERIFY(buffer.isBatching());
+    QVERIFY(buffer.endBatch());
+    QVERIFY(!buffer.isBatching());
+    // Unbalanced ends do not start a batch
+    QVERIFY(!buffer.endBatch());
+    QVERIFY(!buffer.isBatching());
+}
+
+void tst_qvncsendbuffer::withoutDevice()
+{
+    // Messages for a closed connection are dropped
+    QVncSendBuffer buffer;
+    buffer.append(QByteArray("dropped"));
+    QCOMPARE(buffer.flush(nullptr), 0);
+    QVERIFY(buffer.isEmpty());
+
+    buffer.append(QByteArray("cleared"));
+    buffer.clear();
+    QVERIFY(buffer.isEmpty());
+}
+
+QTEST_MAIN(tst_qvncsendbuffer)
+#include "tst_qvncsendbuffer.moc"
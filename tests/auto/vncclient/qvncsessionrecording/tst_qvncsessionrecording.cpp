@@ -0,0 +1,157 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+#include <QtVncClient/private/qvncsessionrecording_p.h>
+
+#include "../shared/vnctestserver.h"
+
+class tst_qvncsessionrecording : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip();
+    void realTime();
+    void truncated();
+    void notARecording();
+
+private:
+    QString record(const QList<QByteArray> &chunks, int pauseMs = 0);
+
+    QTemporaryDir m_dir;
+    int m_files = 0;
+};
+
+using QVncTest::handshake;
+
+// One Raw rectangle covering the framebuffer, in shades of \a base
+static QByteArray rawUpdate(int base)
+{
+    QByteArray out = QByteArray("\x00\x00", 2) + QVncTest::u16(1) + QVncTest::rect(0, 0, 4, 2)
+            + QVncTest::u32(0);
+    for (int i = 0; i < 8; i++)
+        out.append(char(base + i)).append(char(base)).append(char(255 - i)).append('\0');
+    return out;
+}
+
+void tst_qvncsessionrecording::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+QString tst_qvncsessionrecording::record(const QList<QByteArray> &chunks, int pauseMs)
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("session%1.rec").arg(m_files++));
+    QVncClient client;
+    QVncMemorySocket socket;
+    if (!client.startRecording(fileName))
+        return QString();
+    client.setSocket(&socket);
+    for (const QByteArray &chunk : chunks) {
+        socket.feed(chunk);
+        if (pauseMs > 0)
+            QTest::qWait(pauseMs);
+    }
+    client.stopRecording();
+    return fileName;
+}
+
+void tst_qvncsessionrecording::roundTrip()
+{
+    const QList<QByteArray> chunks { handshake(), rawUpdate(10), rawUpdate(100) };
+    qint64 bytes = 0;
+    for (const QByteArray &chunk : chunks)
+        bytes += chunk.size();
+
+    // The image the live client ends up with
+    QVncClient live;
+    QVncMemorySocket socket;
+    live.setSocket(&socket);
+    for (const QByteArray &chunk : chunks)
+        socket.feed(chunk);
+
+    const QString fileName = record(chunks);
+    QVERIFY(!fileName.isEmpty());
+
+    QVncSessionPlayer player;
+    QVERIFY2(player.open(fileName), qPrintable(player.errorString()));
+    QCOMPARE(player.chunkCount(), chunks.size());
+    QCOMPARE(player.totalBytes(), bytes);
+
+    QVncClient replayed;
+    QSignalSpy updated(&replayed, &QVncClient::framebufferUpdated);
+    bool finished = false;
+    player.play(&replayed, QVncSessionPlayer::AsFastAsPossible, [&]() { finished = true; });
+    QVERIFY(finished);
+    QVERIFY(!player.isPlaying());
+    QCOMPARE(updated.size(), 2);
+    QCOMPARE(replayed.framebufferWidth(), 4);
+    QCOMPARE(replayed.image(), live.image());
+
+    player.stop();
+    QCOMPARE(replayed.socket(), nullptr);
+}
+
+void tst_qvncsessionrecording::realTime()
+{
+    const QString fileName = record({ handshake(), rawUpdate(10), rawUpdate(100) }, 100);
+    QVERIFY(!fileName.isEmpty());
+
+    QVncSessionPlayer player;
+    QVERIFY(player.open(fileName));
+    QVERIFY(player.duration() >= 150 * 1000000LL);
+
+    QVncClient replayed;
+    QSignalSpy updated(&replayed, &QVncClient::framebufferUpdated);
+    bool finished = false;
+    QElapsedTimer timer;
+    timer.start();
+    player.play(&replayed, QVncSessionPlayer::RealTime, [&]() { finished = true; });
+    QVERIFY(player.isPlaying());
+    QCOMPARE(updated.size(), 0);
+    QTRY_VERIFY(finished);
+    QCOMPARE(updated.size(), 2);
+    QVERIFY(timer.elapsed() >= player.duration() / 1000000 - 20);
+}
+
+void tst_qvncsessionrecording::truncated()
+{
+    const QString fileName = record({ handshake(), rawUpdate(10) });
+    QVERIFY(!fileName.isEmpty());
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() - 5));
+    }
+
+    QVncSessionPlayer player;
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("is truncated"));
+    QVERIFY(player.open(fileName));
+    QCOMPARE(player.chunkCount(), 1);
+    QCOMPARE(player.totalBytes(), handshake().size());
+}
+
+void tst_qvncsessionrecording::notARecording()
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("garbage.rec"));
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("RFB 003.008\n and more that is not a recording");
+    }
+    QVncSessionPlayer player;
+    QVERIFY(!player.open(fileName));
+    QVERIFY(!player.errorString().isEmpty());
+    QCOMPARE(player.chunkCount(), 0);
+
+    QVERIFY(!player.open(m_dir.filePath(QStringLiteral("missing.rec"))));
+}
+
+QTEST_MAIN(tst_qvncsessionrecording)
+#include "tst_qvncsessionrecording.moc"
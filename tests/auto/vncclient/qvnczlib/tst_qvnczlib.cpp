@@ -0,0 +1,137 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvnczlib_p.h>
+
+class tst_qvnczlib : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void persistentStream();
+    void outputInPieces();
+    void finishedStreams();
+    void corruptData();
+};
+
+static QByteArray sampleData(int size, int seed)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; i++)
+        data[i] = char((i / 7 + seed) % 23);
+    return data;
+}
+
+static QByteArray inflateAll(QVncInflater &inflater, const QByteArray &compressed, qsizetype expected)
+{
+    QByteArray out(expected, Qt::Uninitialized);
+    inflater.setInput(reinterpret_cast<const uchar *>(compressed.constData()), compressed.size());
+    qsizetype written = 0;
+    if (inflater.inflate(reinterpret_cast<uchar *>(out.data()), out.size(), &written) == QVncInflater::Error)
+        return QByteArray();
+    out.resize(written);
+    return out;
+}
+
+void tst_qvnczlib::initTestCase()
+{
+    if (!QVncInflater::backend())
+        QSKIP("Built without zlib");
+    qDebug() << "Backend:" << QVncInflater::backend();
+}
+
+void tst_qvnczlib::persistentStream()
+{
+    // Like the rectangles of one Tight or ZRLE stream: later chunks refer
+    // to the dictionary of earlier ones
+    QVncDeflater deflater;
+    QVncInflater inflater;
+    QVERIFY(!inflater.isActive());
+    for (int chunk = 0; chunk < 4; chunk++) {
+        const QByteArray data = sampleData(5000, chunk % 2);
+        const QByteArray compressed = deflater.compress(data, QVncDeflater::SyncFlush);
+        QVERIFY(!compressed.isNull());
+        QVERIFY(compressed.size() < data.size());
+        QCOMPARE(inflateAll(inflater, compressed, data.size()), data);
+        QVERIFY(inflater.isActive());
+        QCOMPARE(inflater.availableInput(), 0);
+    }
+
+    // A chunk after the first cannot be inflated by a new stream
+    const QByteArray data = sampleData(5000, 0);
+    const QByteArray compressed = deflater.compress(data, QVncDeflater::SyncFlush);
+    inflater.end();
+    QVERIFY(!inflater.isActive());
+    QVERIFY(inflateAll(inflater, compressed, data.size()) != data);
+}
+
+void tst_qvnczlib::outputInPieces()
+{
+    QVncDeflater deflater;
+    const QByteArray data = sampleData(10000, 3);
+    const QByteArray compressed = deflater.compress(data, QVncDeflater::FullFlush);
+
+    QVncInflater inflater;
+    inflater.setInput(reinterpret_cast<const uchar *>(compressed.constData()), compressed.size());
+    QByteArray out(data.size(), Qt::Uninitialized);
+    qsizetype produced = 0;
+    while (produced < out.size()) {
+        qsizetype written = 0;
+        const qsizetype piece = qMin<qsizetype>(999, out.size() - produced);
+        QCOMPARE(inflater.inflate(reinterpret_cast<uchar *>(out.data() + produced), piece, &written),
+                 QVncInflater::Ok);
+        QVERIFY(written > 0);
+        produced += written;
+    }
+    QCOMPARE(out, data);
+
+    // Out of input is not an error
+    qsizetype written = -1;
+    char spare[16];
+    QCOMPARE(inflater.inflate(reinterpret_cast<uchar *>(spare), sizeof(spare), &written), QVncInflater::Ok);
+    QCOMPARE(written, 0);
+}
+
+void tst_qvnczlib::finishedStreams()
+{
+    // Like extended clipboard messages: one finished stream each
+    QVncDeflater deflater;
+    QVncInflater inflater;
+    for (int message = 0; message < 3; message++) {
+        const QByteArray data = sampleData(300 + message, message);
+        const QByteArray compressed = deflater.compress(data, QVncDeflater::Finish);
+        QVERIFY(!compressed.isNull());
+
+        QVERIFY(inflater.reset());
+        inflater.setInput(reinterpret_cast<const uchar *>(compressed.constData()), compressed.size());
+        QByteArray out(1000, Qt::Uninitialized);
+        qsizetype written = 0;
+        QCOMPARE(inflater.inflate(reinterpret_cast<uchar *>(out.data()), out.size(), &written),
+                 QVncInflater::StreamEnd);
+        out.resize(written);
+        QCOMPARE(out, data);
+    }
+}
+
+void tst_qvnczlib::corruptData()
+{
+    QVncInflater inflater;
+    const QByteArray garbage("\xff\xff\xff\xff\xff\xff\xff\xff", 8);
+    inflater.setInput(reinterpret_cast<const uchar *>(garbage.constData()), garbage.size());
+    char out[64];
+    qsizetype written = -1;
+    QCOMPARE(inflater.inflate(reinterpret_cast<uchar *>(out), sizeof(out), &written), QVncInflater::Error);
+    QCOMPARE(written, 0);
+    QVERIFY(qstrlen(inflater.errorString()) > 0);
+
+    // A new stream recovers
+    inflater.end();
+    QVncDeflater deflater;
+    const QByteArray data = sampleData(100, 1);
+    QCOMPARE(inflateAll(inflater, deflater.compress(data, QVncDeflater::SyncFlush), data.size()), data);
+}
+
+QTEST_MAIN(tst_qvnczlib)
+#include "tst_qvnczlib.moc"
@@ -0,0 +1,78 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef VNCTESTSERVER_H
+#define VNCTESTSERVER_H
+
+// The server side of the tests that script a session byte by byte: message
+// builders, and a client connected to an in-memory socket.
+
+#include <QtCore/QByteArray>
+#include <QtCore/QtEndian>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+
+namespace QVncTest {
+
+inline QByteArray u16(quint16 value)
+{
+    const quint16_be be(value);
+    return QByteArray(reinterpret_cast<const char *>(&be), 2);
+}
+
+inline QByteArray u32(quint32 value)
+{
+    const quint32_be be(value);
+    return QByteArray(reinterpret_cast<const char *>(&be), 4);
+}
+
+inline QByteArray rect(int x, int y, int w, int h) { return u16(x) + u16(y) + u16(w) + u16(h); }
+
+// Protocol 3.8 without authentication, \a width x \a height framebuffer,
+// 32 bpp 0x00RRGGBB
+inline QByteArray handshake(int width = 4, int height = 2)
+{
+    return QByteArray("RFB 003.008\n") + QByteArray("\x01\x01", 2) + u32(0)
+            + u16(width) + u16(height) + QByteArray("\x20\x18\x00\x01", 4)
+            + u16(255) + u16(255) + u16(255) + QByteArray("\x10\x08\x00\x00\x00\x00", 6)
+            + u32(4) + "test";
+}
+
+// A Raw update filling the 4x2 framebuffer with \a pixel
+inline QByteArray rawUpdate(const QByteArray &pixel)
+{
+    return QByteArray("\x00\x00", 2) + u16(1) + rect(0, 0, 4, 2) + u32(0) + pixel.repeated(8);
+}
+
+// A Raw update filling the 2x2 square at \a x with \a pixel
+inline QByteArray squareUpdate(int x, const QByteArray &pixel)
+{
+    return QByteArray("\x00\x00", 2) + u16(1) + rect(x, 0, 2, 2) + u32(0) + pixel.repeated(4);
+}
+
+// A client past the handshake, with nothing written yet
+struct Session
+{
+    Session()
+    {
+        client.setSocket(&socket);
+        socket.feed(handshake());
+        socket.clearWritten();
+    }
+
+    // Sends \a data as the server and returns what the client wrote back
+    QByteArray exchange(const QByteArray &data)
+    {
+        socket.feed(data);
+        const QByteArray written = socket.written();
+        socket.clearWritten();
+        return written;
+    }
+
+    QVncClient client;
+    QVncMemorySocket socket;
+};
+
+} // namespace QVncTest
+
+#endif // VNCTESTSERVER_H
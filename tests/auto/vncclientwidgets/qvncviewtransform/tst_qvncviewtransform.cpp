@@ -0,0 +1,54 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClientWidgets/private/qvncviewtransform_p.h>
+
+class tst_qvncviewtransform : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unscaled();
+    void scaledToWidth();
+    void scaledToHeight();
+    void empty();
+};
+
+void tst_qvncviewtransform::unscaled()
+{
+    const QVncViewTransform transform(QSize(100, 50), QSize(300, 300), false);
+    QCOMPARE(transform.scale(), 1.0);
+    QCOMPARE(transform.target(), QRectF(0, 0, 100, 50));
+    QCOMPARE(transform.toFramebuffer(QPointF(10.5, 20.9)), QPoint(10, 20));
+    // Dragged out of the framebuffer, the pointer stays at its edge
+    QCOMPARE(transform.toFramebuffer(QPointF(150, -5)), QPoint(99, 0));
+}
+
+void tst_qvncviewtransform::scaledToWidth()
+{
+    const QVncViewTransform transform(QSize(200, 100), QSize(400, 400), true);
+    QCOMPARE(transform.scale(), 2.0);
+    QCOMPARE(transform.target(), QRectF(0, 100, 400, 200));
+    QCOMPARE(transform.toFramebuffer(QPointF(0, 100)), QPoint(0, 0));
+    QCOMPARE(transform.toFramebuffer(QPointF(399.5, 299.5)), QPoint(199, 99));
+    QCOMPARE(transform.toView(QRectF(10, 10, 5, 5)), QRectF(20, 120, 10, 10));
+}
+
+void tst_qvncviewtransform::scaledToHeight()
+{
+    const QVncViewTransform transform(QSize(100, 100), QSize(300, 200), true);
+    QCOMPARE(transform.scale(), 2.0);
+    QCOMPARE(transform.target(), QRectF(50, 0, 200, 200));
+    QCOMPARE(transform.toFramebuffer(QPointF(51, 3)), QPoint(0, 1));
+}
+
+void tst_qvncviewtransform::empty()
+{
+    const QVncViewTransform transform(QSize(), QSize(300, 200), true);
+    QVERIFY(transform.isNull());
+    QCOMPARE(transform.toFramebuffer(QPointF(10, 10)), QPoint());
+}
+
+QTEST_MAIN(tst_qvncviewtransform)
+#include "tst_qvncviewtransform.moc"
@@ -0,0 +1,580 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QtEndian>
+#include <QtGui/QImage>
+#include <QtGui/QImageWriter>
+#include <QtVncClient/QVncClient>
+#include <QtVncClient/private/qvncmemorysocket_p.h>
+#include <QtVncClient/private/qvncsessionrecording_p.h>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+// Runs synthetic server streams through QVncClient over an in-memory
+// socket: a handshake, then the same FramebufferUpdate over and over. The
+// time per iteration is one frame; wire MB/s and frames/s are printed as
+// well. The first frame of every lossless stream is checked against the
+// image it encodes, so a decoder that got faster by getting wrong fails.
+class tst_bench_qvncclient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decode_data();
+    void decode();
+    void replay_data();
+    void replay();
+};
+
+namespace {
+
+enum Encoding {
+    Raw,
+    CopyRect,
+    Hextile,
+    Zrle,
+    TightCopy,
+    TightPalette,
+    TightGradient,
+    TightJpeg,
+};
+
+struct Stream
+{
+    QByteArray prime;   // handshake, plus an update that opens the zlib streams
+    int primeUpdates = 0;
+    QByteArray frame;   // one FramebufferUpdate that can be sent repeatedly
+    QImage expected;    // framebuffer after prime and one frame; null if lossy
+};
+
+void putU8(QByteArray &out, quint8 value) { out.append(char(value)); }
+
+void putU16(QByteArray &out, quint16 value)
+{
+    const quint16_be be(value);
+    out.append(reinterpret_cast<const char *>(&be), 2);
+}
+
+void putU32(QByteArray &out, quint32 value)
+{
+    const quint32_be be(value);
+    out.append(reinterpret_cast<const char *>(&be), 4);
+}
+
+// The server format below: 32 bpp little endian 0x00RRGGBB
+void putPixel(QByteArray &out, QRgb rgb)
+{
+    putU8(out, qBlue(rgb));
+    putU8(out, qGreen(rgb));
+    putU8(out, qRed(rgb));
+    putU8(out, 0);
+}
+
+// ZRLE CPIXEL and Tight TPIXEL: the three significant bytes of the pixel
+void putCompactPixel(QByteArray &out, QRgb rgb)
+{
+    putU8(out, qBlue(rgb));
+    putU8(out, qGreen(rgb));
+    putU8(out, qRed(rgb));
+}
+
+void putRect(QByteArray &out, int x, int y, int w, int h, qint32 encoding)
+{
+    putU16(out, x);
+    putU16(out, y);
+    putU16(out, w);
+    putU16(out, h);
+    putU32(out, quint32(encoding));
+}
+
+void putUpdate(QByteArray &out, int rects)
+{
+    putU8(out, 0); // FramebufferUpdate
+    putU8(out, 0); // padding
+    putU16(out, rects);
+}
+
+void putCompactLength(QByteArray &out, int length)
+{
+    putU8(out, (length & 0x7f) | (length > 0x7f ? 0x80 : 0));
+    if (length > 0x7f) {
+        putU8(out, ((length >> 7) & 0x7f) | (length > 0x3fff ? 0x80 : 0));
+        if (length > 0x3fff)
+            putU8(out, length >> 14);
+    }
+}
+
+QByteArray handshake(int width, int height)
+{
+    QByteArray out("RFB 003.008\n");
+    putU8(out, 1); // one security type
+    putU8(out, 1); // None
+    putU32(out, 0); // SecurityResult OK
+    putU16(out, width);
+    putU16(out, height);
+    putU8(out, 32); // bits per pixel
+    putU8(out, 24); // depth
+    putU8(out, 0);  // little endian
+    putU8(out, 1);  // true colour
+    putU16(out, 255);
+    putU16(out, 255);
+    putU16(out, 255);
+    putU8(out, 16);
+    putU8(out, 8);
+    putU8(out, 0);
+    out.append(3, '\0');
+    const QByteArray name("bench");
+    putU32(out, name.size());
+    out.append(name);
+    return out;
+}
+
+// Desktop-like content: solid panels, text-like patterns and gradients
+QRgb sample(int x, int y)
+{
+    const int block = x / 64 + (y / 64) * 7;
+    switch (block % 4) {
+    case 0: return qRgb(40, 44, 52);
+    case 1: return qRgb(x & 0xff, y & 0xff, (x + y) & 0xff);
+    case 2: return ((x ^ y) & 4) ? qRgb(255, 255, 255) : qRgb(0, 0, 0);
+    default: return qRgb((block * 37) & 0xff, (block * 91) & 0xff, (block * 53) & 0xff);
+    }
+}
+
+QImage content(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; y++) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; x++)
+            line[x] = sample(x, y);
+    }
+    return image;
+}
+
+QByteArray rawRect(const QImage &image, const QRect &rect)
+{
+    QByteArray out;
+    out.reserve(qsizetype(rect.width()) * rect.height() * 4);
+    for (int y = rect.top(); y <= rect.bottom(); y++)
+        for (int x = rect.left(); x <= rect.right(); x++)
+            putPixel(out, image.pixel(x, y));
+    return out;
+}
+
+#ifdef USE_ZLIB
+// One zlib stream. Every chunk ends with a full flush, so chunks after the
+// first do not refer to earlier data and can be replayed in any number.
+class Deflater
+{
+public:
+    Deflater()
+    {
+        memset(&m_stream, 0, sizeof(m_stream));
+        deflateInit(&m_stream, Z_DEFAULT_COMPRESSION);
+    }
+    ~Deflater() { deflateEnd(&m_stream); }
+
+    QByteArray compress(const QByteArray &data)
+    {
+        QByteArray out(deflateBound(&m_stream, data.size()) + 64, Qt::Uninitialized);
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+        m_stream.avail_in = data.size();
+        m_stream.next_out = reinterpret_cast<Bytef *>(out.data());
+        m_stream.avail_out = out.size();
+        deflate(&m_stream, Z_FULL_FLUSH);
+        out.resize(out.size() - m_stream.avail_out);
+        return out;
+    }
+
+private:
+    z_stream m_stream;
+};
+#endif
+
+void encodeHextile(const QRect &area, QByteArray &out, QImage &expected)
+{
+    enum { BackgroundSpecified = 2, AnySubrects = 8, SubrectsColoured = 16 };
+    for (int ty = area.top(); ty <= area.bottom(); ty += 16) {
+        const int th = qMin(16, area.bottom() + 1 - ty);
+        for (int tx = area.left(); tx <= area.right(); tx += 16) {
+            const int tw = qMin(16, area.right() + 1 - tx);
+            const QRgb background = sample(tx, ty);
+            putU8(out, BackgroundSpecified | AnySubrects | SubrectsColoured);
+            putPixel(out, background);
+            putU8(out, 4);
+            for (int y = 0; y < th; y++)
+                for (int x = 0; x < tw; x++)
+                    expected.setPixel(tx + x, ty + y, background);
+            for (int i = 0; i < 4; i++) {
+                const QRgb color = qRgb(i * 60, 255 - i * 60, (tx + ty) & 0xff);
+                putPixel(out, color);
+                putU8(out, (i * 4) << 4 | (i * 4));
+                putU8(out, 3 << 4 | 3);
+                for (int y = i * 4; y < qMin(i * 4 + 4, th); y++)
+                    for (int x = i * 4; x < qMin(i * 4 + 4, tw); x++)
+                        expected.setPixel(tx + x, ty + y, color);
+            }
+        }
+    }
+}
+
+// Cycles through solid, packed palette, plain RLE and raw tiles
+QByteArray zrleTiles(const QRect &area, const QImage &source, QImage &expected)
+{
+    QByteArray out;
+    int tile = 0;
+    for (int ty = area.top(); ty <= area.bottom(); ty += 64) {
+        const int th = qMin(64, area.bottom() + 1 - ty);
+        for (int tx = area.left(); tx <= area.right(); tx += 64, tile++) {
+            const int tw = qMin(64, area.right() + 1 - tx);
+            switch (tile % 4) {
+            case 0: {
+                const QRgb color = sample(tx, ty) | 0x00102030;
+                putU8(out, 1);
+                putCompactPixel(out, color);
+                for (int y = 0; y < th; y++)
+                    for (int x = 0; x < tw; x++)
+                        expected.setPixel(tx + x, ty + y, color);
+                break;
+            }
+            case 1: {
+                const QRgb palette[2] = { qRgb(250, 250, 250), qRgb(20, 20, 120) };
+                putU8(out, 2);
+                putCompactPixel(out, palette[0]);
+                putCompactPixel(out, palette[1]);
+                for (int y = 0; y < th; y++) {
+                    QByteArray row((tw + 7) / 8, '\0');
+                    for (int x = 0; x < tw; x++) {
+                        const int index = ((x ^ y) >> 2) & 1;
+                        row[x / 8] = char(row.at(x / 8) | (index << (7 - x % 8)));
+                        expected.setPixel(tx + x, ty + y, palette[index]);
+                    }
+                    out.append(row);
+                }
+                break;
+            }
+            case 2: {
+                putU8(out, 128);
+                const int total = tw * th;
+                for (int pos = 0, run = 0; pos < total; pos += 37, run++) {
+                    const int length = qMin(37, total - pos);
+                    const QRgb color = qRgb((run * 40) & 0xff, 128, (255 - run * 40) & 0xff);
+                    putCompactPixel(out, color);
+                    for (int rest = length - 1; rest >= 0; rest -= 255)
+                        putU8(out, qMin(rest, 255));
+                    for (int i = pos; i < pos + length; i++)
+                        expected.setPixel(tx + i % tw, ty + i / tw, color);
+                }
+                break;
+            }
+            default:
+                putU8(out, 0);
+                for (int y = 0; y < th; y++) {
+                    for (int x = 0; x < tw; x++) {
+                        putCompactPixel(out, source.pixel(tx + x, ty + y));
+                        expected.setPixel(tx + x, ty + y, source.pixel(tx + x, ty + y));
+                    }
+                }
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+// Pixel data of one Tight basic rectangle, before compression
+QByteArray tightPixels(Encoding encoding, const QRect &rect, const QImage &source, QImage &expected)
+{
+    QByteArray out;
+    if (encoding == TightPalette) {
+        const QRgb palette[2] = { qRgb(255, 255, 255), qRgb(0, 0, 0) };
+        for (int y = 0; y < rect.height(); y++) {
+            QByteArray row((rect.width() + 7) / 8, '\0');
+            for (int x = 0; x < rect.width(); x++) {
+                const int index = ((rect.x() + x) ^ (rect.y() + y)) >> 2 & 1;
+                row[x / 8] = char(row.at(x / 8) | (index << (7 - x % 8)));
+                expected.setPixel(rect.x() + x, rect.y() + y, palette[index]);
+            }
+            out.append(row);
+        }
+        return out;
+    }
+
+    for (int y = 0; y < rect.height(); y++) {
+        for (int x = 0; x < rect.width(); x++) {
+            const QRgb color = source.pixel(rect.x() + x, rect.y() + y);
+            expected.setPixel(rect.x() + x, rect.y() + y, color);
+            if (encoding == TightCopy) {
+                putCompactPixel(out, color);
+                continue;
+            }
+            // Gradient filter: send the difference to the prediction
+            auto channel = [&](int dx, int dy, int c) {
+                if (x + dx < 0 || y + dy < 0)
+                    return 0;
+                const QRgb p = source.pixel(rect.x() + x + dx, rect.y() + y + dy);
+                return c == 0 ? qRed(p) : c == 1 ? qGreen(p) : qBlue(p);
+            };
+            int error[3];
+            for (int c = 0; c < 3; c++) {
+                const int predicted = qBound(0, channel(-1, 0, c) + channel(0, -1, c) - channel(-1, -1, c), 255);
+                error[c] = (channel(0, 0, c) - predicted) & 0xff;
+            }
+            putCompactPixel(out, qRgb(error[0], error[1], error[2]));
+        }
+    }
+    return out;
+}
+} // namespace
+
+void tst_bench_qvncclient::decode_data()
+{
+    QTest::addColumn<int>("encoding");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("threads");
+
+    const struct { const char *name; Encoding encoding; } encodings[] = {
+        { "raw", Raw },
+        { "copyrect", CopyRect },
+        { "hextile", Hextile },
+        { "zrle", Zrle },
+        { "tight-copy", TightCopy },
+        { "tight-palette", TightPalette },
+        { "tight-gradient", TightGradient },
+        { "tight-jpeg", TightJpeg },
+    };
+    const struct { const char *name; QSize size; } sizes[] = {
+        { "1080p", QSize(1920, 1080) },
+        { "4k", QSize(3840, 2160) },
+        { "8k", QSize(7680, 4320) },
+    };
+    const int workers = QThread::idealThreadCount();
+    for (const auto &encoding : encodings) {
+        for (const auto &size : sizes) {
+            QTest::addRow("%s-%s", encoding.name, size.name) << int(encoding.encoding) << size.size << 0;
+            if (workers > 1) {
+                QTest::addRow("%s-%s-threaded", encoding.name, size.name)
+                        << int(encoding.encoding) << size.size << workers;
+            }
+        }
+    }
+}
+
+static Stream makeStream(Encoding encoding, const QSize &size)
+{
+    const int w = size.width();
+    const int h = size.height();
+    const QImage source = content(w, h);
+
+    Stream stream;
+    stream.prime = handshake(w, h);
+    stream.expected = QImage(w, h, QImage::Format_RGB32);
+    stream.expected.fill(Qt::white);
+
+    switch (encoding) {
+    case Raw:
+        putUpdate(stream.frame, 1);
+        putRect(stream.frame, 0, 0, w, h, 0);
+        stream.frame.append(rawRect(source, QRect(0, 0, w, h)));
+        stream.expected = source;
+        break;
+    case CopyRect: {
+        // Scroll up by one line, after a raw frame to have something to move
+        putUpdate(stream.prime, 1);
+        putRect(stream.prime, 0, 0, w, h, 0);
+        stream.prime.append(rawRect(source, QRect(0, 0, w, h)));
+        stream.primeUpdates = 1;
+        putUpdate(stream.frame, 1);
+        putRect(stream.frame, 0, 0, w, h - 1, 1);
+        putU16(stream.frame, 0);
+        putU16(stream.frame, 1);
+        stream.expected = source.copy();
+        for (int y = 0; y < h - 1; y++)
+            memcpy(stream.expected.scanLine(y), source.constScanLine(y + 1), w * 4);
+        break;
+    }
+    case Hextile:
+        putUpdate(stream.frame, 1);
+        putRect(stream.frame, 0, 0, w, h, 5);
+        encodeHextile(QRect(0, 0, w, h), stream.frame, stream.expected);
+        break;
+#ifdef USE_ZLIB
+    case Zrle: {
+        Deflater deflater;
+        const QByteArray tiles = zrleTiles(QRect(0, 0, w, h), source, stream.expected);
+        for (QByteArray *out : { &stream.prime, &stream.frame }) {
+            const QByteArray compressed = deflater.compress(tiles);
+            putUpdate(*out, 1);
+            putRect(*out, 0, 0, w, h, 16);
+            putU32(*out, compressed.size());
+            out->append(compressed);
+        }
+        stream.primeUpdates = 1;
+        break;
+    }
+    case TightCopy:
+    case TightPalette:
+    case TightGradient: {
+        // 256x256 rectangles, as Tight servers split large updates
+        const int streamId = encoding - TightCopy;
+        Deflater deflater;
+        QList<QRect> rects;
+        for (int y = 0; y < h; y += 256)
+            for (int x = 0; x < w; x += 256)
+                rects.append(QRect(x, y, qMin(256, w - x), qMin(256, h - y)));
+
+        auto putTight = [&](QByteArray &out, const QRect &rect) {
+            putRect(out, rect.x(), rect.y(), rect.width(), rect.height(), 7);
+            if (encoding == TightCopy) {
+                putU8(out, streamId << 4);
+            } else {
+                putU8(out, (4 | streamId) << 4);
+                putU8(out, encoding == TightPalette ? 1 : 2);
+            }
+            if (encoding == TightPalette) {
+                putU8(out, 1); // two colours
+                putCompactPixel(out, qRgb(255, 255, 255));
+                putCompactPixel(out, qRgb(0, 0, 0));
+            }
+            const QByteArray compressed = deflater.compress(tightPixels(encoding, rect, source, stream.expected));
+            putCompactLength(out, compressed.size());
+            out.append(compressed);
+        };
+        putUpdate(stream.prime, 1);
+        putTight(stream.prime, rects.first());
+        stream.primeUpdates = 1;
+        putUpdate(stream.frame, rects.size());
+        for (const QRect &rect : std::as_const(rects))
+            putTight(stream.frame, rect);
+        break;
+    }
+#else
+    case Zrle:
+    case TightCopy:
+    case TightPalette:
+    case TightGradient:
+        break;
+#endif
+    case TightJpeg: {
+        putUpdate(stream.frame, ((w + 255) / 256) * ((h + 255) / 256));
+        for (int y = 0; y < h; y += 256) {
+            for (int x = 0; x < w; x += 256) {
+                const QRect rect(x, y, qMin(256, w - x), qMin(256, h - y));
+                QByteArray jpeg;
+                QBuffer buffer(&jpeg);
+                buffer.open(QIODevice::WriteOnly);
+                source.copy(rect).save(&buffer, "JPEG", 80);
+                putRect(stream.frame, rect.x(), rect.y(), rect.width(), rect.height(), 7);
+                putU8(stream.frame, 0x90);
+                putCompactLength(stream.frame, jpeg.size());
+                stream.frame.append(jpeg);
+            }
+        }
+        stream.expected = QImage();
+        break;
+    }
+    }
+    return stream;
+}
+
+void tst_bench_qvncclient::decode()
+{
+    QFETCH(int, encoding);
+    QFETCH(QSize, size);
+    QFETCH(int, threads);
+
+#ifndef USE_ZLIB
+    if (encoding == Zrle || encoding == TightCopy || encoding == TightPalette || encoding == TightGradient)
+        QSKIP("Built without zlib");
+#endif
+    if (encoding == TightJpeg && !QImageWriter::supportedImageFormats().contains("jpeg"))
+        QSKIP("No JPEG support to create test data");
+
+    const Stream stream = makeStream(Encoding(encoding), size);
+
+    QVncClient client;
+    client.setDecodeThreadCount(threads);
+    QVncMemorySocket socket;
+    socket.setKeepWritten(false);
+    client.setSocket(&socket);
+
+    int updates = 0;
+    connect(&client, &QVncClient::framebufferUpdated, this, [&]() { updates++; });
+    auto waitForUpdates = [&](int count) {
+        while (updates < count)
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    };
+
+    socket.feed(stream.prime);
+    waitForUpdates(stream.primeUpdates);
+    QCOMPARE(client.framebufferWidth(), size.width());
+
+    socket.feed(stream.frame);
+    waitForUpdates(stream.primeUpdates + 1);
+    if (!stream.expected.isNull())
+        QCOMPARE(client.image(), stream.expected);
+
+    qint64 frames = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        socket.feed(stream.frame);
+        waitForUpdates(stream.primeUpdates + 2 + int(frames));
+        frames++;
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    qInfo("%s: %.1f MB/s, %.1f frames/s", QTest::currentDataTag(),
+          frames * stream.frame.size() / seconds / 1e6, frames / seconds);
+}
+
+void tst_bench_qvncclient::replay_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("single") << 0;
+    if (QThread::idealThreadCount() > 1)
+        QTest::newRow("threaded") << QThread::idealThreadCount();
+}
+
+// Plays a recording made with QVncClient::startRecording(), named by the
+// QVNCCLIENT_BENCH_SESSION environment variable, as fast as possible.
+void tst_bench_qvncclient::replay()
+{
+    QFETCH(int, threads);
+
+    const QString fileName = qEnvironmentVariable("QVNCCLIENT_BENCH_SESSION");
+    if (fileName.isEmpty())
+        QSKIP("Set QVNCCLIENT_BENCH_SESSION to a session recording");
+    QVncSessionPlayer player;
+    QVERIFY2(player.open(fileName), qPrintable(player.errorString()));
+
+    QVncClient client;
+    client.setDecodeThreadCount(threads);
+    int updates = 0;
+    connect(&client, &QVncClient::framebufferUpdated, this, [&]() { updates++; });
+
+    qint64 runs = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        bool finished = false;
+        player.play(&client, QVncSessionPlayer::AsFastAsPossible, [&]() { finished = true; });
+        QVERIFY(finished);
+        // Jobs still decoding are waited for when the next play() resets
+        // the client, so they are part of the measurement
+        QCoreApplication::processEvents();
+        runs++;
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    qInfo("%s: %.1f MB/s, %.1f frames/s", QTest::currentDataTag(),
+          runs * player.totalBytes() / seconds / 1e6, updates / seconds);
+}
+
+QTEST_MAIN(tst_bench_qvncclient)
+#include "tst_bench_qvncclient.moc"
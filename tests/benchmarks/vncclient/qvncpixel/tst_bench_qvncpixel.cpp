@@ -0,0 +1,266 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtGui/QImage>
+#include <QtVncClient/private/qvncpixel_p.h>
+#include <QtVncClient/private/qvncpixelformat_p.h>
+
+// Compares the per-pixel QImage::setPixel() path the decoders used to take
+// against the scanline kernels, using the write pattern of each encoding
+// over a full 1080p frame.
+class tst_bench_qvncpixel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void raw_data();
+    void raw();
+    void solidTiles_data();
+    void solidTiles();
+    void hextileSubrects_data();
+    void hextileSubrects();
+    void rleRuns_data();
+    void rleRuns();
+    void convertRow_data();
+    void convertRow();
+
+private:
+    void addModes();
+};
+
+static const int frameWidth = 1920;
+static const int frameHeight = 1080;
+
+static inline QRgb sampleColor(int i)
+{
+    return qRgb(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff);
+}
+
+void tst_bench_qvncpixel::addModes()
+{
+    QTest::addColumn<bool>("scanline");
+    QTest::newRow("setPixel") << false;
+    QTest::newRow("scanline") << true;
+}
+
+// Raw / ZRLE raw tiles / Tight copy filter: every pixel converted once.
+void tst_bench_qvncpixel::raw_data()
+{
+    addModes();
+}
+
+void tst_bench_qvncpixel::raw()
+{
+    QFETCH(bool, scanline);
+    QImage image(frameWidth, frameHeight, QImage::Format_ARGB32);
+    QList<quint32> source(frameWidth);
+    for (int x = 0; x < frameWidth; x++)
+        source[x] = sampleColor(x * 7);
+
+    if (scanline) {
+        QBENCHMARK {
+            QVncPixelWriter writer(image);
+            for (int y = 0; y < frameHeight; y++) {
+                QRgb *dst = writer.beginRow(0, y, frameWidth);
+                for (int x = 0; x < frameWidth; x++)
+                    dst[x] = source.at(x) | 0xff000000;
+                writer.endRow();
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (int y = 0; y < frameHeight; y++)
+                for (int x = 0; x < frameWidth; x++)
+                    image.setPixel(x, y, source.at(x) | 0xff000000);
+        }
+    }
+}
+
+// Hextile background / ZRLE solid tiles / Tight fill: 64x64 solid tiles.
+void tst_bench_qvncpixel::solidTiles_data()
+{
+    addModes();
+}
+
+void tst_bench_qvncpixel::solidTiles()
+{
+    QFETCH(bool, scanline);
+    QImage image(frameWidth, frameHeight, QImage::Format_ARGB32);
+    const int tile = 64;
+
+    if (scanline) {
+        QBENCHMARK {
+            QVncPixelWriter writer(image);
+            for (int ty = 0; ty < frameHeight; ty += tile)
+                for (int tx = 0; tx < frameWidth; tx += tile)
+                    writer.fillRect(tx, ty, qMin(tile, frameWidth - tx), qMin(tile, frameHeight - ty),
+                                    sampleColor(tx + ty));
+        }
+    } else {
+        QBENCHMARK {
+            for (int ty = 0; ty < frameHeight; ty += tile) {
+                for (int tx = 0; tx < frameWidth; tx += tile) {
+                    const QRgb color = sampleColor(tx + ty);
+                    for (int y = ty; y < qMin(ty + tile, frameHeight); y++)
+                        for (int x = tx; x < qMin(tx + tile, frameWidth); x++)
+                            image.setPixel(x, y, color);
+                }
+            }
+        }
+    }
+}
+
+// Hextile: 16x16 tiles, background plus four 4x4 coloured subrects each.
+void tst_bench_qvncpixel::hextileSubrects_data()
+{
+    addModes();
+}
+
+void tst_bench_qvncpixel::hextileSubrects()
+{
+    QFETCH(bool, scanline);
+    QImage image(frameWidth, frameHeight, QImage::Format_ARGB32);
+    const int tile = 16;
+
+    auto setPixelRect = [&](int x0, int y0, int w, int h, QRgb color) {
+        for (int y = y0; y < y0 + h; y++)
+            for (int x = x0; x < x0 + w; x++)
+                image.setPixel(x, y, color);
+    };
+
+    if (scanline) {
+        QBENCHMARK {
+            QVncPixelWriter writer(image);
+            for (int ty = 0; ty < frameHeight; ty += tile) {
+                for (int tx = 0; tx < frameWidth; tx += tile) {
+                    writer.fillRect(tx, ty, tile, tile, sampleColor(tx));
+                    for (int i = 0; i < 4; i++)
+                        writer.fillRect(tx + i * 4, ty + i * 4, 4, 4, sampleColor(ty + i));
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (int ty = 0; ty < frameHeight; ty += tile) {
+                for (int tx = 0; tx < frameWidth; tx += tile) {
+                    setPixelRect(tx, ty, tile, tile, sampleColor(tx));
+                    for (int i = 0; i < 4; i++)
+                        setPixelRect(tx + i * 4, ty + i * 4, 4, 4, sampleColor(ty + i));
+                }
+            }
+        }
+    }
+}
+
+// ZRLE plain/palette RLE: 64x64 tiles made of runs that wrap tile rows.
+void tst_bench_qvncpixel::rleRuns_data()
+{
+    addModes();
+}
+
+void tst_bench_qvncpixel::rleRuns()
+{
+    QFETCH(bool, scanline);
+    QImage image(frameWidth, frameHeight, QImage::Format_ARGB32);
+    const int tile = 64;
+    const int runLength = 97;
+
+    if (scanline) {
+        QRgb buffer[tile * tile];
+        QBENCHMARK {
+            QVncPixelWriter writer(image);
+            for (int ty = 0; ty < frameHeight; ty += tile) {
+                for (int tx = 0; tx < frameWidth; tx += tile) {
+                    const int tw = qMin(tile, frameWidth - tx);
+                    const int th = qMin(tile, frameHeight - ty);
+                    const int total = tw * th;
+                    for (int pos = 0; pos < total; pos += runLength)
+                        std::fill_n(buffer + pos, qMin(runLength, total - pos), sampleColor(pos));
+                    writer.writeRect(tx, ty, tw, th, buffer, tw);
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (int ty = 0; ty < frameHeight; ty += tile) {
+                for (int tx = 0; tx < frameWidth; tx += tile) {
+                    const int tw = qMin(tile, frameWidth - tx);
+                    const int th = qMin(tile, frameHeight - ty);
+                    const int total = tw * th;
+                    for (int pos = 0; pos < total; pos++)
+                        image.setPixel(tx + pos % tw, ty + pos / tw, sampleColor(pos - pos % runLength));
+                }
+            }
+        }
+    }
+}
+
+// Pixel format conversion of a full frame, per wire layout. "shift-mask"
+// is the per-pixel arithmetic the decoders used before the converters.
+void tst_bench_qvncpixel::convertRow_data()
+{
+    QTest::addColumn<int>("bytesPerPixel");
+    QTest::addColumn<QList<int>>("max");
+    QTest::addColumn<QList<int>>("shift");
+    QTest::addColumn<bool>("converter");
+
+    const QList<int> max888 { 255, 255, 255 };
+    const QList<int> bgrx { 16, 8, 0 };
+    QTest::newRow("bgrx8888-shift-mask") << 4 << max888 << bgrx << false;
+    QTest::newRow("bgrx8888") << 4 << max888 << bgrx << true;
+    QTest::newRow("rgbx8888") << 4 << max888 << QList<int> { 0, 8, 16 } << true;
+    QTest::newRow("cpixel-bgr888") << 3 << max888 << bgrx << true;
+    QTest::newRow("rgb565") << 2 << QList<int> { 31, 63, 31 } << QList<int> { 11, 5, 0 } << true;
+    QTest::newRow("bgr233") << 1 << QList<int> { 7, 7, 3 } << QList<int> { 0, 3, 6 } << true;
+}
+
+void tst_bench_qvncpixel::convertRow()
+{
+    QFETCH(int, bytesPerPixel);
+    QFETCH(QList<int>, max);
+    QFETCH(QList<int>, shift);
+    QFETCH(bool, converter);
+
+    QVncPixelFormat format;
+    format.bitsPerPixel = bytesPerPixel == 3 ? 32 : bytesPerPixel * 8;
+    format.trueColourFlag = 1;
+    format.redMax = max.at(0);
+    format.greenMax = max.at(1);
+    format.blueMax = max.at(2);
+    format.redShift = shift.at(0);
+    format.greenShift = shift.at(1);
+    format.blueShift = shift.at(2);
+    const QVncPixelConverter pixelConverter(format, bytesPerPixel);
+
+    QByteArray source(frameWidth * bytesPerPixel, Qt::Uninitialized);
+    for (int i = 0; i < source.size(); i++)
+        source[i] = char(i * 13);
+    const uchar *src = reinterpret_cast<const uchar *>(source.constData());
+    QImage image(frameWidth, frameHeight, QImage::Format_ARGB32);
+
+    if (converter) {
+        QBENCHMARK {
+            QVncPixelWriter writer(image);
+            for (int y = 0; y < frameHeight; y++)
+                pixelConverter.convertRow(src, writer.scanLine(y), frameWidth);
+        }
+    } else {
+        QBENCHMARK {
+            QVncPixelWriter writer(image);
+            for (int y = 0; y < frameHeight; y++) {
+                QRgb *dst = writer.scanLine(y);
+                for (int x = 0; x < frameWidth; x++) {
+                    quint32 color;
+                    memcpy(&color, src + x * 4, 4);
+                    dst[x] = qRgb((color >> format.redShift) & format.redMax,
+                                  (color >> format.greenShift) & format.greenMax,
+                                  (color >> format.blueShift) & format.blueMax);
+                }
+            }
+        }
+    }
+}
+
+QTEST_MAIN(tst_bench_qvncpixel)
+#include "tst_bench_qvncpixel.moc"
@@ -0,0 +1,82 @@
+// Copyright (C) 2025 Signal Slot Inc.
+// SPDX-License-Identifier: LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtTest/QtTest>
+#include <QtVncClient/private/qvnczlib_p.h>
+
+// Inflate throughput of the zlib backend the library was built with, on
+// the kind of data Tight and ZRLE streams carry. Build once with
+// VNCCLIENT_ZLIB_BACKEND=zlib and once with zlib-ng to compare.
+class tst_bench_qvnczlib : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void inflate_data();
+    void inflate();
+};
+
+static const int frameWidth = 1920;
+static const int frameHeight = 1080;
+// About the size of a 64 pixel high band of a ZRLE update
+static const int chunkSize = frameWidth * 64 * 4;
+
+void tst_bench_qvnczlib::initTestCase()
+{
+    if (!QVncInflater::backend())
+        QSKIP("Built without zlib");
+    qDebug() << "Backend:" << QVncInflater::backend();
+}
+
+void tst_bench_qvnczlib::inflate_data()
+{
+    QTest::addColumn<QByteArray>("chunk");
+
+    // Desktop: long runs of a few colours, like windows and text
+    QByteArray desktop(chunkSize, Qt::Uninitialized);
+    for (int i = 0; i < chunkSize; i++)
+        desktop[i] = char(((i / 4) % frameWidth) / 240 + ((i / 4 / frameWidth) % 16 == 0 ? 0x40 : 0));
+    QTest::newRow("desktop") << desktop;
+
+    // Photo: smooth gradients with noise, which compress poorly
+    QByteArray photo(chunkSize, Qt::Uninitialized);
+    quint32 noise = 1;
+    for (int i = 0; i < chunkSize; i++) {
+        noise = noise * 1103515245 + 12345;
+        photo[i] = char(((i / 4) % frameWidth) / 8 + ((noise >> 16) & 0x0f));
+    }
+    QTest::newRow("photo") << photo;
+}
+
+void tst_bench_qvnczlib::inflate()
+{
+    QFETCH(QByteArray, chunk);
+
+    // Every chunk ends with a full flush, so it can be replayed on a primed
+    // stream any number of times
+    QVncDeflater deflater;
+    const QByteArray first = deflater.compress(chunk, QVncDeflater::FullFlush);
+    const QByteArray compressed = deflater.compress(chunk, QVncDeflater::FullFlush);
+    QVERIFY(!first.isNull() && !compressed.isNull());
+
+    QVncInflater inflater;
+    QByteArray out(chunk.size(), Qt::Uninitialized);
+    qsizetype written = 0;
+    inflater.setInput(reinterpret_cast<const uchar *>(first.constData()), first.size());
+    QCOMPARE(inflater.inflate(reinterpret_cast<uchar *>(out.data()), out.size(), &written), QVncInflater::Ok);
+    QCOMPARE(out, chunk);
+
+    const int chunksPerFrame = frameHeight / 64;
+    QBENCHMARK {
+        for (int i = 0; i < chunksPerFrame; i++) {
+            inflater.setInput(reinterpret_cast<const uchar *>(compressed.constData()), compressed.size());
+            inflater.inflate(reinterpret_cast<uchar *>(out.data()), out.size(), &written);
+        }
+    }
+    QCOMPARE(written, chunk.size());
+    QCOMPARE(out, chunk);
+}
+
+QTEST_MAIN(tst_bench_qvnczlib)
+#include "tst_bench_qvnczlib.moc"